@@ -1,4 +1,5 @@
 #include <cstring>
+#include <cctype>
 
 #include "archive.h"
 #include "gobArchive.h"
@@ -176,3 +177,94 @@ void Archive::deleteCustomArchive(Archive* archive)
 	}
 	delete archive;
 }
+
+/////////////////////////////////////////////////
+// Shared directory lookup
+/////////////////////////////////////////////////
+namespace
+{
+	// FNV-1a hash of the lower case file name.
+	u32 hashFileName(const char* name)
+	{
+		u32 hash = 2166136261u;
+		for (; *name; name++)
+		{
+			hash ^= u32(tolower(*name));
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+}
+
+void Archive::buildFileIndex()
+{
+	clearFileIndex();
+	const u32 count = getFileCount();
+	if (!count) { return; }
+
+	// Keep the load factor at or below 50%.
+	u32 tableSize = 16;
+	while (tableSize < count * 2) { tableSize <<= 1; }
+	m_fileIndex.resize(tableSize, INVALID_FILE);
+	m_fileIndexMask = tableSize - 1;
+
+	for (u32 i = 0; i < count; i++)
+	{
+		const char* name = getFileName(i);
+		if (!name) { continue; }
+
+		u32 slot = hashFileName(name) & m_fileIndexMask;
+		bool duplicate = false;
+		while (m_fileIndex[slot] != INVALID_FILE)
+		{
+			// Match the original linear search, where the first entry with a given name wins.
+			if (strcasecmp(name, getFileName(m_fileIndex[slot])) == 0)
+			{
+				duplicate = true;
+				break;
+			}
+			slot = (slot + 1) & m_fileIndexMask;
+		}
+		if (!duplicate)
+		{
+			m_fileIndex[slot] = i;
+		}
+	}
+}
+
+void Archive::clearFileIndex()
+{
+	m_fileIndex.clear();
+	m_fileIndexMask = 0;
+}
+
+u32 Archive::findFileIndex(const char* file)
+{
+	if (m_fileIndex.empty() || !file) { return INVALID_FILE; }
+
+	u32 slot = hashFileName(file) & m_fileIndexMask;
+	while (m_fileIndex[slot] != INVALID_FILE)
+	{
+		const u32 index = m_fileIndex[slot];
+		if (strcasecmp(file, getFileName(index)) == 0)
+		{
+			return index;
+		}
+		slot = (slot + 1) & m_fileIndexMask;
+	}
+	return INVALID_FILE;
+}
+
+const u8* Archive::getMappedData(size_t offset, size_t size)
+{
+	if (!m_mappedFile.isOpen() && !m_mappedFile.open(m_archivePath))
+	{
+		return nullptr;
+	}
+	// Guard against truncated archives.
+	if (offset + size > m_mappedFile.getSize())
+	{
+		return nullptr;
+	}
+	return m_mappedFile.getData() + offset;
+}
@@ -1,8 +1,10 @@
 #pragma once
 #include <cstdio>
+#include <vector>
 
 #include <TFE_System/types.h>
 #include <TFE_FileSystem/paths.h>
+#include <TFE_FileSystem/mappedFile.h>
 
 enum ArchiveType
 {
@@ -31,8 +33,8 @@ public:
 	
 	// Public Archive API
 public:
-	Archive() : m_type(ARCHIVE_UNKNOWN) {}
-	Archive(ArchiveType type) : m_type(type) {}
+	Archive() : m_type(ARCHIVE_UNKNOWN), m_fileIndexMask(0) {}
+	Archive(ArchiveType type) : m_type(type), m_fileIndexMask(0) {}
 	virtual ~Archive() {}
 
 	// Archive
@@ -65,6 +67,22 @@ public:
 	// Edit
 	virtual void addFile(const char* fileName, const char* filePath) = 0;
 
+	// Read-only views
+	// Returns the entry data without copying it, or nullptr if views are not supported.
+	// The view stays valid until releaseFileView() is called or the archive is closed or modified.
+	virtual const u8* acquireFileView(u32 index, size_t* size) { return nullptr; }
+	virtual void releaseFileView(u32 index) {}
+
+	// Shared directory lookup.
+protected:
+	// Build a case-insensitive hash index from getFileCount() and getFileName(), called once the directory has been read.
+	void buildFileIndex();
+	void clearFileIndex();
+	// Returns the index of the first entry matching 'file' or INVALID_FILE.
+	u32  findFileIndex(const char* file);
+	// Returns a pointer into the memory mapped archive file, which is mapped on first use.
+	const u8* getMappedData(size_t offset, size_t size);
+
 	// Shared Private State
 protected:
 	ArchiveType m_type;
@@ -72,4 +90,8 @@ protected:
 	char m_archivePath[TFE_MAX_PATH];
 
 	s32 m_fileOffset;
+
+	std::vector<u32> m_fileIndex;	// Open addressed hash table of file indices.
+	u32 m_fileIndexMask;
+	MappedFile m_mappedFile;
 };
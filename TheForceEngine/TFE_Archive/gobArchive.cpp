@@ -33,8 +33,10 @@ bool GobArchive::create(const char *archivePath)
 
 	strcpy(m_archivePath, archivePath);
 	m_file.close();
+	// Keep the archive open for reading, like open().
+	m_archiveOpen = m_file.open(m_archivePath, Stream::MODE_READ);
 
-	return true;
+	return m_archiveOpen;
 }
 
 bool GobArchive::validate(const char *archivePath, s32 minFileCount)
@@ -81,7 +83,8 @@ bool GobArchive::open(const char *archivePath)
 	m_file.readBuffer(m_fileList.entries, sizeof(GOB_Entry_t), m_fileList.MASTERN);
 
 	strcpy(m_archivePath, archivePath);
-	m_file.close();
+	buildFileIndex();
+	// The archive file is kept open until the archive is closed, so opening an entry only requires a seek.
 
 	return true;
 }
@@ -89,9 +92,11 @@ bool GobArchive::open(const char *archivePath)
 void GobArchive::close()
 {
 	m_file.close();
+	m_mappedFile.close();
 	m_archiveOpen = false;
 	delete[] m_fileList.entries;
 	m_fileList.entries = nullptr;
+	clearFileIndex();
 }
 
 // File Access
@@ -99,23 +104,12 @@ bool GobArchive::openFile(const char *file)
 {
 	if (!m_archiveOpen) { return false; }
 
-	m_file.open(m_archivePath, Stream::MODE_READ);
-	m_curFile = -1;
 	m_fileOffset = 0;
-
-	//search for this file.
-	for (s32 i = 0; i < m_fileList.MASTERN; i++)
-	{
-		if (strcasecmp(file, m_fileList.entries[i].NAME) == 0)
-		{
-			m_curFile = i;
-			break;
-		}
-	}
+	const u32 index = findFileIndex(file);
+	m_curFile = (index == INVALID_FILE) ? -1 : s32(index);
 
 	if (m_curFile == -1)
 	{
-		m_file.close();
 		TFE_System::logWrite(LOG_ERROR, "GOB", "Failed to load \"%s\" from \"%s\"", file, m_archivePath);
 	}
 	else
@@ -131,46 +125,27 @@ bool GobArchive::openFile(u32 index)
 
 	m_curFile = s32(index);
 	m_fileOffset = 0;
-	m_file.open(m_archivePath, Stream::MODE_READ);
 	m_file.seek(m_fileList.entries[m_curFile].IX);
 	return true;
 }
 
 void GobArchive::closeFile()
 {
+	// The archive file itself stays open until close().
 	m_curFile = -1;
-	m_file.close();
 }
 
 u32 GobArchive::getFileIndex(const char* file)
 {
 	if (!m_archiveOpen) { return INVALID_FILE; }
-
-	//search for this file.
-	for (s32 i = 0; i < m_fileList.MASTERN; i++)
-	{
-		if (strcasecmp(file, m_fileList.entries[i].NAME) == 0)
-		{
-			return i;
-		}
-	}
-	return INVALID_FILE;
+	return findFileIndex(file);
 }
 
 bool GobArchive::fileExists(const char *file)
 {
 	if (!m_archiveOpen) { return false; }
 	m_curFile = -1;
-
-	//search for this file.
-	for (s32 i = 0; i < m_fileList.MASTERN; i++)
-	{
-		if (strcasecmp(file, m_fileList.entries[i].NAME) == 0)
-		{
-			return true;
-		}
-	}
-	return false;
+	return findFileIndex(file) != INVALID_FILE;
 }
 
 bool GobArchive::fileExists(u32 index)
@@ -251,6 +226,14 @@ size_t GobArchive::getFileLength(u32 index)
 	return m_fileList.entries[index].LEN;
 }
 
+// Read-only views
+const u8* GobArchive::acquireFileView(u32 index, size_t* size)
+{
+	if (!m_archiveOpen || index >= getFileCount()) { return nullptr; }
+	*size = m_fileList.entries[index].LEN;
+	return getMappedData(m_fileList.entries[index].IX, *size);
+}
+
 // Edit
 void GobArchive::addFile(const char* fileName, const char* filePath)
 {
@@ -275,6 +258,7 @@ void GobArchive::addFile(const char* fileName, const char* filePath)
 
 	// Read all of the file data.
 	std::vector<std::vector<u8>> fileData(m_fileList.MASTERN);
+	m_file.close();
 	if (m_file.open(m_archivePath, Stream::MODE_READ))
 	{
 		for (s32 f = 0; f < m_fileList.MASTERN - 1; f++)
@@ -290,7 +274,8 @@ void GobArchive::addFile(const char* fileName, const char* filePath)
 		file.close();
 	}
 
-	// Now write the new file.
+	// Now write the new file, existing views are invalidated.
+	m_mappedFile.close();
 	if (m_file.open(m_archivePath, Stream::MODE_WRITE))
 	{
 		m_file.writeBuffer(&m_header, sizeof(GOB_Header_t));
@@ -303,4 +288,9 @@ void GobArchive::addFile(const char* fileName, const char* filePath)
 		m_file.writeBuffer(m_fileList.entries, sizeof(GOB_Entry_t), m_fileList.MASTERN);
 		m_file.close();
 	}
+
+	// Reopen the archive for reading and update the directory lookup.
+	m_archiveOpen = m_file.open(m_archivePath, Stream::MODE_READ);
+	m_curFile = -1;
+	buildFileIndex();
 }
@@ -41,6 +41,9 @@ public:
 	// Edit
 	void addFile(const char* fileName, const char* filePath) override;
 
+	// Read-only views, these point directly into the archive memory.
+	const u8* acquireFileView(u32 index, size_t* size) override;
+
 private:
 	const u8* m_buffer;
 	size_t m_size;
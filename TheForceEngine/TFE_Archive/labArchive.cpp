@@ -33,9 +33,11 @@ bool LabArchive::open(const char *archivePath)
 
 	// Read string table.
 	m_file.readBuffer(m_stringTable, m_header.stringTableSize);
-	m_file.close();
+	m_stringTable[m_header.stringTableSize] = 0;
 		
 	strcpy(m_archivePath, archivePath);
+	buildFileIndex();
+	// The archive file is kept open until the archive is closed, so opening an entry only requires a seek.
 	
 	return true;
 }
@@ -43,9 +45,13 @@ bool LabArchive::open(const char *archivePath)
 void LabArchive::close()
 {
 	m_file.close();
+	m_mappedFile.close();
 	m_archiveOpen = false;
 	delete[] m_entries;
 	delete[] m_stringTable;
+	m_entries = nullptr;
+	m_stringTable = nullptr;
+	clearFileIndex();
 }
 
 // File Access
@@ -53,23 +59,12 @@ bool LabArchive::openFile(const char *file)
 {
 	if (!m_archiveOpen) { return false; }
 
-	m_file.open(m_archivePath, Stream::MODE_READ);
-	m_curFile = -1;
 	m_fileOffset = 0;
-
-	//search for this file.
-	for (u32 i = 0; i < m_header.fileCount; i++)
-	{
-		if (strcasecmp(file, &m_stringTable[m_entries[i].nameOffset]) == 0)
-		{
-			m_curFile = i;
-			break;
-		}
-	}
+	const u32 index = findFileIndex(file);
+	m_curFile = (index == INVALID_FILE) ? -1 : s32(index);
 
 	if (m_curFile == -1)
 	{
-		m_file.close();
 		TFE_System::logWrite(LOG_ERROR, "GOB", "Failed to load \"%s\" from \"%s\"", file, m_archivePath);
 	}
 	else
@@ -85,47 +80,28 @@ bool LabArchive::openFile(u32 index)
 
 	m_curFile = s32(index);
 	m_fileOffset = 0;
-	m_file.open(m_archivePath, Stream::MODE_READ);
 	m_file.seek(m_entries[m_curFile].dataOffset);
 	return true;
 }
 
 void LabArchive::closeFile()
 {
+	// The archive file itself stays open until close().
 	m_curFile = -1;
-	m_file.close();
 }
 
 u32 LabArchive::getFileIndex(const char* file)
 {
 	if (!m_archiveOpen) { return INVALID_FILE; }
 	m_curFile = -1;
-
-	//search for this file.
-	for (u32 i = 0; i < m_header.fileCount; i++)
-	{
-		if (strcasecmp(file, &m_stringTable[m_entries[i].nameOffset]) == 0)
-		{
-			return i;
-		}
-	}
-	return INVALID_FILE;
+	return findFileIndex(file);
 }
 
 bool LabArchive::fileExists(const char *file)
 {
 	if (!m_archiveOpen) { return false; }
 	m_curFile = -1;
-
-	//search for this file.
-	for (u32 i = 0; i < m_header.fileCount; i++)
-	{
-		if (strcasecmp(file, &m_stringTable[m_entries[i].nameOffset]) == 0)
-		{
-			return true;
-		}
-	}
-	return false;
+	return findFileIndex(file) != INVALID_FILE;
 }
 
 bool LabArchive::fileExists(u32 index)
@@ -206,6 +182,14 @@ size_t LabArchive::getFileLength(u32 index)
 	return m_entries[index].len;
 }
 
+// Read-only views
+const u8* LabArchive::acquireFileView(u32 index, size_t* size)
+{
+	if (!m_archiveOpen || index >= getFileCount()) { return nullptr; }
+	*size = m_entries[index].len;
+	return getMappedData(m_entries[index].dataOffset, *size);
+}
+
 // Edit
 void LabArchive::addFile(const char* fileName, const char* filePath)
 {
@@ -7,7 +7,7 @@
 class LabArchive : public Archive
 {
 public:
-	LabArchive() : Archive(ARCHIVE_LAB), m_archiveOpen(false), m_curFile(-1) {}
+	LabArchive() : Archive(ARCHIVE_LAB), m_archiveOpen(false), m_stringTable(nullptr), m_entries(nullptr), m_curFile(-1) {}
 	~LabArchive() override;
 
 	// Archive
@@ -37,6 +37,9 @@ public:
 	// Edit
 	void addFile(const char* fileName, const char* filePath) override;
 
+	// Read-only views
+	const u8* acquireFileView(u32 index, size_t* size) override;
+
 private:
 	#pragma pack(push)
 	#pragma pack(1)
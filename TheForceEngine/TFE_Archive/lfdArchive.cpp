@@ -25,8 +25,10 @@ bool LfdArchive::create(const char *archivePath)
 
 	strcpy(m_archivePath, archivePath);
 	m_file.close();
+	// Keep the archive open for reading, like open().
+	m_archiveOpen = m_file.open(m_archivePath, Stream::MODE_READ);
 
-	return true;
+	return m_archiveOpen;
 }
 
 bool LfdArchive::open(const char *archivePath)
@@ -61,7 +63,8 @@ bool LfdArchive::open(const char *archivePath)
 	}
 
 	strcpy(m_archivePath, archivePath);
-	m_file.close();
+	buildFileIndex();
+	// The archive file is kept open until the archive is closed, so opening an entry only requires a seek.
 
 	return true;
 }
@@ -69,6 +72,7 @@ bool LfdArchive::open(const char *archivePath)
 void LfdArchive::close()
 {
 	m_file.close();
+	m_mappedFile.close();
 	m_archiveOpen = false;
 
 	if (m_fileList.entries)
@@ -76,6 +80,7 @@ void LfdArchive::close()
 		delete[] m_fileList.entries;
 		m_fileList.entries = nullptr;
 	}
+	clearFileIndex();
 }
 
 // File Access
@@ -83,23 +88,12 @@ bool LfdArchive::openFile(const char *file)
 {
 	if (!m_archiveOpen) { return false; }
 
-	m_file.open(m_archivePath, Stream::MODE_READ);
-	m_curFile = -1;
 	m_fileOffset = 0;
-
-	//search for this file.
-	for (s32 i = 0; i < m_fileList.MASTERN; i++)
-	{
-		if (strcasecmp(file, m_fileList.entries[i].NAME) == 0)
-		{
-			m_curFile = i;
-			break;
-		}
-	}
+	const u32 index = findFileIndex(file);
+	m_curFile = (index == INVALID_FILE) ? -1 : s32(index);
 
 	if (m_curFile == -1)
 	{
-		m_file.close();
 		TFE_System::logWrite(LOG_ERROR, "LFD", "Failed to load \"%s\" from \"%s\"", file, m_archivePath);
 	}
 	else
@@ -115,47 +109,28 @@ bool LfdArchive::openFile(u32 index)
 
 	m_curFile = s32(index);
 	m_fileOffset = 0;
-	m_file.open(m_archivePath, Stream::MODE_READ);
 	m_file.seek(m_fileList.entries[m_curFile].IX);
 	return true;
 }
 
 void LfdArchive::closeFile()
 {
+	// The archive file itself stays open until close().
 	m_curFile = -1;
-	m_file.close();
 }
 
 u32 LfdArchive::getFileIndex(const char* file)
 {
 	if (!m_archiveOpen) { return INVALID_FILE; }
 	m_curFile = -1;
-
-	//search for this file.
-	for (s32 i = 0; i < m_fileList.MASTERN; i++)
-	{
-		if (strcasecmp(file, m_fileList.entries[i].NAME) == 0)
-		{
-			return i;
-		}
-	}
-	return INVALID_FILE;
+	return findFileIndex(file);
 }
 
 bool LfdArchive::fileExists(const char *file)
 {
 	if (!m_archiveOpen) { return false; }
 	m_curFile = -1;
-
-	//search for this file.
-	for (s32 i = 0; i < m_fileList.MASTERN; i++)
-	{
-		if (strcasecmp(file, m_fileList.entries[i].NAME) == 0)
-		{
-			return true;
-		}
-	}
-	return false;
+	return findFileIndex(file) != INVALID_FILE;
 }
 
 bool LfdArchive::fileExists(u32 index)
@@ -236,6 +211,14 @@ size_t LfdArchive::getFileLength(u32 index)
 	return m_fileList.entries[index].LENGTH;
 }
 
+// Read-only views
+const u8* LfdArchive::acquireFileView(u32 index, size_t* size)
+{
+	if (!m_archiveOpen || index >= getFileCount()) { return nullptr; }
+	*size = m_fileList.entries[index].LENGTH;
+	return getMappedData(m_fileList.entries[index].IX, *size);
+}
+
 // Edit
 void LfdArchive::addFile(const char* fileName, const char* filePath)
 {
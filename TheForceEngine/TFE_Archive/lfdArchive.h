@@ -42,6 +42,9 @@ public:
 	// Edit
 	void addFile(const char* fileName, const char* filePath) override;
 
+	// Read-only views
+	const u8* acquireFileView(u32 index, size_t* size) override;
+
 private:
 	#pragma pack(push)
 	#pragma pack(1)
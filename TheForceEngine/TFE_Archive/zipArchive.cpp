@@ -72,10 +72,12 @@ bool ZipArchive::open(const char *archivePath)
 		m_entries[i].length = (size_t)zip_entry_size(zip);
 		zip_entry_close(zip);
 	}
-	zip_close(zip);
 
 	strcpy(m_archivePath, archivePath);
-	m_fileHandle = nullptr;
+	buildFileIndex();
+	// Keep the zip file open so that entries can be opened without re-reading the central directory.
+	m_fileHandle = zip;
+	m_entryOpen = false;
 
 	return true;
 }
@@ -83,26 +85,39 @@ bool ZipArchive::open(const char *archivePath)
 void ZipArchive::close()
 {
 	closeFile();
+	for (ZipViewMap::iterator iView = m_views.begin(); iView != m_views.end(); ++iView)
+	{
+		free(iView->second.data);
+	}
+	m_views.clear();
+	if (m_fileHandle)
+	{
+		zip_close((struct zip_t*)m_fileHandle);
+		m_fileHandle = nullptr;
+	}
 
 	delete[] m_entries;
 	m_entries = nullptr;
 	m_curFile = INVALID_FILE;
+	clearFileIndex();
 }
 
 // File Access
 bool ZipArchive::openFile(const char *file)
 {
-	m_curFile = getFileIndex(file);
+	closeFile();
+	m_curFile = m_fileHandle ? getFileIndex(file) : INVALID_FILE;
 	m_fileOffset = 0;
 	if (m_curFile != INVALID_FILE)
 	{
-		m_fileHandle = zip_open(m_archivePath, 0, 'r');
 		if (zip_entry_openbyindex((struct zip_t*)m_fileHandle, m_curFile) != 0)
 		{
 			TFE_System::logWrite(LOG_ERROR, "zipArchive", "Cannot open file '%s' from archive '%s'", file, m_archivePath);
 			m_curFile = INVALID_FILE;
-			zip_close((struct zip_t*)m_fileHandle);
-			m_fileHandle = nullptr;
+		}
+		else
+		{
+			m_entryOpen = true;
 		}
 	}
 
@@ -119,20 +134,20 @@ bool ZipArchive::openFile(const char *file)
 
 bool ZipArchive::openFile(u32 index)
 {
-	m_curFile = INVALID_FILE;
+	closeFile();
 	m_fileOffset = 0;
-	if (index <= (u32)m_entryCount)
+	if (m_fileHandle && index < (u32)m_entryCount)
 	{
-		// Open the system file.
-		m_fileHandle = zip_open(m_archivePath, 0, 'r');
-		// Open the file entry itself.
+		// Open the file entry itself, the system file is already open.
 		m_curFile = index;
 		if (zip_entry_openbyindex((struct zip_t*)m_fileHandle, index) != 0)
 		{
 			TFE_System::logWrite(LOG_ERROR, "zipArchive", "Cannot open file '%s' from archive '%s'", m_entries[index].name.c_str(), m_archivePath);
 			m_curFile = INVALID_FILE;
-			zip_close((struct zip_t*)m_fileHandle);
-			m_fileHandle = nullptr;
+		}
+		else
+		{
+			m_entryOpen = true;
 		}
 	}
 
@@ -149,13 +164,11 @@ bool ZipArchive::openFile(u32 index)
 
 void ZipArchive::closeFile()
 {
-	if (m_fileHandle)
+	if (m_fileHandle && m_entryOpen)
 	{
-		// Close the file entry.
+		// Close the file entry, the system file stays open until close().
 		zip_entry_close((struct zip_t*)m_fileHandle);
-		// Close the system file.
-		zip_close((struct zip_t*)m_fileHandle);
-		m_fileHandle = nullptr;
+		m_entryOpen = false;
 	}
 	m_curFile = INVALID_FILE;
 }
@@ -172,14 +185,7 @@ bool ZipArchive::fileExists(u32 index)
 
 u32 ZipArchive::getFileIndex(const char* file)
 {
-	for (s32 i = 0; i < m_entryCount; i++)
-	{
-		if (strcasecmp(file, m_entries[i].name.c_str()) == 0)
-		{
-			return i;
-		}
-	}
-	return INVALID_FILE;
+	return findFileIndex(file);
 }
 
 size_t ZipArchive::getFileLength()
@@ -272,6 +278,53 @@ size_t ZipArchive::getFileLength(u32 index)
 	return m_entries[index].length;
 }
 
+// Read-only views
+const u8* ZipArchive::acquireFileView(u32 index, size_t* size)
+{
+	// Only one entry can be open at a time, so views cannot be created while a file is being streamed.
+	if (!m_fileHandle || m_entryOpen || index >= (u32)m_entryCount) { return nullptr; }
+	*size = m_entries[index].length;
+
+	ZipViewMap::iterator iView = m_views.find(index);
+	if (iView != m_views.end())
+	{
+		iView->second.refCount++;
+		return iView->second.data;
+	}
+
+	struct zip_t* zip = (struct zip_t*)m_fileHandle;
+	if (zip_entry_openbyindex(zip, index) != 0)
+	{
+		TFE_System::logWrite(LOG_ERROR, "zipArchive", "Cannot open file '%s' from archive '%s'", m_entries[index].name.c_str(), m_archivePath);
+		return nullptr;
+	}
+	// Allocate at least one byte so that empty entries still return a valid pointer.
+	u8* data = (u8*)malloc(std::max(m_entries[index].length, (size_t)1));
+	const bool success = m_entries[index].length == 0 || zip_entry_noallocread(zip, data, m_entries[index].length) > 0;
+	zip_entry_close(zip);
+	if (!success)
+	{
+		free(data);
+		return nullptr;
+	}
+
+	m_views[index] = { data, 1 };
+	return data;
+}
+
+void ZipArchive::releaseFileView(u32 index)
+{
+	ZipViewMap::iterator iView = m_views.find(index);
+	if (iView == m_views.end()) { return; }
+
+	iView->second.refCount--;
+	if (iView->second.refCount <= 0)
+	{
+		free(iView->second.data);
+		m_views.erase(iView);
+	}
+}
+
 // Edit
 void ZipArchive::addFile(const char* fileName, const char* filePath)
 {
@@ -1,11 +1,12 @@
 #pragma once
 #include "archive.h"
 #include <string>
+#include <map>
 
 class ZipArchive : public Archive
 {
 public:
-	ZipArchive() : Archive(ARCHIVE_ZIP), m_entryCount(0), m_curFile(INVALID_FILE), m_entries(nullptr), m_fileHandle(nullptr) {}
+	ZipArchive() : Archive(ARCHIVE_ZIP), m_entryCount(0), m_curFile(INVALID_FILE), m_entries(nullptr), m_fileHandle(nullptr), m_entryOpen(false) {}
 	~ZipArchive() override;
 
 	// Archive
@@ -35,6 +36,10 @@ public:
 	// Edit
 	void addFile(const char* fileName, const char* filePath) override;
 
+	// Read-only views, entries are decompressed into a buffer that is kept until the view is released.
+	const u8* acquireFileView(u32 index, size_t* size) override;
+	void releaseFileView(u32 index) override;
+
 private:
 	struct ZipEntry
 	{
@@ -43,10 +48,20 @@ private:
 		bool isDir;
 	};
 
+	struct ZipView
+	{
+		u8* data;
+		s32 refCount;
+	};
+	typedef std::map<u32, ZipView> ZipViewMap;
+
 	s32 m_entryCount;
 	u32 m_curFile;
 	ZipEntry* m_entries;
-	void* m_fileHandle;
+	void* m_fileHandle;		// The zip file stays open while the archive is open.
+	bool  m_entryOpen;
+
+	ZipViewMap m_views;
 
 	u8* m_tempBuffer = nullptr;
 	size_t m_tempBufferSize = 0;
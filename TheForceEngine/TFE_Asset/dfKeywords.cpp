@@ -4,7 +4,7 @@
 #include <TFE_System/system.h>
 
 // These strings are taken directly from the Dark Forces EXE.
-static const char* c_keywords[] =
+static constexpr const char* c_keywords[] =
 {
 	"VISIBLE:",
 	"SHADED:",
@@ -228,8 +228,101 @@ static const char* c_keywords[] =
 };
 
 #define KEYWORD_COUNT TFE_ARRAYSIZE(c_keywords)
+static_assert(KEYWORD_COUNT == KW_COUNT, "The keyword strings and KEYWORD enum are out of sync.");
+
+// Perfect hash for the keyword table.
+// Each unique keyword (ignoring case) maps to its own slot, so a lookup is a single hash and string compare.
+// The table is built at compile time; if the keyword list changes and the static_assert below fires,
+// search for a new KEYWORD_HASH_SEED that produces no collisions.
+enum KeywordHash : u32
+{
+	KEYWORD_HASH_SIZE = 2048,
+	KEYWORD_HASH_MASK = KEYWORD_HASH_SIZE - 1,
+	KEYWORD_HASH_SEED = 33972,
+};
+
+struct KeywordHashTable
+{
+	s16 slots[KEYWORD_HASH_SIZE];
+	s32 collisions;
+};
+
+static constexpr char keyword_upper(char c)
+{
+	return (c >= 'a' && c <= 'z') ? char(c - 'a' + 'A') : c;
+}
+
+static constexpr u32 keyword_hash(const char* str, size_t len)
+{
+	u32 hash = 2166136261u ^ u32(KEYWORD_HASH_SEED);
+	for (size_t i = 0; i < len; i++)
+	{
+		hash ^= u8(keyword_upper(str[i]));
+		hash *= 16777619u;
+	}
+	return hash ^ (hash >> 15u);
+}
+
+static constexpr size_t keyword_length(const char* str)
+{
+	size_t len = 0;
+	while (str[len]) { len++; }
+	return len;
+}
+
+static constexpr bool keyword_equal(const char* a, const char* b)
+{
+	while (*a && keyword_upper(*a) == keyword_upper(*b)) { a++; b++; }
+	return keyword_upper(*a) == keyword_upper(*b);
+}
+
+static constexpr KeywordHashTable keyword_buildHashTable()
+{
+	KeywordHashTable table = {};
+	for (s32 i = 0; i < s32(KEYWORD_HASH_SIZE); i++)
+	{
+		table.slots[i] = -1;
+	}
+	for (s32 i = 0; i < s32(KEYWORD_COUNT); i++)
+	{
+		const u32 slot = keyword_hash(c_keywords[i], keyword_length(c_keywords[i])) & KEYWORD_HASH_MASK;
+		const s32 existing = table.slots[slot];
+		if (existing < 0)
+		{
+			table.slots[slot] = s16(i);
+		}
+		else if (!keyword_equal(c_keywords[existing], c_keywords[i]))
+		{
+			table.collisions++;
+		}
+		// Repeated keywords keep the first index, matching the original linear search.
+	}
+	return table;
+}
+
+static constexpr KeywordHashTable s_keywordHash = keyword_buildHashTable();
+static_assert(s_keywordHash.collisions == 0, "Keyword hash collision, choose a new KEYWORD_HASH_SEED.");
+
+KEYWORD getKeywordIndex(const char* keywordString, size_t len)
+{
+	const s32 index = s_keywordHash.slots[keyword_hash(keywordString, len) & KEYWORD_HASH_MASK];
+	if (index < 0) { return KW_UNKNOWN; }
+
+	const char* keyword = c_keywords[index];
+	if (strncasecmp(keywordString, keyword, len) || keyword[len] != 0)
+	{
+		return KW_UNKNOWN;
+	}
+	return KEYWORD(index);
+}
 
 KEYWORD getKeywordIndex(const char* keywordString)
+{
+	return getKeywordIndex(keywordString, strlen(keywordString));
+}
+
+// Reference implementation, kept to validate and benchmark the hashed lookup.
+KEYWORD getKeywordIndexLinear(const char* keywordString)
 {
 	s32 result = -1;
 	for (s32 i = 0; i < KEYWORD_COUNT; i++)
@@ -235,4 +235,8 @@ enum KEYWORD
 	KW_COUNT
 };
 
-extern KEYWORD getKeywordIndex(const char* keywordString);
\ No newline at end of file
+extern KEYWORD getKeywordIndex(const char* keywordString);
+// Lookup a keyword that is not null terminated, such as a token slice into a line.
+extern KEYWORD getKeywordIndex(const char* keywordString, size_t len);
+// Linear search over the keyword table, the hashed lookups above should be used instead.
+extern KEYWORD getKeywordIndexLinear(const char* keywordString);
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include <cstring>
+#include <cmath>
+#include <vector>
+
+#include "audioResampler.h"
+#include <TFE_System/system.h>
+#include <algorithm>
+
+namespace TFE_AudioResampler
+{
+	enum ResamplerConstants
+	{
+		RESAMPLE_TAPS = 32,				// Filter taps per phase, in input samples.
+		RESAMPLE_MAX_PHASES = 4096,
+		RESAMPLE_BLOCK_FRAMES = 256,	// Maximum number of frames processed or requested from the source at once.
+		RESAMPLE_MAX_INPUT = RESAMPLE_TAPS + RESAMPLE_BLOCK_FRAMES + 1,
+	};
+	// Cutoff as a fraction of the input Nyquist frequency, leaving room for the transition band.
+	static const f64 c_cutoff = 0.9;
+	static const f64 c_pi = 3.14159265358979323846;
+
+	static bool s_passthrough = true;
+	// The output advances by s_phaseStep / s_phaseCount input samples per frame.
+	static u32 s_phaseCount = 1;
+	static u32 s_phaseStep = 1;
+	static u32 s_phase = 0;
+	static std::vector<f32> s_filter;
+
+	static f32 s_input[RESAMPLE_MAX_INPUT * 2];
+	static u32 s_inputCount = 0;
+
+	u32 gcd(u32 a, u32 b)
+	{
+		while (b)
+		{
+			const u32 r = a % b;
+			a = b;
+			b = r;
+		}
+		return a;
+	}
+
+	f64 windowedSinc(f64 t)
+	{
+		const f64 halfWidth = f64(RESAMPLE_TAPS / 2);
+		if (fabs(t) >= halfWidth) { return 0.0; }
+
+		// Blackman window.
+		const f64 w = 0.5 + 0.5 * t / halfWidth;
+		const f64 window = 0.42 - 0.5 * cos(2.0 * c_pi * w) + 0.08 * cos(4.0 * c_pi * w);
+		const f64 x = c_pi * c_cutoff * t;
+		const f64 sinc = (fabs(x) < 1e-9) ? 1.0 : sin(x) / x;
+		return c_cutoff * sinc * window;
+	}
+
+	bool init(u32 inputRate, u32 outputRate)
+	{
+		s_passthrough = true;
+		s_phaseCount = 1;
+		s_phaseStep = 1;
+		s_filter.clear();
+
+		if (!inputRate || outputRate < inputRate)
+		{
+			return false;
+		}
+		const u32 div = gcd(inputRate, outputRate);
+		if (outputRate / div > RESAMPLE_MAX_PHASES)
+		{
+			return false;
+		}
+
+		if (inputRate != outputRate)
+		{
+			s_passthrough = false;
+			s_phaseCount = outputRate / div;
+			s_phaseStep = inputRate / div;
+
+			// Tap j of phase p is applied to input sample (j - RESAMPLE_TAPS/2 + 1) relative to the output position.
+			s_filter.resize(s_phaseCount * RESAMPLE_TAPS);
+			for (u32 p = 0; p < s_phaseCount; p++)
+			{
+				const f64 frac = f64(p) / f64(s_phaseCount);
+				f32* taps = &s_filter[p * RESAMPLE_TAPS];
+				f64 sum = 0.0;
+				for (s32 j = 0; j < RESAMPLE_TAPS; j++)
+				{
+					sum += windowedSinc(frac - f64(j - RESAMPLE_TAPS / 2 + 1));
+				}
+				// Normalize each phase to unity gain so that constant signals do not ripple.
+				for (s32 j = 0; j < RESAMPLE_TAPS; j++)
+				{
+					taps[j] = f32(windowedSinc(frac - f64(j - RESAMPLE_TAPS / 2 + 1)) / sum);
+				}
+			}
+		}
+		reset();
+		return true;
+	}
+
+	void reset()
+	{
+		// Start with enough silence that the first output frame lines up with the first input frame.
+		memset(s_input, 0, sizeof(s_input));
+		s_inputCount = RESAMPLE_TAPS / 2 - 1;
+		s_phase = 0;
+	}
+
+	u32 getMaxSourceFrames()
+	{
+		return RESAMPLE_BLOCK_FRAMES;
+	}
+
+	void resample(f32* output, u32 frames, ResamplerSourceFunc source)
+	{
+		if (s_passthrough)
+		{
+			while (frames)
+			{
+				const u32 count = std::min(frames, u32(RESAMPLE_BLOCK_FRAMES));
+				source(output, count);
+				output += count * 2;
+				frames -= count;
+			}
+			return;
+		}
+
+		while (frames)
+		{
+			const u32 count = std::min(frames, u32(RESAMPLE_BLOCK_FRAMES));
+			// Pull enough input for the last frame of the block.
+			const u32 lastIndex = u32((u64(s_phase) + u64(count - 1) * s_phaseStep) / s_phaseCount);
+			const u32 required = lastIndex + RESAMPLE_TAPS;
+			while (s_inputCount < required)
+			{
+				const u32 sourceCount = std::min(required - s_inputCount, u32(RESAMPLE_BLOCK_FRAMES));
+				source(&s_input[s_inputCount * 2], sourceCount);
+				s_inputCount += sourceCount;
+			}
+
+			u32 index = 0;
+			u32 phase = s_phase;
+			for (u32 i = 0; i < count; i++, output += 2)
+			{
+				const f32* x = &s_input[index * 2];
+				const f32* h = &s_filter[phase * RESAMPLE_TAPS];
+				f32 left = 0.0f, right = 0.0f;
+				for (s32 j = 0; j < RESAMPLE_TAPS; j++, x += 2)
+				{
+					left  += x[0] * h[j];
+					right += x[1] * h[j];
+				}
+				output[0] = left;
+				output[1] = right;
+
+				phase += s_phaseStep;
+				while (phase >= s_phaseCount)
+				{
+					phase -= s_phaseCount;
+					index++;
+				}
+			}
+			s_phase = phase;
+
+			// Keep the unconsumed input, which is at most the filter history.
+			s_inputCount -= index;
+			memmove(s_input, &s_input[index * 2], s_inputCount * 2 * sizeof(f32));
+			frames -= count;
+		}
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Polyphase windowed-sinc resampler.
+// The mixer runs at the original game rate and the result is converted
+// to the output device rate, so the device can run at its native rate
+// rather than relying on the OS to resample.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+
+namespace TFE_AudioResampler
+{
+	// Render 'frames' interleaved stereo frames at the input rate.
+	typedef void(*ResamplerSourceFunc)(f32* buffer, u32 frames);
+
+	// Build the filter for the given rates, returns false if the conversion is not supported.
+	// Only upsampling is supported and matching rates pass the source through unchanged.
+	bool init(u32 inputRate, u32 outputRate);
+	void reset();
+
+	// Maximum number of frames requested from the source at once.
+	u32  getMaxSourceFrames();
+	// Fill 'frames' interleaved stereo frames at the output rate, pulling input from 'source' as needed.
+	void resample(f32* output, u32 frames, ResamplerSourceFunc source);
+}
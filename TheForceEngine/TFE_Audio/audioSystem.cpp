@@ -2,6 +2,7 @@
 
 #include "audioSystem.h"
 #include "audioDevice.h"
+#include "audioResampler.h"
 #include <TFE_System/system.h>
 #include <TFE_System/math.h>
 #include <TFE_Settings/settings.h>
@@ -27,16 +28,16 @@ enum SoundSourceFlags
 	SND_FLAG_ACTIVE   = (1 << 1),
 	SND_FLAG_LOOPING  = (1 << 2),
 	SND_FLAG_PLAYING  = (1 << 3),
-	SND_FLAG_FINISHED = (1 << 4),
 };
 
+// Client side source state, only accessed by the client.
 struct SoundSource
 {
 	SoundType type;
 	f32 volume;
-	u32 sampleIndex;
 	u32 flags;
 	s32 slot;
+	u32 playId;		// Incremented each time the source starts playing.
 
 	// Sound data.
 	const SoundBuffer* buffer;
@@ -47,8 +48,32 @@ struct SoundSource
 	s32 finishedArg = 0;
 };
 
+// Mixer side source state, only accessed on the audio thread.
+struct SoundVoice
+{
+	const SoundBuffer* buffer;
+	f32 volume;
+	u32 sampleIndex;
+	u32 flags;
+	u32 playId;
+};
+
 namespace TFE_Audio
 {
+	enum AudioConstants
+	{
+		// Must be a power of two. This is far more than the clients queue between two callbacks,
+		// so the queue only fills if the audio thread stalls or the device is lost.
+		AUDIO_COMMAND_COUNT = 1024,
+		AUDIO_COMMAND_MASK = AUDIO_COMMAND_COUNT - 1,
+		AUDIO_FLUSH_TIMEOUT_MS = 20,	// Added to two buffer periods.
+		AUDIO_TEST_STALL_MS = 100,
+		// Sources and the audio thread callback are mixed at the original rate and then resampled to the output rate.
+		AUDIO_MIX_RATE = 11025,
+		AUDIO_MIN_BUFFER_SIZE = 64,
+		AUDIO_MAX_BUFFER_SIZE = 4096,
+	};
+
 	static const f32 c_channelLimit  = 1.0f;
 	static const f32 c_soundHeadroom = 0.7f;
 
@@ -56,47 +81,85 @@ namespace TFE_Audio
 	static f32 s_soundFxVolume = 1.0f;
 
 	static u32 s_sourceCount;
+	// Play ids are global so they stay unique when the sources are reset, 0 is never used.
+	static u32 s_nextPlayId = 0;
 	static SoundSource s_sources[MAX_SOUND_SOURCES];
 	static Mutex s_mutex;
-	static bool s_paused = false;
+	static atomic_bool s_paused(false);
 	static bool s_nullDevice = false;
-
+	static u32 s_outputRate = AUDIO_MIX_RATE;
+	static u32 s_bufferSize = 256;
+
+	// Single producer, single consumer command queue - producers are serialized by s_cmdMutex.
+	static AudioCommand s_commands[AUDIO_COMMAND_COUNT];
+	static Mutex s_cmdMutex;
+	static atomic_u32 s_cmdWrite(0);
+	static atomic_u32 s_cmdRead(0);
+	static atomic_u32 s_cmdComplete(0);
+	static bool s_cmdQueueFull = false;	// Only log once while the queue is full.
+
+	// Audio thread state.
 	static AudioThreadCallback s_audioThreadCallback = nullptr;
+	static bool s_mixPaused = false;
+	static SoundVoice s_voices[MAX_SOUND_SOURCES];
+	// The playId of the last sound to finish in each slot, written by the audio thread and consumed by update().
+	static atomic_u32 s_voiceFinished[MAX_SOUND_SOURCES];
+	// Stop requests that could not be queued, the voice is stopped if it is still playing the matching playId.
+	static atomic_u32 s_voiceStopRequest[MAX_SOUND_SOURCES];
+	static atomic_bool s_voiceStopPending(false);
 
 	s32 audioCallback(void *outputBuffer, void* inputBuffer, u32 bufferSize, f64 streamTime, u32 status, void* userData);
 	void setSoundVolumeConsole(const ConsoleArgList& args);
 	void getSoundVolumeConsole(const ConsoleArgList& args);
+	void testCommandQueueConsole(const ConsoleArgList& args);
+	void resetSources();
+	void resetCommands();
+	void mixSource(f32* buffer, u32 frames);
 
 #if AUDIO_TIMING == 1
 	static f64 s_soundIterMaxF = 0.0;
 	static f64 s_soundIterAveF = 0.0;
+	static f64 s_soundResampleAveF = 0.0;
+	static f64 s_soundLoadAveF = 0.0;
+	static u64 s_soundMixTicks = 0;
 	static s32 s_soundIterMax = 0;
 	static s32 s_soundIterAve = 0;
+	static s32 s_soundResampleAve = 0;
+	static s32 s_soundLoadAve = 0;
 #endif
 
 	bool init(bool useNullDevice/*=false*/, s32 outputId/*=-1*/)
 	{
 		TFE_System::logWrite(LOG_MSG, "Startup", "TFE_AudioSystem::init");
-		s_sourceCount = 0u;
 
 		CCMD("setSoundVolume", setSoundVolumeConsole, 1, "Sets the sound volume, range is 0.0 to 1.0");
 		CCMD("getSoundVolume", getSoundVolumeConsole, 0, "Get the current sound volume.");
+		CCMD("audioQueueTest", testCommandQueueConsole, 0, "Fill the audio command queue and verify that a full queue rejects commands without waiting, briefly stalls audio output.");
 
 	#if AUDIO_TIMING == 1
 		TFE_COUNTER(s_soundIterMax, "SoundIterMax-MicroSec");
 		TFE_COUNTER(s_soundIterAve, "SoundIterAve-MicroSec");
+		TFE_COUNTER(s_soundResampleAve, "SoundResampleAve-MicroSec");
+		TFE_COUNTER(s_soundLoadAve, "SoundCallbackLoad-Percent");
 	#endif
 
 		TFE_Settings_Sound* soundSettings = TFE_Settings::getSoundSettings();
 		setVolume(soundSettings->soundFxVolume);
 
-		memset(s_sources, 0, sizeof(SoundSource) * MAX_SOUND_SOURCES);
-		for (s32 i = 0; i < MAX_SOUND_SOURCES; i++)
+		resetSources();
+		resetCommands();
+		s_audioThreadCallback = nullptr;
+
+		s_bufferSize = u32(std::max(s32(AUDIO_MIN_BUFFER_SIZE), std::min(soundSettings->audioBufferSize, s32(AUDIO_MAX_BUFFER_SIZE))));
+		s_outputRate = u32(std::max(soundSettings->audioOutputRate, 0));
+		if (!TFE_AudioResampler::init(AUDIO_MIX_RATE, s_outputRate))
 		{
-			s_sources[i].slot = i;
+			TFE_System::logWrite(LOG_WARNING, "Audio", "Unsupported output sample rate %u, using %u instead.", s_outputRate, u32(AUDIO_MIX_RATE));
+			s_outputRate = AUDIO_MIX_RATE;
+			TFE_AudioResampler::init(AUDIO_MIX_RATE, s_outputRate);
 		}
 
-		bool audDev = TFE_AudioDevice::init(256u, outputId, useNullDevice);
+		bool audDev = TFE_AudioDevice::init(s_bufferSize, outputId, useNullDevice);
 		if (!audDev)
 		{
 			TFE_System::logWrite(LOG_ERROR, "Audio", "Cannot start audio device.");
@@ -104,15 +167,18 @@ namespace TFE_Audio
 			return false;
 		}
 
-		bool audStream = TFE_AudioDevice::startOutput(audioCallback, nullptr, 2u, 11025u);
+		MUTEX_INITIALIZE(&s_mutex);
+		MUTEX_INITIALIZE(&s_cmdMutex);
+		bool audStream = TFE_AudioDevice::startOutput(audioCallback, nullptr, 2u, s_outputRate);
 		if (!audStream)
 		{
 			TFE_System::logWrite(LOG_ERROR, "Audio", "Cannot start audio stream.");
+			MUTEX_DESTROY(&s_mutex);
+			MUTEX_DESTROY(&s_cmdMutex);
 			s_nullDevice = true;
 			return false;
 		}
 
-		MUTEX_INITIALIZE(&s_mutex);
 		s_nullDevice = false;
 		return true;
 	}
@@ -126,20 +192,200 @@ namespace TFE_Audio
 
 		TFE_AudioDevice::destroy();
 		MUTEX_DESTROY(&s_mutex);
+		MUTEX_DESTROY(&s_cmdMutex);
 	}
 
-	void stopAllSounds()
+	void resetSources()
 	{
-		if (s_nullDevice) { return; }
-
-		MUTEX_LOCK(&s_mutex);
 		s_sourceCount = 0u;
 		memset(s_sources, 0, sizeof(SoundSource) * MAX_SOUND_SOURCES);
 		for (s32 i = 0; i < MAX_SOUND_SOURCES; i++)
 		{
 			s_sources[i].slot = i;
 		}
-		MUTEX_UNLOCK(&s_mutex);
+	}
+
+	void resetCommands()
+	{
+		// Only called when the audio thread is not running.
+		memset(s_voices, 0, sizeof(SoundVoice) * MAX_SOUND_SOURCES);
+		for (s32 i = 0; i < MAX_SOUND_SOURCES; i++)
+		{
+			s_voiceFinished[i].store(0);
+			s_voiceStopRequest[i].store(0);
+		}
+		s_voiceStopPending.store(false);
+		s_cmdWrite.store(0);
+		s_cmdRead.store(0);
+		s_cmdComplete.store(0);
+		s_cmdQueueFull = false;
+	}
+
+	//////////////////////////////////////////////////
+	// Command Queue
+	//////////////////////////////////////////////////
+	bool queueCommand(const AudioCommand& cmd)
+	{
+		if (s_nullDevice) { return false; }
+
+		MUTEX_LOCK(&s_cmdMutex);
+		const u32 write = s_cmdWrite.load(std::memory_order_relaxed);
+		// Never wait for the audio thread here, the callers may hold the audio lock.
+		if (write - s_cmdRead.load(std::memory_order_acquire) >= AUDIO_COMMAND_COUNT)
+		{
+			const bool logError = !s_cmdQueueFull;
+			s_cmdQueueFull = true;
+			MUTEX_UNLOCK(&s_cmdMutex);
+			if (logError)
+			{
+				TFE_System::logWrite(LOG_ERROR, "Audio", "The audio command queue is full, the audio thread is not responding. Dropping commands.");
+			}
+			return false;
+		}
+		s_cmdQueueFull = false;
+		s_commands[write & AUDIO_COMMAND_MASK] = cmd;
+		s_cmdWrite.store(write + 1, std::memory_order_release);
+		MUTEX_UNLOCK(&s_cmdMutex);
+		return true;
+	}
+
+	void flushCommands()
+	{
+		if (s_nullDevice) { return; }
+
+		// The commands are executed by the next callback or the one after it, so only wait for two buffer periods.
+		// Waiting longer does not help if the device has stalled or been lost.
+		const u32 target = s_cmdWrite.load(std::memory_order_acquire);
+		const s32 timeoutMs = AUDIO_FLUSH_TIMEOUT_MS + s32(2000 * s_bufferSize / s_outputRate);
+		for (s32 i = 0; i < timeoutMs; i++)
+		{
+			if (s32(s_cmdComplete.load(std::memory_order_acquire) - target) >= 0)
+			{
+				return;
+			}
+			TFE_System::sleep(1);
+		}
+		TFE_System::logWrite(LOG_WARNING, "Audio", "Timed out waiting for the audio thread to execute commands.");
+	}
+
+	// Called on the audio thread.
+	void executeStopRequests()
+	{
+		if (!s_voiceStopPending.exchange(false)) { return; }
+
+		SoundVoice* voice = s_voices;
+		for (s32 i = 0; i < MAX_SOUND_SOURCES; i++, voice++)
+		{
+			const u32 playId = s_voiceStopRequest[i].exchange(0u);
+			if (playId && voice->playId == playId)
+			{
+				voice->flags = 0;
+				voice->buffer = nullptr;
+			}
+		}
+	}
+
+	// Called on the audio thread.
+	u32 executeCommands()
+	{
+		const u32 write = s_cmdWrite.load(std::memory_order_acquire);
+		u32 read = s_cmdRead.load(std::memory_order_relaxed);
+		for (; read != write; read++)
+		{
+			const AudioCommand* cmd = &s_commands[read & AUDIO_COMMAND_MASK];
+			cmd->func(cmd);
+		}
+		s_cmdRead.store(read, std::memory_order_release);
+		return read;
+	}
+
+	void cmdPlayVoice(const AudioCommand* cmd)
+	{
+		SoundVoice* voice = &s_voices[cmd->args[0]];
+		voice->buffer = (const SoundBuffer*)cmd->data;
+		voice->volume = cmd->value;
+		voice->flags = SND_FLAG_PLAYING | u32(cmd->args[2]);
+		voice->playId = u32(cmd->args[1]);
+		voice->sampleIndex = 0u;
+	}
+
+	void cmdStopVoice(const AudioCommand* cmd)
+	{
+		SoundVoice* voice = &s_voices[cmd->args[0]];
+		voice->flags = 0;
+		voice->buffer = nullptr;
+	}
+
+	void cmdSetVoiceVolume(const AudioCommand* cmd)
+	{
+		s_voices[cmd->args[0]].volume = cmd->value;
+	}
+
+	void cmdSetVoiceBuffer(const AudioCommand* cmd)
+	{
+		SoundVoice* voice = &s_voices[cmd->args[0]];
+		voice->buffer = (const SoundBuffer*)cmd->data;
+		voice->sampleIndex = 0u;
+		if (!voice->buffer)
+		{
+			voice->flags = 0;
+		}
+	}
+
+	void cmdStopAllVoices(const AudioCommand* cmd)
+	{
+		memset(s_voices, 0, sizeof(SoundVoice) * MAX_SOUND_SOURCES);
+	}
+
+	void cmdSetCallback(const AudioCommand* cmd)
+	{
+		s_audioThreadCallback = (AudioThreadCallback)cmd->data;
+	}
+
+	bool queueVoiceCommand(AudioCommandFunc func, const SoundSource* source)
+	{
+		AudioCommand cmd = {};
+		cmd.func = func;
+		cmd.data = (void*)source->buffer;
+		cmd.args[0] = source->slot;
+		cmd.args[1] = s32(source->playId);
+		cmd.args[2] = s32(source->flags & SND_FLAG_LOOPING);
+		cmd.value = source->volume;
+		return queueCommand(cmd);
+	}
+
+	// Stops must never be lost, otherwise a looping voice would play forever.
+	// If the command cannot be queued, fall back to a per-slot request that the audio thread checks every callback.
+	void queueStopVoice(const SoundSource* source)
+	{
+		if (!queueVoiceCommand(cmdStopVoice, source))
+		{
+			s_voiceStopRequest[source->slot].store(source->playId);
+			s_voiceStopPending.store(true);
+		}
+	}
+
+	//////////////////////////////////////////////////
+	// Client API
+	//////////////////////////////////////////////////
+	void stopAllSounds()
+	{
+		if (s_nullDevice) { return; }
+
+		AudioCommand cmd = {};
+		cmd.func = cmdStopAllVoices;
+		if (!queueCommand(cmd))
+		{
+			for (u32 s = 0; s < s_sourceCount; s++)
+			{
+				if (s_sources[s].flags & SND_FLAG_PLAYING)
+				{
+					s_voiceStopRequest[s].store(s_sources[s].playId);
+				}
+			}
+			s_voiceStopPending.store(true);
+		}
+		resetSources();
 	}
 
 	void selectDevice(s32 id)
@@ -151,11 +397,38 @@ namespace TFE_Audio
 
 		if (id != TFE_AudioDevice::getOutputDeviceId() && id >= 0 && id < TFE_AudioDevice::getOutputDeviceCount())
 		{
+			AudioThreadCallback callback = s_audioThreadCallback;
 			shutdown();
 			init(false, id);
+			setAudioThreadCallback(callback);
 		}
 	}
 
+	void setOutputFormat(u32 outputRate, u32 bufferSize)
+	{
+		if (outputRate == s_outputRate && bufferSize == s_bufferSize) { return; }
+
+		TFE_Settings_Sound* soundSettings = TFE_Settings::getSoundSettings();
+		soundSettings->audioOutputRate = s32(outputRate);
+		soundSettings->audioBufferSize = s32(bufferSize);
+
+		const s32 outputId = TFE_AudioDevice::getOutputDeviceId();
+		AudioThreadCallback callback = s_audioThreadCallback;
+		shutdown();
+		init(false, outputId);
+		setAudioThreadCallback(callback);
+	}
+
+	u32 getOutputRate()
+	{
+		return s_outputRate;
+	}
+
+	u32 getBufferSize()
+	{
+		return s_bufferSize;
+	}
+
 	void setVolume(f32 volume)
 	{
 		s_soundFxVolume = volume;
@@ -180,9 +453,15 @@ namespace TFE_Audio
 	{
 		if (s_nullDevice) { return; }
 
-		MUTEX_LOCK(&s_mutex);
-		s_audioThreadCallback = callback;
-		MUTEX_UNLOCK(&s_mutex);
+		AudioCommand cmd = {};
+		cmd.func = cmdSetCallback;
+		cmd.data = (void*)callback;
+		queueCommand(cmd);
+		// Make sure the previous callback is no longer in use before the client tears down its state.
+		if (!callback)
+		{
+			flushCommands();
+		}
 	}
 
 	const OutputDeviceInfo* getOutputDeviceList(s32& count, s32& curOutput)
@@ -202,30 +481,39 @@ namespace TFE_Audio
 		MUTEX_UNLOCK(&s_mutex);
 	}
 
-	// One shot, play and forget. Only do this if the client needs no control until stopAllSounds() is called.
-	// Note that looping one shots are valid.
-	bool playOneShot(SoundType type, f32 volume, const SoundBuffer* buffer, bool looping, SoundFinishedCallback finishedCallback, void* cbUserData, s32 cbArg)
+	u32 nextPlayId()
 	{
-		if (!buffer || s_nullDevice) { return false; }
+		s_nextPlayId++;
+		if (!s_nextPlayId) { s_nextPlayId++; }
+		return s_nextPlayId;
+	}
 
-		MUTEX_LOCK(&s_mutex);
+	SoundSource* allocSource()
+	{
 		// Find the first inactive source.
 		SoundSource* snd = s_sources;
-		SoundSource* newSource = nullptr;
 		for (u32 s = 0; s < s_sourceCount; s++, snd++)
 		{
 			if (!(snd->flags&SND_FLAG_ACTIVE))
 			{
-				newSource = snd;
-				break;
+				return snd;
 			}
 		}
-		if (!newSource && s_sourceCount < MAX_SOUND_SOURCES)
+		if (s_sourceCount < MAX_SOUND_SOURCES)
 		{
-			newSource = &s_sources[s_sourceCount];
 			s_sourceCount++;
+			return &s_sources[s_sourceCount - 1];
 		}
+		return nullptr;
+	}
 
+	// One shot, play and forget. Only do this if the client needs no control until stopAllSounds() is called.
+	// Note that looping one shots are valid.
+	bool playOneShot(SoundType type, f32 volume, const SoundBuffer* buffer, bool looping, SoundFinishedCallback finishedCallback, void* cbUserData, s32 cbArg)
+	{
+		if (!buffer || s_nullDevice) { return false; }
+
+		SoundSource* newSource = allocSource();
 		if (newSource)
 		{
 			newSource->type = type;
@@ -236,13 +524,18 @@ namespace TFE_Audio
 			}
 			newSource->volume = type == SOUND_3D ? 0.0f : volume;
 			newSource->buffer = buffer;
-			newSource->sampleIndex = 0u;
+			newSource->playId = nextPlayId();
 			newSource->finishedCallback = finishedCallback;
 			newSource->finishedUserData = cbUserData;
 			newSource->finishedArg = cbArg;
+			// The audio thread never sees the source if the command is dropped, so it would never finish.
+			if (!queueVoiceCommand(cmdPlayVoice, newSource))
+			{
+				newSource->flags = 0;
+				newSource->buffer = nullptr;
+				return false;
+			}
 		}
-		MUTEX_UNLOCK(&s_mutex);
-
 		return newSource != nullptr;
 	}
 
@@ -252,36 +545,16 @@ namespace TFE_Audio
 		if (!buffer || s_nullDevice) { return nullptr; }
 		assert(volume >= 0.0f && volume <= 1.0f);
 
-		MUTEX_LOCK(&s_mutex);
-		// Find the first inactive source.
-		SoundSource* snd = s_sources;
-		SoundSource* newSource = nullptr;
-		for (u32 s = 0; s < s_sourceCount; s++, snd++)
-		{
-			if (!(snd->flags&SND_FLAG_ACTIVE))
-			{
-				newSource = snd;
-				break;
-			}
-		}
-		if (!newSource && s_sourceCount < MAX_SOUND_SOURCES)
-		{
-			newSource = &s_sources[s_sourceCount];
-			s_sourceCount++;
-		}
-
+		SoundSource* newSource = allocSource();
 		if (newSource)
 		{
 			newSource->type = type;
 			newSource->flags = SND_FLAG_ACTIVE;
 			newSource->volume = volume;
 			newSource->buffer = buffer;
-			newSource->sampleIndex = 0u;
 			newSource->finishedCallback = callback;
 			newSource->finishedUserData = userData;
 		}
-		MUTEX_UNLOCK(&s_mutex);
-
 		return newSource;
 	}
 
@@ -314,45 +587,44 @@ namespace TFE_Audio
 			return;
 		}
 		
-		MUTEX_LOCK(&s_mutex);
-			source->flags |= SND_FLAG_PLAYING;
-			if (looping) { source->flags |= SND_FLAG_LOOPING; }
-			source->sampleIndex = 0u;
-		MUTEX_UNLOCK(&s_mutex);
+		source->flags |= SND_FLAG_PLAYING;
+		if (looping) { source->flags |= SND_FLAG_LOOPING; }
+		source->playId = nextPlayId();
+		if (!queueVoiceCommand(cmdPlayVoice, source))
+		{
+			source->flags &= ~(SND_FLAG_PLAYING | SND_FLAG_LOOPING);
+		}
 	}
 
 	void stopSource(SoundSource* source)
 	{
 		if (!source || s_nullDevice) { return; }
-		MUTEX_LOCK(&s_mutex);
-			source->flags &= ~SND_FLAG_PLAYING;
-		MUTEX_UNLOCK(&s_mutex);
+		source->flags &= ~SND_FLAG_PLAYING;
+		queueStopVoice(source);
 	}
 	
 	void freeSource(SoundSource* source)
 	{
 		if (!source || s_nullDevice) { return; }
-		MUTEX_LOCK(&s_mutex);
-			source->flags &= ~SND_FLAG_PLAYING;
-			source->flags &= ~SND_FLAG_ACTIVE;
-			source->buffer = nullptr;
-		MUTEX_UNLOCK(&s_mutex);
+		source->flags &= ~SND_FLAG_PLAYING;
+		source->flags &= ~SND_FLAG_ACTIVE;
+		source->buffer = nullptr;
+		queueStopVoice(source);
 	}
 
 	void setSourceVolume(SoundSource* source, f32 volume)
 	{
 		if (s_nullDevice) { return; }
 		source->volume = std::max(0.0f, std::min(1.0f, volume));
+		queueVoiceCommand(cmdSetVoiceVolume, source);
 	}
 
 	// This will restart the sound and change the buffer.
 	void setSourceBuffer(SoundSource* source, const SoundBuffer* buffer)
 	{
 		if (s_nullDevice) { return; }
-		MUTEX_LOCK(&s_mutex);
-			source->sampleIndex = 0u;
-			source->buffer = buffer;
-		MUTEX_UNLOCK(&s_mutex);
+		source->buffer = buffer;
+		queueVoiceCommand(cmdSetVoiceBuffer, source);
 	}
 
 	bool isSourcePlaying(SoundSource* source)
@@ -367,28 +639,35 @@ namespace TFE_Audio
 		return source->volume;
 	}
 
-	// Internal
-	static const f32 c_scale[] = { 2.0f / 255.0f, 2.0f / 65535.0f, 1.0f };
-	static const f32 c_offset[] = { -1.0f, -1.0f, 0.0f };
-
-	void cleanupSources()
+	void update()
 	{
-		// call any finished callbacks.
-		for (u32 s = 0; s < s_sourceCount; s++)
+		if (s_nullDevice) { return; }
+
+		// Handle sources that the audio thread has finished playing and call any finished callbacks.
+		SoundSource* snd = s_sources;
+		for (u32 s = 0; s < s_sourceCount; s++, snd++)
 		{
-			if (s_sources[s].flags&SND_FLAG_FINISHED)
+			const u32 finishedId = s_voiceFinished[s].exchange(0u);
+			// Ignore sounds that have been restarted or stopped since.
+			if (!finishedId || finishedId != snd->playId || !(snd->flags & SND_FLAG_PLAYING))
 			{
-				s_sources[s].flags = 0;
-				s_sources[s].buffer = nullptr;
-				if (s_sources[s].finishedCallback)
-				{
-					s_sources[s].finishedCallback(s_sources[s].finishedUserData, s_sources[s].finishedArg);
-				}
+				continue;
+			}
+
+			snd->flags &= ~SND_FLAG_PLAYING;
+			if (snd->flags & SND_FLAG_ONE_SHOT)
+			{
+				snd->flags = 0;
+				snd->buffer = nullptr;
+			}
+			if (snd->finishedCallback)
+			{
+				snd->finishedCallback(snd->finishedUserData, snd->finishedArg);
 			}
 		}
 
+		// Shrink the number of sources until an active source is found.
 		const s32 end = (s32)s_sourceCount - 1;
-		//shrink the number of sources until an active source is found.
 		for (s32 s = end; s >= 0; s--)
 		{
 			if (s_sources[s].flags&SND_FLAG_ACTIVE)
@@ -398,6 +677,18 @@ namespace TFE_Audio
 			s_sourceCount--;
 		}
 	}
+
+	// Internal
+	static const f32 c_scale[] = { 2.0f / 255.0f, 2.0f / 65535.0f, 1.0f };
+	static const f32 c_offset[] = { -1.0f, -1.0f, 0.0f };
+
+	void finishVoice(s32 slot, SoundVoice* voice)
+	{
+		voice->flags = 0;
+		voice->buffer = nullptr;
+		voice->sampleIndex = 0u;
+		s_voiceFinished[slot].store(voice->playId);
+	}
 		
 	f32 sampleBuffer(u32 index, SoundDataType type, const u8* data)
 	{
@@ -412,21 +703,21 @@ namespace TFE_Audio
 		return sampleValue * c_scale[type] + c_offset[type];
 	}
 
-	// Audio callback
-	s32 audioCallback(void *outputBuffer, void* inputBuffer, u32 bufferSize, f64 streamTime, u32 status, void* userData)
+	// Mix the sources and the audio thread callback at AUDIO_MIX_RATE, called by the resampler as input is needed.
+	void mixSource(f32* buffer, u32 bufferSize)
 	{
-		f32* buffer = (f32*)outputBuffer;
+		f32* outputBuffer = buffer;
 
 	#if AUDIO_TIMING == 1
-		u64 soundIterStart = TFE_System::getCurrentTimeInTicks();
+		u64 mixStart = TFE_System::getCurrentTimeInTicks();
 	#endif
 
 		// First clear samples
 		memset(buffer, 0, sizeof(f32)*bufferSize*2);
-			   
-		MUTEX_LOCK(&s_mutex);
+
 		// Then call the audio thread callback
-		if (s_audioThreadCallback && !s_paused)
+		const bool paused = s_mixPaused;
+		if (s_audioThreadCallback && !paused)
 		{
 			s_audioThreadCallback(buffer, bufferSize, s_soundFxVolume * c_soundHeadroom);
 		}
@@ -434,8 +725,8 @@ namespace TFE_Audio
 		// Then loop through the sources.
 		// Note: this is no longer used by Dark Forces. However I decided to keep direct sound support around
 		// so it can be used for tools.
-		SoundSource* snd = s_sources;
-		for (u32 s = 0; s < s_sourceCount && !s_paused; s++, snd++)
+		SoundVoice* snd = s_voices;
+		for (s32 s = 0; s < MAX_SOUND_SOURCES && !paused; s++, snd++)
 		{
 			if (!(snd->flags&SND_FLAG_PLAYING)) { continue; }
 			assert(snd->buffer->data);
@@ -454,9 +745,7 @@ namespace TFE_Audio
 					}
 					else
 					{
-						snd->flags &= ~SND_FLAG_PLAYING;
-						snd->flags |= SND_FLAG_FINISHED;
-						snd->sampleIndex = 0u;
+						finishVoice(s, snd);
 					}
 				}
 				continue;
@@ -476,9 +765,7 @@ namespace TFE_Audio
 					}
 					else
 					{
-						snd->flags &= ~SND_FLAG_PLAYING;
-						snd->flags |= SND_FLAG_FINISHED;
-						snd->sampleIndex = 0u;
+						finishVoice(s, snd);
 						break;
 					}
 				}
@@ -496,9 +783,6 @@ namespace TFE_Audio
 				snd->sampleIndex = sIndex;
 			}
 		}
-		// Cleanup sound sources while we are still in the mutex.
-		cleanupSources();
-		MUTEX_UNLOCK(&s_mutex);
 
 		// Finally handle out of range audio samples.
 		buffer = (f32*)outputBuffer;
@@ -524,14 +808,47 @@ namespace TFE_Audio
 		#endif
 		}
 
+	#if AUDIO_TIMING == 1
+		s_soundMixTicks += TFE_System::getCurrentTimeInTicks() - mixStart;
+	#endif
+	}
+
+	// Audio callback
+	s32 audioCallback(void *outputBuffer, void* inputBuffer, u32 bufferSize, f64 streamTime, u32 status, void* userData)
+	{
+		TFE_THREAD_NAME("Audio");
+		TFE_ZONE("Audio Callback");
+	#if AUDIO_TIMING == 1
+		u64 soundIterStart = TFE_System::getCurrentTimeInTicks();
+		s_soundMixTicks = 0;
+	#endif
+
+		// Apply the commands queued since the last callback, no locks are taken on the audio thread.
+		const u32 cmdComplete = executeCommands();
+		executeStopRequests();
+		s_mixPaused = s_paused;
+
+		// Mix at the original rate and convert to the output rate.
+		TFE_AudioResampler::resample((f32*)outputBuffer, bufferSize, mixSource);
+
+		// Let flushCommands() know that the commands have been applied and the callback is done with any previous state.
+		s_cmdComplete.store(cmdComplete, std::memory_order_release);
+
 		// Timing
 	#if AUDIO_TIMING == 1
 		u64 soundIterEnd = TFE_System::getCurrentTimeInTicks();
 		f64 soundIterDeltaMS = 1000000.0 * TFE_System::convertFromTicksToSeconds(soundIterEnd - soundIterStart);
+		f64 soundResampleDeltaMS = soundIterDeltaMS - 1000000.0 * TFE_System::convertFromTicksToSeconds(s_soundMixTicks);
+		// Percentage of the buffer duration spent in the callback.
+		f64 soundLoad = 100.0 * soundIterDeltaMS * f64(s_outputRate) / (1000000.0 * f64(bufferSize));
 		s_soundIterAveF = soundIterDeltaMS * 0.01 + s_soundIterAveF * 0.99;
 		s_soundIterMaxF = std::max(s_soundIterMaxF, soundIterDeltaMS);
+		s_soundResampleAveF = soundResampleDeltaMS * 0.01 + s_soundResampleAveF * 0.99;
+		s_soundLoadAveF = soundLoad * 0.01 + s_soundLoadAveF * 0.99;
 		s_soundIterAve = s32(s_soundIterAveF);
 		s_soundIterMax = s32(s_soundIterMaxF);
+		s_soundResampleAve = s32(s_soundResampleAveF);
+		s_soundLoadAve = s32(s_soundLoadAveF);
 	#endif
 		
 		return 0;
@@ -555,4 +872,72 @@ namespace TFE_Audio
 		sprintf(res, "Sound Volume: %2.3f", s_soundFxVolume);
 		TFE_Console::addToHistory(res);
 	}
+
+	//////////////////////////////////////////////////
+	// Command Queue Test
+	//////////////////////////////////////////////////
+	static atomic_bool s_testStalled(false);
+	static atomic_u32 s_testExecuted(0);
+
+	// Holds up the audio thread so the queue fills, the read index is not advanced until the command returns.
+	void cmdTestStall(const AudioCommand* cmd)
+	{
+		s_testStalled.store(true);
+		TFE_System::sleep(AUDIO_TEST_STALL_MS);
+	}
+
+	void cmdTestCount(const AudioCommand* cmd)
+	{
+		s_testExecuted++;
+	}
+
+	bool testCommandQueue()
+	{
+		if (s_nullDevice) { return false; }
+
+		s_testStalled.store(false);
+		s_testExecuted.store(0);
+
+		AudioCommand cmd = {};
+		cmd.func = cmdTestStall;
+		if (!queueCommand(cmd)) { return false; }
+		for (s32 i = 0; i < AUDIO_TEST_STALL_MS && !s_testStalled.load(); i++)
+		{
+			TFE_System::sleep(1);
+		}
+		if (!s_testStalled.load())
+		{
+			TFE_System::logWrite(LOG_ERROR, "Audio", "Command queue test: the audio thread is not running.");
+			return false;
+		}
+
+		// The stall command still holds a slot, so the queue is full after AUDIO_COMMAND_COUNT - 1 commands.
+		cmd.func = cmdTestCount;
+		const u32 count = AUDIO_COMMAND_COUNT - 1;
+		for (u32 i = 0; i < count; i++)
+		{
+			if (!queueCommand(cmd))
+			{
+				TFE_System::logWrite(LOG_ERROR, "Audio", "Command queue test: command %u was dropped before the queue was full.", i);
+				return false;
+			}
+		}
+		// A full queue must fail right away instead of waiting for the audio thread.
+		const u64 start = TFE_System::getCurrentTimeInTicks();
+		const bool overflowQueued = queueCommand(cmd);
+		const f64 overflowMs = 1000.0 * TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - start);
+
+		TFE_System::sleep(AUDIO_TEST_STALL_MS);
+		flushCommands();
+
+		const u32 executed = s_testExecuted.load();
+		TFE_System::logWrite(LOG_MSG, "Audio", "Command queue test: overflow rejected: %s in %.3f ms, executed %u of %u commands.",
+			overflowQueued ? "no" : "yes", overflowMs, executed, count);
+		return !overflowQueued && overflowMs < 5.0 && executed == count;
+	}
+
+	void testCommandQueueConsole(const ConsoleArgList& args)
+	{
+		TFE_Console::addToHistory(testCommandQueue() ? "Audio command queue test passed." : "Audio command queue test FAILED, see the log.");
+	}
 }
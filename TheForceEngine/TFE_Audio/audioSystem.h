@@ -47,6 +47,19 @@ enum SoundType
 typedef void (*SoundFinishedCallback)(void* userData, s32 arg);
 typedef void (*AudioThreadCallback)(f32* buffer, u32 bufferSize, f32 systemVolume);
 
+// Commands are passed from the client threads to the audio thread through a lock-free queue
+// and are executed, in order, at the start of the next audio callback.
+struct AudioCommand;
+typedef void (*AudioCommandFunc)(const AudioCommand* cmd);
+struct AudioCommand
+{
+	AudioCommandFunc func;
+	void* data;
+	iptr  id;
+	s32   args[4];
+	f32   value;
+};
+
 namespace TFE_Audio
 {
 	// constants
@@ -54,21 +67,45 @@ namespace TFE_Audio
 	// The system smoothly interpolates between the extremes.
 	static const f32 c_closeDistance = 20.0f;
 	static const f32 c_clipDistance = 140.0f;
+	// Output formats offered to the user. Audio is mixed at the original 11025 Hz and resampled to the output rate.
+	static const u32 c_outputRates[] = { 11025, 22050, 44100, 48000, 96000 };
+	static const u32 c_outputBufferSizes[] = { 64, 128, 256, 512, 1024, 2048 };
 
 	// functions
 	bool init(bool useNullDevice=false, s32 outputId=-1);
 	void shutdown();
 	void stopAllSounds();
 	void selectDevice(s32 id);
+	// Restart the output stream with a new sample rate and buffer size (in frames), the settings are updated to match.
+	void setOutputFormat(u32 outputRate, u32 bufferSize);
+	u32  getOutputRate();
+	u32  getBufferSize();
 
 	void setVolume(f32 volume);
 	f32  getVolume();
 	void pause();
 	void resume();
 
+	// Serializes clients that modify audio state from multiple threads (such as the game and midi threads).
+	// This is never held by the audio thread, changes are passed to the audio thread using queueCommand().
 	void lock();
 	void unlock();
 
+	// Queue a command to be executed on the audio thread, this never waits for the audio thread.
+	// Returns false if the command was dropped because the queue is full (the audio thread stopped responding),
+	// the caller must handle this.
+	bool queueCommand(const AudioCommand& cmd);
+	// Wait until all commands queued so far have been executed and the audio callback that executed them has finished.
+	// Gives up after about two buffer periods, in case the device has stalled. Do not call while holding the audio lock.
+	void flushCommands();
+	// Call once per frame from the main thread, handles sources that have finished playing.
+	void update();
+	// Fill the command queue while the audio thread is held up, verify that a full queue rejects commands without
+	// waiting and that every accepted command is executed.
+	// This stalls audio output briefly, it is meant for testing (see the "audioQueueTest" console command).
+	bool testCommandQueue();
+
+	// Note that clearing the callback waits for the audio thread, so the callback is never called after this returns.
 	void setAudioThreadCallback(AudioThreadCallback callback = nullptr);
 	const OutputDeviceInfo* getOutputDeviceList(s32& count, s32& curOutput);
 
@@ -3,6 +3,7 @@
 #include "audioDevice.h"
 #include <TFE_Asset/gmidAsset.h>
 #include <TFE_System/system.h>
+#include <TFE_System/profiler.h>
 #include <TFE_System/Threads/thread.h>
 #include <TFE_Settings/settings.h>
 #include <TFE_FrontEndUI/console.h>
@@ -73,14 +74,23 @@ namespace TFE_MidiPlayer
 	void setMusicVolumeConsole(const ConsoleArgList& args);
 	void getMusicVolumeConsole(const ConsoleArgList& args);
 
-	bool init(s32 midiDeviceIndex)
+	bool init(s32 midiDeviceIndex, bool useNullDevice/*=false*/)
 	{
 		TFE_System::logWrite(LOG_MSG, "Startup", "TFE_MidiPlayer::init");
 
-		bool res = TFE_MidiDevice::init();
-		if (!TFE_MidiDevice::selectDevice(midiDeviceIndex))
+		bool res = true;
+		if (useNullDevice)
 		{
-			TFE_MidiDevice::selectDevice(0);
+			// Messages are dropped by TFE_MidiDevice when there is no output.
+			TFE_System::logWrite(LOG_MSG, "MidiPlayer", "Using the null midi device.");
+		}
+		else
+		{
+			res = TFE_MidiDevice::init();
+			if (!TFE_MidiDevice::selectDevice(midiDeviceIndex))
+			{
+				TFE_MidiDevice::selectDevice(0);
+			}
 		}
 		s_runMusicThread.store(true);
 
@@ -323,6 +333,7 @@ namespace TFE_MidiPlayer
 	// Thread Function
 	TFE_THREADRET midiUpdateFunc(void* userData)
 	{
+		TFE_THREAD_NAME("Midi");
 		bool runThread  = true;
 		bool wasPlaying = false;
 		bool isPlaying  = false;
@@ -374,6 +385,7 @@ namespace TFE_MidiPlayer
 				s_midiCallback.accumulator += TFE_System::updateThreadLocal(&localTimeCallback);
 				while (s_midiCallback.callback && s_midiCallback.accumulator >= s_midiCallback.timeStep)
 				{
+					TFE_ZONE("Midi Callback");
 					s_midiCallback.callback();
 					s_midiCallback.accumulator -= s_midiCallback.timeStep;
 					s_curNoteTime += s_midiCallback.timeStep;
@@ -4,7 +4,8 @@ struct GMidiAsset;
 
 namespace TFE_MidiPlayer
 {
-	bool init(s32 midiDeviceIndex);
+	// useNullDevice: no midi device is opened, music is still sequenced but not heard.
+	bool init(s32 midiDeviceIndex, bool useNullDevice = false);
 	void destroy();
 	
 	///////////////////////////////////////////////////////////
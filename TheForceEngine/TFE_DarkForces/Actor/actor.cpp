@@ -169,7 +169,7 @@ namespace TFE_DarkForces
 		
 	void actor_createTask()
 	{
-		s_istate.actorDispatch = allocator_create(sizeof(ActorDispatch));
+		s_istate.actorDispatch = allocator_create(sizeof(ActorDispatch), nullptr, ALLOC_SLAB_LARGE);
 		s_istate.actorTask = createSubTask("actor", actorLogicTaskFunc, actorLogicMsgFunc);
 		s_istate.actorPhysicsTask = createSubTask("physics", actorPhysicsTaskFunc);
 	}
@@ -521,17 +521,13 @@ namespace TFE_DarkForces
 			}
 
 			SecObject** objList = sector->objectList;
-			for (s32 i = 0, idx = 0; i < sector->objectCount && idx < sector->objectCapacity; idx++)
+			for (s32 i = 0; i < sector->objectCount; i++)
 			{
-				SecObject* obj = objList[idx];
-				if (obj)
+				SecObject* obj = objList[i];
+				if ((obj->entityFlags & ETFLAG_CORPSE) && !(obj->entityFlags & ETFLAG_KEEP_CORPSE) && !actor_canSeeObject(obj, s_playerObject))
 				{
-					if ((obj->entityFlags & ETFLAG_CORPSE) && !(obj->entityFlags & ETFLAG_KEEP_CORPSE) && !actor_canSeeObject(obj, s_playerObject))
-					{
-						freeObject(obj);
-						return;
-					}
-					i++;
+					freeObject(obj);
+					return;
 				}
 			}
 		}
@@ -1563,6 +1559,14 @@ namespace TFE_DarkForces
 
 	JBool actor_canSeeObject(SecObject* actorObj, SecObject* obj)
 	{
+		// TFE: Reject actors in sectors without an open path to the target sector before tracing the rays.
+		// The set of sectors that can reach the target is shared by all actors until the target moves to another
+		// sector or the level geometry changes. This happens after any random() draws, so the results are unchanged.
+		if (!collision_canReachSector(actorObj->sector, obj->sector))
+		{
+			return JFALSE;
+		}
+
 		vec3_fixed p0 = { actorObj->posWS.x, actorObj->posWS.y - actorObj->worldHeight, actorObj->posWS.z };
 		vec3_fixed p1 = { obj->posWS.x, obj->posWS.y, obj->posWS.z };
 		if (collision_canHitObject(actorObj->sector, obj->sector, p0, p1, 0))
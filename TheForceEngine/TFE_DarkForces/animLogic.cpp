@@ -110,7 +110,7 @@ namespace TFE_DarkForces
 		}
 		if (!s_spriteAnimList)
 		{
-			s_spriteAnimList = allocator_create(sizeof(SpriteAnimLogic));
+			s_spriteAnimList = allocator_create(sizeof(SpriteAnimLogic), nullptr, ALLOC_SLAB_LARGE);
 		}
 
 		SpriteAnimLogic* anim = (SpriteAnimLogic*)allocator_newItem(s_spriteAnimList);
@@ -152,7 +152,7 @@ namespace TFE_DarkForces
 			}
 			if (!s_spriteAnimList)
 			{
-				s_spriteAnimList = allocator_create(sizeof(SpriteAnimLogic));
+				s_spriteAnimList = allocator_create(sizeof(SpriteAnimLogic), nullptr, ALLOC_SLAB_LARGE);
 			}
 			task_makeActive(s_spriteAnimTask);
 
@@ -553,19 +553,9 @@ namespace TFE_DarkForces
 		if (s_mapShowSectorMode)
 		{
 			SecObject** objIter = sector->objectList;
-			for (s32 i = 0; i < sector->objectCount; objIter++)
+			for (s32 i = 0; i < sector->objectCount; i++, objIter++)
 			{
-				SecObject* obj = *objIter;
-				while (!obj)
-				{
-					objIter++;
-					obj = *objIter;
-				}
-				if (obj)
-				{
-					automap_drawObject(obj);
-					i++;
-				}
+				automap_drawObject(*objIter);
 			}
 		}
 	}
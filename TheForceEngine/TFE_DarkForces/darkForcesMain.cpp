@@ -45,6 +45,7 @@
 #include <TFE_Archive/gobMemoryArchive.h>
 #include <TFE_Jedi/Level/rfont.h>
 #include <TFE_Jedi/Level/level.h>
+#include <TFE_Jedi/Level/levelData.h>
 #include <TFE_Jedi/InfSystem/infSystem.h>
 #include <TFE_Jedi/Task/task.h>
 #include <TFE_Jedi/Renderer/jediRenderer.h>
@@ -423,6 +424,69 @@ namespace TFE_DarkForces
 		return s_runGameState.state == GSTATE_MISSION;
 	}
 
+	u32 DarkForces::getRandomSeed()
+	{
+		return random_getSeed();
+	}
+
+	void DarkForces::setRandomSeed(u32 seed)
+	{
+		random_seed(seed);
+	}
+
+	u32 DarkForces::getSimTick()
+	{
+		return s_curTick;
+	}
+
+	u32 DarkForces::getSimTickRate()
+	{
+		return TICKS_PER_SECOND;
+	}
+
+	// FNV-1a
+	static u32 hashData(u32 hash, const void* data, size_t size)
+	{
+		const u8* bytes = (const u8*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ bytes[i]) * 16777619u;
+		}
+		return hash;
+	}
+
+	u32 DarkForces::getStateHash()
+	{
+		u32 hash = 2166136261u;
+		const u32 seed = random_getSeed();
+		hash = hashData(hash, &seed, sizeof(u32));
+		hash = hashData(hash, &s_curTick, sizeof(Tick));
+		if (s_runGameState.state != GSTATE_MISSION || !s_levelState.sectors)
+		{
+			return hash;
+		}
+
+		hash = hashData(hash, &s_playerInfo.health, sizeof(s32));
+		hash = hashData(hash, &s_playerInfo.shields, sizeof(s32));
+		// Sector heights cover INF elevators, object positions and orientation cover the player, AI and projectiles.
+		for (u32 s = 0; s < s_levelState.sectorCount; s++)
+		{
+			RSector* sector = &s_levelState.sectors[s];
+			hash = hashData(hash, &sector->floorHeight, sizeof(fixed16_16));
+			hash = hashData(hash, &sector->ceilingHeight, sizeof(fixed16_16));
+
+			SecObject** objectList = sector->objectList;
+			for (s32 i = 0; i < sector->objectCount; i++)
+			{
+				SecObject* obj = objectList[i];
+				hash = hashData(hash, &obj->posWS, sizeof(vec3_fixed));
+				hash = hashData(hash, &obj->yaw, sizeof(angle14_16));
+				hash = hashData(hash, &obj->pitch, sizeof(angle14_16));
+			}
+		}
+		return hash;
+	}
+
 	void DarkForces::getLevelName(char* name)
 	{
 		const char* levelName = agent_getLevelDisplayName();
@@ -1218,6 +1282,8 @@ namespace TFE_DarkForces
 				SERIALIZE(SaveVersionInit, length, 0);
 				if (serialization_getMode() == SMODE_READ)
 				{
+					// Restoring in place, such as a quickload from memory.
+					game_free(s_runGameState.args[i]);
 					s_runGameState.args[i] = (char*)game_alloc(length + 1);
 				}
 				SERIALIZE_BUF(SaveVersionInit, s_runGameState.args[i], length);
@@ -21,6 +21,11 @@ namespace TFE_DarkForces
 		bool isPaused() override;
 		void getLevelName(char* name) override;
 		void getModList(char* modList) override;
+		u32  getRandomSeed() override;
+		void setRandomSeed(u32 seed) override;
+		u32  getStateHash() override;
+		u32  getSimTick() override;
+		u32  getSimTickRate() override;
 	};
 
 	extern void saveLevelStatus();
@@ -260,7 +260,7 @@ namespace TFE_DarkForces
 	void hitEffect_createTask()
 	{
 		hitEffect_clearState();
-		s_hitEffects = allocator_create(sizeof(HitEffect));
+		s_hitEffects = allocator_create(sizeof(HitEffect), nullptr, ALLOC_SLAB_LARGE);
 		s_hitEffectTask = createSubTask("hitEffects", hitEffectTaskFunc);
 	}
 
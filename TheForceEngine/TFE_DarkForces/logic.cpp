@@ -123,7 +123,8 @@ namespace TFE_DarkForces
 			line = parser->readLine(*bufferPos);
 			if (!line) { return JFALSE; }
 
-			s_objSeqArgCount = sscanf(line, " %s %s %s %s %s %s", s_objSeqArg0, s_objSeqArg1, s_objSeqArg2, s_objSeqArg3, s_objSeqArg4, s_objSeqArg5);
+			char* args[] = { s_objSeqArg0, s_objSeqArg1, s_objSeqArg2, s_objSeqArg3, s_objSeqArg4, s_objSeqArg5 };
+			s_objSeqArgCount = TFE_Parser::scanArgs(line, args, TFE_ARRAYSIZE(args), sizeof(s_objSeqArg0));
 			KEYWORD key = getKeywordIndex(s_objSeqArg0);
 			if (key == KW_TYPE || key == KW_LOGIC)
 			{
@@ -24,6 +24,7 @@
 #include <TFE_Jedi/Level/level.h>
 #include <TFE_Jedi/Level/levelData.h>
 #include <TFE_Jedi/InfSystem/infSystem.h>
+#include <TFE_Jedi/Collision/collision.h>
 #include <TFE_Jedi/Renderer/rlimits.h>
 #include <TFE_Jedi/Renderer/jediRenderer.h>
 #include <TFE_Jedi/Renderer/rcommon.h>
@@ -191,6 +192,75 @@ namespace TFE_DarkForces
 		logic_spawnEnemy(args[1].c_str(), args[2].c_str());
 	}
 
+	// Compare parsing the LEV text against the cooked level cache for the levels in the mission list.
+	void console_levelCacheBench(const ConsoleArgList& args)
+	{
+		f64 textTotal = 0.0, cachedTotal = 0.0;
+		char msg[256];
+		for (s32 i = 0; i < s_maxLevelIndex; i++)
+		{
+			f64 textTime, cachedTime;
+			if (!s_levelGamePaths[i] || !level_benchmarkGeometry(s_levelGamePaths[i], &textTime, &cachedTime))
+			{
+				continue;
+			}
+			textTotal += textTime;
+			cachedTotal += cachedTime;
+
+			sprintf(msg, "%-10s text: %7.2f ms, cached: %7.2f ms", s_levelGamePaths[i], textTime * 1000.0, cachedTime * 1000.0);
+			TFE_Console::addToHistory(msg);
+		}
+		sprintf(msg, "%-10s text: %7.2f ms, cached: %7.2f ms", "Total", textTotal * 1000.0, cachedTotal * 1000.0);
+		TFE_Console::addToHistory(msg);
+	}
+
+	// Compare sscanf() and linear keyword lookups against the zero allocation scanner and perfect hash over the INF and O files.
+	void console_parseBench(const ConsoleArgList& args)
+	{
+		const s32 repeatCount = args.size() > 1 ? max(1, atoi(args[1].c_str())) : 10;
+		size_t totalBytes = 0;
+		f64 scanfTotal = 0.0, sliceTotal = 0.0;
+		JBool allMatch = JTRUE;
+		char msg[256];
+		for (s32 i = 0; i < s_maxLevelIndex; i++)
+		{
+			size_t bytes;
+			f64 scanfTime, sliceTime;
+			JBool match;
+			if (!s_levelGamePaths[i] || !level_benchmarkTextParsing(s_levelGamePaths[i], repeatCount, &bytes, &scanfTime, &sliceTime, &match))
+			{
+				continue;
+			}
+			totalBytes += bytes;
+			scanfTotal += scanfTime;
+			sliceTotal += sliceTime;
+			allMatch = (allMatch && match) ? JTRUE : JFALSE;
+
+			sprintf(msg, "%-10s sscanf: %7.2f ms, scanner: %7.2f ms%s", s_levelGamePaths[i], scanfTime * 1000.0, sliceTime * 1000.0, match ? "" : " - results DO NOT MATCH");
+			TFE_Console::addToHistory(msg);
+		}
+		const f64 megabytes = f64(totalBytes) / (1024.0 * 1024.0);
+		sprintf(msg, "%-10s sscanf: %7.2f ms (%.1f MB/s), scanner: %7.2f ms (%.1f MB/s), results %s.", "Total",
+			scanfTotal * 1000.0, scanfTotal > 0.0 ? megabytes / scanfTotal : 0.0,
+			sliceTotal * 1000.0, sliceTotal > 0.0 ? megabytes / sliceTotal : 0.0, allMatch ? "match" : "DO NOT MATCH");
+		TFE_Console::addToHistory(msg);
+	}
+
+	// Compare the original radius query, which visits every sector, against the adjoin walk in the current level.
+	void console_collisionRangeBench(const ConsoleArgList& args)
+	{
+		const s32 queryCount = args.size() > 1 ? max(1, atoi(args[1].c_str())) : 1000;
+		const fixed16_16 range = args.size() > 2 ? floatToFixed16(f32(atof(args[2].c_str()))) : FIXED(30);
+
+		f64 scanTime, adjoinTime;
+		const JBool match = collision_benchmarkRangeQueries(queryCount, range, &scanTime, &adjoinTime);
+
+		char msg[256];
+		sprintf(msg, "%d queries, range %.1f - scan: %.2f ms, adjoin walk: %.2f ms, results %s.", queryCount, fixed16ToFloat(range),
+			scanTime * 1000.0, adjoinTime * 1000.0, match ? "match" : "DO NOT MATCH");
+		TFE_Console::addToHistory(msg);
+	}
+
 	void mission_createDisplay()
 	{
 		vfb_setResolution(320, 200);
@@ -350,6 +420,9 @@ namespace TFE_DarkForces
 			// TFE-specific
 			mission_addCheatCommands();
 			CCMD("spawnEnemy", console_spawnEnemy, 2, "spawnEnemy(waxName, enemyTypeName) - spawns an enemy 8 units away in the player direction. Example: spawnEnemy offcfin.wax i_officer");
+			CCMD("levelCacheBench", console_levelCacheBench, 0, "Compare LEV text parsing against the cooked level cache for every level in the mission list.");
+			CCMD("parseBench", console_parseBench, 0, "Time INF and O parsing for every level in the mission list: parseBench [repeatCount]");
+			CCMD("collisionRangeBench", console_collisionRangeBench, 0, "Time explosion radius queries in the current level: collisionRangeBench [queryCount] [range]");
 
 			// Make sure the loading screen is displayed for at least 1 second.
 			if (!s_loadingFromSave)
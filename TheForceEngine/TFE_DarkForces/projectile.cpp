@@ -149,7 +149,7 @@ namespace TFE_DarkForces
 	void projectile_createTask()
 	{
 		projectile_clearState();
-		s_projectiles = allocator_create(sizeof(ProjectileLogic));
+		s_projectiles = allocator_create(sizeof(ProjectileLogic), nullptr, ALLOC_SLAB_LARGE);
 		s_projectileTask = createSubTask("projectiles", projectileTaskFunc);
 	}
 
@@ -47,4 +47,9 @@ namespace TFE_DarkForces
 	{
 		s_seed = seed;
 	}
+
+	u32 random_getSeed()
+	{
+		return s_seed;
+	}
 }  // TFE_DarkForces
\ No newline at end of file
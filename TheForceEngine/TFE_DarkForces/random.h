@@ -18,4 +18,5 @@ namespace TFE_DarkForces
 	void random_serialize(Stream* stream);
 
 	void random_seed(u32 seed);
+	u32  random_getSeed();
 }  // namespace TFE_DarkForces
\ No newline at end of file
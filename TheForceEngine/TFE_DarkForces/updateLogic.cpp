@@ -80,7 +80,7 @@ namespace TFE_DarkForces
 	{
 		if (!s_logicUpdateList)
 		{
-			s_logicUpdateList = allocator_create(sizeof(UpdateLogic));
+			s_logicUpdateList = allocator_create(sizeof(UpdateLogic), nullptr, ALLOC_SLAB_LARGE);
 		}
 		if (!s_logicUpdateTask)
 		{
@@ -130,7 +130,7 @@ namespace TFE_DarkForces
 		{
 			if (!s_logicUpdateList)
 			{
-				s_logicUpdateList = allocator_create(sizeof(UpdateLogic));
+				s_logicUpdateList = allocator_create(sizeof(UpdateLogic), nullptr, ALLOC_SLAB_LARGE);
 			}
 			if (!s_logicUpdateTask)
 			{
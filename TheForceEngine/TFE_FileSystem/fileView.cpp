@@ -0,0 +1,86 @@
+#include "fileView.h"
+#include "filestream.h"
+#include <TFE_Archive/archive.h>
+
+FileView::FileView() : m_archive(nullptr), m_index(INVALID_FILE), m_data(nullptr), m_size(0)
+{
+}
+
+FileView::~FileView()
+{
+	close();
+}
+
+bool FileView::open(const FilePath* filePath)
+{
+	close();
+	if (!filePath->archive)
+	{
+		return open(filePath->path);
+	}
+	if (filePath->index == INVALID_FILE) { return false; }
+
+	size_t size = 0;
+	const u8* data = filePath->archive->acquireFileView(filePath->index, &size);
+	if (data)
+	{
+		m_archive = filePath->archive;
+		m_index = filePath->index;
+		m_data = data;
+		m_size = size;
+		return true;
+	}
+
+	// The archive does not support views, so read a copy instead.
+	FileStream file;
+	if (!file.open(filePath, Stream::MODE_READ))
+	{
+		return false;
+	}
+	m_buffer.resize(file.getSize());
+	file.readBuffer(m_buffer.data(), (u32)m_buffer.size());
+	file.close();
+
+	m_data = m_buffer.data();
+	m_size = m_buffer.size();
+	return true;
+}
+
+bool FileView::open(const char* path)
+{
+	close();
+	if (m_mappedFile.open(path))
+	{
+		m_data = m_mappedFile.getData();
+		m_size = m_mappedFile.getSize();
+		return true;
+	}
+
+	// Mapping can fail for empty files or unusual file systems, so read a copy instead.
+	FileStream file;
+	if (!file.open(path, Stream::MODE_READ))
+	{
+		return false;
+	}
+	m_buffer.resize(file.getSize());
+	file.readBuffer(m_buffer.data(), (u32)m_buffer.size());
+	file.close();
+
+	m_data = m_buffer.data();
+	m_size = m_buffer.size();
+	return true;
+}
+
+void FileView::close()
+{
+	if (m_archive)
+	{
+		m_archive->releaseFileView(m_index);
+		m_archive = nullptr;
+		m_index = INVALID_FILE;
+	}
+	m_mappedFile.close();
+	m_buffer.clear();
+	m_data = nullptr;
+	m_size = 0;
+}
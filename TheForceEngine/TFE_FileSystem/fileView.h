@@ -0,0 +1,38 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Read-only view of a whole file.
+// Files found with TFE_Paths::getFilePath() can be viewed in place:
+// loose files are memory mapped and archive entries point into the
+// mapped archive (or the decompressed entry for ZIP archives), so
+// loaders that only parse the data can skip the intermediate copy.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include <vector>
+#include "paths.h"
+#include "mappedFile.h"
+
+class Archive;
+
+class FileView
+{
+public:
+	FileView();
+	~FileView();
+
+	bool open(const FilePath* filePath);
+	bool open(const char* path);
+	void close();
+
+	const u8* getData() const { return m_data; }
+	size_t getSize() const { return m_size; }
+
+private:
+	MappedFile m_mappedFile;
+	Archive* m_archive;
+	u32 m_index;
+	// Fallback copy, used when the file cannot be viewed directly.
+	std::vector<u8> m_buffer;
+
+	const u8* m_data;
+	size_t m_size;
+};
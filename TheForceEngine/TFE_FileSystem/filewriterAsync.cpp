@@ -1,99 +1,172 @@
 #include "filewriterAsync.h"
+#include "filestream.h"
 #include <assert.h>
 #include <stdio.h>
 #include <stdarg.h>
-#include <vector>
-
-#ifdef _WIN32
-#define WIN32_LEAN_AND_MEAN 1
-#include <Windows.h>
-#endif
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
 
+// Files are written by a single writer thread, so writes complete in the order they were submitted.
 namespace FileWriterAsync
 {
-#ifdef _WIN32
 	#define MAX_REQUEST_COUNT 32
 
 	struct WriteRequest
 	{
+		std::string path;
 		std::vector<u8> buffer;
-		OVERLAPPED file;
 
 		FileWriteCompletionCallback callback;
+		FileWriteProcessCallback process;
 		void* userData;
 	};
-	WriteRequest s_requests[MAX_REQUEST_COUNT];
-	s32 s_freeRequests[MAX_REQUEST_COUNT];
-	s32 s_processRequest[MAX_REQUEST_COUNT];
 
-	std::atomic<s32> s_requestCount = 0;
-	std::atomic<s32> s_freeRequestCount = 0;
-	std::atomic<s32> s_processRequestCount = 0;
+	// Stops the writer thread on exit, if shutdown() was not called.
+	struct FileWriter
+	{
+		std::thread thread;
+		~FileWriter();
+	};
 
-	void CALLBACK fileWrittenCallback(DWORD dwErrorCode, DWORD dwBytesTransferred, LPOVERLAPPED lpOverlapped)
+	static std::mutex s_mutex;
+	static std::condition_variable s_requestReady;
+	static std::condition_variable s_requestsDone;
+	static std::vector<WriteRequest*> s_requestQueue;
+	static std::vector<WriteRequest*> s_freeRequests;
+	static WriteRequest s_requests[MAX_REQUEST_COUNT];
+	static s32 s_requestCount = 0;
+	static s32 s_pendingCount = 0;
+	static bool s_exit = false;
+	static FileWriter s_writer;
+
+	FileWriter::~FileWriter()
 	{
-		// Note that this won't be called unless the calling thread is waiting in an "alertable" state.
-		const size_t id = (size_t)lpOverlapped->hEvent;
-		WriteRequest& request = s_requests[id];
+		shutdown();
+	}
 
-		if (dwErrorCode == 0 && request.callback)	// Success
+	void processRequest(WriteRequest* request)
+	{
+		u32 errorCode = AFW_SUCCESS;
+		size_t bytesWritten = 0;
+		if (request->process && !request->process(request->buffer, request->userData))
 		{
-			request.callback(size_t(dwBytesTransferred), request.userData, u32(dwErrorCode));
+			errorCode = AFW_PROCESS_FAILED;
 		}
-		else if (request.callback)  // Failure
+		else if (!request->path.empty())
 		{
-			request.callback(0, request.userData, u32(dwErrorCode));
+			FileStream file;
+			if (file.open(request->path.c_str(), Stream::MODE_WRITE))
+			{
+				file.writeBuffer(request->buffer.data(), u32(request->buffer.size()));
+				file.close();
+				bytesWritten = request->buffer.size();
+			}
+			else
+			{
+				TFE_System::logWrite(LOG_ERROR, "AsyncFileWrite", "Cannot write file: %s", request->path.c_str());
+				errorCode = AFW_CANNOT_OPEN_FILE;
+			}
 		}
 
-		request.buffer.clear();
-		s_freeRequests[s_freeRequestCount++] = id;
+		if (request->callback)
+		{
+			request->callback(bytesWritten, request->userData, errorCode);
+		}
 	}
 
-	bool writeFileToDisk(const char* path, u8* data, size_t dataSize, FileWriteCompletionCallback completionCallback, void* userData)
+	void writerThread()
 	{
-		size_t index = 0;
-		if (s_freeRequestCount)
+		std::unique_lock<std::mutex> lock(s_mutex);
+		while (1)
 		{
-			index = s_freeRequests[s_freeRequestCount - 1];
-			s_freeRequestCount--;
+			s_requestReady.wait(lock, [] { return s_exit || !s_requestQueue.empty(); });
+			if (s_requestQueue.empty())
+			{
+				break;
+			}
+
+			WriteRequest* request = s_requestQueue.front();
+			s_requestQueue.erase(s_requestQueue.begin());
+
+			lock.unlock();
+			processRequest(request);
+			lock.lock();
+
+			// Free the memory, large save buffers should not stick around.
+			std::vector<u8>().swap(request->buffer);
+			s_freeRequests.push_back(request);
+			s_pendingCount--;
+			s_requestsDone.notify_all();
+		}
+	}
+
+	bool queueRequest(const char* path, u8* data, size_t dataSize, FileWriteCompletionCallback completionCallback, void* userData, FileWriteProcessCallback processCallback)
+	{
+		std::unique_lock<std::mutex> lock(s_mutex);
+		WriteRequest* request = nullptr;
+		if (!s_freeRequests.empty())
+		{
+			request = s_freeRequests.back();
+			s_freeRequests.pop_back();
 		}
 		else if (s_requestCount < MAX_REQUEST_COUNT)
 		{
-			index = s_requestCount;
+			request = &s_requests[s_requestCount];
 			s_requestCount++;
 		}
 		else
 		{
+			TFE_System::logWrite(LOG_ERROR, "AsyncFileWrite", "Too many pending requests, cannot process: %s", path[0] ? path : "(no file)");
 			return false;
 		}
 
-		WriteRequest* request = &s_requests[index];
-		request->buffer.resize(dataSize);
-		memcpy(request->buffer.data(), data, dataSize);
-
+		request->path = path;
+		request->buffer.assign(data, data + dataSize);
 		request->callback = completionCallback;
+		request->process = processCallback;
 		request->userData = userData;
 
-		HANDLE hFile = CreateFile(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_FLAG_OVERLAPPED, NULL);
-		if (hFile == INVALID_HANDLE_VALUE)
+		if (!s_writer.thread.joinable())
 		{
-			TFE_System::logWrite(LOG_ERROR, "AsyncFileWrite", "Cannot create file handle for: %s", path);
-			return false;
+			s_exit = false;
+			s_writer.thread = std::thread(writerThread);
 		}
+		s_requestQueue.push_back(request);
+		s_pendingCount++;
+		s_requestReady.notify_one();
+		return true;
+	}
 
-		memset(&request->file, 0, sizeof(OVERLAPPED));
-		request->file.Offset = 0;
-		request->file.OffsetHigh = 0;
-		request->file.hEvent = HANDLE(index);
+	bool writeFileToDisk(const char* path, u8* data, size_t dataSize, FileWriteCompletionCallback completionCallback, void* userData, FileWriteProcessCallback processCallback)
+	{
+		return queueRequest(path, data, dataSize, completionCallback, userData, processCallback);
+	}
 
-		if (!WriteFileEx(hFile, request->buffer.data(), DWORD(dataSize), &request->file, fileWrittenCallback))
+	bool processAsync(u8* data, size_t dataSize, FileWriteProcessCallback processCallback, void* userData, FileWriteCompletionCallback completionCallback)
+	{
+		// An empty path skips the write.
+		return queueRequest("", data, dataSize, completionCallback, userData, processCallback);
+	}
+
+	void flush()
+	{
+		std::unique_lock<std::mutex> lock(s_mutex);
+		s_requestsDone.wait(lock, [] { return s_pendingCount == 0; });
+	}
+
+	void shutdown()
+	{
 		{
-			TFE_System::logWrite(LOG_ERROR, "AsyncFileWrite", "Cannot write file: %s", path);
-			return false;
+			std::unique_lock<std::mutex> lock(s_mutex);
+			s_exit = true;
+		}
+		s_requestReady.notify_one();
+		// The writer finishes the queued requests before exiting.
+		if (s_writer.thread.joinable())
+		{
+			s_writer.thread.join();
 		}
-
-		CloseHandle(hFile);
-		return true;
 	}
-#endif
 };
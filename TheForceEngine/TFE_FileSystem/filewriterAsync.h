@@ -1,15 +1,32 @@
 #pragma once
 #include <TFE_System/system.h>
+#include <vector>
 
 // TODO: Flesh out error codes.
 enum AsyncFileWriteCodes
 {
 	AFW_SUCCESS = 0,
+	AFW_PROCESS_FAILED,
+	AFW_CANNOT_OPEN_FILE,
 };
 
+// Called on the writer thread once the file has been written (or failed).
 typedef void(*FileWriteCompletionCallback)(size_t bytesWritten, void* userData, u32 errorCode);
+// Optional callback called on the writer thread before the data is written, it may modify or replace
+// the buffer contents (for example to compress the data). Return false to cancel the write.
+typedef bool(*FileWriteProcessCallback)(std::vector<u8>& buffer, void* userData);
 
 namespace FileWriterAsync
 {
-	bool writeFileToDisk(const char* path, u8* data, size_t dataSize, FileWriteCompletionCallback completionCallback = nullptr, void* userData = nullptr);
+	// The data is copied, so it can be freed or modified as soon as the function returns.
+	bool writeFileToDisk(const char* path, u8* data, size_t dataSize, FileWriteCompletionCallback completionCallback = nullptr, void* userData = nullptr,
+		FileWriteProcessCallback processCallback = nullptr);
+	// Run 'processCallback' on the writer thread without writing a file, in order with the writes.
+	// This is used to move expensive work such as compression off of the main thread. The data is copied.
+	bool processAsync(u8* data, size_t dataSize, FileWriteProcessCallback processCallback, void* userData = nullptr,
+		FileWriteCompletionCallback completionCallback = nullptr);
+	// Wait until all pending writes have completed, call before reading a file that may still be in flight.
+	void flush();
+	// Flush and then stop the writer thread.
+	void shutdown();
 };
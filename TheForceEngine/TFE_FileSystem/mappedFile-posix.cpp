@@ -0,0 +1,57 @@
+#include "mappedFile.h"
+#include <TFE_System/system.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile() : m_data(nullptr), m_size(0), m_fileHandle(nullptr), m_mappingHandle(nullptr)
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const char* path)
+{
+	close();
+
+	const int fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		// Empty files cannot be mapped.
+		::close(fd);
+		return false;
+	}
+
+	void* data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping keeps its own reference to the file.
+	::close(fd);
+	if (data == MAP_FAILED)
+	{
+		TFE_System::logWrite(LOG_ERROR, "MappedFile", "Cannot map '%s'.", path);
+		return false;
+	}
+
+	m_data = (const u8*)data;
+	m_size = (size_t)st.st_size;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data)
+	{
+		munmap((void*)m_data, m_size);
+		m_data = nullptr;
+	}
+	m_size = 0;
+}
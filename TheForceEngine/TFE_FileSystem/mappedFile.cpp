@@ -0,0 +1,78 @@
+#include "mappedFile.h"
+#include <TFE_System/system.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN 1
+#include <Windows.h>
+#endif
+
+MappedFile::MappedFile() : m_data(nullptr), m_size(0), m_fileHandle(nullptr), m_mappingHandle(nullptr)
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const char* path)
+{
+	close();
+
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		// Empty files cannot be mapped.
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		TFE_System::logWrite(LOG_ERROR, "MappedFile", "Cannot create a file mapping for '%s'.", path);
+		CloseHandle(file);
+		return false;
+	}
+
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data)
+	{
+		TFE_System::logWrite(LOG_ERROR, "MappedFile", "Cannot map '%s'.", path);
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	m_data = (const u8*)data;
+	m_size = (size_t)size.QuadPart;
+	m_fileHandle = file;
+	m_mappingHandle = mapping;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data)
+	{
+		UnmapViewOfFile(m_data);
+		m_data = nullptr;
+	}
+	if (m_mappingHandle)
+	{
+		CloseHandle((HANDLE)m_mappingHandle);
+		m_mappingHandle = nullptr;
+	}
+	if (m_fileHandle)
+	{
+		CloseHandle((HANDLE)m_fileHandle);
+		m_fileHandle = nullptr;
+	}
+	m_size = 0;
+}
@@ -0,0 +1,28 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Read-only memory mapped file.
+// The whole file is mapped into the address space so that it can be
+// accessed without copying it into an intermediate buffer.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool open(const char* path);
+	void close();
+
+	bool isOpen() const { return m_data != nullptr; }
+	const u8* getData() const { return m_data; }
+	size_t getSize() const { return m_size; }
+
+private:
+	const u8* m_data;
+	size_t m_size;
+	// Platform handles, unused on some platforms.
+	void* m_fileHandle;
+	void* m_mappingHandle;
+};
@@ -12,6 +12,7 @@
 #include <TFE_System/system.h>
 #include <TFE_System/parser.h>
 #include <TFE_System/frameLimiter.h>
+#include <TFE_System/jobSystem.h>
 #include <TFE_Jedi/IMuse/imuse.h>
 #include <TFE_FileSystem/fileutil.h>
 #include <TFE_FileSystem/paths.h>
@@ -2163,6 +2164,15 @@ namespace TFE_FrontEndUI
 			graphics->asyncFramebuffer = true;
 			graphics->gpuColorConvert = true;
 			ImGui::Checkbox("Extend Adjoin/Portal Limits", &graphics->extendAjoinLimits);
+
+			// Rasterization threads, only used by the floating point sub-renderer (resolutions other than 320x200).
+			const s32 maxThreads = min(TFE_Jobs::getHardwareThreadCount(), (s32)TFE_Jobs::MAX_THREAD_COUNT);
+			graphics->renderThreadCount = clamp(graphics->renderThreadCount, 1, maxThreads);
+			ImGui::LabelText("##ConfigLabel", "Render Threads:"); ImGui::SameLine(150 * s_uiScale);
+			ImGui::SetNextItemWidth(196 * s_uiScale);
+			ImGui::SliderInt("##RenderThreadSlider", &graphics->renderThreadCount, 1, maxThreads, "%d");
+			// Rasterize each strip into a column-major buffer, which is faster at high resolutions.
+			ImGui::Checkbox("Column-Major Rasterization", &graphics->columnMajorRaster);
 		}
 		else if (graphics->rendererIndex == 1)
 		{
@@ -2354,6 +2364,31 @@ namespace TFE_FrontEndUI
 			}
 			TFE_Audio::selectDevice(curOutput);
 			sound->audioDevice = curOutput;
+
+			// Output format, these must match TFE_Audio::c_outputRates[] and TFE_Audio::c_outputBufferSizes[].
+			const char* outputRateNames[] = { "11025 Hz (Original)", "22050 Hz", "44100 Hz", "48000 Hz", "96000 Hz" };
+			const char* bufferSizeNames[] = { "64", "128", "256", "512", "1024", "2048" };
+			s32 rateIndex = 0, bufferIndex = 0;
+			for (s32 i = 0; i < TFE_ARRAYSIZE(TFE_Audio::c_outputRates); i++)
+			{
+				if (TFE_Audio::c_outputRates[i] == TFE_Audio::getOutputRate()) { rateIndex = i; }
+			}
+			for (s32 i = 0; i < TFE_ARRAYSIZE(TFE_Audio::c_outputBufferSizes); i++)
+			{
+				if (TFE_Audio::c_outputBufferSizes[i] == TFE_Audio::getBufferSize()) { bufferIndex = i; }
+			}
+
+			ImGui::LabelText("##ConfigLabel", "Sample Rate:"); ImGui::SameLine(150 * s_uiScale);
+			ImGui::SetNextItemWidth(256 * s_uiScale);
+			bool formatChanged = ImGui::Combo("##Output Rate", &rateIndex, outputRateNames, TFE_ARRAYSIZE(outputRateNames));
+
+			ImGui::LabelText("##ConfigLabel", "Buffer Size:"); ImGui::SameLine(150 * s_uiScale);
+			ImGui::SetNextItemWidth(256 * s_uiScale);
+			formatChanged |= ImGui::Combo("##Buffer Size", &bufferIndex, bufferSizeNames, TFE_ARRAYSIZE(bufferSizeNames));
+			if (formatChanged)
+			{
+				TFE_Audio::setOutputFormat(TFE_Audio::c_outputRates[rateIndex], TFE_Audio::c_outputBufferSizes[bufferIndex]);
+			}
 		}
 		ImGui::Separator();
 		{
@@ -2424,6 +2459,15 @@ namespace TFE_FrontEndUI
 		{
 			system->returnToModLoader = returnToModLoader;
 		}
+		// In-memory snapshots of the current level, restored with the "rewind" console command.
+		ImGui::Checkbox("Enable Rewind Snapshots", &system->enableSnapshots);
+		if (system->enableSnapshots)
+		{
+			system->snapshotInterval = clamp(system->snapshotInterval, 1, 60);
+			ImGui::LabelText("##ConfigLabel", "Snapshot Interval:"); ImGui::SameLine(150 * s_uiScale);
+			ImGui::SetNextItemWidth(196 * s_uiScale);
+			ImGui::SliderInt("##SnapshotIntervalSlider", &system->snapshotInterval, 1, 60, "%d sec");
+		}
 	}
 
 	void pickCurrentResolution()
@@ -9,6 +9,7 @@
 #include <TFE_Ui/ui.h>
 #include <TFE_Ui/markdown.h>
 #include <TFE_System/parser.h>
+#include <TFE_Game/igame.h>
 
 #include <TFE_Ui/imGUI/imgui.h>
 #include <algorithm>
@@ -16,6 +17,7 @@
 namespace TFE_ProfilerView
 {
 	static bool s_open = false;
+	static s32  s_captureFrames = 120;
 
 	bool init()
 	{
@@ -26,6 +28,18 @@ namespace TFE_ProfilerView
 	{
 	}
 
+	void drawRegionStats(const char* name, MemoryRegion* region)
+	{
+		if (!region) { return; }
+
+		MemoryRegionStats stats;
+		TFE_Memory::region_getStats(region, &stats);
+		ImGui::Text("%s", name); ImGui::SameLine(64);
+		ImGui::Text("Used %zu / %zu KB, %u blocks, largest free %zu KB, %u free spans, fragmentation %0.1f%%", stats.used / 1024, stats.capacity / 1024,
+			stats.blockCount, stats.largestFree / 1024, stats.freeSpanCount, stats.fragmentation * 100.0f);
+		ImGui::SameLine(); ImGui::Text(" Allocs/frame %u, Frees/frame %u", stats.frameAllocCount, stats.frameFreeCount);
+	}
+
 	void update()
 	{
 		if (!s_open) { return; }
@@ -34,6 +48,37 @@ namespace TFE_ProfilerView
 		ImGui::SetNextWindowSize(ImVec2(800, 768));
 		ImGui::Begin("Profiler View", &s_open);
 
+		// Capture all zones, from every thread, for a range of frames.
+		const bool capturing = TFE_Profiler::isCapturing();
+		ImGui::SetNextItemWidth(96.0f);
+		ImGui::InputInt("Frames", &s_captureFrames);
+		s_captureFrames = std::max(1, std::min(s_captureFrames, 3600));
+		ImGui::SameLine();
+		if (ImGui::Button("Capture Trace") && !capturing)
+		{
+			char capturePath[TFE_MAX_PATH];
+			TFE_Paths::appendPath(PATH_USER_DOCUMENTS, "profile_capture.json", capturePath);
+			TFE_Profiler::captureFrames(u32(s_captureFrames), capturePath, CAPTURE_TRACE_JSON);
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Capture Binary") && !capturing)
+		{
+			char capturePath[TFE_MAX_PATH];
+			TFE_Paths::appendPath(PATH_USER_DOCUMENTS, "profile_capture.tfp", capturePath);
+			TFE_Profiler::captureFrames(u32(s_captureFrames), capturePath, CAPTURE_BINARY);
+		}
+		if (capturing)
+		{
+			ImGui::SameLine();
+			ImGui::Text("Capturing...");
+		}
+		const u32 droppedCount = TFE_Profiler::getDroppedEventCount();
+		if (droppedCount)
+		{
+			ImGui::Text("Dropped zone events: %u", droppedCount);
+		}
+		ImGui::Spacing();
+
 		ImGui::LabelText("##Label", "Counters");
 		ImGui::Separator();
 		u32 counterCount = TFE_Profiler::getCounterCount();
@@ -47,6 +92,14 @@ namespace TFE_ProfilerView
 		}
 		ImGui::Unindent();
 
+		ImGui::Spacing();
+		ImGui::LabelText("##Label", "Memory Regions");
+		ImGui::Separator();
+		ImGui::Indent();
+		drawRegionStats("Game", s_gameRegion);
+		drawRegionStats("Level", s_levelRegion);
+		ImGui::Unindent();
+
 		ImGui::Spacing();
 		ImGui::LabelText("##Label", "Zones");
 		ImGui::Separator();
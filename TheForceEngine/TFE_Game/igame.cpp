@@ -48,6 +48,12 @@ void game_destroy()
 	s_levelRegion = nullptr;
 }
 
+void game_endFrame()
+{
+	region_endFrame(s_gameRegion);
+	region_endFrame(s_levelRegion);
+}
+
 void game_clearLevelData()
 {
 	region_clear(s_levelRegion);
@@ -30,6 +30,13 @@ struct IGame
 	virtual bool isPaused() { return false; }
 	virtual void getLevelName(char* name) {};
 	virtual void getModList(char* modList) {};
+	// Replay support: the random seed and a hash of the simulation state, used to verify that a replay matches the recording.
+	virtual u32  getRandomSeed() { return 0; }
+	virtual void setRandomSeed(u32 seed) {}
+	virtual u32  getStateHash() { return 0; }
+	// The simulation tick and the number of ticks per second, a rate of 0 means the game does not expose its tick.
+	virtual u32  getSimTick() { return 0; }
+	virtual u32  getSimTickRate() { return 0; }
 
 	GameID id;
 };
@@ -39,3 +46,5 @@ void   freeGame(IGame* game);
 
 void game_init();
 void game_destroy();
+// Latch the per-frame memory region stats.
+void game_endFrame();
@@ -0,0 +1,320 @@
+#include <cstring>
+
+#include "replaySystem.h"
+#include <TFE_Input/input.h>
+#include <TFE_Input/inputMapping.h>
+#include <TFE_System/system.h>
+#include <TFE_FileSystem/filestream.h>
+#include <vector>
+
+using namespace TFE_Input;
+
+namespace TFE_ReplaySystem
+{
+	enum ReplayVersion
+	{
+		RVER_INIT = 1,
+		RVER_CUR = RVER_INIT
+	};
+
+	enum ReplayFrameFlags
+	{
+		RFRAME_TICK  = FLAG_BIT(0),	// The tasks ran this frame, the state hash follows.
+		RFRAME_MOUSE = FLAG_BIT(1),	// Non-zero mouse movement follows.
+		RFRAME_AXES  = FLAG_BIT(2),	// Non-zero analog axes follow.
+	};
+
+	enum ReplayMode
+	{
+		RMODE_NONE = 0,
+		RMODE_RECORD,
+		RMODE_PLAYBACK,
+	};
+
+	// Action states use 2 bits each.
+	static const u32 c_replayMagic = 0x50524654;	// "TFRP"
+	static const u32 c_actionBytes = (IA_COUNT + 3) / 4;
+
+	struct ReplayFrame
+	{
+		f64 time;
+		f64 dt;
+		u8  actions[c_actionBytes];
+		s32 mouseMove[2];
+		f32 axes[AA_COUNT];
+	};
+
+	static ReplayMode s_mode = RMODE_NONE;
+	static FileStream s_file;
+	static ReplayFrame s_frame;
+	static u32 s_frameIndex = 0;
+	static u32 s_tickCount = 0;
+	static u32 s_mismatchCount = 0;
+	static u8  s_frameFlags = 0;
+
+	// Playback reads the whole replay into memory.
+	static std::vector<u8> s_data;
+	static size_t s_readPos = 0;
+	static bool s_playbackFinished = false;
+
+	bool readBytes(void* dst, size_t size)
+	{
+		if (s_readPos + size > s_data.size())
+		{
+			return false;
+		}
+		memcpy(dst, s_data.data() + s_readPos, size);
+		s_readPos += size;
+		return true;
+	}
+
+	bool readHeaderFromData(ReplayHeader* header)
+	{
+		u32 magic = 0;
+		if (!readBytes(&magic, sizeof(u32)) || magic != c_replayMagic)
+		{
+			return false;
+		}
+		if (!readBytes(&header->version, sizeof(u32)) || header->version > RVER_CUR)
+		{
+			return false;
+		}
+		return readBytes(&header->gameId, sizeof(u32)) && readBytes(&header->randomSeed, sizeof(u32)) &&
+			readBytes(header->levelName, REPLAY_MAX_LEVEL_NAME);
+	}
+
+	bool readHeader(const char* filename, ReplayHeader* header)
+	{
+		FileStream file;
+		if (!file.open(filename, Stream::MODE_READ))
+		{
+			return false;
+		}
+		u32 magic = 0;
+		file.read(&magic);
+		file.read(&header->version);
+		file.read(&header->gameId);
+		file.read(&header->randomSeed);
+		file.readBuffer(header->levelName, REPLAY_MAX_LEVEL_NAME);
+		file.close();
+		header->levelName[REPLAY_MAX_LEVEL_NAME - 1] = 0;
+
+		return magic == c_replayMagic && header->version <= RVER_CUR;
+	}
+
+	bool startRecording(const char* filename, IGame* game, const char* levelName)
+	{
+		stop();
+		if (!game || !s_file.open(filename, Stream::MODE_WRITE))
+		{
+			TFE_System::logWrite(LOG_ERROR, "Replay", "Cannot record replay '%s'.", filename);
+			return false;
+		}
+
+		ReplayHeader header = {};
+		header.version = RVER_CUR;
+		header.gameId = game->id;
+		header.randomSeed = game->getRandomSeed();
+		if (levelName)
+		{
+			strncpy(header.levelName, levelName, REPLAY_MAX_LEVEL_NAME - 1);
+		}
+
+		s_file.write(&c_replayMagic);
+		s_file.write(&header.version);
+		s_file.write(&header.gameId);
+		s_file.write(&header.randomSeed);
+		s_file.writeBuffer(header.levelName, REPLAY_MAX_LEVEL_NAME);
+
+		s_mode = RMODE_RECORD;
+		s_frameIndex = 0;
+		s_tickCount = 0;
+		s_mismatchCount = 0;
+		TFE_System::logWrite(LOG_MSG, "Replay", "Recording replay '%s', level: '%s', seed: 0x%08x.", filename, header.levelName, header.randomSeed);
+		return true;
+	}
+
+	bool startPlayback(const char* filename, IGame* game)
+	{
+		stop();
+
+		void* contents = nullptr;
+		const u32 size = game ? FileStream::readContents(filename, &contents) : 0;
+		if (!size)
+		{
+			TFE_System::logWrite(LOG_ERROR, "Replay", "Cannot read replay '%s'.", filename);
+			return false;
+		}
+		s_data.assign((u8*)contents, (u8*)contents + size);
+		free(contents);
+		s_readPos = 0;
+
+		ReplayHeader header;
+		if (!readHeaderFromData(&header) || header.gameId != u32(game->id))
+		{
+			TFE_System::logWrite(LOG_ERROR, "Replay", "Invalid replay '%s'.", filename);
+			s_data.clear();
+			return false;
+		}
+		header.levelName[REPLAY_MAX_LEVEL_NAME - 1] = 0;
+		game->setRandomSeed(header.randomSeed);
+
+		s_mode = RMODE_PLAYBACK;
+		s_frameIndex = 0;
+		s_tickCount = 0;
+		s_mismatchCount = 0;
+		s_playbackFinished = false;
+		TFE_System::logWrite(LOG_MSG, "Replay", "Playing replay '%s', level: '%s', seed: 0x%08x.", filename, header.levelName, header.randomSeed);
+		return true;
+	}
+
+	u32 stop()
+	{
+		const u32 mismatchCount = s_mismatchCount;
+		if (s_mode == RMODE_RECORD)
+		{
+			s_file.close();
+			TFE_System::logWrite(LOG_MSG, "Replay", "Recorded %u frames, %u ticks.", s_frameIndex, s_tickCount);
+		}
+		else if (s_mode == RMODE_PLAYBACK)
+		{
+			s_data.clear();
+			inputMapping_overrideAnalogAxes(nullptr);
+			TFE_System::clearFrameTimeOverride();
+			TFE_System::logWrite(mismatchCount ? LOG_WARNING : LOG_MSG, "Replay", "Played %u frames, %u ticks, %u ticks did not match the recording.",
+				s_frameIndex, s_tickCount, mismatchCount);
+		}
+		s_mode = RMODE_NONE;
+		s_mismatchCount = 0;
+		return mismatchCount;
+	}
+
+	bool isRecording()
+	{
+		return s_mode == RMODE_RECORD;
+	}
+
+	bool isPlaying()
+	{
+		return s_mode == RMODE_PLAYBACK;
+	}
+
+	bool playbackFinished()
+	{
+		return s_playbackFinished;
+	}
+
+	void recordFrame()
+	{
+		s_frame.time = TFE_System::getTime();
+		s_frame.dt = TFE_System::getDeltaTime();
+		memset(s_frame.actions, 0, c_actionBytes);
+		for (u32 i = 0; i < IA_COUNT; i++)
+		{
+			s_frame.actions[i >> 2] |= u8(inputMapping_getActionState(InputAction(i)) << ((i & 3) * 2));
+		}
+		TFE_Input::getMouseMove(&s_frame.mouseMove[0], &s_frame.mouseMove[1]);
+		for (u32 i = 0; i < AA_COUNT; i++)
+		{
+			s_frame.axes[i] = inputMapping_getAnalogAxis(AnalogAxis(i));
+		}
+	}
+
+	void writeFrame(bool tickRan, u32 hash)
+	{
+		u8 flags = tickRan ? RFRAME_TICK : 0;
+		if (s_frame.mouseMove[0] || s_frame.mouseMove[1]) { flags |= RFRAME_MOUSE; }
+		for (u32 i = 0; i < AA_COUNT; i++)
+		{
+			if (s_frame.axes[i] != 0.0f) { flags |= RFRAME_AXES; break; }
+		}
+
+		s_file.write(&flags);
+		s_file.write(&s_frame.time);
+		s_file.write(&s_frame.dt);
+		s_file.write(s_frame.actions, c_actionBytes);
+		if (flags & RFRAME_MOUSE) { s_file.write(s_frame.mouseMove, 2); }
+		if (flags & RFRAME_AXES)  { s_file.write(s_frame.axes, AA_COUNT); }
+		if (flags & RFRAME_TICK)  { s_file.write(&hash); }
+	}
+
+	// Returns false at the end of the replay.
+	bool readFrame(u8* flags)
+	{
+		if (!readBytes(flags, sizeof(u8)) || !readBytes(&s_frame.time, sizeof(f64)) || !readBytes(&s_frame.dt, sizeof(f64)) ||
+			!readBytes(s_frame.actions, c_actionBytes))
+		{
+			return false;
+		}
+		memset(s_frame.mouseMove, 0, sizeof(s32) * 2);
+		memset(s_frame.axes, 0, sizeof(f32) * AA_COUNT);
+		if ((*flags & RFRAME_MOUSE) && !readBytes(s_frame.mouseMove, sizeof(s32) * 2)) { return false; }
+		if ((*flags & RFRAME_AXES)  && !readBytes(s_frame.axes, sizeof(f32) * AA_COUNT)) { return false; }
+		return true;
+	}
+
+	void beginFrame()
+	{
+		if (s_mode == RMODE_RECORD)
+		{
+			recordFrame();
+		}
+		else if (s_mode == RMODE_PLAYBACK)
+		{
+			u8 flags;
+			if (!readFrame(&flags))
+			{
+				s_playbackFinished = true;
+				stop();
+				return;
+			}
+
+			TFE_System::overrideFrameTime(s_frame.time, s_frame.dt);
+			for (u32 i = 0; i < IA_COUNT; i++)
+			{
+				inputMapping_setActionState(InputAction(i), ActionState((s_frame.actions[i >> 2] >> ((i & 3) * 2)) & 3));
+			}
+			TFE_Input::setRelativeMousePos(s_frame.mouseMove[0], s_frame.mouseMove[1]);
+			inputMapping_overrideAnalogAxes(s_frame.axes);
+			// The state hash, if any, is read and checked in endFrame().
+			s_frameFlags = flags;
+		}
+	}
+
+	void endFrame(IGame* game, bool tickRan)
+	{
+		if (s_mode == RMODE_NONE)
+		{
+			return;
+		}
+		const u32 hash = (tickRan && game) ? game->getStateHash() : 0;
+
+		if (s_mode == RMODE_RECORD)
+		{
+			writeFrame(tickRan, hash);
+		}
+		else
+		{
+			u32 recordedHash = 0;
+			const bool recordedTick = (s_frameFlags & RFRAME_TICK) != 0;
+			if (recordedTick && !readBytes(&recordedHash, sizeof(u32)))
+			{
+				s_playbackFinished = true;
+				stop();
+				return;
+			}
+
+			if (recordedTick != tickRan || recordedHash != hash)
+			{
+				if (!s_mismatchCount)
+				{
+					TFE_System::logWrite(LOG_WARNING, "Replay", "Replay diverged from the recording at frame %u, tick %u.", s_frameIndex, s_tickCount);
+				}
+				s_mismatchCount++;
+			}
+		}
+
+		s_frameIndex++;
+		if (tickRan) { s_tickCount++; }
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Input recording and deterministic replay.
+// Records the per-frame input action states, mouse movement, analog
+// axes and frame time together with the random seed, so that a level
+// run can be played back exactly. A hash of the simulation state is
+// stored for every tick and checked during playback, which makes it
+// possible to verify that code changes do not change the simulation.
+//
+// Only the mapped game input is recorded, input read directly from
+// the keyboard (menus, PDA, console) is not part of the replay.
+//////////////////////////////////////////////////////////////////////
+#include "igame.h"
+
+namespace TFE_ReplaySystem
+{
+	enum ReplayConst
+	{
+		REPLAY_MAX_LEVEL_NAME = 64,
+	};
+
+	struct ReplayHeader
+	{
+		u32  version;
+		u32  gameId;
+		u32  randomSeed;
+		char levelName[REPLAY_MAX_LEVEL_NAME];
+	};
+
+	// Start recording or playback, call after the game has been started.
+	bool startRecording(const char* filename, IGame* game, const char* levelName);
+	bool startPlayback(const char* filename, IGame* game);
+	// Stop recording or playback, returns the number of ticks that did not match the recording during playback.
+	u32  stop();
+
+	// Read only the header, so the level can be started before playback.
+	bool readHeader(const char* filename, ReplayHeader* header);
+
+	bool isRecording();
+	bool isPlaying();
+	// Playback has reached the end of the replay.
+	bool playbackFinished();
+
+	// Call after the system and input updates and before the game update.
+	// Records the input and frame time, or replaces them with the recorded values during playback.
+	void beginFrame();
+	// Call after the tasks have run, records or verifies the simulation state hash.
+	void endFrame(IGame* game, bool tickRan);
+}
@@ -2,13 +2,20 @@
 #include <TFE_Input/inputMapping.h>
 #include <TFE_System/system.h>
 #include <TFE_Settings/gameSourceData.h>
+#include <TFE_Settings/settings.h>
 #include <TFE_FileSystem/fileutil.h>
+#include <TFE_FileSystem/filewriterAsync.h>
+#include <TFE_FileSystem/memorystream.h>
+#include <TFE_FrontEndUI/console.h>
 
 #include <TFE_RenderBackend/renderBackend.h>
 #include <TFE_Asset/imageAsset.h>
 #include <cassert>
 #include <cstring>
 
+#define MINIZ_HEADER_FILE_ONLY
+#include <TFE_Archive/zip/miniz.h>
+
 using namespace TFE_Input;
 
 namespace TFE_SaveSystem
@@ -23,7 +30,8 @@ namespace TFE_SaveSystem
 	enum SaveMasterVersion
 	{
 		SVER_INIT = 1,
-		SVER_CUR = SVER_INIT
+		SVER_COMPRESSED = 2,	// The game state following the header is compressed.
+		SVER_CUR = SVER_COMPRESSED
 	};
 
 	static SaveRequest s_req = SF_REQ_NONE;
@@ -35,6 +43,35 @@ namespace TFE_SaveSystem
 
 	static u32* s_imageBuffer[2] = { nullptr, nullptr };
 	static size_t s_imageBufferSize[2] = { 0 };
+	// The save is serialized into memory and then compressed and written on the file writer thread.
+	static MemoryStream s_saveStream;
+
+	// Snapshot ring, the newest snapshot is kept uncompressed and each older snapshot is stored
+	// as a compressed XOR delta against the next newer one, so the oldest can be dropped at any time.
+	// The main thread only serializes the game state, the ring is updated on the file writer thread.
+	// So the main thread must call FileWriterAsync::flush() before accessing the ring.
+	struct Snapshot
+	{
+		std::vector<u8> delta;
+		u32 size;
+	};
+	static Snapshot s_snapshots[SNAPSHOT_RING_SIZE];
+	static s32 s_snapshotHead = 0;
+	static s32 s_snapshotCount = 0;
+	static std::vector<u8> s_snapshotLatest;
+	static std::vector<u8> s_snapshotWork;
+	static char s_snapshotLevel[256] = "";
+	// Simulation tick of the last snapshot, snapshots are scheduled in game time.
+	static u32 s_snapshotTick = 0;
+	static bool s_snapshotTickValid = false;
+	static s32 s_rewindRequest = 0;
+
+	// The game state from the last quicksave, so quickloads within the same level do not need to
+	// restart the game or read from disk.
+	static std::vector<u8> s_quickSaveState;
+	static char s_quickSaveLevel[256] = "";
+
+	void console_rewind(const ConsoleArgList& args);
 
 	void saveHeader(Stream* stream, const char* saveName)
 	{
@@ -131,7 +168,7 @@ namespace TFE_SaveSystem
 		stream->writeBuffer(png, pngSize);
 	}
 
-	void loadHeader(Stream* stream, SaveHeader* header, const char* fileName)
+	u32 loadHeader(Stream* stream, SaveHeader* header, const char* fileName)
 	{
 		// Master version.
 		u32 version;
@@ -180,6 +217,38 @@ namespace TFE_SaveSystem
 		image.data = header->imageData;
 		TFE_Image::readImageFromMemory(&image, pngSize, s_imageBuffer[0]);
 		assert(image.width == SAVE_IMAGE_WIDTH && image.height == SAVE_IMAGE_HEIGHT);
+		return version;
+	}
+
+	// Called on the file writer thread, compresses the game state following the header.
+	// Layout: header | u32 state size | u32 compressed size | compressed state
+	bool compressSaveState(std::vector<u8>& buffer, void* userData)
+	{
+		const size_t headerSize = size_t(userData);
+		const mz_ulong stateSize = mz_ulong(buffer.size() - headerSize);
+		mz_ulong compressedSize = mz_compressBound(stateSize);
+
+		std::vector<u8> output(headerSize + sizeof(u32) * 2 + compressedSize);
+		memcpy(output.data(), buffer.data(), headerSize);
+		if (mz_compress2(output.data() + headerSize + sizeof(u32) * 2, &compressedSize, buffer.data() + headerSize, stateSize, MZ_BEST_SPEED) != MZ_OK)
+		{
+			TFE_System::logWrite(LOG_ERROR, "Save", "Cannot compress the game state.");
+			return false;
+		}
+
+		const u32 sizes[] = { u32(stateSize), u32(compressedSize) };
+		memcpy(output.data() + headerSize, sizes, sizeof(u32) * 2);
+		output.resize(headerSize + sizeof(u32) * 2 + compressedSize);
+		buffer.swap(output);
+		return true;
+	}
+
+	void saveWriteComplete(size_t bytesWritten, void* userData, u32 errorCode)
+	{
+		if (errorCode != AFW_SUCCESS)
+		{
+			TFE_System::logWrite(LOG_ERROR, "Save", "Failed to write the save game, error code %u.", errorCode);
+		}
 	}
 
 	void populateSaveDirectory(std::vector<SaveHeader>& dir)
@@ -192,6 +261,8 @@ namespace TFE_SaveSystem
 
 		const std::string* filenames = fileList.data();
 		SaveHeader* headers = dir.data();
+		// Make sure recent saves have reached the disk.
+		FileWriterAsync::flush();
 		for (size_t i = 0; i < saveCount; i++)
 		{
 			loadGameHeader(filenames[i].c_str(), &headers[i]);
@@ -200,10 +271,17 @@ namespace TFE_SaveSystem
 
 	void init()
 	{
+		CCMD("rewind", console_rewind, 0, "Restore an earlier snapshot of the current level - rewind [count], count defaults to 1.");
 	}
 
 	void destroy()
 	{
+		// Finish writing any saves in flight.
+		FileWriterAsync::shutdown();
+		clearSnapshots();
+		std::vector<u8>().swap(s_snapshotLatest);
+		std::vector<u8>().swap(s_snapshotWork);
+		std::vector<u8>().swap(s_quickSaveState);
 		for (s32 i = 0; i < 2; i++)
 		{
 			free(s_imageBuffer[i]);
@@ -216,13 +294,26 @@ namespace TFE_SaveSystem
 		char filePath[TFE_MAX_PATH];
 		sprintf(filePath, "%s%s", s_gameSavePath, filename);
 
-		bool ret = false;
-		FileStream stream;
-		if (stream.open(filePath, Stream::MODE_WRITE))
+		// Serialize into memory, the snapshot is then compressed and written on the file writer thread.
+		s_saveStream.clear();
+		if (!s_saveStream.open(Stream::MODE_WRITE))
 		{
-			saveHeader(&stream, saveName);
-			ret = s_game->serializeGameState(&stream, filename, true);
-			stream.close();
+			return false;
+		}
+		saveHeader(&s_saveStream, saveName);
+		const size_t headerSize = s_saveStream.getLoc();
+		bool ret = s_game->serializeGameState(&s_saveStream, filename, true);
+		s_saveStream.close();
+
+		if (ret && strcasecmp(filename, c_quickSaveName) == 0)
+		{
+			const u8* state = (u8*)s_saveStream.data() + headerSize;
+			s_quickSaveState.assign(state, state + s_saveStream.getSize() - headerSize);
+			s_game->getLevelName(s_quickSaveLevel);
+		}
+		if (ret)
+		{
+			ret = FileWriterAsync::writeFileToDisk(filePath, (u8*)s_saveStream.data(), s_saveStream.getSize(), saveWriteComplete, (void*)headerSize, compressSaveState);
 		}
 		return ret;
 	}
@@ -232,16 +323,48 @@ namespace TFE_SaveSystem
 		char filePath[TFE_MAX_PATH];
 		sprintf(filePath, "%s%s", s_gameSavePath, filename);
 
-		bool ret = false;
-		FileStream stream;
-		if (stream.open(filePath, Stream::MODE_READ))
+		// The save may still be in flight, such as a quickload right after a quicksave.
+		FileWriterAsync::flush();
+
+		// Read the whole file at once.
+		MemoryStream stream;
+		FileStream file;
+		if (!file.open(filePath, Stream::MODE_READ))
 		{
-			SaveHeader header;
-			loadHeader(&stream, &header, filename);
-			ret = s_game->serializeGameState(&stream, filename, false);
-			stream.close();
+			return false;
 		}
-		return ret;
+		const size_t size = file.getSize();
+		const bool readFile = size > 0 && stream.allocate(size) && file.readBuffer(stream.data(), u32(size)) == size;
+		file.close();
+		if (!readFile || !stream.open(Stream::MODE_READ))
+		{
+			return false;
+		}
+
+		SaveHeader header;
+		const u32 version = loadHeader(&stream, &header, filename);
+		if (version < SVER_COMPRESSED)
+		{
+			return s_game->serializeGameState(&stream, filename, false);
+		}
+
+		// Decompress the game state in one pass.
+		u32 stateSize = 0, compressedSize = 0;
+		stream.read(&stateSize);
+		stream.read(&compressedSize);
+		const size_t offset = stream.getLoc();
+		mz_ulong outSize = stateSize;
+
+		MemoryStream stateStream;
+		if (!stateSize || offset + compressedSize > size || !stateStream.allocate(stateSize) ||
+			mz_uncompress((u8*)stateStream.data(), &outSize, (const u8*)stream.data() + offset, compressedSize) != MZ_OK || outSize != stateSize)
+		{
+			TFE_System::logWrite(LOG_ERROR, "Save", "Save game '%s' is corrupt.", filename);
+			return false;
+		}
+		stream.close();
+		stateStream.open(Stream::MODE_READ);
+		return s_game->serializeGameState(&stateStream, filename, false);
 	}
 
 	bool loadGameHeader(const char* filename, SaveHeader* header)
@@ -331,6 +454,211 @@ namespace TFE_SaveSystem
 	{
 		s_game = game;
 		setCurrentGame(game->id);
+
+		// Snapshots only apply to the game instance they were taken from.
+		clearSnapshots();
+		s_quickSaveState.clear();
+		s_quickSaveLevel[0] = 0;
+	}
+
+	/////////////////////////////////////////////
+	// Snapshots
+	/////////////////////////////////////////////
+	void clearSnapshotRing()
+	{
+		for (s32 i = 0; i < SNAPSHOT_RING_SIZE; i++)
+		{
+			std::vector<u8>().swap(s_snapshots[i].delta);
+			s_snapshots[i].size = 0;
+		}
+		s_snapshotHead = 0;
+		s_snapshotCount = 0;
+		s_snapshotLatest.clear();
+	}
+
+	void clearSnapshots()
+	{
+		// Wait for any snapshot in flight before touching the ring.
+		FileWriterAsync::flush();
+		clearSnapshotRing();
+		s_snapshotLevel[0] = 0;
+		s_snapshotTickValid = false;
+	}
+
+	void postRewindRequest(s32 count)
+	{
+		s_rewindRequest = count;
+	}
+
+	void console_rewind(const ConsoleArgList& args)
+	{
+		s32 count = args.size() > 1 ? atoi(args[1].c_str()) : 1;
+		FileWriterAsync::flush();
+		if (count < 1 || count > s_snapshotCount)
+		{
+			char msg[256];
+			sprintf(msg, "Cannot rewind %d snapshot(s), %d available.", count, s_snapshotCount);
+			TFE_Console::addToHistory(msg);
+			return;
+		}
+		postRewindRequest(count);
+	}
+
+	// dst = src ^ ref, where 'ref' is treated as zero beyond its size.
+	void xorBuffers(u8* dst, const u8* src, size_t size, const u8* ref, size_t refSize)
+	{
+		const size_t overlap = std::min(size, refSize);
+		for (size_t i = 0; i < overlap; i++)
+		{
+			dst[i] = src[i] ^ ref[i];
+		}
+		if (size > overlap)
+		{
+			memcpy(dst + overlap, src + overlap, size - overlap);
+		}
+	}
+
+	bool restoreGameState(const u8* state, size_t size, const char* filename)
+	{
+		MemoryStream stream;
+		if (!size || !stream.load(size, state) || !stream.open(Stream::MODE_READ))
+		{
+			return false;
+		}
+		const f64 start = TFE_System::getTime();
+		const bool ret = s_game->serializeGameState(&stream, filename, false);
+		TFE_System::logWrite(LOG_MSG, "Save", "Restored '%s' from memory in %.2f ms.", filename, (TFE_System::getTime() - start) * 1000.0);
+		return ret;
+	}
+
+	// Runs on the file writer thread: replace the previous newest snapshot with its delta against the new state,
+	// which then becomes the newest snapshot.
+	bool processSnapshot(std::vector<u8>& state, void* userData)
+	{
+		if (s_snapshotCount)
+		{
+			Snapshot* prev = &s_snapshots[s_snapshotHead];
+			const size_t prevSize = s_snapshotLatest.size();
+			s_snapshotWork.resize(prevSize);
+			xorBuffers(s_snapshotWork.data(), s_snapshotLatest.data(), prevSize, state.data(), state.size());
+
+			mz_ulong compressedSize = mz_compressBound(mz_ulong(prevSize));
+			prev->delta.resize(compressedSize);
+			if (mz_compress2(prev->delta.data(), &compressedSize, s_snapshotWork.data(), mz_ulong(prevSize), MZ_BEST_SPEED) != MZ_OK)
+			{
+				// Without the delta the older snapshots cannot be restored.
+				clearSnapshotRing();
+			}
+			else
+			{
+				prev->delta.resize(compressedSize);
+				prev->size = u32(prevSize);
+				s_snapshotHead = (s_snapshotHead + 1) % SNAPSHOT_RING_SIZE;
+			}
+		}
+
+		Snapshot* snapshot = &s_snapshots[s_snapshotHead];
+		std::vector<u8>().swap(snapshot->delta);
+		snapshot->size = u32(state.size());
+		// The writer frees the request buffer, which now holds the previous state.
+		s_snapshotLatest.swap(state);
+		s_snapshotCount = std::min(s_snapshotCount + 1, s32(SNAPSHOT_RING_SIZE));
+		return true;
+	}
+
+	void captureSnapshot()
+	{
+		char levelName[256];
+		s_game->getLevelName(levelName);
+		if (strcasecmp(levelName, s_snapshotLevel) != 0)
+		{
+			// Snapshots only cover the current level.
+			clearSnapshots();
+			strcpy(s_snapshotLevel, levelName);
+		}
+
+		// Only serialize on the main thread, the delta and compression are done on the file writer thread.
+		s_saveStream.clear();
+		if (!s_saveStream.open(Stream::MODE_WRITE) || !s_game->serializeGameState(&s_saveStream, nullptr, true))
+		{
+			return;
+		}
+		s_saveStream.close();
+		FileWriterAsync::processAsync((u8*)s_saveStream.data(), s_saveStream.getSize(), processSnapshot);
+	}
+
+	bool rewind(s32 count)
+	{
+		char levelName[256];
+		s_game->getLevelName(levelName);
+		FileWriterAsync::flush();
+		if (count < 1 || count > s_snapshotCount || strcasecmp(levelName, s_snapshotLevel) != 0)
+		{
+			return false;
+		}
+
+		// Walk back from the newest snapshot, undoing one delta at a time.
+		for (s32 i = 1; i < count; i++)
+		{
+			Snapshot* snapshot = &s_snapshots[(s_snapshotHead + SNAPSHOT_RING_SIZE - i) % SNAPSHOT_RING_SIZE];
+			s_snapshotWork.resize(snapshot->size);
+			mz_ulong outSize = snapshot->size;
+			if (mz_uncompress(s_snapshotWork.data(), &outSize, snapshot->delta.data(), mz_ulong(snapshot->delta.size())) != MZ_OK || outSize != snapshot->size)
+			{
+				TFE_System::logWrite(LOG_ERROR, "Save", "Snapshot %d is corrupt.", i);
+				return false;
+			}
+			xorBuffers(s_snapshotWork.data(), s_snapshotWork.data(), snapshot->size, s_snapshotLatest.data(), s_snapshotLatest.size());
+			s_snapshotLatest.swap(s_snapshotWork);
+		}
+
+		// The restored snapshot becomes the newest, drop the ones that followed it.
+		s_snapshotHead = (s_snapshotHead + SNAPSHOT_RING_SIZE - (count - 1)) % SNAPSHOT_RING_SIZE;
+		s_snapshotCount -= count - 1;
+		std::vector<u8>().swap(s_snapshots[s_snapshotHead].delta);
+		// The game tick goes back with the restored state.
+		s_snapshotTickValid = false;
+
+		return restoreGameState(s_snapshotLatest.data(), s_snapshotLatest.size(), "snapshot");
+	}
+
+	// Restore the last quicksave in place if it was made in the current level.
+	bool quickLoadFromMemory()
+	{
+		char levelName[256];
+		s_game->getLevelName(levelName);
+		if (s_quickSaveState.empty() || !s_game->canSave() || strcasecmp(levelName, s_quickSaveLevel) != 0)
+		{
+			return false;
+		}
+		// The snapshots may be ahead of the quicksave.
+		clearSnapshots();
+		return restoreGameState(s_quickSaveState.data(), s_quickSaveState.size(), c_quickSaveName);
+	}
+
+	// Capture a snapshot every 'snapshotInterval' seconds of game time, if enabled.
+	void updateSnapshots()
+	{
+		const TFE_Settings_System* system = TFE_Settings::getSystemSettings();
+		const u32 tickRate = s_game->getSimTickRate();
+		if (!system->enableSnapshots || !tickRate || !s_game->canSave())
+		{
+			return;
+		}
+
+		const u32 tick = s_game->getSimTick();
+		const u32 interval = u32(std::max(system->snapshotInterval, 1)) * tickRate;
+		// Start counting from the current tick, the tick may also go back when a level starts or state is restored.
+		if (!s_snapshotTickValid || tick < s_snapshotTick)
+		{
+			s_snapshotTick = tick;
+			s_snapshotTickValid = true;
+		}
+		else if (tick - s_snapshotTick >= interval)
+		{
+			captureSnapshot();
+			s_snapshotTick = tick;
+		}
 	}
 
 	void update()
@@ -341,7 +669,15 @@ namespace TFE_SaveSystem
 		const char* saveFilename = saveRequestFilename();
 
 		bool canSave = !lastState && s_game->canSave();
-		if (saveFilename && canSave)
+		if (s_rewindRequest)
+		{
+			if (s_game->canSave() && !rewind(s_rewindRequest))
+			{
+				TFE_System::logWrite(LOG_WARNING, "Save", "Cannot rewind %d snapshot(s).", s_rewindRequest);
+			}
+			s_rewindRequest = 0;
+		}
+		else if (saveFilename && canSave)
 		{
 			saveGame(saveFilename, s_reqSavename);
 			lastState = 1;
@@ -353,12 +689,18 @@ namespace TFE_SaveSystem
 		}
 		else if (inputMapping_getActionState(IAS_QUICK_LOAD) == STATE_PRESSED && !lastState)
 		{
-			postLoadRequest(c_quickSaveName);
+			// Fall back to restarting the game from the quicksave file.
+			if (!quickLoadFromMemory())
+			{
+				postLoadRequest(c_quickSaveName);
+			}
 			lastState = 1;
 		}
 		else
 		{
 			lastState = 0;
 		}
+
+		updateSnapshots();
 	}
 }
\ No newline at end of file
@@ -13,6 +13,9 @@ namespace TFE_SaveSystem
 		SAVE_MAX_NAME_LEN = 64,
 		SAVE_IMAGE_WIDTH  = 426,
 		SAVE_IMAGE_HEIGHT = 240,
+		// In-memory snapshots of the current level, used for rewinding.
+		// The interval is set by TFE_Settings_System::snapshotInterval.
+		SNAPSHOT_RING_SIZE = 8,
 	};
 	struct SaveHeader
 	{
@@ -42,5 +45,10 @@ namespace TFE_SaveSystem
 
 	void getSaveFilenameFromIndex(s32 index, char* name);
 
+	// Restore the snapshot 'count' steps back in place (1 = the most recent snapshot).
+	// The request is handled during the next update().
+	void postRewindRequest(s32 count);
+	void clearSnapshots();
+
 	void populateSaveDirectory(std::vector<SaveHeader>& dir);
 }
\ No newline at end of file
@@ -113,6 +113,9 @@ namespace TFE_Input
 
 	static InputConfig s_inputConfig = { 0 };
 	static ActionState s_actions[IA_COUNT];
+	// Analog axis values that replace the controller input, used by replay playback.
+	static f32  s_analogOverride[AA_COUNT];
+	static bool s_analogOverrideEnabled = false;
 		
 	void addDefaultControlBinds();
 			   
@@ -389,6 +392,20 @@ namespace TFE_Input
 		return s_actions[action];
 	}
 
+	void inputMapping_setActionState(InputAction action, ActionState state)
+	{
+		s_actions[action] = state;
+	}
+
+	void inputMapping_overrideAnalogAxes(const f32* axes)
+	{
+		s_analogOverrideEnabled = axes != nullptr;
+		if (axes)
+		{
+			memcpy(s_analogOverride, axes, sizeof(f32) * AA_COUNT);
+		}
+	}
+
 	void inputMapping_clearKeyBinding(KeyboardCode key)
 	{
 		// Search through bindings and clear any actions with this key.
@@ -405,6 +422,10 @@ namespace TFE_Input
 
 	f32 inputMapping_getAnalogAxis(AnalogAxis axis)
 	{
+		if (s_analogOverrideEnabled)
+		{
+			return s_analogOverride[axis];
+		}
 		if (!(s_inputConfig.controllerFlags & CFLAG_ENABLE))
 		{
 			return 0.0f;
@@ -175,6 +175,10 @@ namespace TFE_Input
 	void inputMapping_removeBinding(u32 index);
 	ActionState inputMapping_getActionState(InputAction action);
 	f32  inputMapping_getAnalogAxis(AnalogAxis axis);
+	// Replace the live input state, used to play back recorded input.
+	void inputMapping_setActionState(InputAction action, ActionState state);
+	// Replace the analog axes with the AA_COUNT values in 'axes', or pass nullptr to use the controller again.
+	void inputMapping_overrideAnalogAxes(const f32* axes);
 	void inputMapping_updateInput();
 	void inputMapping_removeState(InputAction action);
 	void inputMapping_clearKeyBinding(KeyboardCode key);
@@ -5,6 +5,9 @@
 #include <TFE_Jedi/Level/robject.h>
 #include <TFE_Jedi/Math/core_math.h>
 #include <TFE_Jedi/InfSystem/infSystem.h>
+#include <TFE_System/system.h>
+#include <algorithm>
+#include <vector>
 // Merge player collision into collision
 #include <TFE_DarkForces/playerCollision.h>
 using namespace TFE_DarkForces;
@@ -108,6 +111,7 @@ namespace TFE_Jedi
 	static fixed16_16 s_colObjOffsetZ;
 	static fixed16_16 s_colObjDirX;
 	static fixed16_16 s_colObjDirZ;
+
 	static fixed16_16 s_colObjMinY;
 	static fixed16_16 s_colObjMaxY;
 	static fixed16_16 s_colObjX0;
@@ -126,6 +130,24 @@ namespace TFE_Jedi
 	
 	static s32 s_colObjCount;
 	fixed16_16 s_colObjOverlap;
+
+	// Radius queries
+	static const fixed16_16 c_rangeSectorPadding = ONE_16;
+	static std::vector<RSector*> s_rangeSectors;
+	static std::vector<u32> s_rangeSectorVisit;
+	static u32 s_rangeVisitId = 0;
+	static JBool s_rangeFullScan = JFALSE;	// Visit every sector like the original code, used to verify the results.
+
+	// Line of sight reachability
+	static std::vector<u8> s_reachSectors;
+	static std::vector<RSector*> s_reachQueue;
+	static RSector* s_reachTarget = nullptr;
+	static JBool s_reachValid = JFALSE;
+	// Adjoin data, computed once per level and then updated as sector heights change.
+	static std::vector<s32> s_reachWallStart;	// Index of the first wall of each sector in s_reachPassable.
+	static std::vector<u8> s_reachPassable;		// Passability of each adjoin with the current sector heights.
+	static JBool s_reachAdjoinsValid = JFALSE;
+	static JBool s_reachAllSectors = JFALSE;	// Set if the adjoins are not mirrored, so every sector must be traced.
 	
 	////////////////////////////////////////////////////////
 	// Forward Declarations
@@ -472,14 +494,10 @@ namespace TFE_Jedi
 			// End of checks to pull out of the loop.
 			/////////////////////////////////////////////
 
-			s32 objCapacity = curSector->objectCapacity;
 			s32 objCount = curSector->objectCount;
-			for (s32 objListIndex = 0, objIndex = 0; objIndex < objCount && objListIndex < objCapacity; objListIndex++)
+			for (s32 objIndex = 0; objIndex < objCount; objIndex++)
 			{
-				SecObject* obj = curSector->objectList[objListIndex];
-				if (!obj) { continue; }
-
-				objIndex++;
+				SecObject* obj = curSector->objectList[objIndex];
 				if (skipObj && skipObj == obj) { continue; }
 				if (!(obj->entityFlags & entityFlags)) { continue; }
 				if (obj->posWS.x < x0 || obj->posWS.x > x1 || obj->posWS.z < z0 || obj->posWS.z > z1 || obj->posWS.y < y0 || obj->posWS.y > y1)
@@ -511,6 +529,62 @@ namespace TFE_Jedi
 		return JFALSE;
 	}
 		
+	// Collect the sectors that can hold objects affected by a radius query into s_rangeSectors, starting at 'start'.
+	// The effect functions only accept objects with a clear path from the start sector, which crosses adjoins through
+	// sectors that overlap the query bounds - so walking the adjoins outward from the start sector finds every sector
+	// the original linear scan could produce a hit in. Sectors are sorted by index to keep the original sector order,
+	// objects within a sector are visited in the order they were added (see SectorObjectIter), which can differ from
+	// the original slot order once objects have been removed from the sector.
+	s32 collision_gatherSectorsInRange(RSector* startSector, fixed16_16 x0, fixed16_16 z0, fixed16_16 x1, fixed16_16 z1, size_t start)
+	{
+		if (s_rangeFullScan)
+		{
+			RSector* sector = s_levelState.sectors;
+			for (u32 i = 0; i < s_levelState.sectorCount; i++, sector++)
+			{
+				s_rangeSectors.push_back(sector);
+			}
+			return s32(s_levelState.sectorCount);
+		}
+
+		if (s_rangeSectorVisit.size() != s_levelState.sectorCount || s_rangeVisitId == 0xffffffff)
+		{
+			s_rangeSectorVisit.assign(s_levelState.sectorCount, 0);
+			s_rangeVisitId = 0;
+		}
+		s_rangeVisitId++;
+
+		// Pad the bounds, so that fixed point error at the edges never skips a sector.
+		x0 -= c_rangeSectorPadding;
+		z0 -= c_rangeSectorPadding;
+		x1 += c_rangeSectorPadding;
+		z1 += c_rangeSectorPadding;
+
+		s_rangeSectors.push_back(startSector);
+		s_rangeSectorVisit[startSector->index] = s_rangeVisitId;
+		// s_rangeSectors is also the queue, it may be reallocated so use indices.
+		for (size_t i = start; i < s_rangeSectors.size(); i++)
+		{
+			RSector* sector = s_rangeSectors[i];
+			RWall* wall = sector->walls;
+			for (s32 w = 0; w < sector->wallCount; w++, wall++)
+			{
+				RSector* next = wall->nextSector;
+				if (!next || s_rangeSectorVisit[next->index] == s_rangeVisitId) { continue; }
+				if (x0 > next->boundsMax.x || x1 < next->boundsMin.x || z0 > next->boundsMax.z || z1 < next->boundsMin.z) { continue; }
+
+				s_rangeSectorVisit[next->index] = s_rangeVisitId;
+				s_rangeSectors.push_back(next);
+			}
+		}
+
+		std::sort(s_rangeSectors.begin() + start, s_rangeSectors.end(), [](const RSector* a, const RSector* b)
+		{
+			return a->index < b->index;
+		});
+		return s32(s_rangeSectors.size() - start);
+	}
+
 	// Call the effectFunc() for each object within 'range' of point (x,y,z). This will only be called for objects in range and that have a valid collision path.
 	// Note the collision path is 3D (XYZ), in that it takes into account collision based on height.
 	void collision_effectObjectsInRange3D(RSector* startSector, fixed16_16 range, vec3_fixed origin, CollisionEffectFunc effectFunc, SecObject* excludeObj, u32 entityFlags)
@@ -523,27 +597,27 @@ namespace TFE_Jedi
 		const fixed16_16 y1 = origin.y + range;
 		const fixed16_16 z1 = origin.z + range;
 
-		const fixed16_16 secHeightThreshold = origin.y - COL_SEC_HEIGHT_OFFSET;
-		RSector* sector = s_levelState.sectors;
-		for (u32 i = 0; i < s_levelState.sectorCount; i++, sector++)
+		// The original code checked the start sector bounds for every sector in the level.
+		if (x0 > startSector->boundsMax.x || x1 < startSector->boundsMin.x || z0 > startSector->boundsMax.z || z1 < startSector->boundsMin.z)
 		{
-			// Checks the start sector, should be pulled out of the loop.
-			if (x0 > startSector->boundsMax.x || x1 < startSector->boundsMin.x || z0 > startSector->boundsMax.z || z1 < startSector->boundsMin.z)
-			{
-				continue;
-			}
+			return;
+		}
+
+		// The effect function may start another query, so the sector list is used as a stack.
+		const size_t start = s_rangeSectors.size();
+		const s32 sectorCount = collision_gatherSectorsInRange(startSector, x0, z0, x1, z1, start);
+		for (s32 i = 0; i < sectorCount; i++)
+		{
+			RSector* sector = s_rangeSectors[start + i];
 
 			fixed16_16 floor, ceil;
 			sector_calculateFloor(sector, origin.y, &floor, &ceil);
 			if (y0 > floor || y1 < ceil) { continue; }
-			// End of start sector check.
 
-			for (s32 objIndex = 0, objListIndex = 0; objIndex < sector->objectCount && objListIndex < sector->objectCapacity; objListIndex++)
+			SectorObjectIter iter;
+			sector_beginObjectIter(&iter, sector);
+			while (SecObject* obj = sector_nextObject(&iter))
 			{
-				SecObject* obj = sector->objectList[objListIndex];
-				if (!obj) { continue; }
-				objIndex++;
-
 				if (excludeObj && excludeObj == obj) { continue; }
 				if (!(obj->entityFlags & entityFlags)) { continue; }
 				if (obj->posWS.x < x0 || obj->posWS.x > x1 || obj->posWS.z < z0 || obj->posWS.z > z1 || obj->posWS.y < y0 || obj->posWS.y > y1)
@@ -563,7 +637,9 @@ namespace TFE_Jedi
 					effectFunc(obj);
 				}
 			}  // Object Loop.
+			sector_endObjectIter(&iter);
 		}  // Sector loop.
+		s_rangeSectors.resize(start);
 	}
 
 	// Call the effectFunc() for each object within 'range' of point (x,y,z). This will only be called for objects in range and that have a valid collision path.
@@ -583,29 +659,27 @@ namespace TFE_Jedi
 		const fixed16_16 y1 = origin.y + range;
 		const fixed16_16 z1 = origin.z + range;
 
-		const fixed16_16 secHeightThreshold = origin.y - COL_SEC_HEIGHT_OFFSET;
-		RSector* sector = s_levelState.sectors;
-		for (u32 i = 0; i < s_levelState.sectorCount; i++, sector++)
+		// The original code checked the start sector for every sector in the level.
+		if (x0 > startSector->boundsMax.x || x1 < startSector->boundsMin.x || z0 > startSector->boundsMax.z || z1 < startSector->boundsMin.z)
 		{
-			// Checks the start sector, should be pulled out of the loop.
-			if (x0 > startSector->boundsMax.x || x1 < startSector->boundsMin.x || z0 > startSector->boundsMax.z || z1 < startSector->boundsMin.z)
-			{
-				continue;
-			}
-			fixed16_16 floor, ceil;
-			sector_calculateFloor(startSector, origin.y, &floor, &ceil);
-			if (y0 > floor || y1 < ceil)
-			{
-				continue;
-			}
-			// End of start sector check.
+			return;
+		}
+		fixed16_16 floor, ceil;
+		sector_calculateFloor(startSector, origin.y, &floor, &ceil);
+		if (y0 > floor || y1 < ceil)
+		{
+			return;
+		}
 
-			for (s32 objIndex = 0, objListIndex = 0; objIndex < sector->objectCount && objListIndex < sector->objectCapacity; objListIndex++)
+		const size_t start = s_rangeSectors.size();
+		const s32 sectorCount = collision_gatherSectorsInRange(startSector, x0, z0, x1, z1, start);
+		for (s32 i = 0; i < sectorCount; i++)
+		{
+			RSector* sector = s_rangeSectors[start + i];
+			SectorObjectIter iter;
+			sector_beginObjectIter(&iter, sector);
+			while (SecObject* obj = sector_nextObject(&iter))
 			{
-				SecObject* obj = sector->objectList[objListIndex];
-				if (!obj) { continue; }
-				objIndex++;
-
 				if (excludeObj && excludeObj == obj) { continue; }
 				if (!(obj->entityFlags & entityFlags)) { continue; }
 				if (obj->posWS.x < x0 || obj->posWS.x > x1 || obj->posWS.z < z0 || obj->posWS.z > z1 || obj->posWS.y < y0 || obj->posWS.y > y1)
@@ -647,7 +721,64 @@ namespace TFE_Jedi
 					effectFunc(obj);
 				}
 			}  // Object Loop.
+			sector_endObjectIter(&iter);
 		}  // Sector Loop.
+		s_rangeSectors.resize(start);
+	}
+
+	// Benchmark
+	static std::vector<SecObject*> s_rangeBenchHits;
+
+	void collision_rangeBenchEffect(SecObject* obj)
+	{
+		s_rangeBenchHits.push_back(obj);
+	}
+
+	f64 collision_runRangeQueries(const std::vector<SecObject*>& origins, fixed16_16 range, JBool fullScan, std::vector<SecObject*>* hits)
+	{
+		s_rangeFullScan = fullScan;
+		s_rangeBenchHits.clear();
+
+		const u64 startTime = TFE_System::getCurrentTimeInTicks();
+		for (size_t i = 0; i < origins.size(); i++)
+		{
+			SecObject* obj = origins[i];
+			collision_effectObjectsInRange3D(obj->sector, range, obj->posWS, collision_rangeBenchEffect, obj, 0xffffffff);
+			collision_effectObjectsInRangeXZ(obj->sector, range, obj->posWS, collision_rangeBenchEffect, obj, 0xffffffff);
+		}
+		const f64 time = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - startTime);
+
+		s_rangeFullScan = JFALSE;
+		hits->swap(s_rangeBenchHits);
+		return time;
+	}
+
+	JBool collision_benchmarkRangeQueries(s32 queryCount, fixed16_16 range, f64* scanTime, f64* adjoinTime)
+	{
+		// Explode at the position of random objects in the current level.
+		std::vector<SecObject*> objects;
+		RSector* sector = s_levelState.sectors;
+		for (u32 i = 0; i < s_levelState.sectorCount; i++, sector++)
+		{
+			for (s32 objIndex = 0; objIndex < sector->objectCount; objIndex++)
+			{
+				objects.push_back(sector->objectList[objIndex]);
+			}
+		}
+		if (objects.empty()) { return JFALSE; }
+
+		std::vector<SecObject*> origins(queryCount);
+		u32 seed = 0x9e3779b9u;
+		for (s32 i = 0; i < queryCount; i++)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			origins[i] = objects[(seed >> 8) % objects.size()];
+		}
+
+		std::vector<SecObject*> scanHits, adjoinHits;
+		*scanTime = collision_runRangeQueries(origins, range, JTRUE, &scanHits);
+		*adjoinTime = collision_runRangeQueries(origins, range, JFALSE, &adjoinHits);
+		return scanHits == adjoinHits ? JTRUE : JFALSE;
 	}
 		
 	static RSector*   s_hcolSector;
@@ -1036,6 +1167,162 @@ namespace TFE_Jedi
 		return (sector == endSector) ? JTRUE : JFALSE;
 	}
 
+	void collision_invalidateReachability()
+	{
+		s_reachValid = JFALSE;
+		s_reachAdjoinsValid = JFALSE;
+	}
+
+	// collision_canHitObject() can only cross an adjoin if the ray height at the crossing is within the ceiling and floor
+	// of both sectors, so an adjoin where one sector's ceiling is below the other's floor can never be crossed.
+	static JBool collision_isAdjoinPassable(const RSector* sector, const RSector* next)
+	{
+		const fixed16_16 ceil = max(sector->ceilingHeight, next->ceilingHeight);
+		const fixed16_16 floor = min(sector->floorHeight, next->floorHeight);
+		return ceil <= floor ? JTRUE : JFALSE;
+	}
+
+	static JBool collision_reachAdjoinsMatchLevel()
+	{
+		return s_reachAdjoinsValid && s_reachWallStart.size() == size_t(s_levelState.sectorCount) + 1 ? JTRUE : JFALSE;
+	}
+
+	// Check that every adjoin has a mirror that leads back and compute the passability of every adjoin.
+	static void collision_prepareReachability()
+	{
+		const u32 sectorCount = s_levelState.sectorCount;
+		s_reachAdjoinsValid = JTRUE;
+		s_reachValid = JFALSE;
+		s_reachAllSectors = JFALSE;
+		s_reachWallStart.resize(sectorCount + 1);
+
+		s32 wallCount = 0;
+		RSector* sector = s_levelState.sectors;
+		for (u32 s = 0; s < sectorCount; s++, sector++)
+		{
+			s_reachWallStart[s] = wallCount;
+			wallCount += sector->wallCount;
+		}
+		s_reachWallStart[sectorCount] = wallCount;
+		s_reachPassable.assign(wallCount, 0);
+
+		sector = s_levelState.sectors;
+		for (u32 s = 0; s < sectorCount; s++, sector++)
+		{
+			RWall* wall = sector->walls;
+			u8* passable = &s_reachPassable[s_reachWallStart[s]];
+			for (s32 w = 0; w < sector->wallCount; w++, wall++)
+			{
+				RWall* mirror = wall->mirrorWall;
+				if (!wall->nextSector) { continue; }
+				if (!mirror || mirror->sector != wall->nextSector || mirror->nextSector != sector || u32(wall->nextSector->index) >= sectorCount)
+				{
+					s_reachAllSectors = JTRUE;
+					return;
+				}
+				passable[w] = collision_isAdjoinPassable(sector, wall->nextSector);
+			}
+		}
+	}
+
+	// Add 'start' and every sector connected to it through passable adjoins to the reachable set.
+	static void collision_floodReachability(RSector* start)
+	{
+		s_reachQueue.clear();
+		s_reachQueue.push_back(start);
+		s_reachSectors[start->index] = 1;
+		for (size_t i = 0; i < s_reachQueue.size(); i++)
+		{
+			RSector* sector = s_reachQueue[i];
+			RWall* wall = sector->walls;
+			const u8* passable = &s_reachPassable[s_reachWallStart[sector->index]];
+			for (s32 w = 0; w < sector->wallCount; w++, wall++)
+			{
+				RSector* next = wall->nextSector;
+				if (!next || !passable[w] || s_reachSectors[next->index]) { continue; }
+
+				s_reachSectors[next->index] = 1;
+				s_reachQueue.push_back(next);
+			}
+		}
+	}
+
+	// Mark every sector from which a path through passable adjoins leads to 'target'.
+	// Adjoins are walked from the target outward, which requires each adjoin to have a mirror that leads back.
+	static void collision_buildReachability(RSector* target)
+	{
+		s_reachSectors.assign(s_levelState.sectorCount, 0);
+		s_reachTarget = target;
+		s_reachValid = JTRUE;
+		collision_floodReachability(target);
+	}
+
+	void collision_updateReachability(RSector* sector)
+	{
+		// Otherwise everything is computed on the next query.
+		if (!collision_reachAdjoinsMatchLevel() || s_reachAllSectors || u32(sector->index) >= s_levelState.sectorCount) { return; }
+
+		// Update the passability of the sector adjoins, on both sides.
+		JBool changed = JFALSE;
+		RWall* wall = sector->walls;
+		u8* passable = &s_reachPassable[s_reachWallStart[sector->index]];
+		for (s32 w = 0; w < sector->wallCount; w++, wall++)
+		{
+			RSector* next = wall->nextSector;
+			if (!next) { continue; }
+
+			const u8 isPassable = collision_isAdjoinPassable(sector, next);
+			if (passable[w] == isPassable) { continue; }
+
+			passable[w] = isPassable;
+			s_reachPassable[s_reachWallStart[next->index] + s32(wall->mirrorWall - next->walls)] = isPassable;
+			changed = JTRUE;
+			// A path inside of the reachable set may have been cut, so it has to be rebuilt.
+			if (!isPassable && s_reachValid && s_reachSectors[sector->index] && s_reachSectors[next->index])
+			{
+				s_reachValid = JFALSE;
+			}
+		}
+		if (!changed || !s_reachValid) { return; }
+
+		// The set was closed under the previous adjoins, so it can only grow through the adjoins of this sector.
+		const JBool sectorReached = s_reachSectors[sector->index] ? JTRUE : JFALSE;
+		wall = sector->walls;
+		for (s32 w = 0; w < sector->wallCount; w++, wall++)
+		{
+			RSector* next = wall->nextSector;
+			if (!next || !passable[w] || (s_reachSectors[next->index] ? JTRUE : JFALSE) == sectorReached) { continue; }
+			if (sectorReached)
+			{
+				collision_floodReachability(next);
+			}
+			else
+			{
+				// This sector and everything connected to it are now reachable.
+				collision_floodReachability(sector);
+				break;
+			}
+		}
+	}
+
+	JBool collision_canReachSector(RSector* startSector, RSector* endSector)
+	{
+		if (startSector == endSector || !startSector || !endSector) { return JTRUE; }
+		if (!collision_reachAdjoinsMatchLevel())
+		{
+			collision_prepareReachability();
+		}
+		// Sectors outside of the level, such as the control sector, are not culled.
+		const u32 sectorCount = s_levelState.sectorCount;
+		if (s_reachAllSectors || u32(startSector->index) >= sectorCount || u32(endSector->index) >= sectorCount) { return JTRUE; }
+
+		if (!s_reachValid || s_reachTarget != endSector || s_reachSectors.size() != sectorCount)
+		{
+			collision_buildReachability(endSector);
+		}
+		return s_reachSectors[startSector->index] ? JTRUE : JFALSE;
+	}
+
 	JBool collision_propogateExplosion(RSector* sector)
 	{
 		message_sendToSector(sector, nullptr, INF_EVENT_EXPLOSION, MSG_TRIGGER);
@@ -86,12 +86,23 @@ namespace TFE_Jedi
 	RWall* collision_pathWallCollision(RSector* sector);
 	RWall* collision_wallCollisionFromPath(RSector* sector, fixed16_16 srcX, fixed16_16 srcZ, fixed16_16 dstX, fixed16_16 dstZ);
 	JBool collision_canHitObject(RSector* startSector, RSector* endSector, vec3_fixed p0, vec3_fixed p1, u32 exclWallFlags3);
+	// Returns JFALSE if no collision_canHitObject() path from 'startSector' can end in 'endSector' with the current sector
+	// heights and adjoins. The set of sectors that can reach 'endSector' is cached until the end sector changes or
+	// it is invalidated, so many queries against the same target (such as the player) are cheap.
+	JBool collision_canReachSector(RSector* startSector, RSector* endSector);
+	// Must be called when the heights of 'sector' change, only the adjoins of that sector are updated.
+	void collision_updateReachability(RSector* sector);
+	// Must be called when adjoins change or a new level is loaded.
+	void collision_invalidateReachability();
 
 	SecObject* collision_getObjectCollision(RSector* sector, CollisionInterval* interval, SecObject* prevObj);
 	JBool collision_isAnyObjectInRange(RSector* sector, fixed16_16 radius, vec3_fixed origin, SecObject* skipObj, u32 entityFlags);
 
 	void collision_effectObjectsInRange3D(RSector* startSector, fixed16_16 range, vec3_fixed origin, CollisionEffectFunc effectFunc, SecObject* excludeObj, u32 entityFlags);
 	void collision_effectObjectsInRangeXZ(RSector* startSector, fixed16_16 range, vec3_fixed origin, CollisionEffectFunc effectFunc, SecObject* excludeObj, u32 entityFlags);
+	// Runs 'queryCount' 3D and XZ radius queries centered on random objects, using both the original scan over every sector and the
+	// adjoin walk. Returns JFALSE if the affected objects differ.
+	JBool collision_benchmarkRangeQueries(s32 queryCount, fixed16_16 range, f64* scanTime, f64* adjoinTime);
 
 	JBool handleCollision(CollisionInfo* colInfo);
 	void handleCollisionResponseSimple(fixed16_16 dirX, fixed16_16 dirZ, fixed16_16* moveX, fixed16_16* moveZ);
@@ -0,0 +1,419 @@
+#include "imDigitalMix.h"
+#include <TFE_System/system.h>
+#include <TFE_FrontEndUI/console.h>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#define IM_MIX_X86 1
+	#include <immintrin.h>
+	#if defined(__GNUC__) || defined(__clang__)
+		#define IM_TARGET_SSE2 __attribute__((target("sse2")))
+		#define IM_TARGET_AVX2 __attribute__((target("avx2")))
+	#else
+		#define IM_TARGET_SSE2
+		#define IM_TARGET_AVX2
+	#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	// The 64-byte table lookups used by the mixing kernel are only available on AArch64.
+	#define IM_MIX_NEON 1
+	#include <arm_neon.h>
+#endif
+
+namespace TFE_Jedi
+{
+	typedef void(*ImMixStereoFunc)(s16* audioOut, const u8* sndData, s32 leftVolume, s32 rightVolume, s32 size);
+	typedef void(*ImNormalizeFunc)(f32* driverOut, const s16* audioOut, const f32* normalization, f32 scale, s32 size);
+
+	enum ImMixConstants
+	{
+		IM_VOLUME_ROWS = 17,
+		IM_TEST_SAMPLES = 256 + 27,		// Not a multiple of the SIMD width, so the tail loops are tested.
+		IM_TEST_NORM_RANGE = 2048,
+		// The volume mapping rows are a rounded scale of the centered sample:
+		// mapping[volume][sample] = ((sample - 128) * ImVolumeScale(volume) + IM_VOLUME_ROUND) >> IM_VOLUME_SHIFT
+		IM_VOLUME_SHIFT = 11,
+		IM_VOLUME_ROUND = 1 << (IM_VOLUME_SHIFT - 1),
+		IM_SAMPLE_CENTER = 128,
+	};
+
+	static const s8* s_volumeMapping = nullptr;
+
+	void ImMixStereo_Scalar(s16* audioOut, const u8* sndData, s32 leftVolume, s32 rightVolume, s32 size);
+	void ImNormalize_Scalar(f32* driverOut, const s16* audioOut, const f32* normalization, f32 scale, s32 size);
+
+	static ImMixStereoFunc s_mixStereo = ImMixStereo_Scalar;
+	static ImNormalizeFunc s_normalize = ImNormalize_Scalar;
+
+	void imMixTestConsole(const ConsoleArgList& args);
+
+	// Matches s_audioVolumeToSignedMapping, this is checked by ImMixTestKernels().
+	static inline s32 ImVolumeScale(s32 volume)
+	{
+		return volume ? volume * 129 - 16 : 0;
+	}
+
+	/////////////////////////////////////////////////////
+	// Scalar (reference)
+	/////////////////////////////////////////////////////
+	void ImMixStereo_Scalar(s16* audioOut, const u8* sndData, s32 leftVolume, s32 rightVolume, s32 size)
+	{
+		const s8* leftMapping  = &s_volumeMapping[leftVolume  << 8];
+		const s8* rightMapping = &s_volumeMapping[rightVolume << 8];
+		for (s32 i = 0; i < size; i++, sndData++, audioOut += 2)
+		{
+			const u8 sample = *sndData;
+			audioOut[0] += (s16)leftMapping[sample];
+			audioOut[1] += (s16)rightMapping[sample];
+		}
+	}
+
+	void ImNormalize_Scalar(f32* driverOut, const s16* audioOut, const f32* normalization, f32 scale, s32 size)
+	{
+		for (s32 i = 0; i < size; i++, audioOut++, driverOut++)
+		{
+			*driverOut = normalization[*audioOut] * scale;
+		}
+	}
+
+#if IM_MIX_X86
+	/////////////////////////////////////////////////////
+	// SSE2
+	// There is no gather, so the volume mapping is computed instead of
+	// looked up: each (sample, 1) pair is multiplied by a
+	// (volume scale, rounding) pair, 8 stereo samples at a time.
+	// The normalization table is arbitrary, so those lookups stay scalar.
+	/////////////////////////////////////////////////////
+	IM_TARGET_SSE2 static inline __m128i ImMixScale_SSE2(__m128i samplePairs, __m128i one, __m128i scale)
+	{
+		// samplePairs = (s0, s0, s1, s1, ...) -> (s0, 1, s0, 1, s1, 1, s1, 1) -> 32-bit (L0, R0, L1, R1)
+		const __m128i lo = _mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(samplePairs, one), scale), IM_VOLUME_SHIFT);
+		const __m128i hi = _mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(samplePairs, one), scale), IM_VOLUME_SHIFT);
+		// The results are in [-128, 127], so packing does not saturate.
+		return _mm_packs_epi32(lo, hi);
+	}
+
+	IM_TARGET_SSE2 void ImMixStereo_SSE2(s16* audioOut, const u8* sndData, s32 leftVolume, s32 rightVolume, s32 size)
+	{
+		const s16 leftScale  = s16(ImVolumeScale(leftVolume));
+		const s16 rightScale = s16(ImVolumeScale(rightVolume));
+		const __m128i scale  = _mm_setr_epi16(leftScale, IM_VOLUME_ROUND, rightScale, IM_VOLUME_ROUND, leftScale, IM_VOLUME_ROUND, rightScale, IM_VOLUME_ROUND);
+		const __m128i center = _mm_set1_epi16(IM_SAMPLE_CENTER);
+		const __m128i one    = _mm_set1_epi16(1);
+		const __m128i zero   = _mm_setzero_si128();
+		s32 i = 0;
+		for (; i + 8 <= size; i += 8, sndData += 8, audioOut += 16)
+		{
+			const __m128i sample = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)sndData), zero), center);
+			const __m128i out0 = _mm_loadu_si128((const __m128i*)audioOut);
+			const __m128i out1 = _mm_loadu_si128((const __m128i*)(audioOut + 8));
+			_mm_storeu_si128((__m128i*)audioOut,       _mm_add_epi16(out0, ImMixScale_SSE2(_mm_unpacklo_epi16(sample, sample), one, scale)));
+			_mm_storeu_si128((__m128i*)(audioOut + 8), _mm_add_epi16(out1, ImMixScale_SSE2(_mm_unpackhi_epi16(sample, sample), one, scale)));
+		}
+		ImMixStereo_Scalar(audioOut, sndData, leftVolume, rightVolume, size - i);
+	}
+
+	IM_TARGET_SSE2 void ImNormalize_SSE2(f32* driverOut, const s16* audioOut, const f32* normalization, f32 scale, s32 size)
+	{
+		const __m128 scaleV = _mm_set1_ps(scale);
+		s32 i = 0;
+		for (; i + 4 <= size; i += 4, audioOut += 4, driverOut += 4)
+		{
+			const __m128 value = _mm_setr_ps(normalization[audioOut[0]], normalization[audioOut[1]], normalization[audioOut[2]], normalization[audioOut[3]]);
+			_mm_storeu_ps(driverOut, _mm_mul_ps(value, scaleV));
+		}
+		ImNormalize_Scalar(driverOut, audioOut, normalization, scale, size - i);
+	}
+
+	/////////////////////////////////////////////////////
+	// AVX2
+	// The mixing is computed the same way as SSE2, 16 stereo samples at a
+	// time, which is faster than gathering from the volume mapping.
+	// The normalization lookups use gathers.
+	/////////////////////////////////////////////////////
+	IM_TARGET_AVX2 static inline __m256i ImMixScale_AVX2(__m256i samplePairs, __m256i one, __m256i scale)
+	{
+		const __m256i lo = _mm256_srai_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(samplePairs, one), scale), IM_VOLUME_SHIFT);
+		const __m256i hi = _mm256_srai_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(samplePairs, one), scale), IM_VOLUME_SHIFT);
+		return _mm256_packs_epi32(lo, hi);
+	}
+
+	IM_TARGET_AVX2 void ImMixStereo_AVX2(s16* audioOut, const u8* sndData, s32 leftVolume, s32 rightVolume, s32 size)
+	{
+		const s16 leftScale  = s16(ImVolumeScale(leftVolume));
+		const s16 rightScale = s16(ImVolumeScale(rightVolume));
+		const __m256i scale  = _mm256_setr_epi16(leftScale, IM_VOLUME_ROUND, rightScale, IM_VOLUME_ROUND, leftScale, IM_VOLUME_ROUND, rightScale, IM_VOLUME_ROUND,
+		                                         leftScale, IM_VOLUME_ROUND, rightScale, IM_VOLUME_ROUND, leftScale, IM_VOLUME_ROUND, rightScale, IM_VOLUME_ROUND);
+		const __m256i center = _mm256_set1_epi16(IM_SAMPLE_CENTER);
+		const __m256i one    = _mm256_set1_epi16(1);
+		s32 i = 0;
+		for (; i + 16 <= size; i += 16, sndData += 16, audioOut += 32)
+		{
+			const __m256i sample = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)sndData)), center);
+			// The unpacks work within 128-bit lanes: mixedLo = samples [0, 3] and [8, 11], mixedHi = samples [4, 7] and [12, 15].
+			const __m256i mixedLo = ImMixScale_AVX2(_mm256_unpacklo_epi16(sample, sample), one, scale);
+			const __m256i mixedHi = ImMixScale_AVX2(_mm256_unpackhi_epi16(sample, sample), one, scale);
+			const __m256i out0 = _mm256_loadu_si256((const __m256i*)audioOut);
+			const __m256i out1 = _mm256_loadu_si256((const __m256i*)(audioOut + 16));
+			_mm256_storeu_si256((__m256i*)audioOut,        _mm256_add_epi16(out0, _mm256_permute2x128_si256(mixedLo, mixedHi, 0x20)));
+			_mm256_storeu_si256((__m256i*)(audioOut + 16), _mm256_add_epi16(out1, _mm256_permute2x128_si256(mixedLo, mixedHi, 0x31)));
+		}
+		ImMixStereo_Scalar(audioOut, sndData, leftVolume, rightVolume, size - i);
+	}
+
+	IM_TARGET_AVX2 void ImNormalize_AVX2(f32* driverOut, const s16* audioOut, const f32* normalization, f32 scale, s32 size)
+	{
+		const __m256 scaleV = _mm256_set1_ps(scale);
+		s32 i = 0;
+		for (; i + 8 <= size; i += 8, audioOut += 8, driverOut += 8)
+		{
+			const __m256i index = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)audioOut));
+			const __m256 value = _mm256_i32gather_ps(normalization, index, 4);
+			_mm256_storeu_ps(driverOut, _mm256_mul_ps(value, scaleV));
+		}
+		ImNormalize_Scalar(driverOut, audioOut, normalization, scale, size - i);
+	}
+#endif
+
+#if IM_MIX_NEON
+	/////////////////////////////////////////////////////
+	// NEON
+	// The 256 entry volume mapping is looked up from registers using
+	// four 64-byte table lookups, 16 stereo samples at a time.
+	/////////////////////////////////////////////////////
+	static inline int8x16x4_t ImLoadTable64(const s8* table)
+	{
+		int8x16x4_t result;
+		result.val[0] = vld1q_s8(table);
+		result.val[1] = vld1q_s8(table + 16);
+		result.val[2] = vld1q_s8(table + 32);
+		result.val[3] = vld1q_s8(table + 48);
+		return result;
+	}
+
+	static inline int8x16_t ImLookup256(const int8x16x4_t* table, uint8x16_t index)
+	{
+		// Out of range indices leave the previous result unchanged.
+		int8x16_t result = vqtbl4q_s8(table[0], index);
+		result = vqtbx4q_s8(result, table[1], vsubq_u8(index, vdupq_n_u8(64)));
+		result = vqtbx4q_s8(result, table[2], vsubq_u8(index, vdupq_n_u8(128)));
+		result = vqtbx4q_s8(result, table[3], vsubq_u8(index, vdupq_n_u8(192)));
+		return result;
+	}
+
+	void ImMixStereo_NEON(s16* audioOut, const u8* sndData, s32 leftVolume, s32 rightVolume, s32 size)
+	{
+		const s8* leftMapping  = &s_volumeMapping[leftVolume  << 8];
+		const s8* rightMapping = &s_volumeMapping[rightVolume << 8];
+		int8x16x4_t leftTable[4], rightTable[4];
+		for (s32 t = 0; t < 4; t++)
+		{
+			leftTable[t]  = ImLoadTable64(leftMapping  + t * 64);
+			rightTable[t] = ImLoadTable64(rightMapping + t * 64);
+		}
+
+		s32 i = 0;
+		for (; i + 16 <= size; i += 16, sndData += 16, audioOut += 32)
+		{
+			const uint8x16_t index = vld1q_u8(sndData);
+			const int8x16_t left  = ImLookup256(leftTable, index);
+			const int8x16_t right = ImLookup256(rightTable, index);
+
+			int16x8x2_t out = vld2q_s16(audioOut);
+			out.val[0] = vaddw_s8(out.val[0], vget_low_s8(left));
+			out.val[1] = vaddw_s8(out.val[1], vget_low_s8(right));
+			vst2q_s16(audioOut, out);
+
+			out = vld2q_s16(audioOut + 16);
+			out.val[0] = vaddw_s8(out.val[0], vget_high_s8(left));
+			out.val[1] = vaddw_s8(out.val[1], vget_high_s8(right));
+			vst2q_s16(audioOut + 16, out);
+		}
+		ImMixStereo_Scalar(audioOut, sndData, leftVolume, rightVolume, size - i);
+	}
+
+	void ImNormalize_NEON(f32* driverOut, const s16* audioOut, const f32* normalization, f32 scale, s32 size)
+	{
+		const float32x4_t scaleV = vdupq_n_f32(scale);
+		s32 i = 0;
+		for (; i + 4 <= size; i += 4, audioOut += 4, driverOut += 4)
+		{
+			const f32 value[] = { normalization[audioOut[0]], normalization[audioOut[1]], normalization[audioOut[2]], normalization[audioOut[3]] };
+			vst1q_f32(driverOut, vmulq_f32(vld1q_f32(value), scaleV));
+		}
+		ImNormalize_Scalar(driverOut, audioOut, normalization, scale, size - i);
+	}
+#endif
+
+	/////////////////////////////////////////////////////
+	// Verification
+	/////////////////////////////////////////////////////
+	static u32 s_testSeed = 1;
+	u32 ImMixTestRandom()
+	{
+		s_testSeed = s_testSeed * 1103515245u + 12345u;
+		return s_testSeed >> 8;
+	}
+
+	// Compare the output of the kernel against the scalar reference for every volume combination.
+	// The data is offset by one element to test unaligned access.
+	bool ImVerifyMixStereo(const char* name, ImMixStereoFunc mix)
+	{
+		u8  sndData[IM_TEST_SAMPLES + 1];
+		s16 refOut[IM_TEST_SAMPLES * 2 + 1];
+		s16 testOut[IM_TEST_SAMPLES * 2 + 1];
+		for (s32 i = 0; i <= IM_TEST_SAMPLES; i++)
+		{
+			sndData[i] = u8(ImMixTestRandom());
+		}
+
+		for (s32 left = 0; left < IM_VOLUME_ROWS; left++)
+		{
+			for (s32 right = 0; right < IM_VOLUME_ROWS; right++)
+			{
+				// Include values near the limits so that overflow wraps the same way.
+				for (s32 i = 0; i <= IM_TEST_SAMPLES * 2; i++)
+				{
+					refOut[i] = s16(ImMixTestRandom());
+				}
+				memcpy(testOut, refOut, sizeof(refOut));
+
+				ImMixStereo_Scalar(refOut + 1, sndData + 1, left, right, IM_TEST_SAMPLES);
+				mix(testOut + 1, sndData + 1, left, right, IM_TEST_SAMPLES);
+				if (memcmp(refOut, testOut, sizeof(refOut)) != 0)
+				{
+					TFE_System::logWrite(LOG_ERROR, "iMuse", "%s mixing kernel does not match the reference at volume %d, %d.", name, left, right);
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	bool ImVerifyNormalize(const char* name, ImNormalizeFunc normalize)
+	{
+		f32 normalizationMem[IM_TEST_NORM_RANGE * 2];
+		const f32* normalization = &normalizationMem[IM_TEST_NORM_RANGE];
+		s16 audioOut[IM_TEST_SAMPLES + 1];
+		f32 refOut[IM_TEST_SAMPLES + 1];
+		f32 testOut[IM_TEST_SAMPLES + 1];
+		for (s32 i = 0; i < IM_TEST_NORM_RANGE * 2; i++)
+		{
+			normalizationMem[i] = f32(s32(ImMixTestRandom() & 0xffff) - 32768) / 32768.0f;
+		}
+		for (s32 i = 0; i <= IM_TEST_SAMPLES; i++)
+		{
+			audioOut[i] = s16(s32(ImMixTestRandom() % (IM_TEST_NORM_RANGE * 2)) - IM_TEST_NORM_RANGE);
+		}
+
+		const f32 scales[] = { 1.0f, 0.7f, 0.123f, 0.0f };
+		for (size_t s = 0; s < TFE_ARRAYSIZE(scales); s++)
+		{
+			memset(refOut, 0, sizeof(refOut));
+			memset(testOut, 0, sizeof(testOut));
+			ImNormalize_Scalar(refOut + 1, audioOut + 1, normalization, scales[s], IM_TEST_SAMPLES);
+			normalize(testOut + 1, audioOut + 1, normalization, scales[s], IM_TEST_SAMPLES);
+			if (memcmp(refOut, testOut, sizeof(refOut)) != 0)
+			{
+				TFE_System::logWrite(LOG_ERROR, "iMuse", "%s normalize kernel does not match the reference at scale %f.", name, scales[s]);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// The SIMD kernels are not verified when they are selected, a mismatch is a bug to be fixed
+	// rather than hidden by falling back to the scalar version.
+	bool ImTestKernels(const char* name, ImMixStereoFunc mix, ImNormalizeFunc normalize)
+	{
+		// Both are run so that every mismatch is reported.
+		const bool mixMatches = ImVerifyMixStereo(name, mix);
+		const bool normalizeMatches = ImVerifyNormalize(name, normalize);
+		if (mixMatches && normalizeMatches)
+		{
+			TFE_System::logWrite(LOG_MSG, "iMuse", "%s kernels match the reference.", name);
+		}
+		return mixMatches && normalizeMatches;
+	}
+
+	void ImSelectKernels(const char* name, ImMixStereoFunc mix, ImNormalizeFunc normalize)
+	{
+		s_mixStereo = mix;
+		s_normalize = normalize;
+		TFE_System::logWrite(LOG_MSG, "iMuse", "Digital audio mixing uses %s.", name);
+	}
+
+	/////////////////////////////////////////////////////
+	// API
+	/////////////////////////////////////////////////////
+	void ImMixInitKernels(const s8* volumeMapping)
+	{
+		CCMD("imuseMixTest", imMixTestConsole, 0, "Compare the SIMD digital audio mixing kernels supported by this CPU against the scalar reference.");
+
+		s_volumeMapping = volumeMapping;
+
+		s_mixStereo = ImMixStereo_Scalar;
+		s_normalize = ImNormalize_Scalar;
+
+		const u32 cpuFeatures = TFE_System::getCpuFeatures();
+	#if IM_MIX_X86
+		if (cpuFeatures & CPU_FEATURE_AVX2)
+		{
+			ImSelectKernels("AVX2", ImMixStereo_AVX2, ImNormalize_AVX2);
+		}
+		else if (cpuFeatures & CPU_FEATURE_SSE2)
+		{
+			ImSelectKernels("SSE2", ImMixStereo_SSE2, ImNormalize_SSE2);
+		}
+	#elif IM_MIX_NEON
+		if (cpuFeatures & CPU_FEATURE_NEON)
+		{
+			ImSelectKernels("NEON", ImMixStereo_NEON, ImNormalize_NEON);
+		}
+	#endif
+		(void)cpuFeatures;
+	}
+
+	bool ImMixTestKernels()
+	{
+		if (!s_volumeMapping)
+		{
+			TFE_System::logWrite(LOG_ERROR, "iMuse", "Cannot test the mixing kernels before digital audio is initialized.");
+			return false;
+		}
+
+		bool pass = true;
+		const u32 cpuFeatures = TFE_System::getCpuFeatures();
+	#if IM_MIX_X86
+		if (cpuFeatures & CPU_FEATURE_SSE2)
+		{
+			pass = ImTestKernels("SSE2", ImMixStereo_SSE2, ImNormalize_SSE2) && pass;
+		}
+		if (cpuFeatures & CPU_FEATURE_AVX2)
+		{
+			pass = ImTestKernels("AVX2", ImMixStereo_AVX2, ImNormalize_AVX2) && pass;
+		}
+	#elif IM_MIX_NEON
+		if (cpuFeatures & CPU_FEATURE_NEON)
+		{
+			pass = ImTestKernels("NEON", ImMixStereo_NEON, ImNormalize_NEON) && pass;
+		}
+	#endif
+		(void)cpuFeatures;
+		return pass;
+	}
+
+	void imMixTestConsole(const ConsoleArgList& args)
+	{
+		TFE_Console::addToHistory(ImMixTestKernels() ? "iMuse mixing kernel test passed." : "iMuse mixing kernel test FAILED, see the log.");
+	}
+
+	void ImMixStereo(s16* audioOut, const u8* sndData, s32 leftVolume, s32 rightVolume, s32 size)
+	{
+		s_mixStereo(audioOut, sndData, leftVolume, rightVolume, size);
+	}
+
+	void ImNormalize(f32* driverOut, const s16* audioOut, const f32* normalization, f32 scale, s32 size)
+	{
+		s_normalize(driverOut, audioOut, normalization, scale, size);
+	}
+}  // namespace TFE_Jedi
@@ -0,0 +1,24 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// iMuse Digital Mixing
+// Inner loops of the digital sound mixer, with SIMD versions that are
+// selected at runtime based on the CPU features.
+//
+// The scalar versions are the reference, the SIMD versions must give
+// bit-exact results. This is checked by ImMixTestKernels(), which is
+// available as the "imuseMixTest" console command.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+
+namespace TFE_Jedi
+{
+	// volumeMapping: 17 volume rows of 256 entries, mapping unsigned 8-bit samples to signed values.
+	void ImMixInitKernels(const s8* volumeMapping);
+	// Compare every SIMD kernel supported by the CPU against the scalar reference, mismatches are logged as errors.
+	bool ImMixTestKernels();
+
+	// Add 'size' unsigned 8-bit samples to the interleaved stereo output, using the volume rows [0, 16] for each channel.
+	void ImMixStereo(s16* audioOut, const u8* sndData, s32 leftVolume, s32 rightVolume, s32 size);
+	// Convert 'size' mixed values to floating point using the normalization table, which may be indexed with negative values.
+	void ImNormalize(f32* driverOut, const s16* audioOut, const f32* normalization, f32 scale, s32 size);
+}  // namespace TFE_Jedi
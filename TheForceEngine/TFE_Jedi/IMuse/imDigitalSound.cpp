@@ -1,5 +1,6 @@
 #include "imuse.h"
 #include "imDigitalSound.h"
+#include "imDigitalMix.h"
 #include "imDigitalVolumeTable.h"
 #include "imSoundFader.h"
 #include "imTrigger.h"
@@ -16,7 +17,13 @@ namespace TFE_Jedi
 	#define MAX_SOUND_CHANNELS 16
 	#define DEFAULT_SOUND_CHANNELS 8
 	#define AUDIO_BUFFER_SIZE 512
+	#define WAVE_CHUNK_HEADER_SIZE 48
+	#define WAVE_EVENT_COUNT 64		// Must be a power of two.
+	#define WAVE_EVENT_MASK (WAVE_EVENT_COUNT - 1)
+	// Markers start after the chunk id and size.
+	#define WAVE_MARKER_SIZE (WAVE_CHUNK_HEADER_SIZE - 4)
 
+	// Serializes the game and midi threads, the audio thread only receives changes through audio commands.
 	#define AUDIO_LOCK()   TFE_Audio::lock()
 	#define AUDIO_UNLOCK() TFE_Audio::unlock()
 
@@ -25,6 +32,22 @@ namespace TFE_Jedi
 	////////////////////////////////////////////////////
 	struct ImWaveData;
 
+	enum ImWaveEventType
+	{
+		IM_WAVE_EVENT_MAILBOX = 0,
+		IM_WAVE_EVENT_MARKER,
+	};
+
+	// Mailbox and marker changes found by the audio thread while playing, passed back to the client.
+	struct ImWaveEvent
+	{
+		s32 channel;
+		u32 playId;
+		s32 type;
+		s32 mailbox;
+		char marker[WAVE_MARKER_SIZE + 1];
+	};
+
 	struct ImWaveSound
 	{
 		ImWaveSound* prev;
@@ -44,8 +67,10 @@ namespace TFE_Jedi
 
 		s32 detuneTrans;
 		s32 mailbox;
+		u32 playId;
 	};
 
+	// Playback state, owned by the audio thread once the sound has started.
 	struct ImWaveData
 	{
 		ImWaveSound* sound;
@@ -53,6 +78,12 @@ namespace TFE_Jedi
 		s32 chunkSize;
 		s32 baseOffset;
 		s32 chunkIndex;
+
+		ImSoundId soundId;
+		u32 playId;
+		s32 volume;
+		s32 pan;
+		JBool active;
 	};
 
 	/////////////////////////////////////////////////////
@@ -63,10 +94,20 @@ namespace TFE_Jedi
 	static ImWaveSound* s_imWaveSoundList = nullptr;
 	static ImWaveSound  s_imWaveSound[MAX_SOUND_CHANNELS];
 	static ImWaveData   s_imWaveData[MAX_SOUND_CHANNELS];
-	static u8  s_imWaveChunkData[48];
 	static s32 s_imWaveMixCount = DEFAULT_SOUND_CHANNELS;
 	static s32 s_imWaveNanosecsPerSample;
 	static iMuseInitData* s_imDigitalData;
+	static u32 s_imWavePlayId = 0;
+	// The playId of the last sound to finish on each channel, written by the audio thread.
+	static atomic_u32 s_imWaveFinished[MAX_SOUND_CHANNELS];
+	static atomic_s32 s_imWaveFinishedPending(0);
+	// Single producer (audio thread), single consumer (client threads, serialized by AUDIO_LOCK) event queue.
+	static ImWaveEvent s_imWaveEvents[WAVE_EVENT_COUNT];
+	static atomic_u32 s_imWaveEventWrite(0);
+	static atomic_u32 s_imWaveEventRead(0);
+	// Stops that could not be queued as audio commands, applied by the audio thread if the playId still matches.
+	static atomic_u32 s_imWaveStopRequest[MAX_SOUND_CHANNELS];
+	static atomic_s32 s_imWaveStopPending(0);
 
 	// In DOS these are 8-bit outputs since that is what the driver is accepting.
 	// For TFE, floating-point audio output is used, so these convert to floating-point.
@@ -93,7 +134,9 @@ namespace TFE_Jedi
 	s32 ImGetWaveParamIntern(ImSoundId soundId, s32 param);
 	s32 ImFreeWaveSoundByIdIntern(ImSoundId soundId);
 	s32 ImStartDigitalSoundIntern(ImSoundId soundId, s32 priority, s32 chunkIndex);
-	s32 audioPlaySoundFrame(ImWaveSound* sound);
+	JBool ImQueueWaveParams(ImWaveSound* sound);
+	void ImProcessWaveEvents();
+	s32 audioPlaySoundFrame(ImWaveData* data);
 	s32 audioWriteToDriver(f32 systemVolume);
 		
 	/////////////////////////////////////////////////////////// 
@@ -110,6 +153,16 @@ namespace TFE_Jedi
 		s_imWaveMixCount = initData->waveMixCount;
 		s_digitalPause = 0;
 		s_imWaveSoundList = nullptr;
+		for (s32 i = 0; i < MAX_SOUND_CHANNELS; i++)
+		{
+			s_imWaveData[i].active = JFALSE;
+			s_imWaveFinished[i] = 0;
+			s_imWaveStopRequest[i] = 0;
+		}
+		s_imWaveFinishedPending = 0;
+		s_imWaveStopPending = 0;
+		s_imWaveEventWrite = 0;
+		s_imWaveEventRead = 0;
 
 		if (initData->waveSpeed == IM_WAVE_11kHz) // <- this is the path taken by Dark Forces DOS
 		{
@@ -135,6 +188,7 @@ namespace TFE_Jedi
 			sound->soundId = IM_NULL_SOUNDID;
 		}
 
+		ImMixInitKernels((const s8*)s_audioVolumeToSignedMapping);
 		TFE_Audio::setAudioThreadCallback(ImUpdateWave);
 
 		return ImComputeAudioNormalizationInit(initData);
@@ -182,6 +236,7 @@ namespace TFE_Jedi
 
 	s32 ImGetWaveParam(ImSoundId soundId, s32 param)
 	{
+		ImUpdateFinishedWaveSounds();
 		return ImGetWaveParamIntern(soundId, param);
 	}
 
@@ -190,6 +245,7 @@ namespace TFE_Jedi
 		return ImStartDigitalSoundIntern(soundId, priority, 0);
 	}
 		
+	// Called on the audio thread.
 	void ImUpdateWave(f32* buffer, u32 bufferSize, f32 systemVolume)
 	{
 		// Prepare buffers.
@@ -198,19 +254,60 @@ namespace TFE_Jedi
 		assert(bufferSize * 2 <= AUDIO_BUFFER_SIZE);
 		memset(s_audioOut, 0, 2 * bufferSize * sizeof(s16));
 
+		// Apply stops that could not be queued as commands.
+		if (s_imWaveStopPending.exchange(0))
+		{
+			for (s32 i = 0; i < MAX_SOUND_CHANNELS; i++)
+			{
+				const u32 playId = s_imWaveStopRequest[i].exchange(0);
+				if (playId && s_imWaveData[i].playId == playId)
+				{
+					s_imWaveData[i].active = JFALSE;
+				}
+			}
+		}
+
 		// Write sounds to s_audioOut.
-		ImWaveSound* sound = s_imWaveSoundList;
-		while (sound)
+		ImWaveData* data = s_imWaveData;
+		for (s32 i = 0; i < MAX_SOUND_CHANNELS; i++, data++)
 		{
-			ImWaveSound* next = sound->next;
-			audioPlaySoundFrame(sound);
-			sound = next;
+			if (data->active)
+			{
+				audioPlaySoundFrame(data);
+			}
 		}
 
 		// Convert s_audioOut to "driver" buffer.
 		audioWriteToDriver(systemVolume);
 	}
 
+	// Handle mailbox and marker events from the audio thread and free sounds that it has finished playing.
+	void ImUpdateFinishedWaveSounds()
+	{
+		// Events are posted before the sound is marked as finished, so they are handled first.
+		const s32 finishedPending = s_imWaveFinishedPending.exchange(0);
+		ImProcessWaveEvents();
+		if (!finishedPending)
+		{
+			return;
+		}
+
+		AUDIO_LOCK();
+		{
+			ImWaveSound* sound = s_imWaveSound;
+			for (s32 i = 0; i < MAX_SOUND_CHANNELS; i++, sound++)
+			{
+				const u32 playId = s_imWaveFinished[i].exchange(0);
+				// The sound may have already been freed or restarted.
+				if (playId && sound->soundId && sound->playId == playId)
+				{
+					ImFreeWaveSound(sound);
+				}
+			}
+		}
+		AUDIO_UNLOCK();
+	}
+
 	s32 ImPauseDigitalSound()
 	{
 		s_digitalPause = 1;
@@ -223,6 +320,154 @@ namespace TFE_Jedi
 		return imSuccess;
 	}
 
+	////////////////////////////////////
+	// Audio thread commands
+	////////////////////////////////////
+	void ImWaveStartCmd(const AudioCommand* cmd)
+	{
+		ImWaveData* data = ImGetWaveData(s32((ImWaveSound*)cmd->data - s_imWaveSound));
+		data->soundId = (ImSoundId)cmd->id;
+		data->playId = u32(cmd->args[0]);
+		data->offset = cmd->args[1];
+		data->chunkSize = cmd->args[2];
+		data->baseOffset = cmd->args[3];
+		data->chunkIndex = 0;
+		data->active = JTRUE;
+	}
+
+	void ImWaveStopCmd(const AudioCommand* cmd)
+	{
+		ImWaveData* data = ImGetWaveData(s32((ImWaveSound*)cmd->data - s_imWaveSound));
+		if (data->playId == u32(cmd->args[0]))
+		{
+			data->active = JFALSE;
+		}
+	}
+
+	void ImWaveParamCmd(const AudioCommand* cmd)
+	{
+		ImWaveData* data = ImGetWaveData(s32((ImWaveSound*)cmd->data - s_imWaveSound));
+		if (data->playId == u32(cmd->args[0]))
+		{
+			data->volume = cmd->args[1];
+			data->pan = cmd->args[2];
+		}
+	}
+
+	JBool ImQueueWaveParams(ImWaveSound* sound)
+	{
+		AudioCommand cmd = {};
+		cmd.func = ImWaveParamCmd;
+		cmd.data = sound;
+		cmd.args[0] = s32(sound->playId);
+		cmd.args[1] = sound->volume;
+		cmd.args[2] = sound->pan;
+		return TFE_Audio::queueCommand(cmd) ? JTRUE : JFALSE;
+	}
+
+	////////////////////////////////////
+	// Audio thread events
+	////////////////////////////////////
+	// Called on the audio thread.
+	void ImPostWaveEvent(const ImWaveData* data, s32 type, s32 mailbox, const u8* marker)
+	{
+		const u32 write = s_imWaveEventWrite.load(std::memory_order_relaxed);
+		if (write - s_imWaveEventRead.load(std::memory_order_acquire) >= WAVE_EVENT_COUNT)
+		{
+			IM_LOG_ERR("%s", "The wave event queue is full, dropping event.");
+			return;
+		}
+
+		ImWaveEvent* ev = &s_imWaveEvents[write & WAVE_EVENT_MASK];
+		ev->channel = s32(data - s_imWaveData);
+		ev->playId = data->playId;
+		ev->type = type;
+		ev->mailbox = mailbox;
+		if (marker)
+		{
+			memcpy(ev->marker, marker, WAVE_MARKER_SIZE);
+		}
+		ev->marker[WAVE_MARKER_SIZE] = 0;
+		s_imWaveEventWrite.store(write + 1, std::memory_order_release);
+	}
+
+	// Set the mailbox if it is empty. On the audio thread, this is passed to the client as an event.
+	void ImWaveSetMailbox(ImWaveData* data, s32 mailbox, JBool audioThread)
+	{
+		if (audioThread)
+		{
+			ImPostWaveEvent(data, IM_WAVE_EVENT_MAILBOX, mailbox, nullptr);
+		}
+		else if (data->sound->mailbox == 0)
+		{
+			data->sound->mailbox = mailbox;
+		}
+	}
+
+	// Execute the triggers for a marker. On the audio thread, this is passed to the client as an event,
+	// since triggers run client callbacks that modify iMuse state.
+	void ImWaveSetMarker(ImWaveData* data, const u8* marker, JBool audioThread)
+	{
+		if (audioThread)
+		{
+			ImPostWaveEvent(data, IM_WAVE_EVENT_MARKER, 0, marker);
+		}
+		else
+		{
+			ImSetSoundTrigger((ImSoundId)data->sound, (void*)marker);
+		}
+	}
+
+	// Apply the events posted by the audio thread, triggers are executed without holding the audio lock.
+	void ImProcessWaveEvents()
+	{
+		// Avoid taking the lock when there is nothing to do.
+		if (s_imWaveEventRead.load(std::memory_order_relaxed) == s_imWaveEventWrite.load(std::memory_order_acquire))
+		{
+			return;
+		}
+
+		while (1)
+		{
+			ImSoundId triggerSoundId = IM_NULL_SOUNDID;
+			char marker[WAVE_MARKER_SIZE + 1];
+
+			AUDIO_LOCK();
+			const u32 read = s_imWaveEventRead.load(std::memory_order_relaxed);
+			if (read == s_imWaveEventWrite.load(std::memory_order_acquire))
+			{
+				AUDIO_UNLOCK();
+				break;
+			}
+
+			const ImWaveEvent* ev = &s_imWaveEvents[read & WAVE_EVENT_MASK];
+			ImWaveSound* sound = &s_imWaveSound[ev->channel];
+			// Ignore events for sounds that have since been freed or restarted.
+			if (sound->soundId && sound->playId == ev->playId)
+			{
+				if (ev->type == IM_WAVE_EVENT_MAILBOX)
+				{
+					if (sound->mailbox == 0)
+					{
+						sound->mailbox = ev->mailbox;
+					}
+				}
+				else
+				{
+					triggerSoundId = (ImSoundId)sound;
+					memcpy(marker, ev->marker, sizeof(marker));
+				}
+			}
+			s_imWaveEventRead.store(read + 1, std::memory_order_release);
+			AUDIO_UNLOCK();
+
+			if (triggerSoundId)
+			{
+				ImSetSoundTrigger(triggerSoundId, marker);
+			}
+		}
+	}
+
 	////////////////////////////////////
 	// Internal
 	////////////////////////////////////
@@ -270,7 +515,7 @@ namespace TFE_Jedi
 					}
 					sound->volume = ((sound->baseVolume + 1) * ImGetGroupVolume(value)) >> 7;
 					sound->group = value;
-					return imSuccess;
+					return ImQueueWaveParams(sound) ? imSuccess : imFail;
 				}
 				else if (param == soundPriority)
 				{
@@ -289,7 +534,7 @@ namespace TFE_Jedi
 					}
 					sound->baseVolume = value;
 					sound->volume = ((sound->baseVolume + 1) * ImGetGroupVolume(sound->group)) >> 7;
-					return imSuccess;
+					return ImQueueWaveParams(sound) ? imSuccess : imFail;
 				}
 				else if (param == soundPan)
 				{
@@ -298,7 +543,7 @@ namespace TFE_Jedi
 						return imArgErr;
 					}
 					sound->pan = value;
-					return imSuccess;
+					return ImQueueWaveParams(sound) ? imSuccess : imFail;
 				}
 				else if (param == soundDetune)
 				{
@@ -398,6 +643,8 @@ namespace TFE_Jedi
 
 	ImWaveSound* ImAllocWaveSound(s32 priority)
 	{
+		ImUpdateFinishedWaveSounds();
+
 		ImWaveSound* sound = s_imWaveSound;
 		ImWaveSound* newSound = nullptr;
 		for (s32 i = 0; i < s_imWaveMixCount; i++, sound++)
@@ -444,11 +691,13 @@ namespace TFE_Jedi
 		return nullptr;
 	}
 
-	s32 ImSeekToNextChunk(ImWaveData* data)
+	// This is called on the client thread when a sound is set up and on the audio thread during playback.
+	s32 ImSeekToNextChunk(ImWaveData* data, JBool audioThread)
 	{
+		u8 chunkBuffer[WAVE_CHUNK_HEADER_SIZE];
 		while (1)
 		{
-			u8* chunkData = s_imWaveChunkData;
+			u8* chunkData = chunkBuffer;
 			u8* sndData = nullptr;
 
 			if (data->chunkIndex)
@@ -465,20 +714,16 @@ namespace TFE_Jedi
 			}
 			else  // chunkIndex == 0
 			{
-				ImWaveSound* sound = data->sound;
-				sndData = ImInternalGetSoundData(sound->soundId);
+				sndData = ImInternalGetSoundData(data->soundId);
 				if (!sndData)
 				{
-					if (sound->mailbox == 0)
-					{
-						sound->mailbox = 8;
-					}
+					ImWaveSetMailbox(data, 8, audioThread);
 					IM_LOG_ERR("%s", "null sound addr in SeekToNextChunk()...");
 					return imFail;
 				}
 			}
 
-			memcpy(chunkData, sndData + data->offset, 48);
+			memcpy(chunkData, sndData + data->offset, WAVE_CHUNK_HEADER_SIZE);
 			u8 id = *chunkData;
 			chunkData++;
 
@@ -494,11 +739,7 @@ namespace TFE_Jedi
 				data->chunkSize = chunkSize;
 				if (chunkSize > 220000)
 				{
-					ImWaveSound* sound = data->sound;
-					if (sound->mailbox == 0)
-					{
-						sound->mailbox = 9;
-					}
+					ImWaveSetMailbox(data, 9, audioThread);
 				}
 
 				data->offset += 6;
@@ -512,7 +753,7 @@ namespace TFE_Jedi
 			else if (id == 4)
 			{
 				chunkData += 3;
-				ImSetSoundTrigger((ImSoundId)data->sound, chunkData);
+				ImWaveSetMarker(data, chunkData, audioThread);
 				data->offset += 6;
 			}
 			else if (id == 6)
@@ -538,7 +779,7 @@ namespace TFE_Jedi
 			{
 				if (chunkData[0] != 'r' || chunkData[1] != 'e' || chunkData[2] != 'a')
 				{
-					IM_LOG_ERR("ERR: Illegal chunk in sound %lu...", data->sound->soundId);
+					IM_LOG_ERR("ERR: Illegal chunk in sound %lu...", data->soundId);
 					return imFail;
 				}
 				data->offset += 26;
@@ -550,16 +791,16 @@ namespace TFE_Jedi
 			}
 			else
 			{
-				IM_LOG_ERR("ERR: Illegal chunk in sound %lu...", data->sound->soundId);
+				IM_LOG_ERR("ERR: Illegal chunk in sound %lu...", data->soundId);
 				return imFail;
 			}
 		}
 		return imSuccess;
 	}
 
-	s32 ImWaveSetupSoundData(ImWaveSound* sound, s32 chunkIndex)
+	// The sound data is set up on the client thread and then passed to the audio thread when the sound starts.
+	s32 ImWaveSetupSoundData(ImWaveData* data, s32 chunkIndex)
 	{
-		ImWaveData* data = sound->data;
 		data->offset = 0;
 		data->chunkSize = 0;
 		data->baseOffset = 0;
@@ -571,7 +812,7 @@ namespace TFE_Jedi
 		}
 
 		data->chunkIndex = 0;
-		return ImSeekToNextChunk(data);
+		return ImSeekToNextChunk(data, JFALSE);
 	}
 
 	s32 ImStartDigitalSoundIntern(ImSoundId soundId, s32 priority, s32 chunkIndex)
@@ -594,7 +835,12 @@ namespace TFE_Jedi
 		sound->transpose = 0;
 		sound->detuneTrans = 0;
 		sound->mailbox = 0;
-		if (ImWaveSetupSoundData(sound, chunkIndex) != imSuccess)
+		sound->playId = ++s_imWavePlayId;
+
+		ImWaveData setup = {};
+		setup.sound = sound;
+		setup.soundId = soundId;
+		if (ImWaveSetupSoundData(&setup, chunkIndex) != imSuccess)
 		{
 			IM_LOG_ERR("Failed to setup wave player data - soundId: 0x%x, priority: %d", soundId, priority);
 			ImFreeWaveSound(sound);
@@ -604,6 +850,22 @@ namespace TFE_Jedi
 		AUDIO_LOCK();
 		{
 			IM_LIST_ADD(s_imWaveSoundList, sound);
+
+			AudioCommand cmd = {};
+			cmd.func = ImWaveStartCmd;
+			cmd.data = sound;
+			cmd.id = (iptr)soundId;
+			cmd.args[0] = s32(sound->playId);
+			cmd.args[1] = setup.offset;
+			cmd.args[2] = setup.chunkSize;
+			cmd.args[3] = setup.baseOffset;
+			if (!TFE_Audio::queueCommand(cmd) || !ImQueueWaveParams(sound))
+			{
+				IM_LOG_ERR("Failed to queue wave sound start - soundId: 0x%x", soundId);
+				ImFreeWaveSound(sound);
+				AUDIO_UNLOCK();
+				return imFail;
+			}
 		}
 		AUDIO_UNLOCK();
 
@@ -616,6 +878,17 @@ namespace TFE_Jedi
 		ImClearSoundFaders(sound->soundId, -1);
 		ImClearTrigger(sound->soundId, -1, -1);
 		sound->soundId = IM_NULL_SOUNDID;
+
+		AudioCommand cmd = {};
+		cmd.func = ImWaveStopCmd;
+		cmd.data = sound;
+		cmd.args[0] = s32(sound->playId);
+		// A lost stop would leave a looping sound playing, so fall back to a request checked on every audio update.
+		if (!TFE_Audio::queueCommand(cmd))
+		{
+			s_imWaveStopRequest[sound - s_imWaveSound] = sound->playId;
+			s_imWaveStopPending = 1;
+		}
 	}
 
 	s32 ImFreeWaveSoundById(ImSoundId soundId)
@@ -641,6 +914,8 @@ namespace TFE_Jedi
 
 	ImSoundId ImFindNextWaveSound(ImSoundId soundId)
 	{
+		ImUpdateFinishedWaveSounds();
+
 		ImSoundId nextSoundId = IM_NULL_SOUNDID;
 		ImWaveSound* sound = s_imWaveSoundList;
 		// Find the smallest ID that is greater than 'soundId' or NULL if soundId is the last one.
@@ -658,18 +933,6 @@ namespace TFE_Jedi
 		return nextSoundId;
 	}
 	
-	// leftMapping:  map left channel samples to final values based on volume and pan.
-	// rightMapping: map right channel samples to final values based on volume and pan.
-	void digitalAudioOutput_Stereo(s16* audioOut, const u8* sndData, const s8* leftMapping, const s8* rightMapping, s32 size)
-	{
-		for (s32 i = 0; i < size; i++, sndData++, audioOut+=2)
-		{
-			const u8 sample = *sndData;
-			audioOut[0] += (s16)leftMapping[sample];
-			audioOut[1] += (s16)rightMapping[sample];
-		}
-	}
-
 	void audioProcessFrame(u8* audioFrame, s32 size, s32 outOffset, s32 vol, s32 pan)
 	{
 		s32 vTop = vol >> 3;
@@ -691,16 +954,12 @@ namespace TFE_Jedi
 		// Calculate where the in panVolume mapping channel to read from for each channel.
 		s32 leftVolume  = s_audioPanVolumeTable[8 - panTop + vTop*17];
 		s32 rightVolume = s_audioPanVolumeTable[8 + panTop + vTop*17];
-		// Map [0,255] sample values to signed output values based on volume.
-		const s8* leftMapping  = (s8*)&s_audioVolumeToSignedMapping[leftVolume  << 8];
-		const s8* rightMapping = (s8*)&s_audioVolumeToSignedMapping[rightVolume << 8];
-
-		digitalAudioOutput_Stereo(&s_audioOut[outOffset * 2], audioFrame, leftMapping, rightMapping, size);
+		// Map [0,255] sample values to signed output values based on volume and accumulate.
+		ImMixStereo(&s_audioOut[outOffset * 2], audioFrame, leftVolume, rightVolume, size);
 	}
 
-	s32 audioPlaySoundFrame(ImWaveSound* sound)
+	s32 audioPlaySoundFrame(ImWaveData* data)
 	{
-		ImWaveData* data = sound->data;
 		s32 bufferSize = s_audioOutSize;
 		s32 offset = 0;
 		s32 res = imSuccess;
@@ -709,20 +968,22 @@ namespace TFE_Jedi
 			res = imSuccess;
 			if (!data->chunkSize)
 			{
-				res = ImSeekToNextChunk(data);
+				res = ImSeekToNextChunk(data, JTRUE);
 				if (res != imSuccess)
 				{
-					if (res == imFail)  // Sound has finished playing.
+					if (res == imFail)  // Sound has finished playing, let the client free it.
 					{
-						ImFreeWaveSound(sound);
+						data->active = JFALSE;
+						s_imWaveFinished[data - s_imWaveData] = data->playId;
+						s_imWaveFinishedPending = 1;
 					}
 					break;
 				}
 			}
 
 			s32 readSize = (bufferSize <= data->chunkSize) ? bufferSize : data->chunkSize;
-			s_audioData = ImInternalGetSoundData(sound->soundId) + data->offset;
-			audioProcessFrame(s_audioData, readSize, offset, sound->volume, sound->pan);
+			s_audioData = ImInternalGetSoundData(data->soundId) + data->offset;
+			audioProcessFrame(s_audioData, readSize, offset, data->volume, data->pan);
 
 			offset += readSize;
 			bufferSize -= readSize;
@@ -739,13 +1000,7 @@ namespace TFE_Jedi
 			return imInvalidSound;
 		}
 
-		s32 bufferSize = s_audioOutSize * 2;
-		s16* audioOut  = s_audioOut;
-		f32* driverOut = s_audioDriverOut;
-		for (s32 i = 0; i < bufferSize; i++, audioOut++, driverOut++)
-		{
-			*driverOut = s_audioNormalization[*audioOut] * systemVolume;
-		}
+		ImNormalize(s_audioDriverOut, s_audioOut, s_audioNormalization, systemVolume, s_audioOutSize * 2);
 		return imSuccess;
 	}
 
@@ -33,6 +33,7 @@ namespace TFE_Jedi
 	s32 ImGetWaveParam(ImSoundId soundId, s32 param);
 	s32 ImStartDigitalSound(ImSoundId soundId, s32 priority);
 	void ImUpdateWave(f32* buffer, u32 bufferSize, f32 systemVolume);
+	void ImUpdateFinishedWaveSounds();
 
 	s32 ImFreeWaveSoundById(ImSoundId soundId);
 	s32 ImFreeAllWaveSounds();
@@ -653,6 +653,7 @@ namespace TFE_Jedi
 
 		// Update Midi and Audio
 		ImUpdateMidi();
+		ImUpdateFinishedWaveSounds();
 		if (s_imPause)
 		{
 			return;
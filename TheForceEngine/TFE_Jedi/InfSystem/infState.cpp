@@ -148,7 +148,7 @@ namespace TFE_Jedi
 		else
 		{
 			SERIALIZE(InfState_InitVersion, stopCount, 0);
-			elev->stops = stopCount ? allocator_create(sizeof(Stop)) : nullptr;
+			elev->stops = stopCount ? allocator_create(sizeof(Stop), nullptr, ALLOC_SLAB_SMALL) : nullptr;
 			for (s32 s = 0; s < stopCount; s++)
 			{
 				Stop* stop = (Stop*)allocator_newItem(elev->stops);
@@ -186,7 +186,7 @@ namespace TFE_Jedi
 		else
 		{
 			SERIALIZE(InfState_InitVersion, slaveCount, 0);
-			elev->slaves = allocator_create(sizeof(Slave));
+			elev->slaves = allocator_create(sizeof(Slave), nullptr, ALLOC_SLAB_SMALL);
 			for (s32 s = 0; s < slaveCount; s++)
 			{
 				Slave* slave = (Slave*)allocator_newItem(elev->slaves);
@@ -17,6 +17,7 @@
 #include <TFE_Jedi/Collision/collision.h>
 #include <TFE_System/parser.h>
 #include <TFE_System/system.h>
+#include <TFE_System/profiler.h>
 #include <TFE_System/memoryPool.h>
 #include <TFE_System/math.h>
 #include <TFE_Jedi/Level/rtexture.h>
@@ -66,11 +67,14 @@ namespace TFE_Jedi
 
 	// DOS hack... this is required since elevators with an invalid delay use the previous valid delay.
 	static Tick s_prevStopDelay = 0;
+	// Time taken to load the INF of the current level, in microseconds.
+	static s32 s_infParseTimeUs = 0;
 
 	// Forward Declarations.
 	void inf_elevatorTaskFunc(MessageType msg);
 	void inf_telelporterTaskFunc(MessageType msg);
 	void inf_triggerTaskFunc(MessageType msg);
+	JBool inf_parse(const char* levelName);
 
 	void infElevatorMsgFunc(MessageType msgType);
 	void infTriggerMsgFunc(MessageType msgType);
@@ -117,7 +121,7 @@ namespace TFE_Jedi
 
 	void inf_createElevatorTask()
 	{
-		s_infSerState.infElevators = allocator_create(sizeof(InfElevator));
+		s_infSerState.infElevators = allocator_create(sizeof(InfElevator), nullptr, ALLOC_SLAB_LARGE);
 		s_infState.infElevTask = createSubTask("elevator", inf_elevatorTaskFunc, inf_elevatorTaskLocal);
 	}
 
@@ -125,7 +129,7 @@ namespace TFE_Jedi
 	{
 		s_infState.teleportTask = createSubTask("teleporter", inf_telelporterTaskFunc, inf_teleporterTaskLocal);
 		task_setNextTick(s_infState.teleportTask, TASK_SLEEP);
-		s_infSerState.infTeleports = allocator_create(sizeof(Teleport));
+		s_infSerState.infTeleports = allocator_create(sizeof(Teleport), nullptr, ALLOC_SLAB_LARGE);
 	}
 
 	void inf_createTriggerTask()
@@ -133,7 +137,7 @@ namespace TFE_Jedi
 		s_infState.infTriggerTask = createSubTask("trigger", inf_triggerTaskFunc, inf_triggerTaskLocal);
 		s_infSerState.activeTriggerCount = 0;
 		// TFE: create a trigger allocator to make tracking easier.
-		s_infSerState.infTriggers = allocator_create(sizeof(InfTrigger));
+		s_infSerState.infTriggers = allocator_create(sizeof(InfTrigger), nullptr, ALLOC_SLAB_LARGE);
 	}
 
 	InfLink* allocateLink(Allocator* infLinks, InfElevator* elev)
@@ -182,7 +186,7 @@ namespace TFE_Jedi
 	{
 		if (!elev->stops)
 		{
-			elev->stops = allocator_create(sizeof(Stop));
+			elev->stops = allocator_create(sizeof(Stop), nullptr, ALLOC_SLAB_SMALL);
 		}
 		return allocateStop(elev->stops);
 	}
@@ -568,7 +572,7 @@ namespace TFE_Jedi
 		Allocator* stops = elev->stops;
 		if (!elev->stops)
 		{
-			elev->stops = allocator_create(sizeof(Stop));
+			elev->stops = allocator_create(sizeof(Stop), nullptr, ALLOC_SLAB_SMALL);
 			stops = elev->stops;
 		}
 		s32 index = allocator_getCount(stops);
@@ -655,7 +659,7 @@ namespace TFE_Jedi
 	{
 		if (!elev->slaves)
 		{
-			elev->slaves = allocator_create(sizeof(Slave));
+			elev->slaves = allocator_create(sizeof(Slave), nullptr, ALLOC_SLAB_SMALL);
 		}
 		Slave* slave = (Slave*)allocator_newItem(elev->slaves);
 		slave->sector = sector;
@@ -860,7 +864,8 @@ namespace TFE_Jedi
 			}
 
 			char id[256];
-			s32 argCount = sscanf(line, " %s %s %s %s %s %s %s", id, s_infArg0, s_infArg1, s_infArg2, s_infArg3, s_infArg4, s_infArgExtra);
+			char* args[] = { id, s_infArg0, s_infArg1, s_infArg2, s_infArg3, s_infArg4, s_infArgExtra };
+			s32 argCount = TFE_Parser::scanArgs(line, args, TFE_ARRAYSIZE(args), sizeof(s_infArg0));
 			KEYWORD action = getKeywordIndex(id);
 			if (action == KW_UNKNOWN)
 			{
@@ -903,7 +908,8 @@ namespace TFE_Jedi
 			}
 			
 			char id[256];
-			argCount = sscanf(line, " %s %s %s %s %s", id, s_infArg0, s_infArg1, s_infArg2, s_infArg3);
+			char* args[] = { id, s_infArg0, s_infArg1, s_infArg2, s_infArg3 };
+			argCount = TFE_Parser::scanArgs(line, args, TFE_ARRAYSIZE(args), sizeof(s_infArg0));
 			KEYWORD itemId = getKeywordIndex(id);
 			assert(itemId != KW_UNKNOWN);
 
@@ -1021,7 +1027,8 @@ namespace TFE_Jedi
 			}
 
 			char name[256];
-			sscanf(line, " %s %s %s %s %s", name, s_infArg0, s_infArg1, s_infArg2, s_infArg3);
+			char* args[] = { name, s_infArg0, s_infArg1, s_infArg2, s_infArg3 };
+			TFE_Parser::scanArgs(line, args, TFE_ARRAYSIZE(args), sizeof(s_infArg0));
 			KEYWORD kw = getKeywordIndex(name);
 
 			if (kw == KW_TARGET)
@@ -1118,7 +1125,8 @@ namespace TFE_Jedi
 			}
 
 			char id[256];
-			argCount = sscanf(line, " %s %s %s %s %s", id, s_infArg0, s_infArg1, s_infArg2, s_infArg3);
+			char* args[] = { id, s_infArg0, s_infArg1, s_infArg2, s_infArg3 };
+			argCount = TFE_Parser::scanArgs(line, args, TFE_ARRAYSIZE(args), sizeof(s_infArg0));
 			KEYWORD itemId = getKeywordIndex(id);
 			if (itemId == KW_UNKNOWN)
 			{
@@ -1204,6 +1212,20 @@ namespace TFE_Jedi
 	// For now load the INF data directly.
 	// Move back to asset later.
 	JBool inf_load(const char* levelName)
+	{
+		TFE_ZONE("INF Load");
+		const u64 startTime = TFE_System::getCurrentTimeInTicks();
+		const JBool result = inf_parse(levelName);
+		const f64 parseTime = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - startTime);
+
+		// TFE: Report the INF parse time of the current level.
+		s_infParseTimeUs = s32(parseTime * 1000000.0);
+		TFE_COUNTER(s_infParseTimeUs, "INF Parse Time (us)");
+		TFE_System::logWrite(LOG_MSG, "level_loadINF", "Parsed '%s' INF in %.2f ms.", levelName, parseTime * 1000.0);
+		return result;
+	}
+
+	JBool inf_parse(const char* levelName)
 	{
 		char levelPath[TFE_MAX_PATH];
 		strcpy(levelPath, levelName);
@@ -1316,7 +1338,8 @@ namespace TFE_Jedi
 						while (line = parser.readLine(bufferPos))
 						{
 							char itemName[256];
-							s32 argCount = sscanf(line, " %s %s %s %s %s %s %s", itemName, s_infArg0, s_infArg1, s_infArg2, s_infArg3, s_infArgExtra, s_infArgExtra);
+							char* args[] = { itemName, s_infArg0, s_infArg1, s_infArg2, s_infArg3, s_infArgExtra, s_infArgExtra };
+							s32 argCount = TFE_Parser::scanArgs(line, args, TFE_ARRAYSIZE(args), sizeof(s_infArg0));
 							KEYWORD levelItem = getKeywordIndex(itemName);
 							switch (levelItem)
 							{
@@ -1350,7 +1373,8 @@ namespace TFE_Jedi
 						}
 
 						char id[256];
-						s32 argCount = sscanf(line, " %s %s %s %s %s %s %s", id, s_infArg0, s_infArg1, s_infArg2, s_infArg3, s_infArg4, s_infArgExtra);
+						char* args[] = { id, s_infArg0, s_infArg1, s_infArg2, s_infArg3, s_infArg4, s_infArgExtra };
+						s32 argCount = TFE_Parser::scanArgs(line, args, TFE_ARRAYSIZE(args), sizeof(s_infArg0));
 						KEYWORD itemClass = getKeywordIndex(s_infArg0);
 						assert(itemClass != KW_UNKNOWN);
 
@@ -1395,7 +1419,8 @@ namespace TFE_Jedi
 						}
 
 						char id[256];
-						s32 argCount = sscanf(line, " %s %s %s %s %s", id, s_infArg0, s_infArg1, s_infArg2, s_infArg3);
+						char* args[] = { id, s_infArg0, s_infArg1, s_infArg2, s_infArg3 };
+						s32 argCount = TFE_Parser::scanArgs(line, args, TFE_ARRAYSIZE(args), sizeof(s_infArg0));
 						if (parseLineTrigger(parser, bufferPos, argCount, name, wallNum))
 						{
 							break;
@@ -1633,43 +1658,38 @@ namespace TFE_Jedi
 				while (teleport)
 				{
 					RSector* sector = teleport->sector;
-					s32 objCount = sector->objectCount;
-					SecObject** objList = sector->objectList;
-
-					for (s32 i = 0; i < objCount; objList++)
+					SectorObjectIter iter;
+					sector_beginObjectIter(&iter, sector);
+					while (SecObject* obj = sector_nextObject(&iter))
 					{
-						SecObject* obj = *objList;
-						if (obj)
+						taskCtx->delay = TASK_NO_DELAY;
+						TeleportType type = teleport->type;
+						if (type <= TELEPORT_BASIC)
+						{
+							// So dstPosition is actually an absolute position.
+							obj->posWS = teleport->dstPosition;
+							obj->pitch = teleport->dstAngle[0];
+							obj->yaw   = teleport->dstAngle[1];
+							obj->roll  = teleport->dstAngle[2];
+							sector_addObject(teleport->target, obj);
+						}
+						else if (type == TELEPORT_CHUTE)
 						{
-							i++;
-							taskCtx->delay = TASK_NO_DELAY;
-							TeleportType type = teleport->type;
-							if (type <= TELEPORT_BASIC)
+							sector = teleport->sector;
+							fixed16_16 floorThreshold = sector->floorHeight - HALF_16;
+							// if the object is lower than 0.5 units above the floor.
+							if (floorThreshold < obj->posWS.y)
 							{
-								// So dstPosition is actually an absolute position.
-								obj->posWS = teleport->dstPosition;
-								obj->pitch = teleport->dstAngle[0];
-								obj->yaw   = teleport->dstAngle[1];
-								obj->roll  = teleport->dstAngle[2];
 								sector_addObject(teleport->target, obj);
 							}
-							else if (type == TELEPORT_CHUTE)
-							{
-								sector = teleport->sector;
-								fixed16_16 floorThreshold = sector->floorHeight - HALF_16;
-								// if the object is lower than 0.5 units above the floor.
-								if (floorThreshold < obj->posWS.y)
-								{
-									sector_addObject(teleport->target, obj);
-								}
-							}
+						}
 
-							if (obj->entityFlags & ETFLAG_PLAYER)
-							{
-								// automap_setLayer(obj->sector->layer);
-							}
-						}  // if (obj)
-					}  // for (s32 i = 0; i < objCount; objList++)
+						if (obj->entityFlags & ETFLAG_PLAYER)
+						{
+							// automap_setLayer(obj->sector->layer);
+						}
+					}
+					sector_endObjectIter(&iter);
 					teleport = (Teleport*)allocator_getNext(s_infSerState.infTeleports);
 				}  // while (teleport)
 			}
@@ -2976,6 +2996,7 @@ namespace TFE_Jedi
 
 				sector_setupWallDrawFlags(sector0);
 				sector_setupWallDrawFlags(sector1);
+				collision_invalidateReachability();
 
 				cmd = (AdjoinCmd*)allocator_getNext(adjoinCmds);
 			}
@@ -3024,43 +3045,31 @@ namespace TFE_Jedi
 		{
 			case MSG_WAKEUP:
 			{
-				s32 objCount = sector->objectCount;
-				s32 objCapacity = sector->objectCapacity;
-				SecObject** objList = sector->objectList;
-
-				for (s32 i = 0; i < objCount && i < objCapacity; objList++)
+				SectorObjectIter iter;
+				sector_beginObjectIter(&iter, sector);
+				while (SecObject* obj = sector_nextObject(&iter))
 				{
-					SecObject* obj = *objList;
-					if (obj)
+					if (obj->entityFlags & ETFLAG_CAN_WAKE)
 					{
-						if (obj->entityFlags & ETFLAG_CAN_WAKE)
-						{
-							message_sendToObj(obj, MSG_WAKEUP, nullptr);
-						}
-						i++;
+						message_sendToObj(obj, MSG_WAKEUP, nullptr);
 					}
 				}
+				sector_endObjectIter(&iter);
 			}
 			// MSG_WAKEUP drops through to MSG_MASTER_ON/MSG_MASTER_OFF
 			case MSG_MASTER_ON:
 			case MSG_MASTER_OFF:
 			{
-				s32 objCount = sector->objectCount;
-				s32 objCapacity = sector->objectCapacity;
-				SecObject** objList = sector->objectList;
-
-				for (s32 i = 0; i < objCount && i < objCapacity; objList++)
+				SectorObjectIter iter;
+				sector_beginObjectIter(&iter, sector);
+				while (SecObject* obj = sector_nextObject(&iter))
 				{
-					SecObject* obj = *objList;
-					if (obj)
+					if (obj->entityFlags & ETFLAG_CAN_DISABLE)
 					{
-						if (obj->entityFlags & ETFLAG_CAN_DISABLE)
-						{
-							message_sendToObj(obj, msgType, nullptr);
-						}
-						i++;
+						message_sendToObj(obj, msgType, nullptr);
 					}
 				}
+				sector_endObjectIter(&iter);
 			} break;
 			case MSG_SET_BITS:
 			{
@@ -3374,12 +3383,9 @@ namespace TFE_Jedi
 
 				s32 objCount = sector->objectCount;
 				SecObject** objList = sector->objectList;
-				for (; objCount > 0; objList++)
+				for (s32 i = 0; i < objCount; i++)
 				{
-					SecObject* obj = *objList;
-					if (!obj) { continue; }
-
-					objCount--;
+					SecObject* obj = objList[i];
 					fixed16_16 objHeight = obj->worldHeight + ONE_16;
 					if (obj->posWS.y > offsetHeight) // Object is below the second height
 					{
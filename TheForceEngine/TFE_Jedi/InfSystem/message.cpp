@@ -1,4 +1,5 @@
 #include <cstring>
+#include <cctype>
 
 #include "message.h"
 #include <TFE_Jedi/Memory/allocator.h>
@@ -13,6 +14,7 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <algorithm>
+#include <vector>
 
 namespace TFE_Jedi
 {
@@ -23,16 +25,71 @@ namespace TFE_Jedi
 	u32 s_msgArg2;
 	u32 s_msgEvent;
 
+	// TFE: Case-insensitive hash index over the address names, so lookups no longer walk every address.
+	// Open addressing with linear probing, the capacity is a power of 2 and kept at most half full.
+	enum MessageAddressHash
+	{
+		MSG_ADDR_NAME_LEN     = 16,
+		MSG_ADDR_MIN_CAPACITY = 256,
+	};
+	static std::vector<MessageAddress*> s_messageAddrHash;
+	static u32 s_messageAddrCount = 0;
+
+	static u32 message_hashName(const char* name)
+	{
+		// FNV-1a over the lower case name, limited to the characters compared by strncasecmp().
+		u32 hash = 2166136261u;
+		for (s32 i = 0; i < MSG_ADDR_NAME_LEN && name[i]; i++)
+		{
+			hash ^= u32(tolower((u8)name[i]));
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	static void message_insertHash(MessageAddress* msgAddr)
+	{
+		const u32 mask = u32(s_messageAddrHash.size()) - 1;
+		u32 slot = message_hashName(msgAddr->name) & mask;
+		while (s_messageAddrHash[slot])
+		{
+			// Keep the first address with a given name, which matches the original linear search.
+			if (strncasecmp(msgAddr->name, s_messageAddrHash[slot]->name, MSG_ADDR_NAME_LEN) == 0)
+			{
+				return;
+			}
+			slot = (slot + 1) & mask;
+		}
+		s_messageAddrHash[slot] = msgAddr;
+		s_messageAddrCount++;
+	}
+
+	static void message_growHash()
+	{
+		std::vector<MessageAddress*> prev;
+		prev.swap(s_messageAddrHash);
+		s_messageAddrHash.assign(prev.empty() ? size_t(MSG_ADDR_MIN_CAPACITY) : prev.size() * 2, nullptr);
+		s_messageAddrCount = 0;
+
+		const size_t count = prev.size();
+		for (size_t i = 0; i < count; i++)
+		{
+			if (prev[i]) { message_insertHash(prev[i]); }
+		}
+	}
+
 	void message_free()
 	{
 		s_messageAddr = nullptr;
+		s_messageAddrHash.clear();
+		s_messageAddrCount = 0;
 	}
 
 	void message_addAddress(const char* name, s32 param0, s32 param1, RSector* sector)
 	{
 		if (!s_messageAddr)
 		{
-			s_messageAddr = allocator_create(sizeof(MessageAddress));
+			s_messageAddr = allocator_create(sizeof(MessageAddress), nullptr, ALLOC_SLAB_LARGE);
 		}
 		MessageAddress* msgAddr = (MessageAddress*)allocator_newItem(s_messageAddr);
 
@@ -42,18 +99,29 @@ namespace TFE_Jedi
 		msgAddr->param0 = param0;
 		msgAddr->param1 = param1;
 		msgAddr->sector = sector;
+
+		if ((s_messageAddrCount + 1) * 2 > s_messageAddrHash.size())
+		{
+			message_growHash();
+		}
+		message_insertHash(msgAddr);
 	}
 
 	MessageAddress* message_getAddress(const char* name)
 	{
-		MessageAddress* msgAddr = (MessageAddress*)allocator_getHead(s_messageAddr);
-		while (msgAddr)
+		if (!s_messageAddrHash.empty())
 		{
-			if (strncasecmp(name, msgAddr->name, 16) == 0)
+			const u32 mask = u32(s_messageAddrHash.size()) - 1;
+			u32 slot = message_hashName(name) & mask;
+			while (s_messageAddrHash[slot])
 			{
-				return msgAddr;
+				MessageAddress* msgAddr = s_messageAddrHash[slot];
+				if (strncasecmp(name, msgAddr->name, MSG_ADDR_NAME_LEN) == 0)
+				{
+					return msgAddr;
+				}
+				slot = (slot + 1) & mask;
 			}
-			msgAddr = (MessageAddress*)allocator_getNext(s_messageAddr);
 		}
 
 		TFE_System::logWrite(LOG_ERROR, "INF", "Message_GetAddress: ADDRESS NOT FOUND: %s", name);
@@ -3,7 +3,9 @@
 
 #include "level.h"
 #include "levelData.h"
+#include "levelCache.h"
 #include "rwall.h"
+#include "rsectorGrid.h"
 #include "rtexture.h"
 #include <TFE_Game/igame.h>
 #include <TFE_Asset/assetSystem.h>
@@ -44,10 +46,12 @@ namespace TFE_Jedi
 	static s32 s_dataIndex;
 	static char s_readBuffer[256];
 	static std::vector<char> s_buffer;
+	static CookedLevel s_cookedLevel;
 
 	JBool level_loadGeometry(const char* levelName);
 	JBool level_loadObjects(const char* levelName, u8 difficulty);
 	JBool level_loadGoals(const char* levelName);
+	s32 level_scanObject(const char* line, TokenSlice* objClass, s32* dataIndex, f32* x, f32* y, f32* z, f32* pch, f32* yaw, f32* rol, s32* diff);
 
 	JBool level_load(const char* levelName, u8 difficulty)
 	{
@@ -88,38 +92,18 @@ namespace TFE_Jedi
 		s_palModified = JTRUE;
 	}
 		
-	JBool level_loadGeometry(const char* levelName)
+	// Parse the LEV text into the cooked form.
+	JBool level_parseGeometry(char* buffer, size_t size, CookedLevel* level)
 	{
-		s_levelState.secretCount = 0;
-		s_dataIndex = 0;
-		s_levelState.minLayer = INT_MAX;
-		s_levelState.maxLayer = INT_MIN;
-		message_free();
-
-		char levelPath[TFE_MAX_PATH];
-		strcpy(levelPath, levelName);
-		strcat(levelPath, ".LEV");
-
-		FilePath filePath;
-		if (!TFE_Paths::getFilePath(levelPath, &filePath))
-		{
-			TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot find level geometry '%s'.", levelName);
-			return false;
-		}
-		FileStream file;
-		if (!file.open(&filePath, Stream::MODE_READ))
-		{
-			TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot open level geometry '%s'.", levelName);
-			return false;
-		}
-		size_t len = file.getSize();
-		s_buffer.resize(len);
-		file.readBuffer(s_buffer.data(), u32(len));
-		file.close();
+		level->strings.clear();
+		level->textures.clear();
+		level->sectors.clear();
+		level->walls.clear();
+		level->vertices.clear();
 
 		TFE_Parser parser;
 		size_t bufferPos = 0;
-		parser.init(s_buffer.data(), s_buffer.size());
+		parser.init(buffer, size);
 		parser.addCommentString("#");
 		parser.convertToUpperCase(true);
 
@@ -130,30 +114,28 @@ namespace TFE_Jedi
 		if (sscanf(line, " LEV %d.%d", &versionMajor, &versionMinor) != 2)
 		{
 			TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read version.");
-			return false;
+			return JFALSE;
 		}
 		if (versionMajor != DF_LEVEL_VERSION_MAJOR || versionMinor != DF_LEVEL_VERSION_MINOR)
 		{
 			TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Invalid level version %d.%d.", versionMajor, versionMinor);
-			return false;
+			return JFALSE;
 		}
 		
 		line = parser.readLine(bufferPos);
 		if (sscanf(line, " LEVELNAME %s", s_readBuffer) != 1)
 		{
 			TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read level name.");
-			return false;
+			return JFALSE;
 		}
 
 		// This gets read here just to be overwritten later... so just ignore for now.
 		line = parser.readLine(bufferPos);
-		if (sscanf(line, " PALETTE %s", s_levelState.levelPaletteName) != 1)
+		if (sscanf(line, " PALETTE %s", level->paletteName) != 1)
 		{
 			TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read palette name.");
-			return false;
+			return JFALSE;
 		}
-
-		level_loadPalette();
 		
 		// Another value that is ignored.
 		line = parser.readLine(bufferPos);
@@ -171,85 +153,61 @@ namespace TFE_Jedi
 		if (sscanf(line, " PARALLAX %f %f", &parallax0, &parallax1) != 2)
 		{
 			TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read parallax values.");
-			return false;
+			return JFALSE;
 		}
-		s_levelState.parallax0 = floatToFixed16(parallax0);
-		s_levelState.parallax1 = floatToFixed16(parallax1);
+		level->parallax0 = floatToFixed16(parallax0);
+		level->parallax1 = floatToFixed16(parallax1);
 
 		// Number of textures used by the level.
 		line = parser.readLine(bufferPos);
-		if (sscanf(line, " TEXTURES %d", &s_levelState.textureCount) != 1)
+		s32 textureCount;
+		if (sscanf(line, " TEXTURES %d", &textureCount) != 1)
 		{
 			TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read texture count.");
-			return false;
+			return JFALSE;
 		}
-		s_levelState.textures = (TextureData**)level_alloc(2 * s_levelState.textureCount * sizeof(TextureData**));
-		memset(s_levelState.textures, 0, 2 * s_levelState.textureCount * sizeof(TextureData**));
 
-		// Load Textures.
-		TextureData** texture = s_levelState.textures;
-		TextureData** texBase = s_levelState.textures + s_levelState.textureCount;
-		for (s32 i = 0; i < s_levelState.textureCount; i++, texture++, texBase++)
+		// Texture names.
+		level->textures.resize(textureCount);
+		for (s32 i = 0; i < textureCount; i++)
 		{
 			line = parser.readLine(bufferPos);
 			char textureName[256];
 			if (sscanf(line, " TEXTURE: %s ", textureName) != 1)
 			{
 				TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read texture name.");
-				*texture = bitmap_load("default.bm", 1);
+				level->textures[i] = levelCache_addString(level, "default.bm");
 			}
 			else if (strcasecmp(textureName, "<NoTexture>") == 0)
 			{
-				*texture = nullptr;
+				level->textures[i] = COOKED_NO_TEXTURE;
 			}
 			else
 			{
-				TextureData* tex = bitmap_load(textureName, 1);
-				if (!tex)
-				{
-					TFE_System::logWrite(LOG_WARNING, "level_loadGeometry", "Could not open '%s', using 'default.bm' instead.", textureName);
-					tex = bitmap_load("default.bm", 1);
-					if (!tex)
-					{
-						TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "'default.bm' is not a valid BM file!");
-						assert(0);
-						return false;
-					}
-				}
-				*texture = tex;
-				// This version never gets modified, so serialization is simpler.
-				*texBase = tex;
-
-				// Setup an animated texture.
-				if (tex->uvWidth == BM_ANIMATED_TEXTURE)
-				{
-					bitmap_setupAnimatedTexture(texture, i);
-				}
+				level->textures[i] = levelCache_addString(level, textureName);
 			}
 		}
 
-		// Load Sectors.
+		// Sectors.
+		s32 sectorCount;
 		line = parser.readLine(bufferPos);
-		if (sscanf(line, "NUMSECTORS %d", &s_levelState.sectorCount) != 1)
+		if (sscanf(line, "NUMSECTORS %d", &sectorCount) != 1)
 		{
 			TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read sector count.");
-			return false;
+			return JFALSE;
 		}
 
-		s_levelState.sectors = (RSector*)level_alloc(sizeof(RSector) * s_levelState.sectorCount);
-		memset(s_levelState.sectors, 0, sizeof(RSector) * s_levelState.sectorCount);
-		for (u32 i = 0; i < s_levelState.sectorCount; i++)
+		level->sectors.resize(sectorCount);
+		for (s32 i = 0; i < sectorCount; i++)
 		{
-			RSector* sector = &s_levelState.sectors[i];
-			sector_clear(sector);
-			sector->index = i;
+			CookedSector* sector = &level->sectors[i];
 
 			// Sector ID and Name
 			line = parser.readLine(bufferPos);
 			if (sscanf(line, " SECTOR %d", &sector->id) != 1)
 			{
 				TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read sector id.");
-				return false;
+				return JFALSE;
 			}
 
 			// Allow names to have '#' in them.
@@ -257,24 +215,10 @@ namespace TFE_Jedi
 			// Sectors missing a name are valid but do not get "addresses" - and thus cannot be
 			// used by the INF system (except in the case of doors and exploding walls, see the flags section below).
 			char name[256];
+			sector->nameOffset = COOKED_NO_NAME;
 			if (sscanf(line, " NAME %s", name) == 1)
 			{
-				// Add the sector "address" for later use by the INF system.
-				message_addAddress(name, 0, 0, sector);
-
-				// Track special elevators.
-				if (!strcasecmp(name, "complete"))
-				{
-					s_levelState.completeSector = sector;
-				}
-				else if (!strcasecmp(name, "boss"))
-				{
-					s_levelState.bossSector = sector;
-				}
-				else if (!strcasecmp(name, "mohc"))
-				{
-					s_levelState.mohcSector = sector;
-				}
+				sector->nameOffset = levelCache_addString(level, name);
 			}
 
 			// Lighting
@@ -283,24 +227,18 @@ namespace TFE_Jedi
 			if (sscanf(line, " AMBIENT %d", &ambient) != 1)
 			{
 				TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read sector ambient.");
-				return false;
+				return JFALSE;
 			}
 			sector->ambient = intToFixed16(ambient);
 
 			// Floor Texture & Offset
 			line = parser.readLine(bufferPos);
-			s32 index, tmp;
+			s32 tmp;
 			f32 offsetX, offsetZ;
-			if (sscanf(line, " FLOOR TEXTURE %d %f %f %d", &index, &offsetX, &offsetZ, &tmp) != 4)
+			if (sscanf(line, " FLOOR TEXTURE %d %f %f %d", &sector->floorTex, &offsetX, &offsetZ, &tmp) != 4)
 			{
 				TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read floor texture.");
-				return false;
-			}
-
-			sector->floorTex = nullptr;
-			if (index != -1)
-			{
-				sector->floorTex = &s_levelState.textures[index];
+				return JFALSE;
 			}
 			sector->floorOffset.x = floatToFixed16(offsetX);
 			sector->floorOffset.z = floatToFixed16(offsetZ);
@@ -311,21 +249,16 @@ namespace TFE_Jedi
 			if (sscanf(line, " FLOOR ALTITUDE %f", &alt) != 1)
 			{
 				TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read floor altitude.");
-				return false;
+				return JFALSE;
 			}
 			sector->floorHeight = floatToFixed16(alt);
 
 			// Ceiling Texture & Offset
 			line = parser.readLine(bufferPos);
-			if (sscanf(line, " CEILING TEXTURE %d %f %f %d", &index, &offsetX, &offsetZ, &tmp) != 4)
+			if (sscanf(line, " CEILING TEXTURE %d %f %f %d", &sector->ceilTex, &offsetX, &offsetZ, &tmp) != 4)
 			{
 				TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read ceiling texture.");
-				return false;
-			}
-			sector->ceilTex = nullptr;
-			if (index != -1)
-			{
-				sector->ceilTex = &s_levelState.textures[index];
+				return JFALSE;
 			}
 			sector->ceilOffset.x = floatToFixed16(offsetX);
 			sector->ceilOffset.z = floatToFixed16(offsetZ);
@@ -335,7 +268,7 @@ namespace TFE_Jedi
 			if (sscanf(line, " CEILING ALTITUDE %f", &alt) != 1)
 			{
 				TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read ceiling altitude.");
-				return false;
+				return JFALSE;
 			}
 			sector->ceilingHeight = floatToFixed16(alt);
 
@@ -344,7 +277,7 @@ namespace TFE_Jedi
 			if (sscanf(line, " SECOND ALTITUDE %f", &alt) != 1)
 			{
 				TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read second altitude.");
-				return false;
+				return JFALSE;
 			}
 			sector->secHeight = floatToFixed16(alt);
 
@@ -353,23 +286,7 @@ namespace TFE_Jedi
 			if (sscanf(line, " FLAGS %d %d %d", &sector->flags1, &sector->flags2, &sector->flags3) != 3)
 			{
 				TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read sector flags.");
-				return false;
-			}
-			// Create a door if needed.
-			if (sector->flags1 & SEC_FLAGS1_DOOR)
-			{
-				InfElevator* elev = inf_allocateSpecialElevator(sector, IELEV_SP_DOOR);
-				if (elev) { elev->flags |= INF_EFLAG_DOOR; }
-			}
-			// Create an exploding wall if needed.
-			if (sector->flags1 & SEC_FLAGS1_EXP_WALL)
-			{
-				inf_allocateSpecialElevator(sector, IELEV_SP_EXPLOSIVE_WALL);
-			}
-			// Add secrets.
-			if (sector->flags1 & SEC_FLAGS1_SECRET)
-			{
-				s_levelState.secretCount++;
+				return JFALSE;
 			}
 
 			// Layer
@@ -377,50 +294,42 @@ namespace TFE_Jedi
 			if (sscanf(line, " LAYER %d", &sector->layer) != 1)
 			{
 				TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read sector layer.");
-				return false;
+				return JFALSE;
 			}
-			s_levelState.minLayer = min(s_levelState.minLayer, sector->layer);
-			s_levelState.maxLayer = max(s_levelState.maxLayer, sector->layer);
 
 			// Vertices
 			line = parser.readLine(bufferPos);
-			s32 vertexCount;
-			if (sscanf(line, " VERTICES %d", &vertexCount) != 1)
+			if (sscanf(line, " VERTICES %d", &sector->vertexCount) != 1)
 			{
 				TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read sector vertices.");
-				return false;
+				return JFALSE;
 			}
-			const size_t vtxSize = vertexCount * sizeof(vec2_fixed);
-			sector->verticesWS = (vec2_fixed*)level_alloc(vtxSize);
-			sector->verticesVS = (vec2_fixed*)level_alloc(vtxSize);
-			sector->vertexCount = vertexCount;
-
-			for (s32 v = 0; v < vertexCount; v++)
+			sector->vertexStart = s32(level->vertices.size());
+			level->vertices.resize(sector->vertexStart + sector->vertexCount);
+			vec2_fixed* vertices = &level->vertices[sector->vertexStart];
+			for (s32 v = 0; v < sector->vertexCount; v++)
 			{
 				line = parser.readLine(bufferPos);
 
-				f32 x, z;
+				f32 x = 0.0f, z = 0.0f;
 				sscanf(line, " X: %f Z: %f ", &x, &z);
-				sector->verticesWS[v].x = floatToFixed16(x);
-				sector->verticesWS[v].z = floatToFixed16(z);
+				vertices[v].x = floatToFixed16(x);
+				vertices[v].z = floatToFixed16(z);
 			}
 
 			// Walls
 			line = parser.readLine(bufferPos);
-			s32 wallCount;
-			if (sscanf(line, " WALLS %d", &wallCount) != 1)
+			if (sscanf(line, " WALLS %d", &sector->wallCount) != 1)
 			{
 				TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read sector walls.");
-				return false;
+				return JFALSE;
 			}
-			sector->walls = (RWall*)level_alloc(wallCount * sizeof(RWall));
-			sector->wallCount = wallCount;
-
-			for (s32 w = 0; w < wallCount; w++)
+			sector->wallStart = s32(level->walls.size());
+			level->walls.resize(sector->wallStart + sector->wallCount);
+			CookedWall* wall = &level->walls[sector->wallStart];
+			for (s32 w = 0; w < sector->wallCount; w++, wall++)
 			{
-				s32 light, flags3, flags2, flags1, walk, mirror, adjoin;
-				s32 signTex, unused;
-				s32 botTex, topTex, midTex, right, left;
+				s32 light, walk, unused;
 				f32 signOffsetZ, signOffsetX;
 				f32 botOffsetZ, botOffsetX;
 				f32 topOffsetZ, topOffsetX;
@@ -428,80 +337,226 @@ namespace TFE_Jedi
 
 				line = parser.readLine(bufferPos);
 				if (sscanf(line, " WALL LEFT: %d RIGHT: %d MID: %d %f %f %d TOP: %d %f %f %d BOT: %d %f %f %d SIGN: %d %f %f ADJOIN: %d MIRROR: %d WALK: %d FLAGS: %d %d %d LIGHT: %d",
-					&left, &right, &midTex, &midOffsetX, &midOffsetZ, &unused, &topTex, &topOffsetX, &topOffsetZ, &unused, &botTex, &botOffsetX, &botOffsetZ, &unused,
-					&signTex, &signOffsetX, &signOffsetZ, &adjoin, &mirror, &walk, &flags1, &flags2, &flags3, &light) != 24)
+					&wall->left, &wall->right, &wall->midTex, &midOffsetX, &midOffsetZ, &unused, &wall->topTex, &topOffsetX, &topOffsetZ, &unused, &wall->botTex, &botOffsetX, &botOffsetZ, &unused,
+					&wall->signTex, &signOffsetX, &signOffsetZ, &wall->adjoin, &wall->mirror, &walk, &wall->flags1, &wall->flags2, &wall->flags3, &light) != 24)
 				{
 					TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read wall.");
-					return false;
+					return JFALSE;
+				}
+				wall->light = intToFixed16(light);
+				wall->midOffset  = { floatToFixed16(midOffsetX)  * 8, floatToFixed16(midOffsetZ)  * 8 };
+				wall->topOffset  = { floatToFixed16(topOffsetX)  * 8, floatToFixed16(topOffsetZ)  * 8 };
+				wall->botOffset  = { floatToFixed16(botOffsetX)  * 8, floatToFixed16(botOffsetZ)  * 8 };
+				wall->signOffset = { floatToFixed16(signOffsetX) * 8, floatToFixed16(signOffsetZ) * 8 };
+			}
+		}
+		return JTRUE;
+	}
+
+	// Build the runtime level data from the cooked form.
+	JBool level_buildGeometry(const CookedLevel* level)
+	{
+		strcpy(s_levelState.levelPaletteName, level->paletteName);
+		level_loadPalette();
+		s_levelState.parallax0 = level->parallax0;
+		s_levelState.parallax1 = level->parallax1;
+
+		// Load Textures.
+		s_levelState.textureCount = s32(level->textures.size());
+		s_levelState.textures = (TextureData**)level_alloc(2 * s_levelState.textureCount * sizeof(TextureData**));
+		memset(s_levelState.textures, 0, 2 * s_levelState.textureCount * sizeof(TextureData**));
+
+		// Decode the level textures in parallel first, the loop below then finds them in the texture cache.
+		std::vector<const char*> textureNames;
+		for (s32 i = 0; i < s_levelState.textureCount; i++)
+		{
+			if (level->textures[i] != COOKED_NO_TEXTURE)
+			{
+				textureNames.push_back(&level->strings[level->textures[i]]);
+			}
+		}
+		bitmap_preload(textureNames.data(), s32(textureNames.size()));
+
+		TextureData** texture = s_levelState.textures;
+		TextureData** texBase = s_levelState.textures + s_levelState.textureCount;
+		for (s32 i = 0; i < s_levelState.textureCount; i++, texture++, texBase++)
+		{
+			if (level->textures[i] == COOKED_NO_TEXTURE)
+			{
+				*texture = nullptr;
+				continue;
+			}
+
+			const char* textureName = &level->strings[level->textures[i]];
+			TextureData* tex = bitmap_load(textureName, 1);
+			if (!tex)
+			{
+				TFE_System::logWrite(LOG_WARNING, "level_loadGeometry", "Could not open '%s', using 'default.bm' instead.", textureName);
+				tex = bitmap_load("default.bm", 1);
+				if (!tex)
+				{
+					TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "'default.bm' is not a valid BM file!");
+					assert(0);
+					return JFALSE;
+				}
+			}
+			*texture = tex;
+			// This version never gets modified, so serialization is simpler.
+			*texBase = tex;
+
+			// Setup an animated texture.
+			if (tex->uvWidth == BM_ANIMATED_TEXTURE)
+			{
+				bitmap_setupAnimatedTexture(texture, i);
+			}
+		}
+
+		// Load Sectors.
+		s_levelState.sectorCount = u32(level->sectors.size());
+		s_levelState.sectors = (RSector*)level_alloc(sizeof(RSector) * s_levelState.sectorCount);
+		memset(s_levelState.sectors, 0, sizeof(RSector) * s_levelState.sectorCount);
+		for (u32 i = 0; i < s_levelState.sectorCount; i++)
+		{
+			const CookedSector* src = &level->sectors[i];
+			RSector* sector = &s_levelState.sectors[i];
+			sector_clear(sector);
+			sector->index = i;
+			sector->id = src->id;
+
+			if (src->nameOffset != COOKED_NO_NAME)
+			{
+				const char* name = &level->strings[src->nameOffset];
+				// Add the sector "address" for later use by the INF system.
+				message_addAddress(name, 0, 0, sector);
+
+				// Track special elevators.
+				if (!strcasecmp(name, "complete"))
+				{
+					s_levelState.completeSector = sector;
+				}
+				else if (!strcasecmp(name, "boss"))
+				{
+					s_levelState.bossSector = sector;
+				}
+				else if (!strcasecmp(name, "mohc"))
+				{
+					s_levelState.mohcSector = sector;
 				}
+			}
+
+			sector->ambient = src->ambient;
+			sector->floorTex = (src->floorTex != -1) ? &s_levelState.textures[src->floorTex] : nullptr;
+			sector->floorOffset = src->floorOffset;
+			sector->floorHeight = src->floorHeight;
+			sector->ceilTex = (src->ceilTex != -1) ? &s_levelState.textures[src->ceilTex] : nullptr;
+			sector->ceilOffset = src->ceilOffset;
+			sector->ceilingHeight = src->ceilingHeight;
+			sector->secHeight = src->secHeight;
+
+			sector->flags1 = src->flags1;
+			sector->flags2 = src->flags2;
+			sector->flags3 = src->flags3;
+			// Create a door if needed.
+			if (sector->flags1 & SEC_FLAGS1_DOOR)
+			{
+				InfElevator* elev = inf_allocateSpecialElevator(sector, IELEV_SP_DOOR);
+				if (elev) { elev->flags |= INF_EFLAG_DOOR; }
+			}
+			// Create an exploding wall if needed.
+			if (sector->flags1 & SEC_FLAGS1_EXP_WALL)
+			{
+				inf_allocateSpecialElevator(sector, IELEV_SP_EXPLOSIVE_WALL);
+			}
+			// Add secrets.
+			if (sector->flags1 & SEC_FLAGS1_SECRET)
+			{
+				s_levelState.secretCount++;
+			}
+
+			sector->layer = src->layer;
+			s_levelState.minLayer = min(s_levelState.minLayer, sector->layer);
+			s_levelState.maxLayer = max(s_levelState.maxLayer, sector->layer);
 
+			// Vertices
+			const size_t vtxSize = src->vertexCount * sizeof(vec2_fixed);
+			sector->verticesWS = (vec2_fixed*)level_alloc(vtxSize);
+			sector->verticesVS = (vec2_fixed*)level_alloc(vtxSize);
+			sector->vertexCount = src->vertexCount;
+			if (vtxSize)
+			{
+				memcpy(sector->verticesWS, &level->vertices[src->vertexStart], vtxSize);
+			}
+
+			// Walls
+			sector->walls = (RWall*)level_alloc(src->wallCount * sizeof(RWall));
+			sector->wallCount = src->wallCount;
+
+			const CookedWall* srcWall = src->wallCount ? &level->walls[src->wallStart] : nullptr;
+			for (s32 w = 0; w < src->wallCount; w++, srcWall++)
+			{
 				RWall* wall = &sector->walls[w];
 				wall->id = w;
 				wall->sector = sector;
 				wall->mirrorWall = nullptr;
 				wall->seen = JFALSE;
-				wall->flags1 = flags1;
-				wall->flags2 = flags2;
-				wall->flags3 = flags3;
+				wall->flags1 = srcWall->flags1;
+				wall->flags2 = srcWall->flags2;
+				wall->flags3 = srcWall->flags3;
 
-				vec2_fixed* leftVtxWS = &sector->verticesWS[left];
-				vec2_fixed* rightVtxWS = &sector->verticesWS[right];
+				vec2_fixed* leftVtxWS = &sector->verticesWS[srcWall->left];
+				vec2_fixed* rightVtxWS = &sector->verticesWS[srcWall->right];
 				wall->w0 = leftVtxWS;
 				wall->w1 = rightVtxWS;
-				wall->v0 = &sector->verticesVS[left];
-				wall->v1 = &sector->verticesVS[right];
+				wall->v0 = &sector->verticesVS[srcWall->left];
+				wall->v1 = &sector->verticesVS[srcWall->right];
 				// Store the original position 0 in the wall since it is used by the sector rotation INF.
 				wall->worldPos0.x = leftVtxWS->x;
 				wall->worldPos0.z = leftVtxWS->z;
 
 				wall->nextSector = nullptr;
 				wall->mirror = -1;
-				if (adjoin != -1)
+				if (srcWall->adjoin != -1)
 				{
-					wall->nextSector = &s_levelState.sectors[adjoin];
-					if (mirror == -1)
+					wall->nextSector = &s_levelState.sectors[srcWall->adjoin];
+					if (srcWall->mirror == -1)
 					{
 						TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Adjoining wall missing mirror.");
 					}
-					wall->mirror = mirror;
+					wall->mirror = srcWall->mirror;
 				}
 
 				wall->infLink = nullptr;
 				wall->collisionFrame = 0;
 				wall->drawFrame = 0;
 				wall->drawFlags = 0;
-				wall->wallLight = intToFixed16(light);
+				wall->wallLight = srcWall->light;
 
 				wall->midTex = nullptr;
-				if (midTex != -1)
+				if (srcWall->midTex != -1)
 				{
-					wall->midTex = &s_levelState.textures[midTex];
-					wall->midOffset.x = floatToFixed16(midOffsetX) * 8;
-					wall->midOffset.z = floatToFixed16(midOffsetZ) * 8;
+					wall->midTex = &s_levelState.textures[srcWall->midTex];
+					wall->midOffset = srcWall->midOffset;
 				}
 
 				wall->topTex = nullptr;
-				if (topTex != -1)
+				if (srcWall->topTex != -1)
 				{
-					wall->topTex = &s_levelState.textures[topTex];
-					wall->topOffset.x = floatToFixed16(topOffsetX) * 8;
-					wall->topOffset.z = floatToFixed16(topOffsetZ) * 8;
+					wall->topTex = &s_levelState.textures[srcWall->topTex];
+					wall->topOffset = srcWall->topOffset;
 				}
 
 				wall->botTex = nullptr;
-				if (botTex != -1)
+				if (srcWall->botTex != -1)
 				{
-					wall->botTex = &s_levelState.textures[botTex];
-					wall->botOffset.x = floatToFixed16(botOffsetX) * 8;
-					wall->botOffset.z = floatToFixed16(botOffsetZ) * 8;
+					wall->botTex = &s_levelState.textures[srcWall->botTex];
+					wall->botOffset = srcWall->botOffset;
 				}
 
 				wall->signTex = nullptr;
-				if (signTex != -1)
+				if (srcWall->signTex != -1)
 				{
-					wall->signTex = &s_levelState.textures[signTex];
-					wall->signOffset.x = floatToFixed16(signOffsetX) * 8;
-					wall->signOffset.z = floatToFixed16(signOffsetZ) * 8;
+					wall->signTex = &s_levelState.textures[srcWall->signTex];
+					wall->signOffset = srcWall->signOffset;
 				}
 
 				fixed16_16 dx = rightVtxWS->x - leftVtxWS->x;
@@ -541,7 +596,216 @@ namespace TFE_Jedi
 		s_levelState.controlSector->id = s_levelState.sectorCount;
 		s_levelState.controlSector->index = s_levelState.controlSector->id;
 
-		return true;
+		// TFE: Build the sector grid used to accelerate sector_which3D().
+		sectorGrid_build();
+
+		return JTRUE;
+	}
+
+	JBool level_readGeometryFile(const char* levelName, FilePath* filePath)
+	{
+		char levelPath[TFE_MAX_PATH];
+		strcpy(levelPath, levelName);
+		strcat(levelPath, ".LEV");
+
+		if (!TFE_Paths::getFilePath(levelPath, filePath))
+		{
+			TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot find level geometry '%s'.", levelName);
+			return JFALSE;
+		}
+		FileStream file;
+		if (!file.open(filePath, Stream::MODE_READ))
+		{
+			TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot open level geometry '%s'.", levelName);
+			return JFALSE;
+		}
+		size_t len = file.getSize();
+		s_buffer.resize(len);
+		file.readBuffer(s_buffer.data(), u32(len));
+		file.close();
+		return JTRUE;
+	}
+
+	JBool level_loadGeometry(const char* levelName)
+	{
+		s_levelState.secretCount = 0;
+		s_dataIndex = 0;
+		s_levelState.minLayer = INT_MAX;
+		s_levelState.maxLayer = INT_MIN;
+		message_free();
+
+		FilePath filePath;
+		if (!level_readGeometryFile(levelName, &filePath))
+		{
+			return JFALSE;
+		}
+
+		// Use the cooked level if it matches the source, otherwise parse the text and update the cache.
+		const u64 startTime = TFE_System::getCurrentTimeInTicks();
+		const u64 hash = levelCache_hash(s_buffer.data(), s_buffer.size());
+		const bool cached = levelCache_read(levelName, &filePath, hash, &s_cookedLevel);
+		if (!cached)
+		{
+			if (!level_parseGeometry(s_buffer.data(), s_buffer.size(), &s_cookedLevel))
+			{
+				return JFALSE;
+			}
+			levelCache_write(levelName, &filePath, hash, &s_cookedLevel);
+		}
+		const f64 loadTime = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - startTime);
+		TFE_System::logWrite(LOG_MSG, "level_loadGeometry", "Read '%s' geometry from %s in %.2f ms.", levelName, cached ? "the level cache" : "text", loadTime * 1000.0);
+
+		return level_buildGeometry(&s_cookedLevel);
+	}
+
+	JBool level_benchmarkGeometry(const char* levelName, f64* textTime, f64* cachedTime)
+	{
+		FilePath filePath;
+		if (!level_readGeometryFile(levelName, &filePath))
+		{
+			return JFALSE;
+		}
+		// The parser modifies the buffer (upper case conversion), so parse a copy.
+		std::vector<char> text = s_buffer;
+		const u64 hash = levelCache_hash(s_buffer.data(), s_buffer.size());
+
+		u64 startTime = TFE_System::getCurrentTimeInTicks();
+		if (!level_parseGeometry(text.data(), text.size(), &s_cookedLevel))
+		{
+			return JFALSE;
+		}
+		*textTime = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - startTime);
+		levelCache_write(levelName, &filePath, hash, &s_cookedLevel);
+
+		startTime = TFE_System::getCurrentTimeInTicks();
+		const bool cached = levelCache_read(levelName, &filePath, hash, &s_cookedLevel);
+		*cachedTime = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - startTime);
+		return cached ? JTRUE : JFALSE;
+	}
+
+	JBool level_readTextLines(const char* levelName, const char* ext, std::vector<std::string>& lines, size_t* bytes)
+	{
+		char path[TFE_MAX_PATH];
+		sprintf(path, "%s.%s", levelName, ext);
+
+		FilePath filePath;
+		FileStream file;
+		if (!TFE_Paths::getFilePath(path, &filePath) || !file.open(&filePath, Stream::MODE_READ))
+		{
+			return JFALSE;
+		}
+		const size_t len = file.getSize();
+		s_buffer.resize(len);
+		file.readBuffer(s_buffer.data(), u32(len));
+		file.close();
+
+		TFE_Parser parser;
+		size_t bufferPos = 0;
+		parser.init(s_buffer.data(), s_buffer.size());
+		parser.enableBlockComments();
+		parser.addCommentString("//");
+		parser.addCommentString("#");
+		parser.convertToUpperCase(true);
+
+		const char* line;
+		while ((line = parser.readLine(bufferPos)))
+		{
+			lines.push_back(line);
+			*bytes += lines.back().length();
+		}
+		return JTRUE;
+	}
+
+	// Combines the values read from an object line, so that level_scanObject() can be compared against the original sscanf().
+	static u64 level_objectChecksum(s32 count, const char* objClass, s32 classLen, s32 dataIndex, const f32* transform, s32 diff)
+	{
+		u64 checksum = u64(count) * 1024 + u64(u32(dataIndex)) * 31 + u64(u32(diff)) * 17;
+		for (s32 i = 0; i < classLen; i++)
+		{
+			checksum = checksum * 31 + u8(objClass[i]);
+		}
+		for (s32 i = 0; i < 6; i++)
+		{
+			u32 bits;
+			memcpy(&bits, &transform[i], sizeof(u32));
+			checksum = checksum * 31 + bits;
+		}
+		return checksum;
+	}
+
+	JBool level_benchmarkTextParsing(const char* levelName, s32 repeatCount, size_t* bytes, f64* scanfTime, f64* sliceTime, JBool* match)
+	{
+		// Read the INF and object lines up front so only tokenizing and keyword lookups are timed.
+		std::vector<std::string> lines;
+		*bytes = 0;
+		if (!level_readTextLines(levelName, "INF", lines, bytes))
+		{
+			return JFALSE;
+		}
+		// Object lines are also read as objects, the same way level_loadObjects() tries every line.
+		const size_t objStart = lines.size();
+		if (!level_readTextLines(levelName, "O", lines, bytes))
+		{
+			return JFALSE;
+		}
+		*bytes *= repeatCount;
+
+		enum { BENCH_ARG_COUNT = 7 };
+		char argBuffer[BENCH_ARG_COUNT][256];
+		char* args[BENCH_ARG_COUNT];
+		for (s32 a = 0; a < BENCH_ARG_COUNT; a++) { args[a] = argBuffer[a]; }
+
+		// The original path: sscanf() and a linear keyword search.
+		u64 scanfChecksum = 0;
+		u64 startTime = TFE_System::getCurrentTimeInTicks();
+		for (s32 r = 0; r < repeatCount; r++)
+		{
+			for (size_t l = 0; l < lines.size(); l++)
+			{
+				const s32 argCount = sscanf(lines[l].c_str(), " %255s %255s %255s %255s %255s %255s %255s", args[0], args[1], args[2], args[3], args[4], args[5], args[6]);
+				scanfChecksum += u64(argCount) * 1024 + u64(argCount > 0 ? getKeywordIndexLinear(args[0]) + 1 : 0);
+				for (s32 a = 0; a < argCount; a++) { scanfChecksum += u8(args[a][0]); }
+
+				if (l >= objStart)
+				{
+					s32 dataIndex = 0, diff = 0;
+					f32 t[6] = { 0 };
+					argBuffer[0][0] = 0;
+					const s32 count = sscanf(lines[l].c_str(), " CLASS: %255s DATA: %d X: %f Y: %f Z: %f PCH: %f YAW: %f ROL: %f DIFF: %d",
+						argBuffer[0], &dataIndex, &t[0], &t[1], &t[2], &t[3], &t[4], &t[5], &diff);
+					// sscanf() returns EOF if the line ends before the class name, where level_scanObject() returns 0.
+					scanfChecksum += level_objectChecksum(count < 0 ? 0 : count, argBuffer[0], s32(strlen(argBuffer[0])), dataIndex, t, diff);
+				}
+			}
+		}
+		*scanfTime = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - startTime);
+
+		// The zero allocation scanner and perfect hash lookup.
+		u64 sliceChecksum = 0;
+		startTime = TFE_System::getCurrentTimeInTicks();
+		for (s32 r = 0; r < repeatCount; r++)
+		{
+			for (size_t l = 0; l < lines.size(); l++)
+			{
+				const s32 argCount = TFE_Parser::scanArgs(lines[l].c_str(), args, BENCH_ARG_COUNT, sizeof(argBuffer[0]));
+				sliceChecksum += u64(argCount) * 1024 + u64(argCount > 0 ? getKeywordIndex(args[0]) + 1 : 0);
+				for (s32 a = 0; a < argCount; a++) { sliceChecksum += u8(args[a][0]); }
+
+				if (l >= objStart)
+				{
+					s32 dataIndex = 0, diff = 0;
+					f32 t[6] = { 0 };
+					TokenSlice objClass = { "", 0 };
+					const s32 count = level_scanObject(lines[l].c_str(), &objClass, &dataIndex, &t[0], &t[1], &t[2], &t[3], &t[4], &t[5], &diff);
+					// Match the %255s truncation.
+					sliceChecksum += level_objectChecksum(count, objClass.str, objClass.len < 255 ? objClass.len : 255, dataIndex, t, diff);
+				}
+			}
+		}
+		*sliceTime = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - startTime);
+
+		*match = (scanfChecksum == sliceChecksum) ? JTRUE : JFALSE;
+		return JTRUE;
 	}
 
 	void level_freeAllAssets()
@@ -675,6 +939,36 @@ namespace TFE_Jedi
 		// TODO
 	}
 
+	// Equivalent to sscanf(line, " CLASS: %s DATA: %d X: %f Y: %f Z: %f PCH: %f YAW: %f ROL: %f DIFF: %d", ...)
+	// except that the class name is returned as a slice into the line.
+	// Returns the number of values read, values after the first mismatch are left unchanged.
+	s32 level_scanObject(const char* line, TokenSlice* objClass, s32* dataIndex, f32* x, f32* y, f32* z, f32* pch, f32* yaw, f32* rol, s32* diff)
+	{
+		const char* c_transformLabels[] = { "X:", "Y:", "Z:", "PCH:", "YAW:", "ROL:" };
+		f32* transform[] = { x, y, z, pch, yaw, rol };
+
+		if (!(line = TFE_Parser::scanLiteral(line, "CLASS:")) || !(line = TFE_Parser::scanToken(line, *objClass)))
+		{
+			return 0;
+		}
+		if (!(line = TFE_Parser::scanLiteral(line, "DATA:")) || !(line = TFE_Parser::scanInt(line, *dataIndex)))
+		{
+			return 1;
+		}
+		for (s32 i = 0; i < s32(TFE_ARRAYSIZE(transform)); i++)
+		{
+			if (!(line = TFE_Parser::scanLiteral(line, c_transformLabels[i])) || !(line = TFE_Parser::scanFloat(line, *transform[i])))
+			{
+				return 2 + i;
+			}
+		}
+		if (!(line = TFE_Parser::scanLiteral(line, "DIFF:")) || !TFE_Parser::scanInt(line, *diff))
+		{
+			return 8;
+		}
+		return 9;
+	}
+
 	JBool level_loadObjects(const char* levelName, u8 difficulty)
 	{
 		char levelPath[TFE_MAX_PATH];
@@ -839,9 +1133,9 @@ namespace TFE_Jedi
 
 					s32 objDiff = 0;
 					f32 x, y, z, pch, yaw, rol;
-					char objClass[32];
+					TokenSlice objClass;
 
-					if (sscanf(line, " CLASS: %s DATA: %d X: %f Y: %f Z: %f PCH: %f YAW: %f ROL: %f DIFF: %d", objClass, &s_dataIndex, &x, &y, &z, &pch, &yaw, &rol, &objDiff) > 5)
+					if (level_scanObject(line, &objClass, &s_dataIndex, &x, &y, &z, &pch, &yaw, &rol, &objDiff) > 5)
 					{
 						objIndex++;
 						// objDiff >= 0: This difficulty and all greater.
@@ -871,7 +1165,7 @@ namespace TFE_Jedi
 						obj->yaw   = floatDegreesToFixed(yaw);
 						obj->roll  = floatDegreesToFixed(rol);
 
-						KEYWORD classType = getKeywordIndex(objClass);
+						KEYWORD classType = getKeywordIndex(objClass.str, objClass.len);
 						switch (classType)
 						{
 							case KW_3D:
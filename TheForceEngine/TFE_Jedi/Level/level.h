@@ -52,6 +52,12 @@ namespace TFE_Jedi
 
 	void level_addSound(const char* name, u32 freq, s32 priority);
 	void level_loadPalette();
+	// Times parsing the LEV text against reading the cooked level cache (the cache is updated first).
+	JBool level_benchmarkGeometry(const char* levelName, f64* textTime, f64* cachedTime);
+	// Times tokenizing and keyword lookups for the level INF and O files, comparing sscanf() and a linear keyword search
+	// against the zero allocation scanner and perfect hash, and object lines with the original sscanf() against level_scanObject().
+	// Each file is parsed 'repeatCount' times.
+	JBool level_benchmarkTextParsing(const char* levelName, s32 repeatCount, size_t* bytes, f64* scanfTime, f64* sliceTime, JBool* match);
 
 	void level_updateSecretPercent();
 
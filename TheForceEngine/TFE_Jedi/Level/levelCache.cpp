@@ -0,0 +1,247 @@
+#include <climits>
+#include <cstring>
+
+#include "levelCache.h"
+#include <TFE_Archive/archive.h>
+#include <TFE_FileSystem/filestream.h>
+#include <TFE_FileSystem/fileutil.h>
+#include <TFE_FileSystem/paths.h>
+#include <TFE_System/system.h>
+
+namespace TFE_Jedi
+{
+	enum LevelCacheVersion
+	{
+		LCACHE_VERSION_INIT = 1,
+		LCACHE_VERSION_CUR = LCACHE_VERSION_INIT,
+	};
+	static const u32 c_levelCacheMagic = 0x43564c54;	// "TLVC"
+
+	struct LevelCacheHeader
+	{
+		u32 magic;
+		u32 version;
+		u64 hash;
+		// Sizes are stored so that the cache is rejected if the cooked structures change.
+		u32 sectorSize;
+		u32 wallSize;
+
+		fixed16_16 parallax0;
+		fixed16_16 parallax1;
+		char paletteName[256];
+
+		u32 stringSize;
+		u32 textureCount;
+		u32 sectorCount;
+		u32 wallCount;
+		u32 vertexCount;
+	};
+
+	void levelCache_getPath(const char* levelName, const FilePath* source, char* path)
+	{
+		char cacheDir[TFE_MAX_PATH];
+		sprintf(cacheDir, "%sLevelCache/", TFE_Paths::getPath(PATH_PROGRAM_DATA));
+		if (!FileUtil::directoryExits(cacheDir))
+		{
+			FileUtil::makeDirectory(cacheDir);
+		}
+
+		// Key by the archive so that mods replacing a level do not keep overwriting the stock cache.
+		const char* archiveName = (source && source->archive) ? source->archive->getName() : "Local";
+		sprintf(path, "%s%s_%s.lvc", cacheDir, archiveName, levelName);
+	}
+
+	u64 levelCache_hash(const void* data, size_t size)
+	{
+		// FNV-1a
+		const u8* bytes = (const u8*)data;
+		u64 hash = 14695981039346656037ull;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	s32 levelCache_addString(CookedLevel* level, const char* str)
+	{
+		const s32 offset = s32(level->strings.size());
+		level->strings.insert(level->strings.end(), str, str + strlen(str) + 1);
+		return offset;
+	}
+
+	static bool isValidTexture(s32 texture, s32 textureCount)
+	{
+		return texture == COOKED_NO_TEXTURE || (texture >= 0 && texture < textureCount);
+	}
+
+	// The cache is only trusted after every index has been checked, so a stale or corrupt file cannot read or write
+	// out of bounds when the level is built.
+	static bool levelCache_validate(const CookedLevel* level)
+	{
+		// Every offset must point into the table and the table must end with a terminator,
+		// so every string is null terminated.
+		const s32 stringSize   = s32(level->strings.size());
+		const s32 textureCount = s32(level->textures.size());
+		const s32 sectorCount  = s32(level->sectors.size());
+		const s32 wallCount    = s32(level->walls.size());
+		const s32 vertexCount  = s32(level->vertices.size());
+		if (stringSize && level->strings[stringSize - 1] != 0)
+		{
+			return false;
+		}
+		for (s32 i = 0; i < textureCount; i++)
+		{
+			const s32 offset = level->textures[i];
+			if (offset != COOKED_NO_TEXTURE && (offset < 0 || offset >= stringSize))
+			{
+				return false;
+			}
+		}
+
+		for (s32 i = 0; i < sectorCount; i++)
+		{
+			const CookedSector* sector = &level->sectors[i];
+			if (sector->nameOffset != COOKED_NO_NAME && (sector->nameOffset < 0 || sector->nameOffset >= stringSize))
+			{
+				return false;
+			}
+			if (!isValidTexture(sector->floorTex, textureCount) || !isValidTexture(sector->ceilTex, textureCount))
+			{
+				return false;
+			}
+			if (sector->vertexStart < 0 || sector->vertexCount < 0 || sector->vertexCount > vertexCount - sector->vertexStart ||
+				sector->wallStart < 0 || sector->wallCount < 0 || sector->wallCount > wallCount - sector->wallStart)
+			{
+				return false;
+			}
+		}
+
+		for (s32 i = 0; i < sectorCount; i++)
+		{
+			const CookedSector* sector = &level->sectors[i];
+			for (s32 w = 0; w < sector->wallCount; w++)
+			{
+				const CookedWall* wall = &level->walls[sector->wallStart + w];
+				if (wall->left < 0 || wall->left >= sector->vertexCount || wall->right < 0 || wall->right >= sector->vertexCount)
+				{
+					return false;
+				}
+				if (!isValidTexture(wall->midTex, textureCount) || !isValidTexture(wall->topTex, textureCount) ||
+					!isValidTexture(wall->botTex, textureCount) || !isValidTexture(wall->signTex, textureCount))
+				{
+					return false;
+				}
+				if (wall->adjoin == -1) { continue; }
+				if (wall->adjoin < 0 || wall->adjoin >= sectorCount)
+				{
+					return false;
+				}
+				// A missing mirror is reported when the level is built, the same as for the text.
+				if (wall->mirror != -1 && (wall->mirror < 0 || wall->mirror >= level->sectors[wall->adjoin].wallCount))
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	bool levelCache_read(const char* levelName, const FilePath* source, u64 hash, CookedLevel* level)
+	{
+		char path[TFE_MAX_PATH];
+		levelCache_getPath(levelName, source, path);
+
+		FileStream file;
+		if (!file.open(path, Stream::MODE_READ))
+		{
+			return false;
+		}
+
+		LevelCacheHeader header;
+		if (file.readBuffer(&header, sizeof(LevelCacheHeader)) != sizeof(LevelCacheHeader) || header.magic != c_levelCacheMagic ||
+			header.version != LCACHE_VERSION_CUR || header.hash != hash || header.sectorSize != sizeof(CookedSector) || header.wallSize != sizeof(CookedWall))
+		{
+			file.close();
+			return false;
+		}
+		// The counts are stored as s32 in the cooked data.
+		if (header.stringSize > INT_MAX || header.textureCount > INT_MAX || header.sectorCount > INT_MAX || header.wallCount > INT_MAX || header.vertexCount > INT_MAX)
+		{
+			file.close();
+			return false;
+		}
+		const size_t expectedSize = sizeof(LevelCacheHeader) + header.stringSize + header.textureCount * sizeof(s32) + header.sectorCount * sizeof(CookedSector) +
+			header.wallCount * sizeof(CookedWall) + header.vertexCount * sizeof(vec2_fixed);
+		if (file.getSize() != expectedSize)
+		{
+			file.close();
+			return false;
+		}
+
+		header.paletteName[255] = 0;
+		strcpy(level->paletteName, header.paletteName);
+		level->parallax0 = header.parallax0;
+		level->parallax1 = header.parallax1;
+
+		level->strings.resize(header.stringSize);
+		level->textures.resize(header.textureCount);
+		level->sectors.resize(header.sectorCount);
+		level->walls.resize(header.wallCount);
+		level->vertices.resize(header.vertexCount);
+
+		const u32 textureSize = u32(header.textureCount * sizeof(s32));
+		const u32 sectorSize  = u32(header.sectorCount * sizeof(CookedSector));
+		const u32 wallSize    = u32(header.wallCount * sizeof(CookedWall));
+		const u32 vertexSize  = u32(header.vertexCount * sizeof(vec2_fixed));
+		const bool readAll = file.readBuffer(level->strings.data(), header.stringSize) == header.stringSize &&
+			file.readBuffer(level->textures.data(), textureSize) == textureSize &&
+			file.readBuffer(level->sectors.data(), sectorSize) == sectorSize &&
+			file.readBuffer(level->walls.data(), wallSize) == wallSize &&
+			file.readBuffer(level->vertices.data(), vertexSize) == vertexSize;
+		file.close();
+
+		if (!readAll || !levelCache_validate(level))
+		{
+			TFE_System::logWrite(LOG_WARNING, "LevelCache", "Level cache '%s' is invalid, parsing the level instead.", path);
+			return false;
+		}
+		return true;
+	}
+
+	void levelCache_write(const char* levelName, const FilePath* source, u64 hash, const CookedLevel* level)
+	{
+		char path[TFE_MAX_PATH];
+		levelCache_getPath(levelName, source, path);
+
+		FileStream file;
+		if (!file.open(path, Stream::MODE_WRITE))
+		{
+			TFE_System::logWrite(LOG_WARNING, "LevelCache", "Cannot write level cache '%s'.", path);
+			return;
+		}
+
+		LevelCacheHeader header = {};
+		header.magic = c_levelCacheMagic;
+		header.version = LCACHE_VERSION_CUR;
+		header.hash = hash;
+		header.sectorSize = sizeof(CookedSector);
+		header.wallSize = sizeof(CookedWall);
+		header.parallax0 = level->parallax0;
+		header.parallax1 = level->parallax1;
+		strcpy(header.paletteName, level->paletteName);
+		header.stringSize = u32(level->strings.size());
+		header.textureCount = u32(level->textures.size());
+		header.sectorCount = u32(level->sectors.size());
+		header.wallCount = u32(level->walls.size());
+		header.vertexCount = u32(level->vertices.size());
+
+		file.writeBuffer(&header, sizeof(LevelCacheHeader));
+		file.writeBuffer(level->strings.data(), header.stringSize);
+		file.writeBuffer(level->textures.data(), u32(header.textureCount * sizeof(s32)));
+		file.writeBuffer(level->sectors.data(), u32(header.sectorCount * sizeof(CookedSector)));
+		file.writeBuffer(level->walls.data(), u32(header.wallCount * sizeof(CookedWall)));
+		file.writeBuffer(level->vertices.data(), u32(header.vertexCount * sizeof(vec2_fixed)));
+		file.close();
+	}
+}
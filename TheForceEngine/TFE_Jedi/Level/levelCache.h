@@ -0,0 +1,87 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Level Cache
+// Cooked binary form of the LEV geometry, stored on disk under
+// PATH_PROGRAM_DATA so that later loads of the same level skip the
+// text parser.
+//
+// Cache files are named after the source archive and the level and
+// store a hash of the LEV text, a cache file is only used if the hash
+// matches the current source, otherwise the text is parsed again and
+// the cache is rewritten.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include <TFE_Jedi/Math/core_math.h>
+#include <TFE_Jedi/Math/fixedPoint.h>
+#include <vector>
+
+struct FilePath;
+
+namespace TFE_Jedi
+{
+	enum CookedLevelConst
+	{
+		COOKED_NO_TEXTURE = -1,		// "<NoTexture>" in the texture list.
+		COOKED_NO_NAME    = -1,		// Sector without a name.
+	};
+
+	// Values are stored in their final (fixed point) form.
+	struct CookedSector
+	{
+		s32 id;
+		s32 nameOffset;				// Offset into CookedLevel::strings or COOKED_NO_NAME.
+		fixed16_16 ambient;
+		s32 floorTex;
+		s32 ceilTex;
+		vec2_fixed floorOffset;
+		vec2_fixed ceilOffset;
+		fixed16_16 floorHeight;
+		fixed16_16 ceilingHeight;
+		fixed16_16 secHeight;
+		u32 flags1;
+		u32 flags2;
+		u32 flags3;
+		s32 layer;
+		s32 vertexStart;
+		s32 vertexCount;
+		s32 wallStart;
+		s32 wallCount;
+	};
+
+	struct CookedWall
+	{
+		s32 left, right;
+		s32 midTex, topTex, botTex, signTex;
+		vec2_fixed midOffset;
+		vec2_fixed topOffset;
+		vec2_fixed botOffset;
+		vec2_fixed signOffset;
+		s32 adjoin;
+		s32 mirror;
+		u32 flags1;
+		u32 flags2;
+		u32 flags3;
+		fixed16_16 light;
+	};
+
+	struct CookedLevel
+	{
+		char paletteName[256];
+		fixed16_16 parallax0;
+		fixed16_16 parallax1;
+
+		std::vector<char> strings;		// Texture and sector names, null terminated.
+		std::vector<s32> textures;		// Offsets into 'strings' or COOKED_NO_TEXTURE.
+		std::vector<CookedSector> sectors;
+		std::vector<CookedWall> walls;
+		std::vector<vec2_fixed> vertices;
+	};
+
+	u64  levelCache_hash(const void* data, size_t size);
+	// Adds a null terminated string to the level string table and returns its offset.
+	s32  levelCache_addString(CookedLevel* level, const char* str);
+
+	// Returns false if there is no cache for the level or it does not match 'hash'.
+	bool levelCache_read(const char* levelName, const FilePath* source, u64 hash, CookedLevel* level);
+	void levelCache_write(const char* levelName, const FilePath* source, u64 hash, const CookedLevel* level);
+}
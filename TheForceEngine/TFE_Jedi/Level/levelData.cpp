@@ -4,10 +4,12 @@
 #include "levelData.h"
 #include "rsector.h"
 #include "rwall.h"
+#include "rsectorGrid.h"
 #include "robjData.h"
 #include <TFE_Game/igame.h>
 #include <TFE_System/system.h>
 #include <TFE_Asset/spriteAsset_Jedi.h>
+#include <TFE_Jedi/Collision/collision.h>
 #include <TFE_Jedi/Serialization/serialization.h>
 
 // TODO: coupling between Dark Forces and Jedi.
@@ -49,11 +51,13 @@ namespace TFE_Jedi
 	{
 		s_levelState = { 0 };
 		s_levelIntState = { 0 };
+		sectorGrid_clear();
 
 		s_levelState.controlSector = (RSector*)level_alloc(sizeof(RSector));
 		sector_clear(s_levelState.controlSector);
 
 		objData_clear();
+		collision_invalidateReachability();
 	}
 
 	void level_serializeFixupMirrors()
@@ -215,6 +219,7 @@ namespace TFE_Jedi
 			}
 
 			level_serializeFixupMirrors();
+			sectorGrid_build();
 		}
 
 		// Serialize objects.
@@ -6,6 +6,7 @@
 #include "robject.h"
 #include "level.h"
 #include "levelData.h"
+#include "rsectorGrid.h"
 #include <TFE_Game/igame.h>
 #include <TFE_System/system.h>
 #include <TFE_DarkForces/player.h>
@@ -25,6 +26,11 @@ using namespace TFE_DarkForces;
 
 namespace TFE_Jedi
 {
+	enum SectorConstants
+	{
+		OBJ_LIST_MIN_CAPACITY = 8,
+	};
+
 	// Internal Forward Declarations
 	void sector_computeWallDirAndLength(RWall* wall);
 	void sector_moveWallVertex(RWall* wall, fixed16_16 offsetX, fixed16_16 offsetZ);
@@ -33,6 +39,9 @@ namespace TFE_Jedi
 	void sector_moveObjects(RSector* sector, u32 flags, fixed16_16 offsetX, fixed16_16 offsetZ);
 
 	f32 isLeft(Vec2f p0, Vec2f p1, Vec2f p2);
+
+	// TFE: Active object iterators, see SectorObjectIter.
+	static SectorObjectIter* s_objectIter = nullptr;
 	
 	/////////////////////////////////////////////////
 	// API Implementation
@@ -104,11 +113,9 @@ namespace TFE_Jedi
 		if (sector->objectCount)
 		{
 			fixed16_16 heightOffset = secondHeightOffset + floorOffset;
-			for (s32 i = 0; i < sector->objectCapacity; i++)
+			for (s32 i = 0; i < sector->objectCount; i++)
 			{
 				SecObject* obj = sector->objectList[i];
-				if (!obj) { continue; }
-				
 				if (obj->posWS.y == sector->floorHeight)
 				{
 					obj->posWS.y += floorOffset;
@@ -143,6 +150,8 @@ namespace TFE_Jedi
 		sector->ceilingHeight += ceilOffset;
 		sector->floorHeight += floorOffset;
 		sector->secHeight += secondHeightOffset;
+		// TFE: Openings between sectors may have changed.
+		collision_updateReachability(sector);
 
 		// Update wall data.
 		s32 wallCount = sector->wallCount;
@@ -205,20 +214,17 @@ namespace TFE_Jedi
 		sector->boundsMax.x = maxX;
 		sector->boundsMin.z = minZ;
 		sector->boundsMax.z = maxZ;
+		// TFE: Keep the sector grid up to date as INF moves or rotates walls.
+		sectorGrid_updateSector(sector);
 	}
 
 	fixed16_16 sector_getMaxObjectHeight(RSector* sector)
 	{
 		s32 maxObjHeight = 0;
 		SecObject** objectList = sector->objectList;
-		for (s32 count = sector->objectCount; count > 0; objectList++)
+		for (s32 i = 0; i < sector->objectCount; i++)
 		{
-			SecObject* obj = *objectList;
-			if (obj)
-			{
-				maxObjHeight = max(maxObjHeight, obj->worldHeight + ONE_16);
-				count--;
-			}
+			maxObjHeight = max(maxObjHeight, objectList[i]->worldHeight + ONE_16);
 		}
 		return maxObjHeight;
 	}
@@ -380,41 +386,35 @@ namespace TFE_Jedi
 
 	void sector_growObjectList(RSector* sector)
 	{
-		s32 objectCapacity = sector->objectCapacity;
+		const s32 objectCapacity = sector->objectCapacity;
 		if (sector->objectCount >= objectCapacity)
 		{
+			// TFE: Grow geometrically from the level region rather than 5 slots at a time.
+			const s32 newCapacity = objectCapacity ? objectCapacity * 2 : OBJ_LIST_MIN_CAPACITY;
 			SecObject** list;
 			if (!objectCapacity)
 			{
-				list = (SecObject**)level_alloc(sizeof(SecObject*) * 5);
+				list = (SecObject**)level_alloc(sizeof(SecObject*) * newCapacity);
 				sector->objectList = list;
 			}
 			else
 			{
-				sector->objectList = (SecObject**)level_realloc(sector->objectList, sizeof(SecObject*) * (objectCapacity + 5));
+				sector->objectList = (SecObject**)level_realloc(sector->objectList, sizeof(SecObject*) * newCapacity);
 				list = sector->objectList + objectCapacity;
 			}
-			memset(list, 0, sizeof(SecObject*) * 5);
-			sector->objectCapacity += 5;
+			memset(list, 0, sizeof(SecObject*) * (newCapacity - objectCapacity));
+			sector->objectCapacity = newCapacity;
 		}
 	}
 
 	void sector_addObjectToList(RSector* sector, SecObject* obj)
 	{
-		// Then add the object to the first free slot.
-		// Note that this scheme is optimized for deletion rather than addition.
-		SecObject** list = sector->objectList;
-		for (s32 i = 0; i < sector->objectCapacity; i++, list++)
-		{
-			if (!(*list))
-			{
-				*list = obj;
-				obj->index = i;
-				obj->sector = sector;
-				sector->objectCount++;
-				break;
-			}
-		}
+		// TFE: The list is kept dense, so the object is added to the end.
+		const s32 index = sector->objectCount;
+		sector->objectList[index] = obj;
+		obj->index = index;
+		obj->sector = sector;
+		sector->objectCount++;
 	}
 
 	// Skips some of the checks and does not send messages.
@@ -432,7 +432,7 @@ namespace TFE_Jedi
 		// Grow the object list if necessary.
 		sector_growObjectList(sector);
 
-		// Then add the object to the first free slot.
+		// Then add the object to the end of the list.
 		sector_addObjectToList(sector, obj);
 	}
 
@@ -475,8 +475,38 @@ namespace TFE_Jedi
 		sector->dirtyFlags |= SDF_CHANGE_OBJ;
 
 		// Remove the object from the object list.
+		// TFE: Move the last object into the slot to keep the list dense.
 		SecObject** objList = sector->objectList;
-		objList[obj->index] = nullptr;
+		s32 hole = obj->index;
+		// If the slot has been visited by an active iterator, first move the last visited object into it,
+		// so the visited objects stay in front and the last object cannot be moved behind the iterator.
+		while (1)
+		{
+			SectorObjectIter* iter = nullptr;
+			for (SectorObjectIter* active = s_objectIter; active; active = active->prevIter)
+			{
+				if (active->sector == sector && active->next > hole && (!iter || active->next < iter->next))
+				{
+					iter = active;
+				}
+			}
+			if (!iter) { break; }
+
+			iter->next--;
+			if (iter->next != hole)
+			{
+				objList[hole] = objList[iter->next];
+				objList[hole]->index = hole;
+				hole = iter->next;
+			}
+		}
+		const s32 last = sector->objectCount - 1;
+		if (last != hole)
+		{
+			objList[hole] = objList[last];
+			objList[hole]->index = hole;
+		}
+		objList[last] = nullptr;
 		sector->objectCount--;
 
 		if (!((obj->entityFlags & ETFLAG_PLAYER) && s_playerDying))
@@ -489,6 +519,26 @@ namespace TFE_Jedi
 		}
 	}
 
+	void sector_beginObjectIter(SectorObjectIter* iter, RSector* sector)
+	{
+		iter->sector = sector;
+		iter->next = 0;
+		iter->prevIter = s_objectIter;
+		s_objectIter = iter;
+	}
+
+	SecObject* sector_nextObject(SectorObjectIter* iter)
+	{
+		RSector* sector = iter->sector;
+		return iter->next < sector->objectCount ? sector->objectList[iter->next++] : nullptr;
+	}
+
+	void sector_endObjectIter(SectorObjectIter* iter)
+	{
+		assert(s_objectIter == iter);
+		s_objectIter = iter->prevIter;
+	}
+
 	void sector_changeGlobalLightLevel()
 	{
 		RSector* sector = s_levelState.sectors;
@@ -506,13 +556,18 @@ namespace TFE_Jedi
 		fixed16_16 iz = dz;
 		fixed16_16 y = dy;
 		
-		RSector* sector = s_levelState.sectors;
 		RSector* foundSector = nullptr;
 		s32 sectorUnitArea = 0;
 		s32 prevSectorUnitArea = INT_MAX;
 
-		for (u32 i = 0; i < s_levelState.sectorCount; i++, sector++)
+		// TFE: Only test the sectors in the grid cell containing the point, in the same order as the full list.
+		const u32* candidates = nullptr;
+		s32 count = s32(s_levelState.sectorCount);
+		const JBool useGrid = sectorGrid_getCandidates(ix, iz, &candidates, &count);
+
+		for (s32 i = 0; i < count; i++)
 		{
+			RSector* sector = &s_levelState.sectors[useGrid ? candidates[i] : i];
 			if (y >= sector->ceilingHeight && y <= sector->floorHeight)
 			{
 				const fixed16_16 sectorMaxX = sector->boundsMax.x;
@@ -545,13 +600,18 @@ namespace TFE_Jedi
 		fixed16_16 ix = dx;
 		fixed16_16 iz = dz;
 
-		RSector* sector = s_levelState.sectors;
 		RSector* foundSector = nullptr;
 		s32 sectorUnitArea = 0;
 		s32 prevSectorUnitArea = INT_MAX;
 
-		for (u32 i = 0; i < s_levelState.sectorCount; i++, sector++)
+		// TFE: Only test the sectors in the grid cell containing the point, in the same order as the full list.
+		const u32* candidates = nullptr;
+		s32 count = s32(s_levelState.sectorCount);
+		const JBool useGrid = sectorGrid_getCandidates(ix, iz, &candidates, &count);
+
+		for (s32 i = 0; i < count; i++)
 		{
+			RSector* sector = &s_levelState.sectors[useGrid ? candidates[i] : i];
 			if (sector->layer == layer)
 			{
 				const fixed16_16 sectorMaxX = sector->boundsMax.x;
@@ -821,24 +881,20 @@ namespace TFE_Jedi
 		s32 freeCount = 0;
 		SecObject* freeList[128];
 
-		for (s32 i = 0, idx = 0; i < objectCount && idx < sector->objectCapacity; idx++)
+		for (s32 i = 0; i < objectCount; i++)
 		{
-			SecObject* obj = sector->objectList[idx];
-			if (obj)
-			{
-				i++;
+			SecObject* obj = sector->objectList[i];
 
-				JBool canRemove = (obj->entityFlags & ETFLAG_CORPSE) != 0;
-				canRemove |= ((obj->entityFlags & ETFLAG_PICKUP) && !(obj->flags & OBJ_FLAG_MISSION));
+			JBool canRemove = (obj->entityFlags & ETFLAG_CORPSE) != 0;
+			canRemove |= ((obj->entityFlags & ETFLAG_PICKUP) && !(obj->flags & OBJ_FLAG_MISSION));
 
-				const u32 projType = (obj->projectileLogic) ? ((TFE_DarkForces::ProjectileLogic*)obj->projectileLogic)->type : (0);
-				const JBool isLandMine = projType == PROJ_LAND_MINE || projType == PROJ_LAND_MINE_PROX || projType == PROJ_LAND_MINE_PLACED;
-				canRemove |= ((obj->entityFlags & ETFLAG_PROJECTILE) && isLandMine);
+			const u32 projType = (obj->projectileLogic) ? ((TFE_DarkForces::ProjectileLogic*)obj->projectileLogic)->type : (0);
+			const JBool isLandMine = projType == PROJ_LAND_MINE || projType == PROJ_LAND_MINE_PROX || projType == PROJ_LAND_MINE_PLACED;
+			canRemove |= ((obj->entityFlags & ETFLAG_PROJECTILE) && isLandMine);
 
-				if (canRemove && freeCount < 128)
-				{
-					freeList[freeCount++] = obj;
-				}
+			if (canRemove && freeCount < 128)
+			{
+				freeList[freeCount++] = obj;
 			}
 		}
 
@@ -1045,16 +1101,10 @@ namespace TFE_Jedi
 			moveCeil = JTRUE;
 		}
 
-		SecObject** objList = sector->objectList;
-		s32 objCount = sector->objectCount;
-		for (s32 i = 0; i < objCount; i++, objList++)
+		SectorObjectIter iter;
+		sector_beginObjectIter(&iter, sector);
+		while (SecObject* obj = sector_nextObject(&iter))
 		{
-			SecObject* obj = *objList;
-			while (!obj)
-			{
-				objList++;
-				obj = *objList;
-			}
 			// The first 3 conditionals can be collapsed since the resulting values are the same.
 			if ((moveFloor && obj->posWS.y == sector->floorHeight) ||
 				(moveSecHgt && sector->secHeight && sector->floorHeight + sector->secHeight == obj->posWS.y) ||
@@ -1063,6 +1113,7 @@ namespace TFE_Jedi
 				sector_rotateObj(obj, deltaAngle, cosdAngle, sindAngle, centerX, centerZ);
 			}
 		}
+		sector_endObjectIter(&iter);
 	}
 
 	//////////////////////////////////////////////////////////
@@ -1272,24 +1323,21 @@ namespace TFE_Jedi
 		JBool offset   = (flags & INF_EFLAG_MOVE_SECHT)!=0 ? JTRUE : JFALSE;
 		JBool floor    = (flags & INF_EFLAG_MOVE_FLOOR)!=0 ? JTRUE : JFALSE;
 
-		SecObject** objList = sector->objectList;
-		for (s32 i = 0, idx = 0; i < sector->objectCount && idx < sector->objectCapacity; idx++)
+		SectorObjectIter iter;
+		sector_beginObjectIter(&iter, sector);
+		while (SecObject* obj = sector_nextObject(&iter))
 		{
-			SecObject* obj = objList[idx];
-			if (obj)
+			if ((obj->flags & OBJ_FLAG_MOVABLE) && (obj->entityFlags != ETFLAG_PLAYER))
 			{
-				i++;
-				if ((obj->flags & OBJ_FLAG_MOVABLE) && (obj->entityFlags != ETFLAG_PLAYER))
+				if ((floor   && obj->posWS.y == sector->floorHeight) ||
+					(offset  && sector->secHeight && sector->floorHeight + sector->secHeight == obj->posWS.y) ||
+					(ceiling && obj->posWS.y == sector->ceilingHeight))
 				{
-					if ((floor   && obj->posWS.y == sector->floorHeight) ||
-						(offset  && sector->secHeight && sector->floorHeight + sector->secHeight == obj->posWS.y) ||
-						(ceiling && obj->posWS.y == sector->ceilingHeight))
-					{
-						sector_moveObject(obj, offsetX, offsetZ);
-					}
+					sector_moveObject(obj, offsetX, offsetZ);
 				}
 			}
 		}
+		sector_endObjectIter(&iter);
 	}
 		
 	// Tests if a point (p2) is to the left, on or right of an infinite line (p0 -> p1).
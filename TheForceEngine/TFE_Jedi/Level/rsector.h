@@ -109,6 +109,8 @@ struct RSector
 	vec2_fixed ceilOffset;
 
 	// Objects
+	// TFE: the list is dense, objects are stored in [0, objectCount) and obj->index is the slot of the object.
+	// Removing an object moves the last object into its slot, use SectorObjectIter for loops that may remove objects.
 	s32 objectCount;
 	SecObject** objectList;
 	s32 objectCapacity;
@@ -134,6 +136,18 @@ struct RSector
 	u32 dirtyFlags;
 };
 
+// TFE: Iterates over the objects in a sector while the loop may add or remove objects.
+// Objects are visited front to back, in the order they were added to the sector.
+// Objects removed before they are reached are skipped and objects added during the loop (including objects that
+// left and re-entered the sector) are visited at the end.
+// Iterators are a stack, so sector_endObjectIter() must be called in reverse order of sector_beginObjectIter().
+struct SectorObjectIter
+{
+	RSector* sector;
+	s32 next;					// objects in [0, next) have been visited.
+	SectorObjectIter* prevIter;	// the previously active iterator.
+};
+
 namespace TFE_Jedi
 {
 	void sector_clear(RSector* sector);
@@ -152,6 +166,10 @@ namespace TFE_Jedi
 	void sector_addObject(RSector* sector, SecObject* obj);
 	void sector_addObjectDirect(RSector* sector, SecObject* obj);
 	void sector_removeObject(SecObject* obj);
+
+	void sector_beginObjectIter(SectorObjectIter* iter, RSector* sector);
+	SecObject* sector_nextObject(SectorObjectIter* iter);
+	void sector_endObjectIter(SectorObjectIter* iter);
 	
 	RSector* sector_which3D(fixed16_16 dx, fixed16_16 dy, fixed16_16 dz);
 	RSector* sector_which3D_Map(fixed16_16 dx, fixed16_16 dz, s32 layer);
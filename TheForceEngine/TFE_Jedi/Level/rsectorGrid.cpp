@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "rsectorGrid.h"
+#include "rsector.h"
+#include "levelData.h"
+
+namespace TFE_Jedi
+{
+	enum SectorGridConstants
+	{
+		GRID_MIN_CELL_SHIFT = 3 + 16,	// 8 world units.
+		GRID_MAX_DIM = 256,				// Maximum cells per axis.
+	};
+
+	struct GridRect
+	{
+		s32 x0, z0;
+		s32 x1, z1;
+	};
+
+	static std::vector<std::vector<u32>> s_gridCells;
+	static std::vector<GridRect> s_gridSectorRect;
+	static RSector* s_gridSectors = nullptr;
+	static u32 s_gridSectorCount = 0;
+	static fixed16_16 s_gridOriginX = 0;
+	static fixed16_16 s_gridOriginZ = 0;
+	static s32 s_gridShift = GRID_MIN_CELL_SHIFT;
+	static s32 s_gridWidth = 0;
+	static s32 s_gridHeight = 0;
+
+	// Points outside of the grid are clamped to the border cells, which keeps the sector cells conservative
+	// even after INF moves a sector past the original level bounds.
+	s32 sectorGrid_cellX(fixed16_16 x)
+	{
+		const s64 cx = (s64(x) - s64(s_gridOriginX)) >> s_gridShift;
+		return s32(std::max(s64(0), std::min(cx, s64(s_gridWidth - 1))));
+	}
+
+	s32 sectorGrid_cellZ(fixed16_16 z)
+	{
+		const s64 cz = (s64(z) - s64(s_gridOriginZ)) >> s_gridShift;
+		return s32(std::max(s64(0), std::min(cz, s64(s_gridHeight - 1))));
+	}
+
+	GridRect sectorGrid_getRect(RSector* sector)
+	{
+		GridRect rect;
+		rect.x0 = sectorGrid_cellX(sector->boundsMin.x);
+		rect.z0 = sectorGrid_cellZ(sector->boundsMin.z);
+		rect.x1 = sectorGrid_cellX(sector->boundsMax.x);
+		rect.z1 = sectorGrid_cellZ(sector->boundsMax.z);
+		return rect;
+	}
+
+	void sectorGrid_insert(u32 index, const GridRect& rect)
+	{
+		for (s32 z = rect.z0; z <= rect.z1; z++)
+		{
+			std::vector<u32>* cell = &s_gridCells[z * s_gridWidth + rect.x0];
+			for (s32 x = rect.x0; x <= rect.x1; x++, cell++)
+			{
+				// Keep the indices sorted so that lookups match the order of a linear scan.
+				cell->insert(std::lower_bound(cell->begin(), cell->end(), index), index);
+			}
+		}
+	}
+
+	void sectorGrid_remove(u32 index, const GridRect& rect)
+	{
+		for (s32 z = rect.z0; z <= rect.z1; z++)
+		{
+			std::vector<u32>* cell = &s_gridCells[z * s_gridWidth + rect.x0];
+			for (s32 x = rect.x0; x <= rect.x1; x++, cell++)
+			{
+				std::vector<u32>::iterator iter = std::lower_bound(cell->begin(), cell->end(), index);
+				if (iter != cell->end() && *iter == index)
+				{
+					cell->erase(iter);
+				}
+			}
+		}
+	}
+
+	void sectorGrid_build()
+	{
+		sectorGrid_clear();
+		if (!s_levelState.sectors || !s_levelState.sectorCount) { return; }
+
+		// Level bounds.
+		RSector* sector = s_levelState.sectors;
+		fixed16_16 minX = sector->boundsMin.x, maxX = sector->boundsMax.x;
+		fixed16_16 minZ = sector->boundsMin.z, maxZ = sector->boundsMax.z;
+		sector++;
+		for (u32 i = 1; i < s_levelState.sectorCount; i++, sector++)
+		{
+			minX = min(minX, sector->boundsMin.x);
+			minZ = min(minZ, sector->boundsMin.z);
+			maxX = max(maxX, sector->boundsMax.x);
+			maxZ = max(maxZ, sector->boundsMax.z);
+		}
+
+		// Aim for roughly one cell per sector, with a power of two cell size.
+		const f64 extentX = f64(maxX - minX) / f64(ONE_16) + 1.0;
+		const f64 extentZ = f64(maxZ - minZ) / f64(ONE_16) + 1.0;
+		const f64 cellSize = sqrt(extentX * extentZ / f64(s_levelState.sectorCount));
+		s32 shift = GRID_MIN_CELL_SHIFT;
+		while (f64(1 << (shift - 16)) < cellSize && shift < 30) { shift++; }
+		while ((((s64(maxX) - s64(minX)) >> shift) + 1 > GRID_MAX_DIM || ((s64(maxZ) - s64(minZ)) >> shift) + 1 > GRID_MAX_DIM) && shift < 30)
+		{
+			shift++;
+		}
+
+		s_gridOriginX = minX;
+		s_gridOriginZ = minZ;
+		s_gridShift = shift;
+		s_gridWidth  = s32(((s64(maxX) - s64(minX)) >> shift) + 1);
+		s_gridHeight = s32(((s64(maxZ) - s64(minZ)) >> shift) + 1);
+		s_gridCells.resize(s_gridWidth * s_gridHeight);
+		s_gridSectorRect.resize(s_levelState.sectorCount);
+
+		sector = s_levelState.sectors;
+		for (u32 i = 0; i < s_levelState.sectorCount; i++, sector++)
+		{
+			s_gridSectorRect[i] = sectorGrid_getRect(sector);
+			sectorGrid_insert(i, s_gridSectorRect[i]);
+		}
+
+		s_gridSectors = s_levelState.sectors;
+		s_gridSectorCount = s_levelState.sectorCount;
+	}
+
+	void sectorGrid_clear()
+	{
+		s_gridCells.clear();
+		s_gridSectorRect.clear();
+		s_gridSectors = nullptr;
+		s_gridSectorCount = 0;
+		s_gridWidth = 0;
+		s_gridHeight = 0;
+	}
+
+	void sectorGrid_updateSector(RSector* sector)
+	{
+		if (!s_gridSectors || sector < s_gridSectors || sector >= s_gridSectors + s_gridSectorCount) { return; }
+		const u32 index = u32(sector - s_gridSectors);
+
+		// Small movements usually stay within the same cells.
+		const GridRect rect = sectorGrid_getRect(sector);
+		GridRect* prevRect = &s_gridSectorRect[index];
+		if (rect.x0 == prevRect->x0 && rect.z0 == prevRect->z0 && rect.x1 == prevRect->x1 && rect.z1 == prevRect->z1)
+		{
+			return;
+		}
+
+		sectorGrid_remove(index, *prevRect);
+		sectorGrid_insert(index, rect);
+		*prevRect = rect;
+	}
+
+	JBool sectorGrid_getCandidates(fixed16_16 x, fixed16_16 z, const u32** candidates, s32* count)
+	{
+		// The grid is only valid for the sectors it was built from.
+		if (!s_gridSectors || s_gridSectors != s_levelState.sectors || s_gridSectorCount != s_levelState.sectorCount)
+		{
+			return JFALSE;
+		}
+
+		const std::vector<u32>& cell = s_gridCells[sectorGrid_cellZ(z) * s_gridWidth + sectorGrid_cellX(x)];
+		*candidates = cell.data();
+		*count = s32(cell.size());
+		return JTRUE;
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Sector Grid
+// Uniform 2D grid over the sector XZ bounds, used to accelerate
+// point queries such as sector_which3D().
+//
+// Each cell holds the indices of the sectors whose bounds overlap it,
+// in ascending order, so iterating a cell visits sectors in the same
+// order as a linear scan over s_levelState.sectors.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include <TFE_Jedi/Math/fixedPoint.h>
+
+struct RSector;
+
+namespace TFE_Jedi
+{
+	// Build the grid from the current level sectors and their bounds.
+	void sectorGrid_build();
+	void sectorGrid_clear();
+	// Update the cells that the sector overlaps, called when its bounds change.
+	void sectorGrid_updateSector(RSector* sector);
+
+	// Gets the indices of the sectors that may contain point (x, z) in ascending order.
+	// Returns JFALSE if the grid is not valid for the current level, in which case all sectors must be tested.
+	JBool sectorGrid_getCandidates(fixed16_16 x, fixed16_16 z, const u32** candidates, s32* count);
+}
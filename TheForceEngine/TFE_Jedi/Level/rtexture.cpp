@@ -3,10 +3,12 @@
 #include "rtexture.h"
 #include <TFE_Game/igame.h>
 #include <TFE_System/system.h>
+#include <TFE_System/jobSystem.h>
 #include <TFE_Archive/archive.h>
 #include <TFE_Asset/assetSystem.h>
 #include <TFE_FileSystem/paths.h>
 #include <TFE_FileSystem/filestream.h>
+#include <TFE_FileSystem/fileView.h>
 #include <TFE_Jedi/Task/task.h>
 #include <TFE_Jedi/Serialization/serialization.h>
 #include <TFE_System/math.h>
@@ -39,12 +41,22 @@ namespace TFE_Jedi
 		s32           animTexIndex = 0;
 	};
 	static TextureState s_texState = {};
-	static std::vector<u8> s_buffer;
 	static std::vector<TextureData*> s_tempTextureList;
 
 	static TextureList  s_textureList[POOL_COUNT];
 	static TextureTable s_textureTable[POOL_COUNT];
 
+	// Texture preloading, see bitmap_preload().
+	struct TexturePreload
+	{
+		const char* name;
+		TextureData* texture;
+		const u8* data;			// Image or compressed data, inside the file view.
+		const u32* columns;		// Column offsets for compressed images.
+		u8 compressed;
+	};
+	static std::vector<TexturePreload> s_preload;
+
 	void decompressColumn_Type1(const u8* src, u8* dst, s32 pixelCount);
 	void decompressColumn_Type2(const u8* src, u8* dst, s32 pixelCount);
 	void textureAnimationTaskFunc(MessageType msg);
@@ -213,19 +225,15 @@ namespace TFE_Jedi
 			return nullptr;
 		}
 
-		FileStream file;
-		if (!file.open(&filepath, Stream::MODE_READ))
+		// The BM is parsed directly from the archive data, the view is released when it goes out of scope.
+		FileView file;
+		if (!file.open(&filepath))
 		{
 			return nullptr;
 		}
 
-		size_t size = file.getSize();
-		s_buffer.resize(size);
-		file.readBuffer(s_buffer.data(), (u32)size);
-		file.close();
-
 		TextureData* texture = (TextureData*)region_alloc(s_texState.memoryRegion, sizeof(TextureData));
-		const u8* data = s_buffer.data();
+		const u8* data = file.getData();
 		const u8* fheader = data;
 		data += 3;
 
@@ -334,6 +342,117 @@ namespace TFE_Jedi
 		return texture;
 	}
 
+	// Decode a single preloaded texture, called from the job system.
+	void bitmap_decodePreload(s32 index, void* userData)
+	{
+		const TexturePreload* preload = &s_preload[index];
+		TextureData* texture = preload->texture;
+		if (preload->compressed == 1)
+		{
+			u8* dst = texture->image;
+			for (s32 i = 0; i < texture->width; i++, dst += texture->height)
+			{
+				decompressColumn_Type1(&preload->data[preload->columns[i]], dst, texture->height);
+			}
+		}
+		else if (preload->compressed == 2)
+		{
+			u8* dst = texture->image;
+			for (s32 i = 0; i < texture->width; i++, dst += texture->height)
+			{
+				decompressColumn_Type2(&preload->data[preload->columns[i]], dst, texture->height);
+			}
+		}
+		else
+		{
+			memcpy(texture->image, preload->data, texture->dataSize);
+		}
+	}
+
+	void bitmap_preload(const char* const* names, s32 count, AssetPool pool)
+	{
+		if (count <= 0) { return; }
+
+		// Files are found, viewed and allocated on the calling thread in list order, so the results do not
+		// depend on which worker decodes which texture.
+		FileView* files = new FileView[count];
+		s_preload.clear();
+		for (s32 t = 0; t < count; t++)
+		{
+			const char* name = names[t];
+			if (s_textureTable[pool].find(name) != s_textureTable[pool].end()) { continue; }
+
+			bool duplicate = false;
+			for (size_t i = 0; i < s_preload.size() && !duplicate; i++)
+			{
+				duplicate = strcasecmp(s_preload[i].name, name) == 0;
+			}
+			FilePath filepath;
+			if (duplicate || !TFE_Paths::getFilePath(name, &filepath) || !files[t].open(&filepath))
+			{
+				continue;
+			}
+
+			// Invalid files are skipped here and reported by bitmap_load().
+			const u8* data = files[t].getData();
+			if (files[t].getSize() < 32 || strncmp((const char*)data, "BM ", 3) || data[3] != DF_BM_VERSION)
+			{
+				continue;
+			}
+			data += 4;
+
+			TextureData* texture = (TextureData*)region_alloc(s_texState.memoryRegion, sizeof(TextureData));
+			texture->width = readUShort(data);
+			texture->height = readUShort(data);
+			texture->uvWidth = readShort(data);
+			texture->uvHeight = readShort(data);
+			texture->flags = readByte(data);
+			texture->logSizeY = readByte(data);
+			const u8 compressed = readByte(data);
+			texture->animSetup = 0;
+			// value is ignored.
+			data++;
+
+			TexturePreload preload = { name, texture, nullptr, nullptr, compressed };
+			texture->dataSize = texture->width * texture->height;
+			texture->compressed = 0;
+			texture->columns = nullptr;
+			if (compressed)
+			{
+				s32 inSize = readInt(data);
+				// values are ignored.
+				data += 12;
+
+				preload.data = data;
+				preload.columns = (const u32*)(data + inSize);
+			}
+			else
+			{
+				// Datasize and padding, ignored.
+				data += 16;
+				preload.data = data;
+			}
+			texture->image = (u8*)region_alloc(s_texState.memoryRegion, texture->dataSize);
+			texture->animIndex = -1;
+			texture->frameIdx = -1;
+			texture->animPtr = nullptr;
+			s_preload.push_back(preload);
+		}
+
+		// Decode in parallel.
+		TFE_Jobs::parallelFor(s32(s_preload.size()), bitmap_decodePreload, nullptr);
+
+		// Publish in list order.
+		for (size_t i = 0; i < s_preload.size(); i++)
+		{
+			s32 index = (s32)s_textureList[pool].size();
+			s_textureList[pool].push_back({ s_preload[i].name, s_preload[i].texture });
+			s_textureTable[pool][s_preload[i].name] = index;
+		}
+		s_preload.clear();
+		delete[] files;
+	}
+
 	TextureData* bitmap_loadFromMemory(const u8* data, size_t size, u32 decompress)
 	{
 		TextureData* texture = (TextureData*)malloc(sizeof(TextureData));
@@ -94,6 +94,9 @@ namespace TFE_Jedi
 	// if levelTexture is false, then textures are not serialized and not cleared at level end.
 	TextureData* bitmap_load(const char* name, u32 decompress, AssetPool pool = POOL_LEVEL, bool addToCache = true);
 	bool bitmap_setupAnimatedTexture(TextureData** texture, s32 index);
+	// Read and decode a list of textures using the job system and add them to the pool, so that
+	// later bitmap_load() calls (with decompress = 1) find them in the cache.
+	void bitmap_preload(const char* const* names, s32 count, AssetPool pool = POOL_LEVEL);
 
 	Allocator* bitmap_getAnimatedTextures();
 	TextureData** bitmap_getTextures(s32* textureCount, AssetPool pool);
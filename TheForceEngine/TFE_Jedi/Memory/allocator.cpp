@@ -2,12 +2,25 @@
 #include <TFE_System/system.h>
 #include <TFE_Memory/memoryRegion.h>
 #include <TFE_Game/igame.h>
+#include <TFE_Jedi/Math/core_math.h>
 #include <assert.h>
 
 struct AllocHeader
 {
 	AllocHeader* prev;
 	AllocHeader* next;
+	// TFE: next item in the slab free list. 'prev' and 'next' keep their values after an item is deleted,
+	// so an iterator saved on a deleted item continues in the list as it did in DF.
+	AllocHeader* nextFree;
+	// TFE: position in the list, valid when the allocator index is up to date.
+	s32 index;
+};
+
+// TFE: slab pages are linked together so they can be freed with the allocator,
+// the items directly follow the page header.
+struct AllocSlab
+{
+	AllocSlab* next;
 };
 
 struct Allocator
@@ -24,6 +37,17 @@ struct Allocator
 	// TFE
 	AllocHeader* iterSave;
 	AllocHeader* iterPrevSave;
+
+	// Slab storage, freed items are kept in 'freeList' and reused.
+	AllocSlab*   slabs;
+	AllocHeader* freeList;
+	s32 slabSize;
+	s32 count;
+
+	// Items in list order for random access, built on demand.
+	AllocHeader** items;
+	s32 itemCapacity;
+	JBool indexValid;
 };
 
 namespace TFE_Jedi
@@ -34,9 +58,10 @@ namespace TFE_Jedi
 	static const size_t c_invalidPtr = (~size_t(0)) - sizeof(AllocHeader) + 1;
 	#define ALLOC_INVALID_PTR ((AllocHeader*)c_invalidPtr)
 	#define MAX_ALLOC_SIZE (8*1024*1024)  // 8MB
+	#define MAX_SLAB_SIZE  (64*1024)       // 64KB
 
 	// Create and free an allocator.
-	Allocator* allocator_create(s32 allocSize, MemoryRegion* region)
+	Allocator* allocator_create(s32 allocSize, MemoryRegion* region, s32 slabSize)
 	{
 		if (allocSize > MAX_ALLOC_SIZE || allocSize <= 0)
 		{
@@ -62,19 +87,95 @@ namespace TFE_Jedi
 		res->iter = ALLOC_INVALID_PTR;
 		res->size = allocSize + sizeof(AllocHeader);
 		res->refCount = 0;
+		res->iterSave = ALLOC_INVALID_PTR;
+		res->iterPrevSave = ALLOC_INVALID_PTR;
+
+		// Large items get smaller pages, so a single page never gets too big.
+		res->slabSize = slabSize > 0 ? max(1, min(slabSize, MAX_SLAB_SIZE / res->size)) : ALLOC_SLAB_NONE;
+		if (res->slabSize)
+		{
+			// Items are packed in the page, so keep them aligned.
+			res->size = (res->size + sizeof(void*) - 1) & ~s32(sizeof(void*) - 1);
+		}
+		res->slabs = nullptr;
+		res->freeList = nullptr;
+		res->count = 0;
+		res->items = nullptr;
+		res->itemCapacity = 0;
+		res->indexValid = JFALSE;
 
 		return res;
 	}
 
+	// Allocate a new page and add its items to the free list, in order so that items are handed out by increasing address.
+	static bool allocator_addSlab(Allocator* alloc)
+	{
+		AllocSlab* slab = (AllocSlab*)TFE_Memory::region_alloc(alloc->region, sizeof(AllocSlab) + alloc->size * alloc->slabSize);
+		if (!slab) { return false; }
+		slab->next = alloc->slabs;
+		alloc->slabs = slab;
+
+		u8* items = (u8*)slab + sizeof(AllocSlab);
+		for (s32 i = alloc->slabSize - 1; i >= 0; i--)
+		{
+			AllocHeader* header = (AllocHeader*)(items + i * alloc->size);
+			header->nextFree = alloc->freeList;
+			alloc->freeList = header;
+		}
+		return true;
+	}
+
+	// Make sure the item array and item indices match the list.
+	static void allocator_updateIndex(Allocator* alloc)
+	{
+		if (alloc->indexValid) { return; }
+
+		if (alloc->count > alloc->itemCapacity)
+		{
+			alloc->itemCapacity = max(alloc->count, alloc->itemCapacity * 2);
+			alloc->items = (AllocHeader**)TFE_Memory::region_realloc(alloc->region, alloc->items, sizeof(AllocHeader*) * alloc->itemCapacity);
+		}
+
+		s32 index = 0;
+		AllocHeader* header = alloc->head;
+		while (header != ALLOC_INVALID_PTR)
+		{
+			header->index = index;
+			alloc->items[index] = header;
+			index++;
+			header = header->next;
+		}
+		assert(index == alloc->count);
+		alloc->indexValid = JTRUE;
+	}
+
 	void allocator_free(Allocator* alloc)
 	{
 		if (!alloc) { return; }
 
-		void* item = allocator_getHead(alloc);
-		while (item)
+		if (alloc->slabSize)
+		{
+			// Items live in the pages, so they do not need to be freed individually.
+			AllocSlab* slab = alloc->slabs;
+			while (slab)
+			{
+				AllocSlab* next = slab->next;
+				TFE_Memory::region_free(alloc->region, slab);
+				slab = next;
+			}
+		}
+		else
+		{
+			void* item = allocator_getHead(alloc);
+			while (item)
+			{
+				allocator_deleteItem(alloc, item);
+				item = allocator_getNext(alloc);
+			}
+		}
+		if (alloc->items)
 		{
-			allocator_deleteItem(alloc, item);
-			item = allocator_getNext(alloc);
+			TFE_Memory::region_free(alloc->region, alloc->items);
 		}
 
 		alloc->self = (Allocator*)ALLOC_INVALID_PTR;
@@ -91,7 +192,19 @@ namespace TFE_Jedi
 	{
 		if (!alloc) { return nullptr; }
 
-		AllocHeader* header = (AllocHeader*)TFE_Memory::region_alloc(alloc->region, alloc->size);
+		AllocHeader* header = nullptr;
+		if (alloc->slabSize)
+		{
+			if (alloc->freeList || allocator_addSlab(alloc))
+			{
+				header = alloc->freeList;
+				alloc->freeList = header->nextFree;
+			}
+		}
+		else
+		{
+			header = (AllocHeader*)TFE_Memory::region_alloc(alloc->region, alloc->size);
+		}
 		if (!header)
 		{
 			TFE_System::logWrite(LOG_ERROR, "Allocator", "allocator_newItem - cannot allocate header of size %d", alloc->size);
@@ -113,6 +226,21 @@ namespace TFE_Jedi
 			alloc->head = header;
 		}
 
+		// Items are always added at the end, so the index can be extended in place.
+		header->index = alloc->count;
+		alloc->count++;
+		if (alloc->indexValid)
+		{
+			if (alloc->count > alloc->itemCapacity)
+			{
+				alloc->indexValid = JFALSE;
+			}
+			else
+			{
+				alloc->items[header->index] = header;
+			}
+		}
+
 		return ((u8*)header + sizeof(AllocHeader));
 	}
 
@@ -141,92 +269,60 @@ namespace TFE_Jedi
 			alloc->iterPrev = header->next;
 		}
 
-		TFE_Memory::region_free(alloc->region, header);
+		// Removing the tail keeps the index valid, otherwise it is rebuilt on the next access.
+		alloc->count--;
+		if (next != ALLOC_INVALID_PTR)
+		{
+			alloc->indexValid = JFALSE;
+		}
+		header->index = -1;
+
+		if (alloc->slabSize)
+		{
+			header->nextFree = alloc->freeList;
+			alloc->freeList = header;
+		}
+		else
+		{
+			TFE_Memory::region_free(alloc->region, header);
+		}
 	}
 
 	// Random access.
 	s32 allocator_getCount(Allocator* alloc)
 	{
 		if (!alloc) { return 0; }
-
-		s32 count = 0;
-		AllocHeader* header = alloc->head;
-		while (header != ALLOC_INVALID_PTR)
-		{
-			count++;
-			header = header->next;
-		}
-		return count;
+		return alloc->count;
 	}
 		
 	s32 allocator_getCurPos(Allocator* alloc)
 	{
-		if (!alloc) { return -1; }
+		if (!alloc || alloc->iter == ALLOC_INVALID_PTR) { return -1; }
 
-		s32 index = 0;
-		AllocHeader* iter = alloc->iter;
-		AllocHeader* header = alloc->head;
-		while (header != ALLOC_INVALID_PTR)
-		{
-			if (header == iter)
-			{
-				return index;
-			}
-			index++;
-			header = header->next;
-		}
-		return -1;
+		allocator_updateIndex(alloc);
+		return alloc->iter->index;
 	}
 
 	void allocator_setPos(Allocator* alloc, s32 pos)
 	{
-		s32 index = 0;
-		AllocHeader* header = alloc->head;
-		alloc->iter = ALLOC_INVALID_PTR;
-		while (header != ALLOC_INVALID_PTR)
-		{
-			if (index == pos)
-			{
-				alloc->iter = header;
-				break;
-			}
-			index++;
-			header = header->next;
-		}
+		allocator_updateIndex(alloc);
+		alloc->iter = (pos >= 0 && pos < alloc->count) ? alloc->items[pos] : ALLOC_INVALID_PTR;
 	}
 		
 	s32 allocator_getPrevPos(Allocator* alloc)
 	{
-		if (!alloc) { return -1; }
+		if (!alloc || alloc->iterPrev == ALLOC_INVALID_PTR) { return -1; }
 
-		s32 index = 0;
-		AllocHeader* iterPrev = alloc->iterPrev;
-		AllocHeader* header = alloc->head;
-		while (header != ALLOC_INVALID_PTR)
-		{
-			if (header == iterPrev)
-			{
-				return index;
-			}
-			index++;
-			header = header->next;
-		}
-		return -1;
+		allocator_updateIndex(alloc);
+		return alloc->iterPrev->index;
 	}
 
 	void allocator_setPrevPos(Allocator* alloc, s32 pos)
 	{
-		s32 index = 0;
-		AllocHeader* header = alloc->head;
-		while (header != ALLOC_INVALID_PTR)
+		allocator_updateIndex(alloc);
+		if (pos >= 0 && pos < alloc->count)
 		{
-			if (index == pos)
-			{
-				alloc->iterPrev = header;
-				break;
-			}
-			index++;
-			header = header->next;
+			alloc->iterPrev = alloc->items[pos];
 		}
 	}
 
@@ -234,29 +330,27 @@ namespace TFE_Jedi
 	{
 		if (!item) { return -1; }
 
-		AllocHeader* header = alloc->head;
-		s32 index = 0;
-		while (header != ALLOC_INVALID_PTR)
+		allocator_updateIndex(alloc);
+		AllocHeader* header = (AllocHeader*)((u8*)item - sizeof(AllocHeader));
+		const s32 index = header->index;
+		// Make sure the item belongs to this allocator.
+		if (index < 0 || index >= alloc->count || alloc->items[index] != header)
 		{
-			if ((u8*)item == (u8*)header + sizeof(AllocHeader))
-			{
-				return index;
-			}
-			index++;
-			header = header->next;
+			return -1;
 		}
-		return -1;
+		return index;
 	}
 
 	void* allocator_getByIndex(Allocator* alloc, s32 index)
 	{
 		if (!alloc) { return nullptr; }
 
-		AllocHeader* header = alloc->head;
-		while (index > 0 && header != ALLOC_INVALID_PTR)
+		// Negative indices return the head, matching the original list walk.
+		allocator_updateIndex(alloc);
+		AllocHeader* header = ALLOC_INVALID_PTR;
+		if (alloc->count > 0 && index < alloc->count)
 		{
-			index--;
-			header = header->next;
+			header = alloc->items[max(index, 0)];
 		}
 
 		alloc->iterPrev = header;
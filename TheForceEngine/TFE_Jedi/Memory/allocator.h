@@ -9,8 +9,18 @@ struct Allocator;
 
 namespace TFE_Jedi
 {
+	// Number of items per slab page.
+	// By default each item is allocated separately from the region, slab allocators instead allocate pages of
+	// items at once and reuse freed items, so that items are mostly contiguous in memory.
+	enum AllocatorSlab
+	{
+		ALLOC_SLAB_NONE  = 0,
+		ALLOC_SLAB_SMALL = 8,	// For small lists owned by individual objects.
+		ALLOC_SLAB_LARGE = 64,	// For global lists.
+	};
+
 	// Create and free an allocator.
-	Allocator* allocator_create(s32 allocSize, MemoryRegion* region = nullptr);
+	Allocator* allocator_create(s32 allocSize, MemoryRegion* region = nullptr, s32 slabSize = ALLOC_SLAB_NONE);
 	void allocator_free(Allocator* alloc);
 	bool allocator_validate(Allocator* alloc);
 
@@ -7,6 +7,7 @@
 #include "rclassicFloat.h"
 #include "rclassicFloatSharedState.h"
 #include "fixedPoint20.h"
+#include "rstripsFloat.h"
 #include "../rscanline.h"
 #include "../rsectorRender.h"
 #include "../redgePair.h"
@@ -77,74 +78,42 @@ namespace RClassic_Float
 		}
 	}
 				
-	// This produces functionally identical results to the original but splits apart the U/V and dUdx/dVdx into seperate variables
-	// to account for C vs ASM differences.
+	// Submit the current scanline, it is either drawn immediately or split into strips and recorded.
+	// See rasterScanline() in rstripsFloat.cpp for the inner loops.
+	void submitScanline(u8 func)
+	{
+		RasterScanline scanline;
+		scanline.out = s_scanlineOut;
+		scanline.tex = s_ftexImage;
+		scanline.light = s_scanlineLight;
+		scanline.U0 = s_scanlineU0;
+		scanline.V0 = s_scanlineV0;
+		scanline.dUdX = s_scanline_dUdX;
+		scanline.dVdX = s_scanline_dVdX;
+		scanline.width = s_scanlineWidth;
+		scanline.texDataEnd = s_ftexDataEnd;
+		scanline.func = func;
+		rstrips_drawScanline(&scanline);
+	}
+
 	void drawScanline()
 	{
-		const fixed44_20 dVdX = s_scanline_dVdX;
-		const fixed44_20 dUdX = s_scanline_dUdX;
-		fixed44_20 V = s_scanlineV0;
-		fixed44_20 U = s_scanlineU0;
-
-		// Note this produces a distorted mapping if the texture is not 64x64.
-		// This behavior matches the original.
-		for (s32 i = s_scanlineWidth - 1; i >= 0; i--, U += dUdX, V += dVdX)
-		{
-			const u32 texel = ((floor20(U) & 63) * 64 + (floor20(V) & 63)) & s_ftexDataEnd;
-			s_scanlineOut[i] = s_scanlineLight[s_ftexImage[texel]];
-		}
+		submitScanline(RSCAN_LIT);
 	}
 
 	void drawScanline_Fullbright()
 	{
-		const fixed44_20 dVdX = s_scanline_dVdX;
-		const fixed44_20 dUdX = s_scanline_dUdX;
-		fixed44_20 V = s_scanlineV0;
-		fixed44_20 U = s_scanlineU0;
-
-		// Note this produces a distorted mapping if the texture is not 64x64.
-		// This behavior matches the original.
-		for (s32 i = s_scanlineWidth - 1; i >= 0; i--, U += dUdX, V += dVdX)
-		{
-			const u32 texel = ((floor20(U) & 63) * 64 + (floor20(V) & 63)) & s_ftexDataEnd;
-			s_scanlineOut[i] = s_ftexImage[texel];
-		}
+		submitScanline(RSCAN_FULLBRIGHT);
 	}
 
 	void drawScanline_Trans()
 	{
-		const fixed44_20 dVdX = s_scanline_dVdX;
-		const fixed44_20 dUdX = s_scanline_dUdX;
-		fixed44_20 V = s_scanlineV0;
-		fixed44_20 U = s_scanlineU0;
-
-		// Note this produces a distorted mapping if the texture is not 64x64.
-		// This behavior matches the original.
-		for (s32 i = s_scanlineWidth - 1; i >= 0; i--, U += dUdX, V += dVdX)
-		{
-			const u32 texel = ((floor20(U) & 63) * 64 + (floor20(V) & 63)) & s_ftexDataEnd;
-			const u8 baseColor = s_ftexImage[texel];
-
-			if (baseColor) { s_scanlineOut[i] = s_scanlineLight[baseColor]; }
-		}
+		submitScanline(RSCAN_LIT_TRANS);
 	}
 
 	void drawScanline_Fullbright_Trans()
 	{
-		const fixed44_20 dVdX = s_scanline_dVdX;
-		const fixed44_20 dUdX = s_scanline_dUdX;
-		fixed44_20 V = s_scanlineV0;
-		fixed44_20 U = s_scanlineU0;
-
-		// Note this produces a distorted mapping if the texture is not 64x64.
-		// This behavior matches the original.
-		for (s32 i = s_scanlineWidth - 1; i >= 0; i--, U += dUdX, V += dVdX)
-		{
-			const u32 texel = ((floor20(U) & 63) * 64 + (floor20(V) & 63)) & s_ftexDataEnd;
-			const u8 baseColor = s_ftexImage[texel];
-
-			if (baseColor) { s_scanlineOut[i] = baseColor; }
-		}
+		submitScanline(RSCAN_FULLBRIGHT_TRANS);
 	}
 			   
 	bool flat_setTexture(TextureData* tex)
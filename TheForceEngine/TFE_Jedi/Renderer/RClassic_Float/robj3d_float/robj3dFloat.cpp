@@ -12,6 +12,7 @@
 #include "robj3dFloat_Clipping.h"
 #include "robj3dFloat_PolygonDraw.h"
 #include "../rclassicFloatSharedState.h"
+#include "../rstripsFloat.h"
 #include "../../rcommon.h"
 
 namespace TFE_Jedi
@@ -107,11 +108,17 @@ namespace RClassic_Float
 				continue;
 			}
 
+			// Vertices are drawn as single pixel columns so they land in the correct strip.
+			RasterPolyColumn pixel = {};
+			pixel.count = 1;
+			pixel.colorIndex = color;
+			pixel.func = RPOLY_FLAT_COLOR;
 			for (s32 i = 0; i < area; i++)
 			{
 				const s32 x = clamp(pixel_x - halfSize + (i % size), s_minScreenX_Pixels, s_maxScreenX_Pixels);
 				const s32 y = clamp(pixel_y - halfSize + (i / size), s_windowMinY_Pixels, s_windowMaxY_Pixels);
-				s_display[y*s_width + x] = color;
+				pixel.out = &s_display[y*s_width + x];
+				rstrips_drawPolyColumn(&pixel);
 			}
 		}
 	}
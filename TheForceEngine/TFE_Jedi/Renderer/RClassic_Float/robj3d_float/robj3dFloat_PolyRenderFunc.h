@@ -169,95 +169,28 @@ s32 robj3d_findPrevEdge(s32 minXIndex)
 #if !defined(POLY_INTENSITY) && !defined(POLY_UV)
 void robj3d_drawColumnFlatColor()
 {
-	s32 end = s_columnHeight - 1;
-	s32 offset = end * s_width;
-	for (s32 i = end; i >= 0; i--, offset -= s_width)
-	{
-		s_pcolumnOut[offset] = s_polyColorIndex;
-	}
+	robj3d_submitColumn(RPOLY_FLAT_COLOR);
 }
 #endif
 
 #if defined(POLY_INTENSITY) && !defined(POLY_UV)
 void robj3d_drawColumnShadedColor()
 {
-	const u8* colorMap = s_polyColorMap;
-
-	fixed44_20 intensity = s_col_I0;
-	u8  colorIndex = s_polyColorIndex;
-	s32 dither = s_dither;
-
-	s32 end = s_columnHeight - 1;
-	s32 offset = end * s_width;
-	for (s32 i = end; i >= 0; i--, offset -= s_width)
-	{
-		s32 pixelIntensity = floor20(intensity);
-		if (dither)
-		{
-			const fixed44_20 iOffset = intensity - s_ditherOffset;
-			if (iOffset >= 0)
-			{
-				pixelIntensity = floor20(iOffset);
-			}
-		}
-		s_pcolumnOut[offset] = colorMap[(pixelIntensity&31)*256 + colorIndex];
-
-		intensity += s_col_dIdY;
-		dither = !dither;
-	}
+	robj3d_submitColumn(RPOLY_SHADED_COLOR);
 }
 #endif
 
 #if !defined(POLY_INTENSITY) && defined(POLY_UV)
 void robj3d_drawColumnFlatTexture()
 {
-	const u8* colorMap = &s_polyColorMap[s_polyColorIndex * 256];
-	const u8* textureData = s_polyTexture->image;
-	const s32 texHeight = s_polyTexture->height;
-	const s32 texWidthMask = s_polyTexture->width - 1;
-	const s32 texHeightMask = texHeight - 1;
-
-	fixed44_20 U = s_col_Uv0.x;
-	fixed44_20 V = s_col_Uv0.z;
-	
-	s32 end = s_columnHeight - 1;
-	s32 offset = end * s_width;
-	for (s32 i = end; i >= 0; i--, offset -= s_width)
-	{
-		const u8 colorIndex = textureData[(floor20(U)&texWidthMask)*texHeight + (floor20(V)&texHeightMask)];
-		s_pcolumnOut[offset] = colorMap[colorIndex];
-
-		U += s_col_dUVdY.x;
-		V += s_col_dUVdY.z;
-	}
+	robj3d_submitColumn(RPOLY_FLAT_TEXTURE);
 }
 #endif
 
 #if defined(POLY_INTENSITY) && defined(POLY_UV)
 void robj3d_drawColumnShadedTexture()
 {
-	const u8* colorMap = s_polyColorMap;
-	const u8* textureData = s_polyTexture->image;
-	const s32 texHeight = s_polyTexture->height;
-	const s32 texWidthMask = s_polyTexture->width - 1;
-	const s32 texHeightMask = texHeight - 1;
-
-	fixed44_20 U = s_col_Uv0.x;
-	fixed44_20 V = s_col_Uv0.z;
-	fixed44_20 I = s_col_I0;
-
-	s32 end = s_columnHeight - 1;
-	s32 offset = end * s_width;
-	for (s32 i = end; i >= 0; i--, offset -= s_width)
-	{
-		const u8 colorIndex = textureData[(floor20(U)&texWidthMask)*texHeight + (floor20(V)&texHeightMask)];
-		const s32 pixelIntensity = floor20(I)&31;
-		s_pcolumnOut[offset] = colorMap[pixelIntensity*256 + colorIndex];
-
-		I += s_col_dIdY;
-		U += s_col_dUVdY.x;
-		V += s_col_dUVdY.z;
-	}
+	robj3d_submitColumn(RPOLY_SHADED_TEXTURE);
 }
 #endif
 
@@ -14,6 +14,7 @@
 #include "../rflatFloat.h"
 #include "../rclassicFloatSharedState.h"
 #include "../rlightingFloat.h"
+#include "../rstripsFloat.h"
 #include "../../rcommon.h"
 
 namespace TFE_Jedi
@@ -175,6 +176,41 @@ namespace RClassic_Float
 		return clamp(lightLevel, 0, MAX_LIGHT_LEVEL);
 	}
 		
+	// Submit the current column, it is either drawn immediately or recorded into its strip.
+	// See rasterPolyColumn() in rstripsFloat.cpp for the inner loops.
+	void robj3d_submitColumn(u8 func)
+	{
+		RasterPolyColumn column;
+		column.out = s_pcolumnOut;
+		column.colorMap = s_polyColorMap;
+		column.I0 = s_col_I0;
+		column.dIdY = s_col_dIdY;
+		column.U0 = s_col_Uv0.x;
+		column.V0 = s_col_Uv0.z;
+		column.dUdY = s_col_dUVdY.x;
+		column.dVdY = s_col_dUVdY.z;
+		column.ditherOffset = s_ditherOffset;
+		column.count = s_columnHeight;
+		column.dither = s_dither;
+		column.colorIndex = s_polyColorIndex;
+		column.func = func;
+		if (func == RPOLY_FLAT_TEXTURE || func == RPOLY_SHADED_TEXTURE)
+		{
+			column.tex = s_polyTexture->image;
+			column.texHeight = s_polyTexture->height;
+			column.texWidthMask = s_polyTexture->width - 1;
+			column.texHeightMask = s_polyTexture->height - 1;
+		}
+		else
+		{
+			column.tex = nullptr;
+			column.texHeight = 0;
+			column.texWidthMask = 0;
+			column.texHeightMask = 0;
+		}
+		rstrips_drawPolyColumn(&column);
+	}
+
 	////////////////////////////////////////////////
 	// Instantiate Polygon Draw Routines.
 	// This abuses C-Macros to build 4 versions of
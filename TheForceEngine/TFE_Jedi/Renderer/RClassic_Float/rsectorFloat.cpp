@@ -88,13 +88,7 @@ namespace TFE_Jedi
 
 			for (s32 i = count - 1; i >= 0 && drawCount < MAX_VIEW_OBJ_COUNT; i--, obj++)
 			{
-				// Search for the next allocated object.
 				SecObject* curObj = *obj;
-				while (!curObj)
-				{
-					obj++;
-					curObj = *obj;
-				}
 
 				if (curObj->flags & OBJ_FLAG_NEEDS_TRANSFORM)
 				{
@@ -271,11 +265,6 @@ namespace TFE_Jedi
 				for (s32 i = s_curSector->objectCount - 1; i >= 0; i--, obj++)
 				{
 					SecObject* curObj = *obj;
-					while (!curObj)
-					{
-						obj++;
-						curObj = *obj;
-					}
 
 					if (curObj->flags & OBJ_FLAG_NEEDS_TRANSFORM)
 					{
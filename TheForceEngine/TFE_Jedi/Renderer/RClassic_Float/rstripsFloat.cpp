@@ -0,0 +1,598 @@
+#include <vector>
+
+#include <TFE_System/system.h>
+#include <TFE_System/jobSystem.h>
+#include <TFE_System/profiler.h>
+#include <TFE_FrontEndUI/console.h>
+#include <TFE_Asset/spriteAsset_Jedi.h>
+#include <TFE_Jedi/Math/core_math.h>
+#include "rstripsFloat.h"
+#include "../rcommon.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define TFE_SSE2 1
+#include <emmintrin.h>
+#else
+#define TFE_SSE2 0
+#endif
+
+namespace TFE_Jedi
+{
+
+namespace RClassic_Float
+{
+	enum StripConstants
+	{
+		STRIPS_PER_THREAD = 4,	// More strips than threads to balance uneven scenes.
+		STRIP_ALIGN = 64,		// Keep strip boundaries on cache line boundaries.
+		MAX_STRIP_COUNT = TFE_Jobs::MAX_THREAD_COUNT * STRIPS_PER_THREAD,
+		// Column-major strips are kept narrow, so that scanlines (which step across columns) stay in the cache.
+		COLUMN_MAJOR_STRIP_WIDTH = 256,
+		TRANSPOSE_BLOCK = 16,
+	};
+
+	enum RasterCmdType
+	{
+		RCMD_COLUMN = 0,
+		RCMD_SCANLINE,
+		RCMD_POLY_COLUMN,
+	};
+
+	struct RasterCmd
+	{
+		s32 type;
+		union
+		{
+			RasterColumn column;
+			RasterScanline scanline;
+			RasterPolyColumn polyColumn;
+		};
+	};
+
+	static JBool s_stripsActive = JFALSE;
+	static s32 s_stripCount = 0;
+	static s32 s_stripWidth = 0;
+	static JBool s_columnMajor = JFALSE;
+	static std::vector<RasterCmd> s_strips[MAX_STRIP_COUNT];
+	static std::vector<u8> s_stripBuffers[MAX_STRIP_COUNT];	// Column-major copies of the strips.
+	static u8 s_workBuffer[WAX_DECOMPRESS_SIZE];
+
+	static s32 s_stripCmdCount = 0;
+	static s32 s_benchmarkRepeat = 0;
+
+	void rasterColumn(const RasterColumn* column, u8* columnOut, s32 pitch, u8* workBuffer);
+	void rasterScanline(const RasterScanline* scanline, u8* scanlineOut, s32 step);
+	void rasterPolyColumn(const RasterPolyColumn* column, u8* columnOut, s32 pitch);
+	void rasterStrip(s32 index, void* userData);
+	void runBenchmark();
+
+	void rstrips_requestBenchmark(s32 repeatCount)
+	{
+		s_benchmarkRepeat = max(1, repeatCount);
+	}
+
+	void rstrips_begin(s32 threadCount, bool columnMajor)
+	{
+		static bool s_init = false;
+		if (!s_init)
+		{
+			TFE_COUNTER(s_stripCmdCount, "Raster Strip Commands");
+			s_init = true;
+		}
+
+		s_stripCmdCount = 0;
+		s_columnMajor = columnMajor ? JTRUE : JFALSE;
+		// The benchmark needs the frame to be recorded, so it can be replayed.
+		if (threadCount <= 1 && !columnMajor && !s_benchmarkRepeat)
+		{
+			s_stripsActive = JFALSE;
+			return;
+		}
+
+		TFE_Jobs::setThreadCount(max(threadCount, 1));
+		threadCount = TFE_Jobs::getThreadCount();
+
+		s32 stripWidth = (s_width + threadCount * STRIPS_PER_THREAD - 1) / (threadCount * STRIPS_PER_THREAD);
+		if (columnMajor)
+		{
+			stripWidth = min(stripWidth, (s32)COLUMN_MAJOR_STRIP_WIDTH);
+		}
+		// Never use more strips than there are command lists.
+		stripWidth = max(stripWidth, (s_width + MAX_STRIP_COUNT - 1) / MAX_STRIP_COUNT);
+		stripWidth = (stripWidth + STRIP_ALIGN - 1) & ~(STRIP_ALIGN - 1);
+		s_stripWidth = stripWidth;
+		s_stripCount = (s_width + stripWidth - 1) / stripWidth;
+		for (s32 i = 0; i < s_stripCount; i++)
+		{
+			s_strips[i].clear();
+		}
+		s_stripsActive = JTRUE;
+	}
+
+	void rstrips_end()
+	{
+		if (!s_stripsActive) { return; }
+		s_stripsActive = JFALSE;
+
+		TFE_ZONE("Rasterize Strips");
+		for (s32 i = 0; i < s_stripCount; i++)
+		{
+			s_stripCmdCount += s32(s_strips[i].size());
+		}
+		TFE_Jobs::parallelFor(s_stripCount, rasterStrip, nullptr);
+
+		if (s_benchmarkRepeat)
+		{
+			runBenchmark();
+			s_benchmarkRepeat = 0;
+		}
+	}
+
+	s32 getFramebufferX(const u8* out)
+	{
+		return s32(size_t(out - s_display) % size_t(s_width));
+	}
+
+	void rstrips_drawColumn(const RasterColumn* column)
+	{
+		if (!s_stripsActive)
+		{
+			rasterColumn(column, column->out, s_width, s_workBuffer);
+			return;
+		}
+
+		const s32 strip = getFramebufferX(column->out) / s_stripWidth;
+		RasterCmd cmd;
+		cmd.type = RCMD_COLUMN;
+		cmd.column = *column;
+		s_strips[strip].push_back(cmd);
+	}
+
+	void rstrips_drawScanline(const RasterScanline* scanline)
+	{
+		if (!s_stripsActive)
+		{
+			rasterScanline(scanline, scanline->out, 1);
+			return;
+		}
+
+		// Split the scanline at strip boundaries.
+		const s32 x0 = getFramebufferX(scanline->out);
+		const s32 x1 = x0 + scanline->width - 1;
+		const s32 strip0 = x0 / s_stripWidth;
+		const s32 strip1 = x1 / s_stripWidth;
+		if (strip0 == strip1)
+		{
+			RasterCmd cmd;
+			cmd.type = RCMD_SCANLINE;
+			cmd.scanline = *scanline;
+			s_strips[strip0].push_back(cmd);
+			return;
+		}
+
+		for (s32 s = strip0; s <= strip1; s++)
+		{
+			// Range of the scanline covered by the strip, relative to the left-most pixel.
+			const s32 start = max(x0, s * s_stripWidth) - x0;
+			const s32 end = min(x1, (s + 1) * s_stripWidth - 1) - x0;
+			// Texture coordinates step from the right-most pixel, so offset them by the number of pixels to the right of the piece.
+			// This is integer math, which gives the same result as stepping one pixel at a time.
+			const fixed44_20 steps = fixed44_20(scanline->width - 1 - end);
+
+			RasterCmd cmd;
+			cmd.type = RCMD_SCANLINE;
+			cmd.scanline = *scanline;
+			cmd.scanline.out   = scanline->out + start;
+			cmd.scanline.width = end - start + 1;
+			cmd.scanline.U0   += steps * scanline->dUdX;
+			cmd.scanline.V0   += steps * scanline->dVdX;
+			s_strips[s].push_back(cmd);
+		}
+	}
+
+	void rstrips_drawPolyColumn(const RasterPolyColumn* column)
+	{
+		if (!s_stripsActive)
+		{
+			rasterPolyColumn(column, column->out, s_width);
+			return;
+		}
+
+		const s32 strip = getFramebufferX(column->out) / s_stripWidth;
+		RasterCmd cmd;
+		cmd.type = RCMD_POLY_COLUMN;
+		cmd.polyColumn = *column;
+		s_strips[strip].push_back(cmd);
+	}
+
+	//////////////////////////////////////////////////////
+	// Transpose
+	//////////////////////////////////////////////////////
+	// dst[x*dstStride + y] = src[y*srcStride + x] for a 16x16 block.
+	void transposeBlock(const u8* src, s32 srcStride, u8* dst, s32 dstStride)
+	{
+	#if TFE_SSE2
+		__m128i r[16];
+		for (s32 i = 0; i < 16; i++)
+		{
+			r[i] = _mm_loadu_si128((const __m128i*)(src + i*srcStride));
+		}
+		// Interleave 8, 16, 32 and then 64 bits, each pass doubles the size of the transposed sub-blocks.
+		__m128i t[16];
+		for (s32 i = 0; i < 8; i++)
+		{
+			t[i*2 + 0] = _mm_unpacklo_epi8(r[i*2], r[i*2 + 1]);
+			t[i*2 + 1] = _mm_unpackhi_epi8(r[i*2], r[i*2 + 1]);
+		}
+		for (s32 i = 0; i < 4; i++)
+		{
+			r[i*4 + 0] = _mm_unpacklo_epi16(t[i*4 + 0], t[i*4 + 2]);
+			r[i*4 + 1] = _mm_unpackhi_epi16(t[i*4 + 0], t[i*4 + 2]);
+			r[i*4 + 2] = _mm_unpacklo_epi16(t[i*4 + 1], t[i*4 + 3]);
+			r[i*4 + 3] = _mm_unpackhi_epi16(t[i*4 + 1], t[i*4 + 3]);
+		}
+		for (s32 i = 0; i < 2; i++)
+		{
+			for (s32 j = 0; j < 4; j++)
+			{
+				t[i*8 + j*2 + 0] = _mm_unpacklo_epi32(r[i*8 + j], r[i*8 + j + 4]);
+				t[i*8 + j*2 + 1] = _mm_unpackhi_epi32(r[i*8 + j], r[i*8 + j + 4]);
+			}
+		}
+		for (s32 i = 0; i < 8; i++)
+		{
+			_mm_storeu_si128((__m128i*)(dst + (i*2 + 0)*dstStride), _mm_unpacklo_epi64(t[i], t[i + 8]));
+			_mm_storeu_si128((__m128i*)(dst + (i*2 + 1)*dstStride), _mm_unpackhi_epi64(t[i], t[i + 8]));
+		}
+	#else
+		for (s32 y = 0; y < TRANSPOSE_BLOCK; y++, src += srcStride)
+		{
+			for (s32 x = 0; x < TRANSPOSE_BLOCK; x++)
+			{
+				dst[x*dstStride + y] = src[x];
+			}
+		}
+	#endif
+	}
+
+	// dst[x*dstStride + y] = src[y*srcStride + x] for a width x height region.
+	void transposeRegion(const u8* src, s32 srcStride, u8* dst, s32 dstStride, s32 width, s32 height)
+	{
+		const s32 blockWidth  = width  & ~(TRANSPOSE_BLOCK - 1);
+		const s32 blockHeight = height & ~(TRANSPOSE_BLOCK - 1);
+		for (s32 y = 0; y < blockHeight; y += TRANSPOSE_BLOCK)
+		{
+			for (s32 x = 0; x < blockWidth; x += TRANSPOSE_BLOCK)
+			{
+				transposeBlock(src + y*srcStride + x, srcStride, dst + x*dstStride + y, dstStride);
+			}
+		}
+
+		// Edges that do not fill a complete block.
+		for (s32 y = 0; y < height; y++)
+		{
+			const s32 x0 = y < blockHeight ? blockWidth : 0;
+			for (s32 x = x0; x < width; x++)
+			{
+				dst[x*dstStride + y] = src[y*srcStride + x];
+			}
+		}
+	}
+
+	//////////////////////////////////////////////////////
+	// Strips
+	//////////////////////////////////////////////////////
+	// Replay the commands of a strip directly into the framebuffer.
+	void rasterStripRowMajor(s32 index, u8* workBuffer)
+	{
+		const RasterCmd* cmd = s_strips[index].data();
+		const size_t count = s_strips[index].size();
+		for (size_t i = 0; i < count; i++, cmd++)
+		{
+			switch (cmd->type)
+			{
+				case RCMD_COLUMN:
+					rasterColumn(&cmd->column, cmd->column.out, s_width, workBuffer);
+					break;
+				case RCMD_SCANLINE:
+					rasterScanline(&cmd->scanline, cmd->scanline.out, 1);
+					break;
+				case RCMD_POLY_COLUMN:
+					rasterPolyColumn(&cmd->polyColumn, cmd->polyColumn.out, s_width);
+					break;
+			}
+		}
+	}
+
+	// Replay the commands of a strip into a column-major copy of the strip, so that moving down a column is a one byte step.
+	void rasterStripColumnMajor(s32 index, u8* workBuffer)
+	{
+		const s32 x0 = index * s_stripWidth;
+		const s32 width = min(s_stripWidth, s_width - x0);
+		const s32 height = s_height;
+		if (width <= 0) { return; }
+
+		std::vector<u8>& buffer = s_stripBuffers[index];
+		buffer.resize(size_t(width) * size_t(height));
+		u8* stripOut = buffer.data();
+		transposeRegion(s_display + x0, s_width, stripOut, height, width, height);
+
+		const RasterCmd* cmd = s_strips[index].data();
+		const size_t count = s_strips[index].size();
+		for (size_t i = 0; i < count; i++, cmd++)
+		{
+			// Recorded output pointers are in the framebuffer, convert them to the column-major buffer.
+			const u8* out = cmd->type == RCMD_COLUMN ? cmd->column.out : (cmd->type == RCMD_SCANLINE ? cmd->scanline.out : cmd->polyColumn.out);
+			const size_t offset = size_t(out - s_display);
+			const s32 x = s32(offset % size_t(s_width)) - x0;
+			const s32 y = s32(offset / size_t(s_width));
+			u8* columnMajorOut = stripOut + x*height + y;
+
+			switch (cmd->type)
+			{
+				case RCMD_COLUMN:
+					rasterColumn(&cmd->column, columnMajorOut, 1, workBuffer);
+					break;
+				case RCMD_SCANLINE:
+					rasterScanline(&cmd->scanline, columnMajorOut, height);
+					break;
+				case RCMD_POLY_COLUMN:
+					rasterPolyColumn(&cmd->polyColumn, columnMajorOut, 1);
+					break;
+			}
+		}
+
+		transposeRegion(stripOut, height, s_display + x0, s_width, height, width);
+	}
+
+	// Runs on the worker threads, only reads from the recorded commands, textures and colormaps.
+	void rasterStrip(s32 index, void* userData)
+	{
+		u8 workBuffer[WAX_DECOMPRESS_SIZE];
+		if (s_columnMajor)
+		{
+			rasterStripColumnMajor(index, workBuffer);
+		}
+		else
+		{
+			rasterStripRowMajor(index, workBuffer);
+		}
+	}
+
+	// Replays the recorded frame, which gives the same result since every command writes the same pixels again.
+	f64 timeRasterization(JBool columnMajor, s32 repeatCount)
+	{
+		const JBool prevColumnMajor = s_columnMajor;
+		s_columnMajor = columnMajor;
+
+		const u64 start = TFE_System::getCurrentTimeInTicks();
+		for (s32 i = 0; i < repeatCount; i++)
+		{
+			TFE_Jobs::parallelFor(s_stripCount, rasterStrip, nullptr);
+		}
+		const f64 time = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - start);
+
+		s_columnMajor = prevColumnMajor;
+		return time * 1000.0 / f64(repeatCount);
+	}
+
+	void runBenchmark()
+	{
+		const f64 rowMajorMs = timeRasterization(JFALSE, s_benchmarkRepeat);
+		const f64 columnMajorMs = timeRasterization(JTRUE, s_benchmarkRepeat);
+
+		char result[256];
+		sprintf(result, "Rasterization %dx%d, %d threads, %d strips: row-major %.3f ms, column-major %.3f ms.", s_width, s_height,
+			TFE_Jobs::getThreadCount(), s_stripCount, rowMajorMs, columnMajorMs);
+		TFE_Console::addToHistory(result);
+		TFE_System::logWrite(LOG_MSG, "Renderer", result);
+	}
+
+	//////////////////////////////////////////////////////
+	// Inner loops, shared by the immediate and strip paths.
+	//////////////////////////////////////////////////////
+	// 'pitch' is the distance between rows in the output.
+	void rasterColumn(const RasterColumn* column, u8* columnOut, s32 pitch, u8* workBuffer)
+	{
+		const u8* tex = column->tex;
+		if (column->rleHeight > 0)
+		{
+			// Decompress the column into the "work buffer."
+			sprite_decompressColumn(tex, workBuffer, column->rleHeight);
+			tex = workBuffer;
+		}
+
+		const u8* light = column->light;
+		const fixed44_20 vCoordStep = column->vStep;
+		const s32 texHeightMask = column->texHeightMask;
+		const s32 end = column->count - 1;
+		fixed44_20 vCoordFixed = column->vCoord;
+
+		s32 offset = end * pitch;
+		switch (column->func)
+		{
+			case RCOL_FULLBRIGHT:
+			{
+				for (s32 i = end; i >= 0; i--, offset -= pitch, vCoordFixed += vCoordStep)
+				{
+					const s32 v = floor20(vCoordFixed) & texHeightMask;
+					columnOut[offset] = tex[v];
+				}
+			} break;
+			case RCOL_LIT:
+			{
+				for (s32 i = end; i >= 0; i--, offset -= pitch, vCoordFixed += vCoordStep)
+				{
+					const s32 v = floor20(vCoordFixed) & texHeightMask;
+					columnOut[offset] = light[tex[v]];
+				}
+			} break;
+			case RCOL_FULLBRIGHT_TRANS:
+			{
+				for (s32 i = end; i >= 0; i--, offset -= pitch, vCoordFixed += vCoordStep)
+				{
+					const s32 v = floor20(vCoordFixed) & texHeightMask;
+					const u8 c = tex[v];
+					if (c) { columnOut[offset] = c; }
+				}
+			} break;
+			case RCOL_LIT_TRANS:
+			{
+				for (s32 i = end; i >= 0; i--, offset -= pitch, vCoordFixed += vCoordStep)
+				{
+					const s32 v = floor20(vCoordFixed) & texHeightMask;
+					const u8 c = tex[v];
+					if (c) { columnOut[offset] = light[c]; }
+				}
+			} break;
+		}
+	}
+
+	// This produces functionally identical results to the original but splits apart the U/V and dUdx/dVdx into seperate variables
+	// to account for C vs ASM differences.
+	// Note this produces a distorted mapping if the texture is not 64x64.
+	// This behavior matches the original.
+	// 'step' is the distance between pixels of the scanline in the output.
+	void rasterScanline(const RasterScanline* scanline, u8* scanlineOut, s32 step)
+	{
+		const fixed44_20 dVdX = scanline->dVdX;
+		const fixed44_20 dUdX = scanline->dUdX;
+		fixed44_20 V = scanline->V0;
+		fixed44_20 U = scanline->U0;
+
+		const u8* texImage = scanline->tex;
+		const u8* light = scanline->light;
+		const s32 texDataEnd = scanline->texDataEnd;
+		u8* out = scanlineOut + (scanline->width - 1) * step;
+
+		switch (scanline->func)
+		{
+			case RSCAN_LIT:
+			{
+				for (s32 i = scanline->width - 1; i >= 0; i--, out -= step, U += dUdX, V += dVdX)
+				{
+					const u32 texel = ((floor20(U) & 63) * 64 + (floor20(V) & 63)) & texDataEnd;
+					*out = light[texImage[texel]];
+				}
+			} break;
+			case RSCAN_FULLBRIGHT:
+			{
+				for (s32 i = scanline->width - 1; i >= 0; i--, out -= step, U += dUdX, V += dVdX)
+				{
+					const u32 texel = ((floor20(U) & 63) * 64 + (floor20(V) & 63)) & texDataEnd;
+					*out = texImage[texel];
+				}
+			} break;
+			case RSCAN_LIT_TRANS:
+			{
+				for (s32 i = scanline->width - 1; i >= 0; i--, out -= step, U += dUdX, V += dVdX)
+				{
+					const u32 texel = ((floor20(U) & 63) * 64 + (floor20(V) & 63)) & texDataEnd;
+					const u8 baseColor = texImage[texel];
+					if (baseColor) { *out = light[baseColor]; }
+				}
+			} break;
+			case RSCAN_FULLBRIGHT_TRANS:
+			{
+				for (s32 i = scanline->width - 1; i >= 0; i--, out -= step, U += dUdX, V += dVdX)
+				{
+					const u32 texel = ((floor20(U) & 63) * 64 + (floor20(V) & 63)) & texDataEnd;
+					const u8 baseColor = texImage[texel];
+					if (baseColor) { *out = baseColor; }
+				}
+			} break;
+		}
+	}
+
+	void rasterPolyColumn(const RasterPolyColumn* column, u8* columnOut, s32 pitch)
+	{
+		const s32 end = column->count - 1;
+		s32 offset = end * pitch;
+
+		switch (column->func)
+		{
+			case RPOLY_FLAT_COLOR:
+			{
+				const u8 colorIndex = column->colorIndex;
+				for (s32 i = end; i >= 0; i--, offset -= pitch)
+				{
+					columnOut[offset] = colorIndex;
+				}
+			} break;
+			case RPOLY_SHADED_COLOR:
+			{
+				const u8* colorMap = column->colorMap;
+				const fixed44_20 dIdY = column->dIdY;
+				const fixed44_20 ditherOffset = column->ditherOffset;
+				const u8 colorIndex = column->colorIndex;
+				fixed44_20 intensity = column->I0;
+				s32 dither = column->dither;
+
+				for (s32 i = end; i >= 0; i--, offset -= pitch)
+				{
+					s32 pixelIntensity = floor20(intensity);
+					if (dither)
+					{
+						const fixed44_20 iOffset = intensity - ditherOffset;
+						if (iOffset >= 0)
+						{
+							pixelIntensity = floor20(iOffset);
+						}
+					}
+					columnOut[offset] = colorMap[(pixelIntensity&31)*256 + colorIndex];
+
+					intensity += dIdY;
+					dither = !dither;
+				}
+			} break;
+			case RPOLY_FLAT_TEXTURE:
+			{
+				const u8* colorMap = &column->colorMap[column->colorIndex * 256];
+				const u8* textureData = column->tex;
+				const s32 texHeight = column->texHeight;
+				const s32 texWidthMask = column->texWidthMask;
+				const s32 texHeightMask = column->texHeightMask;
+				const fixed44_20 dUdY = column->dUdY;
+				const fixed44_20 dVdY = column->dVdY;
+				fixed44_20 U = column->U0;
+				fixed44_20 V = column->V0;
+
+				for (s32 i = end; i >= 0; i--, offset -= pitch)
+				{
+					const u8 colorIndex = textureData[(floor20(U)&texWidthMask)*texHeight + (floor20(V)&texHeightMask)];
+					columnOut[offset] = colorMap[colorIndex];
+
+					U += dUdY;
+					V += dVdY;
+				}
+			} break;
+			case RPOLY_SHADED_TEXTURE:
+			{
+				const u8* colorMap = column->colorMap;
+				const u8* textureData = column->tex;
+				const s32 texHeight = column->texHeight;
+				const s32 texWidthMask = column->texWidthMask;
+				const s32 texHeightMask = column->texHeightMask;
+				const fixed44_20 dIdY = column->dIdY;
+				const fixed44_20 dUdY = column->dUdY;
+				const fixed44_20 dVdY = column->dVdY;
+				fixed44_20 U = column->U0;
+				fixed44_20 V = column->V0;
+				fixed44_20 I = column->I0;
+
+				for (s32 i = end; i >= 0; i--, offset -= pitch)
+				{
+					const u8 colorIndex = textureData[(floor20(U)&texWidthMask)*texHeight + (floor20(V)&texHeightMask)];
+					const s32 pixelIntensity = floor20(I)&31;
+					columnOut[offset] = colorMap[pixelIntensity*256 + colorIndex];
+
+					I += dIdY;
+					U += dUdY;
+					V += dVdY;
+				}
+			} break;
+		}
+	}
+}  // RClassic_Float
+
+}  // TFE_Jedi
@@ -0,0 +1,120 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Strips
+// Multithreaded rasterization for the floating point sub-renderer.
+//
+// The sector traversal, wall merging and clipping run on the main
+// thread exactly as before, but every column or scanline that would be
+// written to the framebuffer is recorded instead. The records are
+// bucketed into vertical strips of the framebuffer and the strips are
+// rasterized in parallel once the traversal is complete.
+//
+// Each strip replays its records in the original submission order
+// using the same inner loops as the single-threaded path, so the
+// output is bit-identical regardless of the thread count.
+//
+// Optionally each strip is rasterized into a column-major buffer,
+// so that wall and sprite columns write consecutive bytes instead of
+// touching a new cache line per pixel. The strip is transposed into
+// the buffer before rasterization and back out afterwards, using
+// 16x16 blocks.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include "fixedPoint20.h"
+
+namespace TFE_Jedi
+{
+	namespace RClassic_Float
+	{
+		// Matches ColumnFuncId in rwallFloat.cpp
+		enum RasterColumnFunc
+		{
+			RCOL_FULLBRIGHT = 0,
+			RCOL_LIT,
+			RCOL_FULLBRIGHT_TRANS,
+			RCOL_LIT_TRANS,
+		};
+
+		// Matches c_scanlineDrawFunc in rflatFloat.cpp
+		enum RasterScanlineFunc
+		{
+			RSCAN_LIT = 0,
+			RSCAN_FULLBRIGHT,
+			RSCAN_LIT_TRANS,
+			RSCAN_FULLBRIGHT_TRANS,
+		};
+
+		enum RasterPolyFunc
+		{
+			RPOLY_FLAT_COLOR = 0,
+			RPOLY_SHADED_COLOR,
+			RPOLY_FLAT_TEXTURE,
+			RPOLY_SHADED_TEXTURE,
+		};
+
+		// Wall, sky and sprite columns.
+		struct RasterColumn
+		{
+			u8* out;				// Top pixel of the column.
+			const u8* tex;			// Texture column or RLE compressed sprite column if rleHeight > 0.
+			const u8* light;		// Colormap used by the lit functions.
+			fixed44_20 vCoord;
+			fixed44_20 vStep;
+			s32 count;
+			s32 texHeightMask;
+			s32 rleHeight;
+			u8  func;				// RasterColumnFunc
+		};
+
+		// Flat and 3D object "plane" scanlines, texture coordinates start at the right-most pixel.
+		struct RasterScanline
+		{
+			u8* out;				// Left-most pixel of the scanline.
+			const u8* tex;
+			const u8* light;
+			fixed44_20 U0;
+			fixed44_20 V0;
+			fixed44_20 dUdX;
+			fixed44_20 dVdX;
+			s32 width;
+			s32 texDataEnd;
+			u8  func;				// RasterScanlineFunc
+		};
+
+		// 3D object polygon columns.
+		struct RasterPolyColumn
+		{
+			u8* out;				// Top pixel of the column.
+			const u8* tex;
+			const u8* colorMap;
+			fixed44_20 I0;
+			fixed44_20 dIdY;
+			fixed44_20 U0;
+			fixed44_20 V0;
+			fixed44_20 dUdY;
+			fixed44_20 dVdY;
+			fixed44_20 ditherOffset;
+			s32 count;
+			s32 texHeight;
+			s32 texWidthMask;
+			s32 texHeightMask;
+			s32 dither;
+			u8  colorIndex;
+			u8  func;				// RasterPolyFunc
+		};
+
+		// Start recording for the current frame, a thread count of 1 or less rasterizes immediately unless 'columnMajor' is set.
+		void rstrips_begin(s32 threadCount, bool columnMajor = false);
+		// Rasterize all recorded strips and wait for them to complete.
+		void rstrips_end();
+
+		// Draw or record, depending on whether the strips are active.
+		void rstrips_drawColumn(const RasterColumn* column);
+		void rstrips_drawScanline(const RasterScanline* scanline);
+		void rstrips_drawPolyColumn(const RasterPolyColumn* column);
+
+		// Time the rasterization of the next frame in both the row-major and column-major layouts,
+		// replaying the frame 'repeatCount' times. The results are written to the console.
+		void rstrips_requestBenchmark(s32 repeatCount);
+	}
+}
@@ -12,6 +12,7 @@
 #include "rsectorFloat.h"
 #include "redgePairFloat.h"
 #include "rclassicFloatSharedState.h"
+#include "rstripsFloat.h"
 #include "../rcommon.h"
 #include "../jediRenderer.h"
 
@@ -36,7 +37,6 @@ namespace RClassic_Float
 	static const u8* s_columnLight;
 	static u8* s_texImage;
 	static u8* s_columnOut;
-	static u8  s_workBuffer[WAX_DECOMPRESS_SIZE];
 
 	s32 segmentCrossesLine(f32 ax0, f32 ay0, f32 ax1, f32 ay1, f32 bx0, f32 by0, f32 bx1, f32 by1);
 	f32 solveForZ_Numerator(RWallSegmentFloat* wallSegment);
@@ -2140,62 +2140,40 @@ namespace RClassic_Float
 		return z;
 	}
 
-	void drawColumn_Fullbright()
+	// Submit the current column, it is either drawn immediately or recorded into its strip.
+	void submitColumn(u8 func, s32 rleHeight)
 	{
-		fixed44_20 vCoordFixed = s_vCoordFixed;
-		const u8* tex = s_texImage;
-		const s32 end = s_yPixelCount - 1;
+		RasterColumn column;
+		column.out = s_columnOut;
+		column.tex = s_texImage;
+		column.light = s_columnLight;
+		column.vCoord = s_vCoordFixed;
+		column.vStep = s_vCoordStep;
+		column.count = s_yPixelCount;
+		column.texHeightMask = s_texHeightMask;
+		column.rleHeight = rleHeight;
+		column.func = func;
+		rstrips_drawColumn(&column);
+	}
 
-		s32 offset = end * s_width;
-		for (s32 i = end; i >= 0; i--, offset -= s_width, vCoordFixed += s_vCoordStep)
-		{
-			const s32 v = floor20(vCoordFixed) & s_texHeightMask;
-			s_columnOut[offset] = tex[v];
-		}
+	void drawColumn_Fullbright()
+	{
+		submitColumn(RCOL_FULLBRIGHT, 0);
 	}
 
 	void drawColumn_Lit()
 	{
-		fixed44_20 vCoordFixed = s_vCoordFixed;
-		const u8* tex = s_texImage;
-		const s32 end = s_yPixelCount - 1;
-
-		s32 offset = end * s_width;
-		for (s32 i = end; i >= 0; i--, offset -= s_width, vCoordFixed += s_vCoordStep)
-		{
-			const s32 v = floor20(vCoordFixed) & s_texHeightMask;
-			s_columnOut[offset] = s_columnLight[tex[v]];
-		}
+		submitColumn(RCOL_LIT, 0);
 	}
 
 	void drawColumn_Fullbright_Trans()
 	{
-		fixed44_20 vCoordFixed = s_vCoordFixed;
-		const u8* tex = s_texImage;
-		const s32 end = s_yPixelCount - 1;
-
-		s32 offset = end * s_width;
-		for (s32 i = end; i >= 0; i--, offset -= s_width, vCoordFixed += s_vCoordStep)
-		{
-			const s32 v = floor20(vCoordFixed) & s_texHeightMask;
-			const u8 c = tex[v];
-			if (c) { s_columnOut[offset] = c; }
-		}
+		submitColumn(RCOL_FULLBRIGHT_TRANS, 0);
 	}
 
 	void drawColumn_Lit_Trans()
 	{
-		fixed44_20 vCoordFixed = s_vCoordFixed;
-		const u8* tex = s_texImage;
-		const s32 end = s_yPixelCount - 1;
-
-		s32 offset = end * s_width;
-		for (s32 i = end; i >= 0; i--, offset -= s_width, vCoordFixed += s_vCoordStep)
-		{
-			const s32 v = floor20(vCoordFixed) & s_texHeightMask;
-			const u8 c = tex[v];
-			if (c) { s_columnOut[offset] = s_columnLight[c]; }
-		}
+		submitColumn(RCOL_LIT_TRANS, 0);
 	}
 
 	void wall_addAdjoinSegment(s32 length, s32 x0, f32 top_dydx, f32 y1, f32 bot_dydx, f32 y0, RWallSegmentFloat* wallSegment)
@@ -2294,14 +2272,14 @@ namespace RClassic_Float
 		s_columnLight = computeLighting(z, 0);
 
 		// Figure out the correct column function.
-		ColumnFunction spriteColumnFunc;
+		u8 spriteColumnFunc;
 		if (s_columnLight && !(obj->flags & OBJ_FLAG_FULLBRIGHT) && !s_flatLighting)
 		{
-			spriteColumnFunc = s_columnFunc[COLFUNC_LIT_TRANS];
+			spriteColumnFunc = RCOL_LIT_TRANS;
 		}
 		else
 		{
-			spriteColumnFunc = s_columnFunc[COLFUNC_FULLBRIGHT_TRANS];
+			spriteColumnFunc = RCOL_FULLBRIGHT_TRANS;
 		}
 
 		// Draw
@@ -2360,14 +2338,13 @@ namespace RClassic_Float
 						texelU = cell->sizeX - texelU - 1;
 					}
 
+					// Compressed columns are decompressed into a "work buffer" when rasterized.
+					s32 rleHeight = 0;
 					if (compressed)
 					{
-						const u8* colPtr = (u8*)cell + columnOffset[texelU];
-
-						// Decompress the column into "work buffer."
-						assert(cell->sizeY <= 1024 && texelU >= 0 && texelU < cell->sizeX);
-						sprite_decompressColumn(colPtr, s_workBuffer, cell->sizeY);
-						s_texImage = (u8*)s_workBuffer;
+						assert(cell->sizeY <= WAX_DECOMPRESS_SIZE && texelU >= 0 && texelU < cell->sizeX);
+						s_texImage = (u8*)cell + columnOffset[texelU];
+						rleHeight = cell->sizeY;
 					}
 					else
 					{
@@ -2376,7 +2353,7 @@ namespace RClassic_Float
 					// Output.
 					s_columnOut = &s_display[y0 * s_width + x];
 					// Draw the column.
-					spriteColumnFunc();
+					submitColumn(spriteColumnFunc, rleHeight);
 					if (s_yPixelCount > 1) { drawn = JTRUE; }
 				}
 			}
@@ -1036,12 +1036,9 @@ namespace TFE_Jedi
 		const Vec2f ceilOffset = { fixed16ToFloat(curSector->ceilOffset.x), fixed16ToFloat(curSector->ceilOffset.z) };
 
 		SecObject** objIter = curSector->objectList;
-		for (s32 i = 0; i < curSector->objectCount; objIter++)
+		for (s32 i = 0; i < curSector->objectCount; i++, objIter++)
 		{
 			SecObject* obj = *objIter;
-			if (!obj) { continue; }
-			i++;
-
 			if ((obj->flags & OBJ_FLAG_NEEDS_TRANSFORM) && obj->ptr)
 			{
 				const s32 type = obj->type;
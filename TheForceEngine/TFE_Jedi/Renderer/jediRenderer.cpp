@@ -12,6 +12,7 @@
 #include "RClassic_Float/rclassicFloat.h"
 #include "RClassic_Float/rsectorFloat.h"
 #include "RClassic_Float/rclassicFloatSharedState.h"
+#include "RClassic_Float/rstripsFloat.h"
 
 #include "RClassic_GPU/rclassicGPU.h"
 #include "RClassic_GPU/rsectorGPU.h"
@@ -23,6 +24,7 @@
 #include <TFE_Asset/spriteAsset_Jedi.h>
 #include <TFE_Asset/modelAsset_jedi.h>
 #include <TFE_FrontEndUI/console.h>
+#include <TFE_RenderShared/texturePacker.h>
 
 namespace TFE_Jedi
 {
@@ -32,6 +34,7 @@ namespace TFE_Jedi
 	static TFE_Sectors* s_sectorRendererCache[TSR_COUNT] = { nullptr };
 	TFE_Sectors* s_sectorRenderer = nullptr;
 	RendererType s_rendererType = RENDERER_SOFTWARE;
+	static JBool s_drawEnabled = JTRUE;
 
 	/////////////////////////////////////////////
 	// Forward Declarations
@@ -39,6 +42,8 @@ namespace TFE_Jedi
 	void clear1dDepth();
 	void console_setSubRenderer(const std::vector<std::string>& args);
 	void console_getSubRenderer(const std::vector<std::string>& args);
+	void console_texturePackerBench(const std::vector<std::string>& args);
+	void console_rasterBench(const std::vector<std::string>& args);
 
 	/////////////////////////////////////////////
 	// Implementation
@@ -110,6 +115,8 @@ namespace TFE_Jedi
 		// Remove temporarily until they do something useful again.
 		CCMD("rsetSubRenderer", console_setSubRenderer, 1, "Set the sub-renderer - valid values are: Classic_Fixed, Classic_Float, Classic_GPU");
 		CCMD("rgetSubRenderer", console_getSubRenderer, 0, "Get the current sub-renderer.");
+		CCMD("rasterBench", console_rasterBench, 0, "Time the software rasterization of the next frame in the row-major and column-major layouts: rasterBench [repeatCount]");
+		CCMD("texturePackerBench", console_texturePackerBench, 0, "Benchmark the texture atlas over a sequence of synthetic levels: texturePackerBench [levelCount] [texturesPerLevel]");
 
 		// Setup performance counters.
 		TFE_COUNTER(s_maxAdjoinDepth, "Maximum Adjoin Depth");
@@ -223,6 +230,30 @@ namespace TFE_Jedi
 		};
 		TFE_Console::addToHistory(c_subRenderers[s_subRenderer]);
 	}
+
+	void console_texturePackerBench(const std::vector<std::string>& args)
+	{
+		const s32 levelCount = args.size() > 1 ? max(1, atoi(args[1].c_str())) : 16;
+		const s32 texturesPerLevel = args.size() > 2 ? max(1, atoi(args[2].c_str())) : 400;
+
+		f64 reuseRate;
+		s32 pageCount;
+		const f64 timePerLevel = texturepacker_benchmark(levelCount, texturesPerLevel, &reuseRate, &pageCount);
+
+		char result[256];
+		sprintf(result, "Texture Packer: %d levels, %.3f ms per level, %.1f%% of textures reused, %d pages.", levelCount, timePerLevel * 1000.0, reuseRate * 100.0, pageCount);
+		TFE_Console::addToHistory(result);
+	}
+
+	void console_rasterBench(const std::vector<std::string>& args)
+	{
+		if (s_subRenderer != TSR_CLASSIC_FLOAT)
+		{
+			TFE_Console::addToHistory("rasterBench requires the Classic_Float sub-renderer (resolutions other than 320x200).");
+			return;
+		}
+		RClassic_Float::rstrips_requestBenchmark(args.size() > 1 ? atoi(args[1].c_str()) : 20);
+	}
 		
 	JBool render_setResolution()
 	{
@@ -422,8 +453,19 @@ namespace TFE_Jedi
 		}
 	}
 
+	void renderer_enableDraw(JBool enable)
+	{
+		s_drawEnabled = enable;
+	}
+
 	void drawWorld(u8* display, RSector* sector, const u8* colormap, const u8* lightSourceRamp)
 	{
+		if (!s_drawEnabled)
+		{
+			s_drawnObjCount = 0;
+			return;
+		}
+
 		// Clear the top pixel row.
 		if (s_subRenderer != TSR_CLASSIC_GPU)
 		{
@@ -484,12 +526,25 @@ namespace TFE_Jedi
 			}
 		}
 				
+		// The floating point sub-renderer can rasterize vertical strips of the screen in parallel.
+		const JBool useStrips = s_subRenderer == TSR_CLASSIC_FLOAT;
+		if (useStrips)
+		{
+			TFE_Settings_Graphics* graphics = TFE_Settings::getGraphicsSettings();
+			RClassic_Float::rstrips_begin(graphics->renderThreadCount, graphics->columnMajorRaster);
+		}
+
 		// Recursively draws sectors and their contents (sprites, 3D objects).
 		{
 			TFE_ZONE("Sector Draw");
 			s_sectorRenderer->prepare();
 			s_sectorRenderer->draw(sector);
 		}
+
+		if (useStrips)
+		{
+			RClassic_Float::rstrips_end();
+		}
 	}
 
 	/////////////////////////////////////////////
@@ -67,6 +67,9 @@ namespace TFE_Jedi
 	//void setCamera(f32 yaw, f32 pitch, f32 x, f32 y, f32 z, s32 sectorId, s32 worldAmbient = 0, bool cameraLightSource = false);
 	// Draw the scene to the passed in display using the colormap for shading.
 	void drawWorld(u8* display, RSector* sector, const u8* colormap, const u8* lightSourceRamp);
+	// TFE: Skip world drawing, used when running headless without rendering.
+	// Note that no objects are reported as drawn while disabled, so auto-aim has no targets.
+	void renderer_enableDraw(JBool enable);
 
 	// Added for TFE so the GPU renderer knows the beginning and end of the drawing frame.
 	void beginRender();
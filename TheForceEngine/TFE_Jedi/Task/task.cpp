@@ -8,6 +8,7 @@
 #include <TFE_System/profiler.h>
 #include <TFE_Jedi/Serialization/serialization.h>
 #include <stdarg.h>
+#include <algorithm>
 #include <tuple>
 #include <vector>
 
@@ -62,6 +63,19 @@ struct Task
 
 	// Timing.
 	Tick nextTick;
+
+	// Scheduling.
+	// Tasks that are due (nextTick <= s_curTick), or have due subtasks, are linked into their parent's due list
+	// so that selectNextTask() can skip over sleeping tasks without visiting them.
+	u32 seq;				// Creation order, siblings are always ordered from newest to oldest.
+	u32 schedGen;			// Schedule generation the task was created in, see task_reset().
+	u32 timerId;			// Pending timer in s_taskTimers or 0.
+	s32 dueCount;			// Number of due tasks including this task and all of its subtasks.
+	JBool due;
+	JBool dueInList;
+	Task* dueHead;			// First subtask in this task's due list.
+	Task* duePrev;
+	Task* dueNext;
 };
 
 namespace TFE_Jedi
@@ -88,11 +102,33 @@ namespace TFE_Jedi
 
 	static f64 s_prevTime = 0.0;
 	static f64 s_minIntervalInSec = 0.0;
+	static JBool s_fixedStep = JFALSE;
 	static s32 s_frameActiveTaskCount = 0;
+	static s32 s_frameVisitedTaskCount = 0;
+	static s32 s_frameSkippedTaskCount = 0;
 	static JBool s_taskSystemPaused = JFALSE;
 	static Task* s_taskPauseTask = nullptr;
 
+	// Pending task wake ups, stored as a min-heap on tick.
+	// Timers are not removed when a task is rescheduled or freed, instead the id no longer matches and they are ignored.
+	struct TaskTimer
+	{
+		Tick tick;
+		u32 id;
+		Task* task;
+	};
+	static std::vector<TaskTimer> s_taskTimers;
+	static u32 s_taskTimerId = 0;
+	static u32 s_taskSeq = 0;
+	static u32 s_taskSchedGen = 0;
+	static Tick s_taskSchedTick = 0;
+
 	void selectNextTask();
+	void task_schedule(Task* task, Tick tick);
+	void task_setDue(Task* task, JBool due);
+	void task_resetSchedule();
+	void task_dueListInsert(Task* task);
+	void task_dueListRemove(Task* task);
 
 	void createRootTask()
 	{
@@ -103,6 +139,7 @@ namespace TFE_Jedi
 		s_rootTask.prev = &s_rootTask;
 		s_rootTask.next = &s_rootTask;
 		s_rootTask.nextTick = TASK_SLEEP;
+		task_resetSchedule();
 
 		s_taskIter = &s_rootTask;
 		s_curTask = &s_rootTask;
@@ -110,6 +147,19 @@ namespace TFE_Jedi
 		s_frameActiveTaskCount = 0;
 	}
 
+	void task_initSchedule(Task* task)
+	{
+		task->seq = ++s_taskSeq;
+		task->schedGen = s_taskSchedGen;
+		task->timerId = 0;
+		task->dueCount = 0;
+		task->due = JFALSE;
+		task->dueInList = JFALSE;
+		task->dueHead = nullptr;
+		task->duePrev = nullptr;
+		task->dueNext = nullptr;
+	}
+
 	Task* createSubTask(const char* name, TaskFunc func, TaskFunc localRunFunc)
 	{
 		if (!s_tasks)
@@ -139,13 +189,14 @@ namespace TFE_Jedi
 		newTask->retTask = nullptr;
 		newTask->userData = nullptr;
 		newTask->framebreak = JFALSE;
-		
-		newTask->nextTick = 0;
 
 		newTask->context = { 0 };
 		newTask->context.callstack[0] = func;
 		newTask->localRunFunc = localRunFunc;
 		newTask->context.level = TASK_INIT_LEVEL;
+
+		task_initSchedule(newTask);
+		task_schedule(newTask, 0);
 		return newTask;
 	}
 
@@ -181,8 +232,14 @@ namespace TFE_Jedi
 		newTask->context.callstack[0] = func;
 		newTask->localRunFunc = localRunFunc;
 		newTask->context.level = TASK_INIT_LEVEL;
-		newTask->nextTick = s_curTick;
 
+		task_initSchedule(newTask);
+		// The framebreak task must always be visited, so it never leaves the due list.
+		if (framebreak)
+		{
+			task_dueListInsert(newTask);
+		}
+		task_schedule(newTask, s_curTick);
 		return newTask;
 	}
 	
@@ -199,6 +256,10 @@ namespace TFE_Jedi
 			task->context.stackPtr[0] = task->context.stackMem;
 		}
 		SERIALIZE(SaveVersionInit, task->context.stackOffset, 0);
+		if (serialization_getMode() == SMODE_READ)
+		{
+			task_schedule(task, task->nextTick);
+		}
 		if (localMemCallback)
 		{
 			localMemCallback(stream, userData, task->context.stackPtr[0]);
@@ -228,6 +289,14 @@ namespace TFE_Jedi
 		{
 			selectNextTask();
 		}
+		// Remove the task from the schedule.
+		if (task->schedGen == s_taskSchedGen)
+		{
+			task_setDue(task, JFALSE);
+			task_dueListRemove(task);
+		}
+		task->timerId = 0;
+
 		// Then remove the task.
 		if (task->prev)
 		{
@@ -263,11 +332,13 @@ namespace TFE_Jedi
 		s_rootTask.prev = &s_rootTask;
 		s_rootTask.next = &s_rootTask;
 		s_rootTask.nextTick = TASK_SLEEP;
+		task_resetSchedule();
 
 		s_taskIter = &s_rootTask;
 		s_curTask = &s_rootTask;
 		s_taskCount = 0;
 		s_frameActiveTaskCount = 0;
+		s_frameSkippedTaskCount = 0;
 
 		s_taskSystemPaused = JFALSE;
 		s_taskPauseTask = nullptr;
@@ -277,6 +348,7 @@ namespace TFE_Jedi
 	{
 		chunkedArrayClear(s_tasks);
 		chunkedArrayClear(s_stackBlocks);
+		task_resetSchedule();
 
 		s_curTask    = nullptr;
 		s_curContext = nullptr;
@@ -298,18 +370,22 @@ namespace TFE_Jedi
 		s_prevTime = 0.0;
 		s_minIntervalInSec = 0.0;
 		s_frameActiveTaskCount = 0;
+		s_frameSkippedTaskCount = 0;
 		s_taskSystemPaused = JFALSE;
 		s_taskPauseTask = nullptr;
+
+		task_resetSchedule();
+		s_taskTimers.shrink_to_fit();
 	}
 
 	void task_makeActive(Task* task)
 	{
-		task->nextTick = 0;
+		task_schedule(task, 0);
 	}
 
 	void task_setNextTick(Task* task, Tick tick)
 	{
-		task->nextTick = tick;
+		task_schedule(task, tick);
 	}
 
 	void task_setUserData(Task* task, void* data)
@@ -351,6 +427,246 @@ namespace TFE_Jedi
 		return task->localRunFunc != nullptr;
 	}
 
+	//////////////////////////////////////////////////////////////////////////////////////////
+	// Scheduling
+	// Each task tracks whether it is due to run (nextTick <= s_curTick). Tasks that are due, or have due subtasks,
+	// are kept in a "due list" owned by their parent - or in the circular main list that starts at the root task.
+	// Due lists keep the same relative order as the task lists: new tasks and subtasks are always inserted at the
+	// head of their list, so list order is simply newest to oldest ('seq' from highest to lowest).
+	// Tasks are removed lazily from due lists, when they are passed over while no longer being due.
+	// Tasks delayed by a number of ticks are woken up by timers, so tasks that are not due are never visited.
+	//////////////////////////////////////////////////////////////////////////////////////////
+	bool taskTimerCompare(const TaskTimer& a, const TaskTimer& b)
+	{
+		// Min-heap ordered by tick, then by scheduling order.
+		return a.tick > b.tick || (a.tick == b.tick && a.id > b.id);
+	}
+
+	JBool task_isActive(Task* task)
+	{
+		// The root task anchors the main due list and framebreak tasks must always be visited.
+		return task->dueCount > 0 || task->framebreak || task == &s_rootTask;
+	}
+
+	// Find the first task in the due list that comes after 'task' in list order,
+	// used when 'task' itself is not in the list.
+	Task* task_dueListFind(Task* task)
+	{
+		Task* parent = task->subtaskParent;
+		if (parent)
+		{
+			Task* cur = parent->dueHead;
+			while (cur && cur->seq > task->seq) { cur = cur->dueNext; }
+			return cur;
+		}
+		Task* cur = s_rootTask.dueNext;
+		while (cur != &s_rootTask && cur->seq > task->seq) { cur = cur->dueNext; }
+		return cur;
+	}
+
+	void task_dueListInsert(Task* task)
+	{
+		Task* parent = task->subtaskParent;
+		if (parent)
+		{
+			Task* prev = nullptr;
+			Task* cur = parent->dueHead;
+			while (cur && cur->seq > task->seq)
+			{
+				prev = cur;
+				cur = cur->dueNext;
+			}
+			task->duePrev = prev;
+			task->dueNext = cur;
+			if (prev) { prev->dueNext = task; }
+			else { parent->dueHead = task; }
+			if (cur) { cur->duePrev = task; }
+		}
+		else
+		{
+			// Main tasks, this list is circular like the main task list.
+			Task* cur = task_dueListFind(task);
+			task->duePrev = cur->duePrev;
+			task->dueNext = cur;
+			cur->duePrev->dueNext = task;
+			cur->duePrev = task;
+		}
+		task->dueInList = JTRUE;
+	}
+
+	void task_dueListRemove(Task* task)
+	{
+		if (!task->dueInList) { return; }
+
+		if (task->duePrev) { task->duePrev->dueNext = task->dueNext; }
+		else if (task->subtaskParent) { task->subtaskParent->dueHead = task->dueNext; }
+		if (task->dueNext) { task->dueNext->duePrev = task->duePrev; }
+
+		task->duePrev = nullptr;
+		task->dueNext = nullptr;
+		task->dueInList = JFALSE;
+	}
+
+	// Returns the next sibling that is due or has due subtasks, or null if there are none.
+	Task* task_nextDueSibling(Task* task)
+	{
+		Task* next = task->dueInList ? task->dueNext : task_dueListFind(task);
+		while (next && !task_isActive(next))
+		{
+			Task* skip = next;
+			next = next->dueNext;
+			task_dueListRemove(skip);
+		}
+		return next;
+	}
+
+	Task* task_firstDueSubtask(Task* task)
+	{
+		Task* subtask = task->dueHead;
+		while (subtask && !task_isActive(subtask))
+		{
+			Task* skip = subtask;
+			subtask = subtask->dueNext;
+			task_dueListRemove(skip);
+		}
+		return subtask;
+	}
+
+	void task_setDue(Task* task, JBool due)
+	{
+		// Tasks orphaned by task_reset() are no longer part of the task lists.
+		if (task->due == due || task->schedGen != s_taskSchedGen) { return; }
+		task->due = due;
+
+		const s32 delta = due ? 1 : -1;
+		for (Task* cur = task; cur; cur = cur->subtaskParent)
+		{
+			cur->dueCount += delta;
+			if (delta > 0 && cur->dueCount == 1 && !cur->dueInList)
+			{
+				task_dueListInsert(cur);
+			}
+		}
+	}
+
+	void task_schedule(Task* task, Tick tick)
+	{
+		task->nextTick = tick;
+		task->timerId = 0;
+		if (tick <= s_curTick)
+		{
+			task_setDue(task, JTRUE);
+			return;
+		}
+
+		task_setDue(task, JFALSE);
+		if (tick != TASK_SLEEP && task->schedGen == s_taskSchedGen)
+		{
+			// Compact the timers if too many are stale.
+			if (s_taskTimers.size() >= size_t(2 * s_taskCount + 64))
+			{
+				size_t count = 0;
+				for (size_t i = 0; i < s_taskTimers.size(); i++)
+				{
+					if (s_taskTimers[i].task->timerId == s_taskTimers[i].id)
+					{
+						s_taskTimers[count++] = s_taskTimers[i];
+					}
+				}
+				s_taskTimers.resize(count);
+				std::make_heap(s_taskTimers.begin(), s_taskTimers.end(), taskTimerCompare);
+			}
+
+			task->timerId = ++s_taskTimerId;
+			s_taskTimers.push_back({ tick, task->timerId, task });
+			std::push_heap(s_taskTimers.begin(), s_taskTimers.end(), taskTimerCompare);
+		}
+	}
+
+	void task_resetSchedule()
+	{
+		s_taskTimers.clear();
+		s_taskSchedGen++;
+		s_taskSchedTick = s_curTick;
+
+		s_rootTask.schedGen = s_taskSchedGen;
+		s_rootTask.timerId = 0;
+		s_rootTask.dueCount = 0;
+		s_rootTask.due = JFALSE;
+		s_rootTask.dueInList = JTRUE;
+		s_rootTask.dueHead = nullptr;
+		s_rootTask.duePrev = &s_rootTask;
+		s_rootTask.dueNext = &s_rootTask;
+	}
+
+	void task_visitTree(Task* task, void(*visit)(Task*))
+	{
+		for (Task* subtask = task->subtaskNext; subtask; subtask = subtask->next)
+		{
+			task_visitTree(subtask, visit);
+		}
+		visit(task);
+	}
+
+	void task_visitAll(void(*visit)(Task*))
+	{
+		task_visitTree(&s_rootTask, visit);
+		for (Task* task = s_rootTask.next; task && task != &s_rootTask; task = task->next)
+		{
+			task_visitTree(task, visit);
+		}
+	}
+
+	// Rebuild the due lists and timers from scratch, required if time moves backwards (such as when loading).
+	void task_rebuildSchedule()
+	{
+		task_visitAll([](Task* task)
+		{
+			task->timerId = 0;
+			task->dueCount = 0;
+			task->due = JFALSE;
+			task->dueInList = JFALSE;
+			task->dueHead = nullptr;
+			task->duePrev = nullptr;
+			task->dueNext = nullptr;
+		});
+		task_resetSchedule();
+
+		task_visitAll([](Task* task)
+		{
+			if (task == &s_rootTask) { return; }
+			task->schedGen = s_taskSchedGen;
+			if (task->framebreak && !task->dueInList)
+			{
+				task_dueListInsert(task);
+			}
+			task_schedule(task, task->nextTick);
+		});
+	}
+
+	// Wake up tasks whose timers have expired.
+	void task_updateSchedule()
+	{
+		if (s_curTick < s_taskSchedTick)
+		{
+			task_rebuildSchedule();
+		}
+		s_taskSchedTick = s_curTick;
+
+		while (!s_taskTimers.empty() && s_taskTimers.front().tick <= s_curTick)
+		{
+			const TaskTimer timer = s_taskTimers.front();
+			std::pop_heap(s_taskTimers.begin(), s_taskTimers.end(), taskTimerCompare);
+			s_taskTimers.pop_back();
+
+			if (timer.task->timerId == timer.id)
+			{
+				timer.task->timerId = 0;
+				task_setDue(timer.task, JTRUE);
+			}
+		}
+	}
+
 	void ctxReturn()
 	{
 		TASK_MSG("Return from function, task: '%s'.", s_curTask->name);
@@ -390,6 +706,8 @@ namespace TFE_Jedi
 
 	void selectNextTask()
 	{
+		task_updateSchedule();
+
 		// Find the next task to run.
 		Task* task = s_curTask;
 		while (1)
@@ -402,15 +720,21 @@ namespace TFE_Jedi
 			//  * Execute the task.
 			//  * Once we are on the last sub-task, then go back to the parent.
 			//  * Once the parent executes, then we move on to parent->next and start all over.
-			if (task->next)
+			// Tasks (and their sub-tasks) that are not due are skipped using the due lists, which visits
+			// the remaining tasks in the same order as walking every task.
+			Task* next = task_nextDueSibling(task);
+			if (next)
 			{
 				// Move the to the next task.
-				task = task->next;
-				// If the task has sub-tasks, loop until we find the last one.
+				task = next;
+				s_frameVisitedTaskCount++;
+				// If the task has due sub-tasks, loop until we find the last one.
 				// This is usually only one deep.
-				while (task->subtaskNext)
+				Task* subtask;
+				while ((subtask = task_firstDueSubtask(task)) != nullptr)
 				{
-					task = task->subtaskNext;
+					task = subtask;
+					s_frameVisitedTaskCount++;
 				}
 				// Then execute the task.
 				if (task->nextTick <= s_curTick || task->framebreak)
@@ -424,6 +748,7 @@ namespace TFE_Jedi
 			{
 				// Otherwise, try to execute the parent.
 				task = task->subtaskParent;
+				s_frameVisitedTaskCount++;
 				if (task->nextTick <= s_curTick || task->framebreak)
 				{
 					s_currentMsg = MSG_RUN_TASK;
@@ -503,7 +828,7 @@ namespace TFE_Jedi
 		}
 
 		// Update the current tick based on the delay.
-		s_curTask->nextTick = (delay < TASK_SLEEP) ? s_curTick + delay : delay;
+		task_schedule(s_curTask, (delay < TASK_SLEEP) ? s_curTick + delay : delay);
 		
 		// Find the next task to run.
 		selectNextTask();
@@ -517,9 +842,14 @@ namespace TFE_Jedi
 		s_minIntervalInSec = minIntervalInSec;
 	}
 
+	void task_setFixedStep(JBool fixedStep)
+	{
+		s_fixedStep = fixedStep;
+	}
+
 	JBool task_canRun()
 	{
-		if (s_taskCount)
+		if (s_taskCount && !s_fixedStep)
 		{
 			const f64 time = TFE_System::getTime();
 			if (time - s_prevTime < s_minIntervalInSec)
@@ -548,13 +878,15 @@ namespace TFE_Jedi
 		// Limit the update rate by the minimum interval.
 		// Dark Forces uses discrete 'ticks' to track time and the game behavior is very odd with 0 tick frames.
 		const f64 time = TFE_System::getTime();
-		if (time - s_prevTime < s_minIntervalInSec)
+		if (!s_fixedStep && time - s_prevTime < s_minIntervalInSec)
 		{
 			return JFALSE;
 		}
 		s_prevTime = time;
 		s_currentMsg = MSG_RUN_TASK;
 		s_frameActiveTaskCount = 0;
+		s_frameVisitedTaskCount = 0;
+		task_updateSchedule();
 
 		// Return if the task system is paused.
 		if (s_taskSystemPaused)
@@ -577,6 +909,7 @@ namespace TFE_Jedi
 					}
 				}
 			}
+			s_frameSkippedTaskCount = s_taskCount - s_frameActiveTaskCount;
 			return JTRUE;
 		}
 
@@ -614,6 +947,7 @@ namespace TFE_Jedi
 				break;
 			}
 		}
+		s_frameSkippedTaskCount = max(0, s_taskCount - s_frameVisitedTaskCount);
 		return JTRUE;
 	}
 
@@ -624,6 +958,7 @@ namespace TFE_Jedi
 
 		TFE_COUNTER(s_taskCount, "Task Count");
 		TFE_COUNTER(s_frameActiveTaskCount, "Active Tasks");
+		TFE_COUNTER(s_frameSkippedTaskCount, "Skipped Tasks");
 	}
 
 	s32 task_getCount()
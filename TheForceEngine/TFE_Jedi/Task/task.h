@@ -73,6 +73,9 @@ namespace TFE_Jedi
 	JBool task_canRun();
 	void task_setDefaults();
 	void task_setMinStepInterval(f64 minIntervalInSec);
+	// When enabled, every call to task_run() advances the tasks instead of waiting for the minimum interval to pass.
+	// This is used to drive the tasks on a fixed step, independent of the wall clock.
+	void task_setFixedStep(JBool fixedStep);
 
 	void task_updateTime();
 	s32 task_getCount();
@@ -24,34 +24,47 @@ using namespace TFE_Jedi;
 enum
 {
 	MIN_SPLIT_SIZE = 32,
+	MIN_ALLOC_SIZE = 32,	// Every allocation must be able to hold AllocHeaderFree{} once freed.
 	BLOCK_ARR_STEP = 16,
 	ALIGNMENT = 8,
-	ALLOC_BIN_COUNT = 6,
-	ALLOC_BIN_LAST = 5,
+	ALIGNMENT_LOG2 = 3,
+	// Free lists use two-level segregated fits (TLSF):
+	// The first level splits sizes into powers of two, the second level splits each power of two into SL_COUNT
+	// linear ranges. Sizes below SMALL_BLOCK_SIZE are all in first level 0, with a step of ALIGNMENT.
+	SL_INDEX_LOG2 = 4,
+	SL_COUNT = 1 << SL_INDEX_LOG2,
+	FL_INDEX_SHIFT = SL_INDEX_LOG2 + ALIGNMENT_LOG2,
+	FL_INDEX_MAX = 25,		// Must hold MAX_BLOCK_SIZE.
+	FL_COUNT = FL_INDEX_MAX - FL_INDEX_SHIFT + 1,
+	SMALL_BLOCK_SIZE = 1 << FL_INDEX_SHIFT,
 	// No more then 256 blocks, and no more than 16MB per block for a total of 4GB.
 	MAX_BLOCK_COUNT = 256,
 	MAX_BLOCK_SIZE  = 16 * 1024 * 1024,
 	RELATIVE_NON_NULL_BIT = 1u,
-	SHARED_HEADER_SIZE = 8,	// 8 bytes are shared between RegionAllocHeader{} and AllocHeaderFree{}
+	SHARED_HEADER_SIZE = 16,	// 16 bytes are shared between RegionAllocHeader{} and AllocHeaderFree{}
 };
 
 struct RegionAllocHeader
 {
 	u32 size;
 	u8  free;
-	u8  bin;
-	u8  pad8[2];
-	u32 pad4[2];	// pad to 16 bytes.
+	u8  fl;
+	u8  sl;
+	u8  pad8;
+	u32 prevSize;	// Size of the previous header in the block, 0 for the first header. Used to merge free neighbors.
+	u32 pad4;		// pad to 16 bytes.
 };
 
-// free structure is larger than header, because it fits within the
-// alignment: align(8, sizeof(header)=16 + size), so at least 24 bytes is allocated.
+// free structure is larger than header, so every allocation is at least MIN_ALLOC_SIZE bytes.
 struct AllocHeaderFree
 {
 	u32 size;
 	u8  free;
-	u8  bin;
-	u8  pad8[2];
+	u8  fl;
+	u8  sl;
+	u8  pad8;
+	u32 prevSize;
+	u32 pad4;
 	AllocHeaderFree* binNext;
 	AllocHeaderFree* binPrev;
 #if (defined(_WIN32) && !defined(_WIN64)) || (__SIZEOF_POINTER__ == 4)
@@ -65,15 +78,11 @@ struct MemoryBlock
 {
 	u32 sizeFree;
 	u32 count;
-	// Head pointer to each bin.
-	// Bin index = clamp(log2(nextPow2(size)) - 5, 0, 5)
-	// bin 0: [0,  32]
-	//     1: [33, 64]
-	//     2: [65, 128]
-	//     3: [129, 256]
-	//     4: [257, 512]
-	//     5: [513+]
-	AllocHeaderFree* freeListBins[ALLOC_BIN_COUNT];
+	u32 index;
+	// Bit 'fl' is set if any list in slBitmap[fl] is non-empty, bit 'sl' of slBitmap[fl] is set if freeLists[fl][sl] is non-empty.
+	u32 flBitmap;
+	u32 slBitmap[FL_COUNT];
+	AllocHeaderFree* freeLists[FL_COUNT][SL_COUNT];
 };
 
 struct MemoryRegion
@@ -85,10 +94,22 @@ struct MemoryRegion
 	size_t blockCount;
 	size_t blockSize;
 	size_t maxBlocks;
+
+	// Copy of each block's 'flBitmap', so blocks without a large enough free span are skipped without touching their memory.
+	u32* blockFreeMask;
+
+	// Stats
+	u32 allocCount;
+	u32 freeCount;
+	u32 frameAllocCount;
+	u32 frameFreeCount;
+	u64 totalAllocCount;
+	u64 totalFreeCount;
 };
 
 static_assert(sizeof(RegionAllocHeader) == 16, "RegionAllocHeader is the wrong size.");
-static_assert(sizeof(AllocHeaderFree) == 24, "AllocHeaderFree is the wrong size.");
+static_assert(sizeof(AllocHeaderFree) == MIN_ALLOC_SIZE, "AllocHeaderFree is the wrong size.");
+static_assert(MAX_BLOCK_SIZE < (1 << FL_INDEX_MAX), "FL_INDEX_MAX is too small for MAX_BLOCK_SIZE.");
 
 namespace TFE_Memory
 {
@@ -97,12 +118,48 @@ namespace TFE_Memory
 	static const u32 c_relativeBlockShift = 24u;
 	static const u32 c_relativeOffsetMask = (1u << c_relativeBlockShift) - 1u;
 
-	void freeSlot(RegionAllocHeader* alloc, RegionAllocHeader* next, MemoryBlock* block);
+	void freeSlot(MemoryRegion* region, RegionAllocHeader* alloc, MemoryBlock* block);
 	size_t alloc_align(size_t baseSize);
-	s32  getBinFromSize(u32 size);
+	void getListFromSize(u32 size, s32* fl, s32* sl);
 	bool allocateNewBlock(MemoryRegion* region);
-	void removeHeaderFromFreelist(MemoryBlock* block, RegionAllocHeader* header);
-	void insertBlockIntoFreelist(MemoryBlock* block, RegionAllocHeader* header);
+	void resetBlock(MemoryRegion* region, MemoryBlock* block);
+	void removeHeaderFromFreelist(MemoryRegion* region, MemoryBlock* block, RegionAllocHeader* header);
+	void insertBlockIntoFreelist(MemoryRegion* region, MemoryBlock* block, RegionAllocHeader* header);
+
+	RegionAllocHeader* getNextHeader(MemoryRegion* region, MemoryBlock* block, RegionAllocHeader* header)
+	{
+		RegionAllocHeader* next = (RegionAllocHeader*)((u8*)header + header->size);
+		return ((u8*)next < (u8*)block + sizeof(MemoryBlock) + region->blockSize) ? next : nullptr;
+	}
+
+	RegionAllocHeader* getPrevHeader(RegionAllocHeader* header)
+	{
+		return header->prevSize ? (RegionAllocHeader*)((u8*)header - header->prevSize) : nullptr;
+	}
+
+	// Call after changing the size of 'header', so the following header can find it.
+	void updateNextPrevSize(MemoryRegion* region, MemoryBlock* block, RegionAllocHeader* header)
+	{
+		RegionAllocHeader* next = getNextHeader(region, block, header);
+		if (next)
+		{
+			next->prevSize = header->size;
+		}
+	}
+
+	MemoryBlock* findBlock(MemoryRegion* region, void* ptr)
+	{
+		for (s32 i = (s32)region->blockCount - 1; i >= 0; i--)
+		{
+			MemoryBlock* block = region->memBlocks[i];
+			u8* mem = (u8*)block + sizeof(MemoryBlock);
+			if ((u8*)ptr >= mem && (u8*)ptr < mem + region->blockSize)
+			{
+				return block;
+			}
+		}
+		return nullptr;
+	}
 
 	void verifyMemory(MemoryRegion* region)
 	{
@@ -110,6 +167,7 @@ namespace TFE_Memory
 		{
 			MemoryBlock* block = region->memBlocks[i];
 			assert(block->sizeFree <= region->blockSize);
+			assert(block->index == u32(i) && region->blockFreeMask[i] == block->flBitmap);
 			u8* mem = (u8*)block + sizeof(MemoryBlock);
 			RegionAllocHeader* prev = nullptr;
 			for (u32 a = 0; a < block->count; a++)
@@ -117,18 +175,23 @@ namespace TFE_Memory
 				RegionAllocHeader* header = (RegionAllocHeader*)mem;
 				assert(header->free == 0 || header->free == 1);
 				assert(header->size <= region->blockSize);
+				assert(header->prevSize == (prev ? prev->size : 0));
+				// Free neighbors are always merged.
+				assert(!prev || !prev->free || !header->free);
 				mem += header->size;
 				prev = header;
 			}
 
-			for (s32 b = 0; b < ALLOC_BIN_COUNT; b++)
+			for (s32 fl = 0; fl < FL_COUNT; fl++)
 			{
-				if (block->freeListBins[b])
+				assert(((block->flBitmap >> fl) & 1) == (block->slBitmap[fl] ? 1u : 0u));
+				for (s32 sl = 0; sl < SL_COUNT; sl++)
 				{
-					AllocHeaderFree* slot = block->freeListBins[b];
+					AllocHeaderFree* slot = block->freeLists[fl][sl];
+					assert(((block->slBitmap[fl] >> sl) & 1) == (slot ? 1u : 0u));
 					while (slot)
 					{
-						assert(slot->free == 1 && slot->bin == b);
+						assert(slot->free == 1 && slot->fl == fl && slot->sl == sl);
 						assert(slot->size <= block->sizeFree);
 						slot = slot->binNext;
 					}
@@ -154,14 +217,14 @@ namespace TFE_Memory
 			return nullptr;
 		}
 
+		memset(region, 0, sizeof(MemoryRegion));
 		strcpy(region->name, name);
-		region->memBlocks = nullptr;
-		region->blockArrCapacity = 0;
-		region->blockCount = 0;
 		region->blockSize = blockSize;
 		region->maxBlocks = maxSize ? (maxSize + blockSize - 1) / blockSize : 0;
 		if (!allocateNewBlock(region))
 		{
+			free(region->memBlocks);
+			free(region->blockFreeMask);
 			free(region);
 			TFE_System::logWrite(LOG_ERROR, "MemoryRegion", "Failed to memory block of size %u in region '%s'.", blockSize, name);
 			return nullptr;
@@ -176,15 +239,7 @@ namespace TFE_Memory
 		assert(region);
 		for (s32 i = 0; i < region->blockCount; i++)
 		{
-			MemoryBlock* block = region->memBlocks[i];
-			block->sizeFree = u32(region->blockSize);
-			block->count = 1;
-
-			RegionAllocHeader* header = (RegionAllocHeader*)((u8*)block + sizeof(MemoryBlock));
-			header->size = block->sizeFree;
-			header->free = 0;
-			memset(block->freeListBins, 0, sizeof(AllocHeaderFree*)*ALLOC_BIN_COUNT);
-			insertBlockIntoFreelist(block, header);
+			resetBlock(region, region->memBlocks[i]);
 			VERIFY_MEMORY();
 		}
 	}
@@ -197,73 +252,104 @@ namespace TFE_Memory
 			free(region->memBlocks[i]);
 		}
 		free(region->memBlocks);
+		free(region->blockFreeMask);
 		free(region);
 	}
-		
-	void* allocFromHeader(MemoryBlock* block, RegionAllocHeader* header, u32 size)
+
+	// Split 'header' so that it is 'size' bytes, the remainder is added to the free list.
+	void splitHeader(MemoryRegion* region, MemoryBlock* block, RegionAllocHeader* header, u32 size)
 	{
-		assert(header->free == 1);
 		if (header->size - size >= MIN_SPLIT_SIZE)
 		{
-			// Split.
-			size_t split0 = size;
-			size_t split1 = header->size - split0;
-			RegionAllocHeader* next = (RegionAllocHeader*)((u8*)header + split0);
-
-			// Cleanup the free list.
-			removeHeaderFromFreelist(block, header);
-			header->size = u32(split0);
+			const u32 split1 = header->size - size;
+			RegionAllocHeader* next = (RegionAllocHeader*)((u8*)header + size);
+			header->size = size;
 
 			// Create a new free block.
-			next->size = u32(split1);
+			next->size = split1;
 			next->free = 0;
+			next->prevSize = size;
+			updateNextPrevSize(region, block, next);
 			block->count++;
-						
+
 			// Add the new block to the free list.
-			insertBlockIntoFreelist(block, next);
-		}
-		else
-		{
-			// Consume the whole block.
-			removeHeaderFromFreelist(block, header);
+			insertBlockIntoFreelist(region, block, next);
 		}
+	}
+		
+	void* allocFromHeader(MemoryRegion* region, MemoryBlock* block, RegionAllocHeader* header, u32 size)
+	{
+		assert(header->free == 1);
+		removeHeaderFromFreelist(region, block, header);
+		splitHeader(region, block, header, size);
 		block->sizeFree -= header->size;
 		return (u8*)header + sizeof(RegionAllocHeader);
 	}
 
+	// Find a free header of at least 'size' bytes in constant time.
+	// (fl, sl) is the list 'size' was rounded up to, (exactFl, exactSl) the list that contains 'size'.
+	AllocHeaderFree* findFreeHeader(MemoryBlock* block, u32 size, s32 fl, s32 sl, s32 exactFl, s32 exactSl)
+	{
+		// First look in the same first level list, for second level lists at least as large.
+		u32 slMap = block->slBitmap[fl] & (~0u << sl);
+		if (!slMap)
+		{
+			// Then in the next larger first level list.
+			const u32 flMap = (fl + 1 < FL_COUNT) ? block->flBitmap & (~0u << (fl + 1)) : 0u;
+			if (!flMap)
+			{
+				// Finally search the list containing 'size', in case it holds the only large enough header.
+				AllocHeaderFree* header = block->freeLists[exactFl][exactSl];
+				while (header && header->size < size)
+				{
+					header = header->binNext;
+				}
+				return header;
+			}
+
+			fl = TFE_Math::findLowestBit(flMap);
+			slMap = block->slBitmap[fl];
+		}
+		sl = TFE_Math::findLowestBit(slMap);
+		return block->freeLists[fl][sl];
+	}
+
 	void* region_alloc(MemoryRegion* region, size_t size)
 	{
 		assert(region);
 		if (size == 0) { return nullptr; }
 
-		size = alloc_align(size + sizeof(RegionAllocHeader));
-		assert(size >= 24);	// at least 24 bytes is required to hold the free header.
+		size = std::max(alloc_align(size + sizeof(RegionAllocHeader)), size_t(MIN_ALLOC_SIZE));
 		if (size > region->blockSize) { return nullptr; }
-		
+
+		// Round up to the next list, so that any header in the list found is large enough.
+		u32 searchSize = u32(size);
+		if (searchSize >= SMALL_BLOCK_SIZE)
+		{
+			searchSize += (1u << (TFE_Math::findHighestBit(searchSize) - SL_INDEX_LOG2)) - 1;
+		}
+		s32 fl, sl, exactFl, exactSl;
+		getListFromSize(searchSize, &fl, &sl);
+		getListFromSize(u32(size), &exactFl, &exactSl);
+		if (fl >= FL_COUNT) { fl = FL_COUNT - 1; sl = SL_COUNT - 1; }
+		const u32 flMask = ~0u << exactFl;
+
 		for (s32 i = 0; i < region->blockCount; i++)
 		{
-			MemoryBlock* block = region->memBlocks[i];
-			if (block->sizeFree < size)
+			if (!(region->blockFreeMask[i] & flMask))
 			{
 				continue;
 			}
-
-			// Try to allocate from the closest matching bin.
-			s32 bin = getBinFromSize((u32)size);
-			for (s32 b = bin; b < ALLOC_BIN_COUNT; b++)
+			MemoryBlock* block = region->memBlocks[i];
+			AllocHeaderFree* header = findFreeHeader(block, u32(size), fl, sl, exactFl, exactSl);
+			if (header)
 			{
-				AllocHeaderFree* header = block->freeListBins[b];
-				while (header)
-				{
-					if (header->size >= size)
-					{
-						VERIFY_MEMORY();
-						void* mem = allocFromHeader(block, (RegionAllocHeader*)header, (u32)size);
-						VERIFY_MEMORY();
-						return mem;
-					}
-					header = header->binNext;
-				}
+				assert(header->size >= size);
+				VERIFY_MEMORY();
+				void* mem = allocFromHeader(region, block, (RegionAllocHeader*)header, (u32)size);
+				VERIFY_MEMORY();
+				region->allocCount++;
+				return mem;
 			}
 		}
 
@@ -272,7 +358,7 @@ namespace TFE_Memory
 			if (allocateNewBlock(region))
 			{
 				VERIFY_MEMORY();
-				void* mem = region_alloc(region, size);
+				void* mem = region_alloc(region, size - sizeof(RegionAllocHeader));
 				VERIFY_MEMORY();
 				return mem;
 			}
@@ -289,87 +375,45 @@ namespace TFE_Memory
 		if (!ptr) { return region_alloc(region, size); }
 		if (size == 0) { return nullptr; }
 
-		size = alloc_align(size + sizeof(RegionAllocHeader));
+		const size_t userSize = size;
+		size = std::max(alloc_align(size + sizeof(RegionAllocHeader)), size_t(MIN_ALLOC_SIZE));
 		if (size > region->blockSize) { return nullptr; }
 
 		// If the current block is already large enough, skip looping over the memory blocks.
 		RegionAllocHeader* header = (RegionAllocHeader*)((u8*)ptr - sizeof(RegionAllocHeader));
+		assert(header->free == 0);
 		if (header->size >= size)
 		{
 			return ptr;
 		}
 
-		// First try to reallocate in the same region.
-		u32 prevSize = 0;
-		for (s32 i = (s32)region->blockCount - 1; i >= 0; i--)
+		// If the next block is free, merge the two blocks and then allocate from that.
+		MemoryBlock* block = findBlock(region, ptr);
+		RegionAllocHeader* nextHeader = block ? getNextHeader(region, block, header) : nullptr;
+		if (nextHeader && nextHeader->free && header->size + nextHeader->size >= size)
 		{
-			MemoryBlock* block = region->memBlocks[i];
-			if (ptr >= block)
-			{
-				RegionAllocHeader* header = (RegionAllocHeader*)((u8*)ptr - sizeof(RegionAllocHeader));
-				RegionAllocHeader* nextHeader = (RegionAllocHeader*)((u8*)header + header->size);
-				assert(header->free == 0);
+			VERIFY_MEMORY();
+			removeHeaderFromFreelist(region, block, nextHeader);
 
-				if ((u8*)nextHeader >= (u8*)block + region->blockSize)
-				{
-					nextHeader = nullptr;
-				}
-				// If it is big enough, just stick to the same memory.
-				if (header->size >= size)
-				{
-					return ptr;
-				}
-				// If the next block is free, merge the two blocks and then allocate from that.
-				if (nextHeader && nextHeader->free && header->size + nextHeader->size >= size)
-				{
-					VERIFY_MEMORY();
-					// Remove the nextHeader from the freelist.
-					assert(nextHeader->free == 1);
-					removeHeaderFromFreelist(block, nextHeader);
-
-					// Merge blocks.
-					block->sizeFree += header->size;
-					header->size += nextHeader->size;
-					block->count--;
-									
-					// Allocate from the new header.
-					if (header->size - size >= MIN_SPLIT_SIZE)
-					{
-						// Split.
-						size_t split0 = size;
-						size_t split1 = header->size - split0;
-						RegionAllocHeader* next = (RegionAllocHeader*)((u8*)header + split0);
-
-						// Reset the header.
-						header->free = 0;
-						header->size = u32(split0);
-
-						// Create a new free block.
-						next->size = u32(split1);
-						next->free = 0;
-						block->count++;
-
-						// Add the new block to the free list.
-						insertBlockIntoFreelist(block, next);
-					}
-					block->sizeFree -= header->size;
-					VERIFY_MEMORY();
-					return (u8*)header + sizeof(RegionAllocHeader);
-				}
-				// Otherwise break, we have to free and reallocate.
-				prevSize = header->size;
-				break;
-			}
+			// Merge blocks.
+			block->sizeFree += header->size;
+			header->size += nextHeader->size;
+			updateNextPrevSize(region, block, header);
+			block->count--;
+
+			// Allocate from the new header.
+			splitHeader(region, block, header, u32(size));
+			block->sizeFree -= header->size;
+			VERIFY_MEMORY();
+			return ptr;
 		}
 
-		// Allocate a new block of memory.
-		void* newMem = region_alloc(region, size);
+		// Otherwise allocate a new block of memory.
+		const u32 prevSize = header->size;
+		void* newMem = region_alloc(region, userSize);
 		if (!newMem) { return nullptr; }
 		// Copy over the contents from the previous block.
-		if (prevSize > sizeof(RegionAllocHeader))
-		{
-			memcpy(newMem, ptr, std::min((u32)size, prevSize) - sizeof(RegionAllocHeader));
-		}
+		memcpy(newMem, ptr, std::min((u32)size, prevSize) - sizeof(RegionAllocHeader));
 		// Free the previous block
 		region_free(region, ptr);
 		// Then return the new block.
@@ -381,31 +425,25 @@ namespace TFE_Memory
 	{
 		if (!ptr || !region) { return; }
 
-		for (s32 i = (s32)region->blockCount - 1; i >= 0; i--)
+		MemoryBlock* block = findBlock(region, ptr);
+		if (!block)
 		{
-			MemoryBlock* block = region->memBlocks[i];
-			if (ptr >= block)
-			{
-				RegionAllocHeader* header = (RegionAllocHeader*)((u8*)ptr - sizeof(RegionAllocHeader));
-				RegionAllocHeader* nextHeader = (RegionAllocHeader*)((u8*)header + header->size);
-				if ((u8*)nextHeader >= (u8*)block + region->blockSize)
-				{
-					nextHeader = nullptr;
-				}
-
-				assert(!header->free);
-				if (header->free)
-				{
-					TFE_System::logWrite(LOG_ERROR, "MemoryRegion", "Attempted to double free pointer %x in region '%s'.", ptr, region->name);
-					return;
-				}
+			TFE_System::logWrite(LOG_ERROR, "MemoryRegion", "Attempted to free pointer %x that is not in region '%s'.", ptr, region->name);
+			return;
+		}
 
-				VERIFY_MEMORY();
-				freeSlot(header, nextHeader, block);
-				VERIFY_MEMORY();
-				return;
-			}
+		RegionAllocHeader* header = (RegionAllocHeader*)((u8*)ptr - sizeof(RegionAllocHeader));
+		assert(!header->free);
+		if (header->free)
+		{
+			TFE_System::logWrite(LOG_ERROR, "MemoryRegion", "Attempted to double free pointer %x in region '%s'.", ptr, region->name);
+			return;
 		}
+
+		VERIFY_MEMORY();
+		freeSlot(region, header, block);
+		VERIFY_MEMORY();
+		region->freeCount++;
 	}
 		
 	size_t region_getMemoryUsed(MemoryRegion* region)
@@ -428,6 +466,51 @@ namespace TFE_Memory
 	{
 		return region->blockCount * region->blockSize;
 	}
+
+	void region_getStats(MemoryRegion* region, MemoryRegionStats* stats)
+	{
+		memset(stats, 0, sizeof(MemoryRegionStats));
+		stats->blockCount = u32(region->blockCount);
+		stats->capacity = region->blockCount * region->blockSize;
+		for (size_t i = 0; i < region->blockCount; i++)
+		{
+			MemoryBlock* block = region->memBlocks[i];
+			stats->freeSize += block->sizeFree;
+			if (!block->flBitmap) { continue; }
+
+			for (s32 fl = 0; fl < FL_COUNT; fl++)
+			{
+				for (s32 sl = 0; sl < SL_COUNT; sl++)
+				{
+					AllocHeaderFree* header = block->freeLists[fl][sl];
+					while (header)
+					{
+						stats->largestFree = std::max(stats->largestFree, size_t(header->size));
+						stats->freeSpanCount++;
+						header = header->binNext;
+					}
+				}
+			}
+		}
+		stats->used = stats->capacity - stats->freeSize;
+		stats->fragmentation = stats->freeSize ? 1.0f - f32(stats->largestFree) / f32(stats->freeSize) : 0.0f;
+
+		stats->frameAllocCount = region->frameAllocCount;
+		stats->frameFreeCount = region->frameFreeCount;
+		stats->totalAllocCount = region->totalAllocCount + region->allocCount;
+		stats->totalFreeCount = region->totalFreeCount + region->freeCount;
+	}
+
+	void region_endFrame(MemoryRegion* region)
+	{
+		if (!region) { return; }
+		region->frameAllocCount = region->allocCount;
+		region->frameFreeCount = region->freeCount;
+		region->totalAllocCount += region->allocCount;
+		region->totalFreeCount += region->freeCount;
+		region->allocCount = 0;
+		region->freeCount = 0;
+	}
 		
 	RelativePointer region_getRelativePointer(MemoryRegion* region, void* ptr)
 	{
@@ -437,7 +520,7 @@ namespace TFE_Memory
 		for (s32 i = (s32)region->blockCount - 1; i >= 0; i--)
 		{
 			MemoryBlock* block = region->memBlocks[i];
-			if (ptr >= block)
+			if (ptr >= block && (u8*)ptr < (u8*)block + sizeof(MemoryBlock) + region->blockSize)
 			{
 				rp = RelativePointer((u8*)ptr - (u8*)block - sizeof(MemoryBlock));
 				rp |= (i << c_relativeBlockShift);
@@ -485,36 +568,18 @@ namespace TFE_Memory
 		file->write(&region->blockSize);
 		file->write(&region->maxBlocks);
 
+		// Only the headers and allocated memory are written, the free lists are rebuilt on restore.
 		for (s32 b = 0; b < region->blockCount; b++)
 		{
 			MemoryBlock* block = region->memBlocks[b];
 			file->write(&block->count);
 			file->write(&block->sizeFree);
-			for (s32 bin = 0; bin < ALLOC_BIN_COUNT; bin++)
-			{
-				RelativePointer ptr = region_getRelativePointer(region, block->freeListBins[bin]);
-				file->write(&ptr);
-			}
 
 			u8* memPtr = (u8*)block + sizeof(MemoryBlock);
 			for (u32 al = 0; al < block->count; al++)
 			{
 				RegionAllocHeader* header = (RegionAllocHeader*)memPtr;
-				if (header->free)
-				{
-					AllocHeaderFree* freeHeader = (AllocHeaderFree*)memPtr;
-					file->writeBuffer(freeHeader, SHARED_HEADER_SIZE);
-
-					RelativePointer binNext = region_getRelativePointer(region, freeHeader->binNext);
-					RelativePointer binPrev = region_getRelativePointer(region, freeHeader->binPrev);
-					file->write(&binNext);
-					file->write(&binPrev);
-				}
-				else
-				{
-					file->writeBuffer(header, header->size);
-				}
-
+				file->writeBuffer(header, header->free ? u32(SHARED_HEADER_SIZE) : header->size);
 				memPtr += header->size;
 			}
 		}
@@ -531,7 +596,10 @@ namespace TFE_Memory
 		if (!region)
 		{
 			region = (MemoryRegion*)malloc(sizeof(MemoryRegion));
-			region->blockArrCapacity = 0;
+			if (region)
+			{
+				memset(region, 0, sizeof(MemoryRegion));
+			}
 		}
 		if (!region)
 		{
@@ -548,6 +616,7 @@ namespace TFE_Memory
 			file->read(&region->blockSize);
 			file->read(&region->maxBlocks);
 			region->memBlocks = (MemoryBlock**)malloc(sizeof(MemoryBlock*)*region->blockArrCapacity);
+			region->blockFreeMask = (u32*)malloc(sizeof(u32)*region->blockArrCapacity);
 		}
 		else
 		{
@@ -561,11 +630,12 @@ namespace TFE_Memory
 			if (blockSize != region->blockSize)
 			{
 				// Free memory since we have to reallocate from scratch.
-				for (s32 i = 0; i < region->blockCount; i++)
+				for (size_t i = 0; i < region->blockCount; i++)
 				{
 					free(region->memBlocks[i]);
 				}
 				free(region->memBlocks);
+				free(region->blockFreeMask);
 
 				// Recreate.
 				region->blockArrCapacity = blockArrCapacity;
@@ -573,6 +643,7 @@ namespace TFE_Memory
 				region->blockSize = blockSize;
 				region->maxBlocks = maxBlocks;
 				region->memBlocks = (MemoryBlock**)malloc(sizeof(MemoryBlock*)*region->blockArrCapacity);
+				region->blockFreeMask = (u32*)malloc(sizeof(u32)*region->blockArrCapacity);
 			}
 			else  // We don't need to allocate from scratch.
 			{
@@ -583,6 +654,7 @@ namespace TFE_Memory
 				{
 					region->blockArrCapacity = blockArrCapacity;
 					region->memBlocks = (MemoryBlock**)realloc(region->memBlocks, sizeof(MemoryBlock*)*region->blockArrCapacity);
+					region->blockFreeMask = (u32*)realloc(region->blockFreeMask, sizeof(u32)*region->blockArrCapacity);
 				}
 				region->blockCount = blockCount;
 				region->blockSize  = blockSize;
@@ -590,7 +662,7 @@ namespace TFE_Memory
 			}
 		}
 
-		if (!region->memBlocks)
+		if (!region->memBlocks || !region->blockFreeMask)
 		{
 			free(region);
 			TFE_System::logWrite(LOG_ERROR, "MemoryRegion", "Failed to allocate region.");
@@ -615,12 +687,11 @@ namespace TFE_Memory
 
 			file->read(&block->count);
 			file->read(&block->sizeFree);
-			for (s32 bin = 0; bin < ALLOC_BIN_COUNT; bin++)
-			{
-				RelativePointer ptr;
-				file->read(&ptr);
-				block->freeListBins[bin] = (AllocHeaderFree*)region_getRealPointer(region, ptr);
-			}
+			block->index = b;
+			block->flBitmap = 0;
+			memset(block->slBitmap, 0, sizeof(block->slBitmap));
+			memset(block->freeLists, 0, sizeof(block->freeLists));
+			region->blockFreeMask[b] = 0;
 
 			u8* memPtr = (u8*)block + sizeof(MemoryBlock);
 			for (u32 al = 0; al < block->count; al++)
@@ -630,13 +701,8 @@ namespace TFE_Memory
 
 				if (header->free)
 				{
-					AllocHeaderFree* freeHeader = (AllocHeaderFree*)memPtr;
-					RelativePointer binNext, binPrev;
-					file->read(&binNext);
-					file->read(&binPrev);
-
-					freeHeader->binNext = (AllocHeaderFree*)region_getRealPointer(region, binNext);
-					freeHeader->binPrev = (AllocHeaderFree*)region_getRealPointer(region, binPrev);
+					header->free = 0;
+					insertBlockIntoFreelist(region, block, header);
 				}
 				else
 				{
@@ -650,23 +716,35 @@ namespace TFE_Memory
 		return region;
 	}
 
-	void freeSlot(RegionAllocHeader* alloc, RegionAllocHeader* next, MemoryBlock* block)
+	void freeSlot(MemoryRegion* region, RegionAllocHeader* alloc, MemoryBlock* block)
 	{
 		block->sizeFree += alloc->size;
 
 		assert(alloc->free == 0);
+		RegionAllocHeader* next = getNextHeader(region, block, alloc);
 		if (next && next->free)  // Then try merging the current and next.
 		{
 			assert(next->free == 1);
 			// Remove the next block from the freelist.
-			removeHeaderFromFreelist(block, next);
+			removeHeaderFromFreelist(region, block, next);
 
 			// Merge
 			alloc->size += next->size;
 			block->count--;
 		}
+		RegionAllocHeader* prev = getPrevHeader(alloc);
+		if (prev && prev->free)  // Then try merging the previous and current.
+		{
+			removeHeaderFromFreelist(region, block, prev);
+
+			// Merge
+			prev->size += alloc->size;
+			block->count--;
+			alloc = prev;
+		}
+		updateNextPrevSize(region, block, alloc);
 		// Then add the new item to the free list.
-		insertBlockIntoFreelist(block, alloc);
+		insertBlockIntoFreelist(region, block, alloc);
 	}
 
 	size_t alloc_align(size_t baseSize)
@@ -674,77 +752,96 @@ namespace TFE_Memory
 		return (baseSize + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
 	}
 		
-	s32 getBinFromSize(u32 size)
+	void getListFromSize(u32 size, s32* fl, s32* sl)
 	{
-		if (size < 32) { return 0; }
-		else if (size <= 64) { return 1; }
-		else if (size <= 128) { return 2; }
-		else if (size <= 256) { return 3; }
-		else if (size <= 512) { return 4; }
-		return 5;
+		if (size < SMALL_BLOCK_SIZE)
+		{
+			*fl = 0;
+			*sl = s32(size) / (SMALL_BLOCK_SIZE / SL_COUNT);
+		}
+		else
+		{
+			const u32 highBit = TFE_Math::findHighestBit(size);
+			*sl = s32(size >> (highBit - SL_INDEX_LOG2)) ^ SL_COUNT;
+			*fl = s32(highBit) - (FL_INDEX_SHIFT - 1);
+		}
 	}
 
-	void removeHeaderFromFreelist(MemoryBlock* block, RegionAllocHeader* header)
+	void removeHeaderFromFreelist(MemoryRegion* region, MemoryBlock* block, RegionAllocHeader* header)
 	{
 		AllocHeaderFree* freeHeader = (AllocHeaderFree*)header;
 		assert(freeHeader->free == 1);
-		assert(freeHeader->bin < ALLOC_BIN_COUNT);
+		assert(freeHeader->fl < FL_COUNT && freeHeader->sl < SL_COUNT);
 
-		u8 bin = freeHeader->bin;
+		const s32 fl = freeHeader->fl;
+		const s32 sl = freeHeader->sl;
 		freeHeader->free = 0;
-		freeHeader->bin = 0;
-		if (freeHeader->binPrev)
+		freeHeader->fl = 0;
+		freeHeader->sl = 0;
+		if (freeHeader->binNext)
 		{
-			AllocHeaderFree* nextFree = freeHeader->binNext;
-			AllocHeaderFree* prevFree = freeHeader->binPrev;
-			prevFree->binNext = nextFree;
-			if (nextFree)
-			{
-				nextFree->binPrev = prevFree;
-			}
+			freeHeader->binNext->binPrev = freeHeader->binPrev;
 		}
-		else if (freeHeader->binNext)
+		if (freeHeader->binPrev)
 		{
-			assert(freeHeader == block->freeListBins[bin]);
-			if (freeHeader == block->freeListBins[bin])
-			{
-				block->freeListBins[bin] = freeHeader->binNext;
-				block->freeListBins[bin]->binPrev = nullptr;
-			}
+			freeHeader->binPrev->binNext = freeHeader->binNext;
 		}
 		else
 		{
-			assert(freeHeader->binPrev || freeHeader == block->freeListBins[bin]);
-			if (freeHeader == block->freeListBins[bin])
+			assert(freeHeader == block->freeLists[fl][sl]);
+			block->freeLists[fl][sl] = freeHeader->binNext;
+			if (!block->freeLists[fl][sl])
 			{
-				block->freeListBins[bin] = nullptr;
+				block->slBitmap[fl] &= ~(1u << sl);
+				if (!block->slBitmap[fl])
+				{
+					block->flBitmap &= ~(1u << fl);
+					region->blockFreeMask[block->index] = block->flBitmap;
+				}
 			}
 		}
 	}
 
-	void insertBlockIntoFreelist(MemoryBlock* block, RegionAllocHeader* header)
+	void insertBlockIntoFreelist(MemoryRegion* region, MemoryBlock* block, RegionAllocHeader* header)
 	{
 		AllocHeaderFree* freeNext = (AllocHeaderFree*)header;
 		assert(freeNext->free == 0);
-		s32 bin = getBinFromSize(header->size);
+		s32 fl, sl;
+		getListFromSize(header->size, &fl, &sl);
+		assert(fl < FL_COUNT);
+
 		freeNext->free = 1;
-		freeNext->bin = bin;
-		freeNext->pad8[0] = 0;
-		freeNext->pad8[1] = 0;
-		if (!block->freeListBins[bin])
+		freeNext->fl = u8(fl);
+		freeNext->sl = u8(sl);
+		freeNext->pad8 = 0;
+		freeNext->binPrev = nullptr;
+		freeNext->binNext = block->freeLists[fl][sl];
+		if (freeNext->binNext)
 		{
-			block->freeListBins[bin] = freeNext;
-			freeNext->binPrev = nullptr;
-			freeNext->binNext = nullptr;
+			freeNext->binNext->binPrev = freeNext;
 		}
-		else
-		{
-			block->freeListBins[bin]->binPrev = freeNext;
-			freeNext->binNext = block->freeListBins[bin];
-			freeNext->binPrev = nullptr;
+		block->freeLists[fl][sl] = freeNext;
 
-			block->freeListBins[bin] = freeNext;
-		}
+		block->slBitmap[fl] |= (1u << sl);
+		block->flBitmap |= (1u << fl);
+		region->blockFreeMask[block->index] = block->flBitmap;
+	}
+
+	// Reset a block to a single free header.
+	void resetBlock(MemoryRegion* region, MemoryBlock* block)
+	{
+		block->sizeFree = u32(region->blockSize);
+		block->count = 1;
+		block->flBitmap = 0;
+		memset(block->slBitmap, 0, sizeof(block->slBitmap));
+		memset(block->freeLists, 0, sizeof(block->freeLists));
+		region->blockFreeMask[block->index] = 0;
+
+		RegionAllocHeader* header = (RegionAllocHeader*)((u8*)block + sizeof(MemoryBlock));
+		header->size = block->sizeFree;
+		header->free = 0;
+		header->prevSize = 0;
+		insertBlockIntoFreelist(region, block, header);
 	}
 
 	bool allocateNewBlock(MemoryRegion* region)
@@ -759,13 +856,15 @@ namespace TFE_Memory
 		{
 			region->blockArrCapacity = BLOCK_ARR_STEP;
 			region->memBlocks = (MemoryBlock**)malloc(sizeof(MemoryBlock*)*region->blockArrCapacity);
+			region->blockFreeMask = (u32*)malloc(sizeof(u32)*region->blockArrCapacity);
 		}
 		else if (region->blockCount + 1 > region->blockArrCapacity)
 		{
 			region->blockArrCapacity += BLOCK_ARR_STEP;
 			region->memBlocks = (MemoryBlock**)realloc(region->memBlocks, sizeof(MemoryBlock*)*region->blockArrCapacity);
+			region->blockFreeMask = (u32*)realloc(region->blockFreeMask, sizeof(u32)*region->blockArrCapacity);
 		}
-		if (!region->memBlocks)
+		if (!region->memBlocks || !region->blockFreeMask)
 		{
 			TFE_System::logWrite(LOG_ERROR, "MemoryRegion", "Failed to resize memory block of array to %u in region '%s'.", region->blockArrCapacity, region->name);
 			return false;
@@ -783,14 +882,8 @@ namespace TFE_Memory
 		TFE_System::logWrite(LOG_MSG, "MemoryRegion", "Allocated new memory block in region '%s' - new size is %u blocks, total size is '%u'", region->name, region->blockCount, region->blockSize * region->blockCount);
 
 		MemoryBlock* block = region->memBlocks[blockIndex];
-		block->sizeFree = u32(region->blockSize);
-		block->count = 1;
-
-		RegionAllocHeader* header = (RegionAllocHeader*)((u8*)block + sizeof(MemoryBlock));
-		header->size = block->sizeFree;
-		header->free = 0;
-		memset(block->freeListBins, 0, sizeof(AllocHeaderFree*)*ALLOC_BIN_COUNT);
-		insertBlockIntoFreelist(block, header);
+		block->index = u32(blockIndex);
+		resetBlock(region, block);
 
 		return true;
 	}
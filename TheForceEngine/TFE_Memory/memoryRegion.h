@@ -13,6 +13,23 @@ typedef u32 RelativePointer;
 
 #define NULL_RELATIVE_POINTER 0
 
+struct MemoryRegionStats
+{
+	size_t capacity;
+	size_t used;
+	size_t freeSize;
+	size_t largestFree;		// Largest contiguous free span.
+	u32 blockCount;
+	u32 freeSpanCount;
+	f32 fragmentation;		// 1 - largestFree / freeSize, 0 if all free memory is contiguous.
+
+	// Allocations and frees during the last frame, see region_endFrame().
+	u32 frameAllocCount;
+	u32 frameFreeCount;
+	u64 totalAllocCount;
+	u64 totalFreeCount;
+};
+
 namespace TFE_Memory
 {
 	MemoryRegion* region_create(const char* name, size_t blockSize, size_t maxSize = 0u);
@@ -26,6 +43,10 @@ namespace TFE_Memory
 	size_t region_getMemoryUsed(MemoryRegion* region);
 	size_t region_getMemoryCapacity(MemoryRegion* region);
 	void region_getBlockInfo(MemoryRegion* region, size_t* blockCount, size_t* blockSize);
+	// Walks the free lists, this is meant for debug views and not for every allocation.
+	void region_getStats(MemoryRegion* region, MemoryRegionStats* stats);
+	// Called once per frame to latch the per-frame allocation and free counts.
+	void region_endFrame(MemoryRegion* region);
 
 	RelativePointer region_getRelativePointer(MemoryRegion* region, void* ptr);
 	void* region_getRealPointer(MemoryRegion* region, RelativePointer ptr);
@@ -58,6 +58,8 @@ namespace TFE_RenderBackend
 
 	static Blit* s_postEffectBlit;
 	static std::vector<SDL_Rect> s_displayBounds;
+	// No window or GPU context, the virtual display only exists on the CPU.
+	static bool s_headless = false;
 
 	void drawVirtualDisplay();
 	void setupPostEffectChain(bool useDynamicTexture);
@@ -157,8 +159,27 @@ namespace TFE_RenderBackend
 		return m_window != nullptr;
 	}
 
+	bool initHeadless(const WindowState& state)
+	{
+		m_window = nullptr;
+		m_windowState = state;
+		s_headless = true;
+		TFE_System::logWrite(LOG_MSG, "RenderBackend", "Running headless, no window or GPU device will be created.");
+		return true;
+	}
+
+	bool isHeadless()
+	{
+		return s_headless;
+	}
+
 	void destroy()
 	{
+		if (s_headless)
+		{
+			s_headless = false;
+			return;
+		}
 		delete s_screenCapture;
 
 		// TODO: Move effect destruction into post effect system.
@@ -179,24 +200,27 @@ namespace TFE_RenderBackend
 
 	bool getVsyncEnabled()
 	{
+		if (s_headless) { return false; }
 		return SDL_GL_GetSwapInterval() > 0;
 	}
 
 	void enableVsync(bool enable)
 	{
+		if (s_headless) { return; }
 		SDL_GL_SetSwapInterval(enable ? 1 : 0);
 	}
 
 	void setClearColor(const f32* color)
 	{
+		memcpy(s_clearColor, color, sizeof(f32) * 4);
+		if (s_headless) { return; }
 		glClearColor(color[0], color[1], color[2], color[3]);
 		glClearDepth(0.0f);
-
-		memcpy(s_clearColor, color, sizeof(f32) * 4);
 	}
 		
 	void swap(bool blitVirtualDisplay)
 	{
+		if (s_headless) { return; }
 		// Blit the texture or render target to the screen.
 		if (blitVirtualDisplay) { drawVirtualDisplay(); }
 		else { glClear(GL_COLOR_BUFFER_BIT); }
@@ -223,27 +247,32 @@ namespace TFE_RenderBackend
 
 	void captureScreenToMemory(u32* mem)
 	{
+		if (s_headless) { return; }
 		s_screenCapture->captureFrontBufferToMemory(mem);
 	}
 
 	void queueScreenshot(const char* screenshotPath)
 	{
+		if (s_headless) { return; }
 		strcpy(s_screenshotPath, screenshotPath);
 		s_screenshotQueued = true;
 	}
 		
 	void startGifRecording(const char* path)
 	{
+		if (s_headless) { return; }
 		s_screenCapture->beginRecording(path);
 	}
 
 	void stopGifRecording()
 	{
+		if (s_headless) { return; }
 		s_screenCapture->endRecording();
 	}
 
 	void updateSettings()
 	{
+		if (s_headless) { return; }
 		TFE_Settings_Window* windowSettings = TFE_Settings::getWindowSettings();
 		if (!(m_windowState.flags & WINFLAG_FULLSCREEN))
 		{
@@ -253,6 +282,7 @@ namespace TFE_RenderBackend
 
 	void resize(s32 width, s32 height)
 	{
+		if (s_headless) { return; }
 		TFE_Settings_Window* windowSettings = TFE_Settings::getWindowSettings();
 
 		m_windowState.width = width;
@@ -327,6 +357,7 @@ namespace TFE_RenderBackend
 
 	f32 getDisplayRefreshRate()
 	{
+		if (s_headless) { return 0.0f; }
 		s32 x, y;
 		SDL_GetWindowPosition((SDL_Window*)m_window, &x, &y);
 		s32 displayIndex = getDisplayIndex(x, y);
@@ -352,6 +383,7 @@ namespace TFE_RenderBackend
 
 	void enableFullscreen(bool enable)
 	{
+		if (s_headless) { return; }
 		TFE_Settings_Window* windowSettings = TFE_Settings::getWindowSettings();
 		windowSettings->fullscreen = enable;
 
@@ -410,6 +442,7 @@ namespace TFE_RenderBackend
 
 	void clearWindow()
 	{
+		if (s_headless) { return; }
 		glClear(GL_COLOR_BUFFER_BIT);
 	}
 
@@ -445,6 +478,7 @@ namespace TFE_RenderBackend
 		s_asyncFrameBuffer = (vdispInfo.flags & VDISP_ASYNC_FRAMEBUFFER) != 0;
 		s_gpuColorConvert = (vdispInfo.flags & VDISP_GPU_COLOR_CONVERT) != 0;
 		s_useRenderTarget = (vdispInfo.flags & VDISP_RENDER_TARGET) != 0;
+		if (s_headless) { return true; }
 
 		bool result = false;
 		if (s_useRenderTarget)
@@ -506,6 +540,7 @@ namespace TFE_RenderBackend
 
 	void* getVirtualDisplayGpuPtr()
 	{
+		if (!s_virtualDisplay) { return nullptr; }
 		return (void*)(iptr)s_virtualDisplay->getTexture()->getHandle();
 	}
 
@@ -555,6 +590,7 @@ namespace TFE_RenderBackend
 
 	void copyToVirtualDisplay(RenderTargetHandle src)
 	{
+		if (!s_virtualRenderTarget) { return; }
 		RenderTarget::copy(s_virtualRenderTarget, (RenderTarget*)src);
 	}
 		
@@ -565,7 +601,7 @@ namespace TFE_RenderBackend
 
 	void setPalette(const u32* palette)
 	{
-		if (palette && getGPUColorConvert())
+		if (palette && s_palette && getGPUColorConvert())
 		{
 			TFE_ZONE("Update Palette");
 			s_palette->update(palette, 256 * sizeof(u32));
@@ -574,11 +610,13 @@ namespace TFE_RenderBackend
 
 	const TextureGpu* getPaletteTexture()
 	{
+		if (!s_palette) { return nullptr; }
 		return s_palette->getTexture();
 	}
 
 	void setColorCorrection(bool enabled, const ColorCorrection* color/* = nullptr*/)
 	{
+		if (s_headless) { return; }
 		if (s_postEffectBlit->featureEnabled(BLIT_GPU_COLOR_CORRECTION) != enabled)
 		{
 			if (enabled) { s_postEffectBlit->enableFeatures(BLIT_GPU_COLOR_CORRECTION); }
@@ -611,6 +649,7 @@ namespace TFE_RenderBackend
 	// Render target.
 	RenderTargetHandle createRenderTarget(u32 width, u32 height, bool hasDepthBuffer)
 	{
+		if (s_headless) { return nullptr; }
 		RenderTarget* newTarget = new RenderTarget();
 		TextureGpu* texture = new TextureGpu();
 		texture->create(width, height);
@@ -659,6 +698,7 @@ namespace TFE_RenderBackend
 
 	void unbindRenderTarget()
 	{
+		if (s_headless) { return; }
 		RenderTarget::unbind();
 		glViewport(0, 0, m_windowState.width, m_windowState.height);
 
@@ -685,6 +725,7 @@ namespace TFE_RenderBackend
 
 	TextureGpu* createTexture(u32 width, u32 height, u32 channels)
 	{
+		if (s_headless) { return nullptr; }
 		TextureGpu* texture = new TextureGpu();
 		texture->create(width, height, channels);
 		return texture;
@@ -692,6 +733,7 @@ namespace TFE_RenderBackend
 
 	TextureGpu* createTextureArray(u32 width, u32 height, u32 layers, u32 channels)
 	{
+		if (s_headless) { return nullptr; }
 		TextureGpu* texture = new TextureGpu();
 		texture->createArray(width, height, layers, channels);
 		return texture;
@@ -700,6 +742,7 @@ namespace TFE_RenderBackend
 	// Create a GPU version of a texture, assumes RGBA8 and returns a GPU handle.
 	TextureGpu* createTexture(u32 width, u32 height, const u32* data, MagFilter magFilter)
 	{
+		if (s_headless) { return nullptr; }
 		TextureGpu* texture = new TextureGpu();
 		texture->createWithData(width, height, data, magFilter);
 		return texture;
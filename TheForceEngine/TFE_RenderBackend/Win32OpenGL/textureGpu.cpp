@@ -137,6 +137,36 @@ bool TextureGpu::update(const void* buffer, size_t size, s32 layer)
 	return true;
 }
 
+bool TextureGpu::updateRegion(const void* buffer, u32 stride, u32 x, u32 y, u32 width, u32 height, s32 layer)
+{
+	if (x + width > m_width || y + height > m_height || layer >= (s32)m_layers) { return false; }
+	const GLenum format = m_channels == 4 ? GL_RGBA : GL_RED;
+
+	// 'buffer' points to the first texel of the region inside of a larger image, 'stride' texels wide.
+	GLint prevAlignment;
+	glGetIntegerv(GL_UNPACK_ALIGNMENT, &prevAlignment);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, stride);
+
+	if (m_layers == 1)
+	{
+		glBindTexture(GL_TEXTURE_2D, m_gpuHandle);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, GL_UNSIGNED_BYTE, buffer);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+	else
+	{
+		glBindTexture(GL_TEXTURE_2D_ARRAY, m_gpuHandle);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0/*level*/, x, y, layer < 0 ? 0 : layer, width, height, 1, format, GL_UNSIGNED_BYTE, buffer);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, prevAlignment);
+	assert(glGetError() == GL_NO_ERROR);
+	return true;
+}
+
 void TextureGpu::bind(u32 slot/* = 0*/) const
 {
 	glActiveTexture(GL_TEXTURE0 + slot);
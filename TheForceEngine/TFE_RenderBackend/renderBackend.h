@@ -91,6 +91,10 @@ class TextureGpu;
 namespace TFE_RenderBackend
 {
 	bool init(const WindowState& state);
+	// Used instead of init() to run without a window or GPU device, the virtual display is only kept on the CPU.
+	// Functions that require a GPU become no-ops and resources, such as textures, are not created.
+	bool initHeadless(const WindowState& state);
+	bool isHeadless();
 	void destroy();
 	bool getVsyncEnabled();
 	void enableVsync(bool enable);
@@ -20,9 +20,11 @@
 #include <TFE_RenderShared/texturePacker.h>
 
 #include <TFE_Asset/imageAsset.h>
-#include <TFE_Memory/chunkedArray.h>
 
+#include <algorithm>
+#include <climits>
 #include <map>
+#include <unordered_map>
 
 #define DEBUG_TEXTURE_ATLAS 0
 
@@ -35,36 +37,58 @@ namespace TFE_DarkForces
 
 namespace TFE_Jedi
 {
-	struct TextureNode
-	{
-		TextureNode* child[2] = { 0 };	// Binary tree.
-		Vec4ui rect = { 0 };
-		void* tex = nullptr;
-		s32 pageId = 0;
-	};
-
 	enum
 	{
-		TIGHT_FIT_PIXELS = 2,
 		MAX_TEXTURE_COUNT = 16384,
 		MAX_TEXTURE_PAGES = 16,
 	};
 
-	static std::vector<TextureNode*> s_nodes;
-	static TextureNode* s_root;
+	// Kept separate so that the limits above stay signed, like the counts they are compared against.
+	enum : u32
+	{
+		PINNED_GENERATION = 0xffffffff,	// Reserved textures are never evicted.
+	};
+
+	// How the source image is stored, this is part of the texture hash.
+	enum ImageLayout
+	{
+		IMAGE_COLUMN_MAJOR = 0,		// BM textures and WAX cells.
+		IMAGE_ROW_MAJOR_FLIPPED,	// DELT textures.
+	};
+
+	struct AtlasEntry
+	{
+		u64 hash;
+		s32 page;		// -1 if the entry is unused.
+		Vec4i rect;		// x, y, width, height.
+		u32 lastUsed;	// Generation the texture was last used in.
+	};
+
+	struct TextureAtlasCache
+	{
+		std::vector<AtlasEntry> entries;
+		std::vector<s32> freeEntries;
+		std::unordered_map<u64, s32> entryMap;		// Content hash -> entry, for every texture in the atlas.
+		std::unordered_map<u64, s32> textureIds;	// Content hash -> texture ID, for textures packed since the last discard.
+		std::unordered_map<u64, s32> reservedIds;	// Texture IDs of the reserved textures.
+
+		// Eviction candidates sorted by age, built when the atlas first fills up in a generation.
+		std::vector<s32> evictList;
+		u32 evictGeneration = 0;
+		size_t evictPos = 0;
+	};
+
 	static TexturePacker* s_texturePacker;
 	static std::map<TextureData*, s32> s_textureDataMap;
 	static std::map<WaxCell*, s32> s_waxDataMap;
 	static std::vector<TextureInfo> s_texInfoPool;
-	static std::vector<TextureInfo*> s_unpackedTextures[2];
-	static ChunkedArray* s_nodePool = nullptr;
-	static MemoryRegion* s_texturePackerRegion = nullptr;
+	static std::vector<Vec4i> s_tempRects;
+	static std::vector<u8> s_cellImage;
 
 	static s32 s_usedTexels = 0;
 	static s32 s_totalTexels = 0;
-	static s32 s_nodePoolIndex = 0;
-	static s32 s_unpackedBuffer = 0;
-	static s32 s_currentPage = 0;
+	static s32 s_reusedCount = 0;
+	static s32 s_copiedCount = 0;
 
 	// Global Packer
 	static const char* c_globalTexturePackerName = "GameTextures";
@@ -72,57 +96,93 @@ namespace TFE_Jedi
 	static const s32   c_globalPageReserveCount = 1;
 	static TexturePacker* s_globalTexturePacker = nullptr;
 
-	TextureNode* allocateNode();
-
 #if DEBUG_TEXTURE_ATLAS
 	void debug_writeOutAtlas();
 #endif
 
+	void markDirty(TexturePage* page, const Vec4i& rect)
+	{
+		if (page->dirty.z <= page->dirty.x)
+		{
+			page->dirty = { rect.x, rect.y, rect.x + rect.z, rect.y + rect.w };
+			return;
+		}
+		page->dirty.x = min(page->dirty.x, rect.x);
+		page->dirty.y = min(page->dirty.y, rect.y);
+		page->dirty.z = max(page->dirty.z, rect.x + rect.z);
+		page->dirty.w = max(page->dirty.w, rect.y + rect.w);
+	}
+
+	void resetTexturePage(TexturePage* page, s32 width, s32 height)
+	{
+		page->textureCount = 0;
+		page->freeRects.clear();
+		page->freeRects.push_back({ 0, 0, width, height });
+	}
+
 	TexturePage* allocateTexturePage(s32 width, s32 height)
 	{
-		TexturePage* page = (TexturePage*)malloc(sizeof(TexturePage));
-		memset(page, 0, sizeof(TexturePage));
+		TexturePage* page = new TexturePage();
 		page->backingMemory = (u8*)malloc(width * height);
 		memset(page->backingMemory, 0, width * height);
-		page->root = nullptr;
-		page->textureCount = 0;
+		resetTexturePage(page, width, height);
+		// The GPU copy has not been initialized yet.
+		markDirty(page, { 0, 0, width, height });
 		return page;
 	}
-				
-	// Initialize the texture packer once, it is persistent across levels.
-	TexturePacker* texturepacker_init(const char* name, s32 width, s32 height)
+
+	void freeTexturePage(TexturePage* page)
 	{
-		TexturePacker* texturePacker = (TexturePacker*)malloc(sizeof(TexturePacker));
-		if (!texturePacker) { return nullptr; }
+		if (!page) { return; }
+		free(page->backingMemory);
+		delete page;
+	}
 
-		if (!s_nodePool)
-		{
-			s_texturePackerRegion = TFE_Memory::region_create("game", 8 * 1024 * 1024);
-			s_nodePool = TFE_Memory::createChunkedArray(sizeof(TextureNode), 256, 1, s_texturePackerRegion);
-		}
+	// Create the CPU side of the texture packer.
+	TexturePacker* createTexturePacker(const char* name, s32 width, s32 height)
+	{
+		TexturePacker* texturePacker = new TexturePacker();
+		texturePacker->cache = new TextureAtlasCache();
 
 		// Initialize with one page.
 		texturePacker->pageCount = 1;
-		texturePacker->reservedPages = 0;
-		texturePacker->reservedTexturesPacked = 0;
 		texturePacker->pages = (TexturePage**)malloc(sizeof(TexturePage*) * MAX_TEXTURE_PAGES);
-		if (!texturePacker->pages)
-		{
-			texturepacker_destroy(texturePacker);
-			return nullptr;
-		}
-		texturePacker->pages[0] = allocateTexturePage(width, height);
-
 		texturePacker->textureTable = (Vec4i*)malloc(sizeof(Vec4i) * MAX_TEXTURE_COUNT);	// 256Kb (count can be up to 64K).
-		if (!texturePacker->textureTable)
+		if (!texturePacker->pages || !texturePacker->textureTable)
 		{
-			texturepacker_destroy(texturePacker);
+			free(texturePacker->pages);
+			free(texturePacker->textureTable);
+			delete texturePacker->cache;
+			delete texturePacker;
 			return nullptr;
 		}
+		texturePacker->pages[0] = allocateTexturePage(width, height);
 
 		texturePacker->width = width;
 		texturePacker->height = height;
 		texturePacker->texture = nullptr;
+		strncpy(texturePacker->name, name, 64);
+		texturePacker->name[63] = 0;
+		return texturePacker;
+	}
+
+	void freeTexturePacker(TexturePacker* texturePacker)
+	{
+		free(texturePacker->textureTable);
+		for (s32 p = 0; p < texturePacker->pageCount; p++)
+		{
+			freeTexturePage(texturePacker->pages[p]);
+		}
+		free(texturePacker->pages);
+		delete texturePacker->cache;
+		delete texturePacker;
+	}
+				
+	// Initialize the texture packer once, it is persistent across levels.
+	TexturePacker* texturepacker_init(const char* name, s32 width, s32 height)
+	{
+		TexturePacker* texturePacker = createTexturePacker(name, width, height);
+		if (!texturePacker) { return nullptr; }
 
 		ShaderBufferDef textureTableDef =
 		{
@@ -131,8 +191,6 @@ namespace TFE_Jedi
 			BUF_CHANNEL_INT
 		};
 		texturePacker->textureTableGPU.create(MAX_TEXTURE_COUNT, textureTableDef, true, nullptr);
-
-		strncpy(texturePacker->name, name, 64);
 		return texturePacker;
 	}
 
@@ -140,25 +198,32 @@ namespace TFE_Jedi
 	void texturepacker_destroy(TexturePacker* texturePacker)
 	{
 		if (!texturePacker) { return; }
-
-		TFE_RenderBackend::freeTexture(texturePacker->texture);
-		texturePacker->textureTableGPU.destroy();
-		free(texturePacker->textureTable);
-		for (s32 p = 0; p < texturePacker->pageCount; p++)
+		if (s_texturePacker == texturePacker)
 		{
-			free(texturePacker->pages[p]->backingMemory);
+			s_texturePacker = nullptr;
 		}
-		free(texturePacker->pages);
-		free(texturePacker);
 
-		TFE_Memory::region_destroy(s_texturePackerRegion);
-		s_texturePackerRegion = nullptr;
+		TFE_RenderBackend::freeTexture(texturePacker->texture);
+		texturePacker->textureTableGPU.destroy();
+		freeTexturePacker(texturePacker);
 	}
 		
 	void texturepacker_reserveCommitedPages(TexturePacker* texturePacker)
 	{
 		texturePacker->reservedPages = texturePacker->pageCount;
 		texturePacker->reservedTexturesPacked = texturePacker->texturesPacked;
+
+		// Textures packed so far are kept for the rest of the game.
+		TextureAtlasCache* cache = texturePacker->cache;
+		for (size_t i = 0; i < cache->entries.size(); i++)
+		{
+			AtlasEntry* entry = &cache->entries[i];
+			if (entry->page >= 0 && entry->lastUsed == texturePacker->generation)
+			{
+				entry->lastUsed = PINNED_GENERATION;
+			}
+		}
+		cache->reservedIds = cache->textureIds;
 	}
 
 	bool texturepacker_hasReservedPages(TexturePacker* texturePacker)
@@ -166,248 +231,390 @@ namespace TFE_Jedi
 		return texturePacker->reservedPages > 0;
 	}
 
+	// Start packing a new level: texture IDs start over after the reserved textures, but the atlas keeps its contents
+	// so that textures shared with previous levels are not copied again.
 	void texturepacker_discardUnreservedPages(TexturePacker* texturePacker)
 	{
-		if (!texturepacker_hasReservedPages(texturePacker)) { return; }
-		// Clear pages.
-		for (s32 p = 0; p < s_texturePacker->reservedPages; p++)
-		{
-			s_texturePacker->pages[p]->root = nullptr;
-		}
-		for (s32 p = s_texturePacker->reservedPages; p < s_texturePacker->pageCount; p++)
-		{
-			s_texturePacker->pages[p]->root = nullptr;
-			s_texturePacker->pages[p]->textureCount = 0;
-		}
+		s_texturePacker = texturePacker;
+		s_texturePacker->generation++;
+		s_texturePacker->texturesPacked = s_texturePacker->reservedTexturesPacked;
+		s_texturePacker->cache->textureIds = s_texturePacker->cache->reservedIds;
 
-		TFE_Memory::chunkedArrayClear(s_nodePool);
 		s_textureDataMap.clear();
 		s_waxDataMap.clear();
 		s_texInfoPool.clear();
-
-		// Insert the parent that covers all of the available space.
-		s_texturePacker->pageCount = s_texturePacker->reservedPages;
-		s_texturePacker->texturesPacked = s_texturePacker->reservedTexturesPacked;
 	}
-		
-	bool textureFitsInNode(TextureNode* cur, u32 width, u32 height)
+
+	///////////////////////////////////////////////////
+	// MaxRects
+	///////////////////////////////////////////////////
+	bool rectOverlaps(const Vec4i& a, const Vec4i& b)
 	{
-		return width <= cur->rect.z && height <= cur->rect.w;
+		return a.x < b.x + b.z && b.x < a.x + a.z && a.y < b.y + b.w && b.y < a.y + a.w;
 	}
 
-	bool textureTightFit(TextureNode* cur, u32 width, u32 height)
+	bool rectContains(const Vec4i& a, const Vec4i& b)
 	{
-		return (cur->rect.z - width <= TIGHT_FIT_PIXELS) && (cur->rect.w - height <= TIGHT_FIT_PIXELS);
+		return b.x >= a.x && b.y >= a.y && b.x + b.z <= a.x + a.z && b.y + b.w <= a.y + a.w;
 	}
 
-	TextureNode* insertNode(TextureNode* cur, void* tex, u32 width, u32 height)
+	// Remove free rectangles that are contained in other free rectangles.
+	void pruneFreeRects(std::vector<Vec4i>& freeRects)
 	{
-		TextureNode* newNode = nullptr;
-		if (!s_root)
+		for (size_t i = 0; i < freeRects.size(); i++)
 		{
-			newNode = allocateNode();
-			newNode->child[0] = nullptr;
-			newNode->child[1] = nullptr;
-			newNode->rect = {0u, 0u, (u32)s_texturePacker->width, (u32)s_texturePacker->height};
-			newNode->tex  = tex;
-			s_root = newNode;
-
-			s_nodes.push_back(newNode);
-			return newNode;
+			for (size_t j = i + 1; j < freeRects.size(); j++)
+			{
+				if (rectContains(freeRects[j], freeRects[i]))
+				{
+					freeRects.erase(freeRects.begin() + i);
+					i--;
+					break;
+				}
+				if (rectContains(freeRects[i], freeRects[j]))
+				{
+					freeRects.erase(freeRects.begin() + j);
+					j--;
+				}
+			}
 		}
+	}
 
-		// We are not a leaf...
-		if (cur->child[0])
+	// Find the position for a 'width' x 'height' rectangle using the best short side fit, returns false if it does not fit.
+	bool maxRects_find(const TexturePage* page, s32 width, s32 height, Vec4i* rect)
+	{
+		s32 bestShortSide = INT_MAX;
+		s32 bestLongSide = INT_MAX;
+		const size_t count = page->freeRects.size();
+		const Vec4i* freeRect = page->freeRects.data();
+		for (size_t i = 0; i < count; i++, freeRect++)
 		{
-			// Try inserting left.
-			newNode = insertNode(cur->child[0], tex, width, height);
-			if (newNode) { return newNode; }
+			if (width > freeRect->z || height > freeRect->w) { continue; }
 
-			// Then right.
-			return insertNode(cur->child[1], tex, width, height);
+			const s32 dw = freeRect->z - width;
+			const s32 dh = freeRect->w - height;
+			const s32 shortSide = min(dw, dh);
+			const s32 longSide = max(dw, dh);
+			if (shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide))
+			{
+				*rect = { freeRect->x, freeRect->y, width, height };
+				bestShortSide = shortSide;
+				bestLongSide = longSide;
+			}
 		}
-		else // Leaf node.
-		{
-			// If the node is already full...
-			if (cur->tex) { return nullptr; }
-
-			// Check to see if the texture fits.
-			if (!textureFitsInNode(cur, width, height)) { return nullptr; }
+		return bestShortSide != INT_MAX;
+	}
 
-			// Check to see if it is a tight fit.
-			if (textureTightFit(cur, width, height))
+	// Mark 'used' as allocated, splitting every free rectangle that overlaps it.
+	void maxRects_place(TexturePage* page, const Vec4i& used)
+	{
+		s_tempRects.clear();
+		for (size_t i = 0; i < page->freeRects.size(); i++)
+		{
+			const Vec4i& freeRect = page->freeRects[i];
+			if (!rectOverlaps(freeRect, used))
 			{
-				cur->tex = tex;
-				return cur;
+				s_tempRects.push_back(freeRect);
+				continue;
 			}
 
-			// Split the node.
-			cur->child[0] = allocateNode();
-			cur->child[1] = allocateNode();
-
-			// Push nodes so they can be deleted later.
-			s_nodes.push_back(cur->child[0]);
-			s_nodes.push_back(cur->child[1]);
-			
-			// Binary split along the longest axis.
-			const s32 dw = cur->rect.z - width;
-			const s32 dh = cur->rect.w - height;
-			if (dw > dh)
+			if (used.x > freeRect.x)
 			{
-				cur->child[0]->rect = { cur->rect.x, cur->rect.y, width, cur->rect.w };
-				cur->child[1]->rect = { cur->rect.x + width, cur->rect.y, cur->rect.z - width, cur->rect.w };
+				s_tempRects.push_back({ freeRect.x, freeRect.y, used.x - freeRect.x, freeRect.w });
 			}
-			else
+			if (used.x + used.z < freeRect.x + freeRect.z)
 			{
-				cur->child[0]->rect = { cur->rect.x, cur->rect.y, cur->rect.z, height };
-				cur->child[1]->rect = { cur->rect.x, cur->rect.y + height, cur->rect.z, cur->rect.w - height };
+				s_tempRects.push_back({ used.x + used.z, freeRect.y, freeRect.x + freeRect.z - used.x - used.z, freeRect.w });
+			}
+			if (used.y > freeRect.y)
+			{
+				s_tempRects.push_back({ freeRect.x, freeRect.y, freeRect.z, used.y - freeRect.y });
+			}
+			if (used.y + used.w < freeRect.y + freeRect.w)
+			{
+				s_tempRects.push_back({ freeRect.x, used.y + used.w, freeRect.z, freeRect.y + freeRect.w - used.y - used.w });
 			}
-
-			// Then insert into the first child.
-			return insertNode(cur->child[0], tex, width, height);
 		}
+		page->freeRects.swap(s_tempRects);
+		pruneFreeRects(page->freeRects);
+		page->textureCount++;
 	}
-				
-	void packNode(const TextureNode* node, const TextureData* texData, Vec4i* tableEntry)
+
+	// Return 'rect' to the free space of the page.
+	void maxRects_release(TexturePage* page, Vec4i rect)
 	{
-		// Copy the texture into place.
-		const u8* srcImage = texData->image;
-		u8* output = &s_texturePacker->pages[s_currentPage]->backingMemory[node->rect.y * s_texturePacker->width + node->rect.x];
-		for (s32 y = 0; y < texData->height; y++, output += s_texturePacker->width)
+		page->textureCount--;
+		if (page->textureCount <= 0)
 		{
-			for (s32 x = 0; x < texData->width; x++)
+			resetTexturePage(page, s_texturePacker->width, s_texturePacker->height);
+			return;
+		}
+
+		// Grow the rectangle by merging it with free rectangles that share a full edge.
+		std::vector<Vec4i>& freeRects = page->freeRects;
+		for (size_t i = 0; i < freeRects.size(); i++)
+		{
+			const Vec4i& freeRect = freeRects[i];
+			bool merge = false;
+			if (freeRect.y == rect.y && freeRect.w == rect.w && (freeRect.x + freeRect.z == rect.x || rect.x + rect.z == freeRect.x))
+			{
+				rect.z += freeRect.z;
+				rect.x = min(rect.x, freeRect.x);
+				merge = true;
+			}
+			else if (freeRect.x == rect.x && freeRect.z == rect.z && (freeRect.y + freeRect.w == rect.y || rect.y + rect.w == freeRect.y))
 			{
-				output[x] = srcImage[x*texData->height + y];
+				rect.w += freeRect.w;
+				rect.y = min(rect.y, freeRect.y);
+				merge = true;
+			}
+			if (merge)
+			{
+				freeRects.erase(freeRects.begin() + i);
+				i = size_t(-1);	// Start over with the larger rectangle.
 			}
 		}
-		s_usedTexels += texData->width * texData->height;
-
-		// Copy the mapping into the texture table.
-		tableEntry->x = (s32)node->rect.x;
-		tableEntry->y = (s32)node->rect.y;
-		tableEntry->z = (s32)texData->width;
-		tableEntry->w = (s32)texData->height;
+		freeRects.push_back(rect);
+		pruneFreeRects(freeRects);
+	}
 
-		// Page the page index into the x offset.
-		tableEntry->x |= (s_currentPage << 12);
+	///////////////////////////////////////////////////
+	// Atlas
+	///////////////////////////////////////////////////
+	u64 hashImage(const u8* image, s32 width, s32 height, ImageLayout layout)
+	{
+		// FNV-1a over 8 byte words with an extra shift to mix the high bits down, the size and layout are part of the key.
+		u64 hash = 14695981039346656037ull ^ (u64(width) | (u64(height) << 24) | (u64(layout) << 48));
+		const size_t size = size_t(width) * size_t(height);
+		size_t i = 0;
+		for (; i + sizeof(u64) <= size; i += sizeof(u64))
+		{
+			u64 word;
+			memcpy(&word, image + i, sizeof(u64));
+			hash = (hash ^ word) * 1099511628211ull;
+			hash ^= hash >> 29;
+		}
+		for (; i < size; i++)
+		{
+			hash = (hash ^ image[i]) * 1099511628211ull;
+		}
+		return hash;
 	}
 
-	void packNodeDeltaTex(const TextureNode* node, const TextureData* texData, Vec4i* tableEntry)
+	void copyImage(TexturePage* page, const Vec4i& rect, const u8* srcImage, ImageLayout layout)
 	{
-		// Copy the texture into place.
-		const u8* srcImage = texData->image;
-		u8* output = &s_texturePacker->pages[s_currentPage]->backingMemory[node->rect.y * s_texturePacker->width + node->rect.x];
-		for (s32 y = 0; y < texData->height; y++, output += s_texturePacker->width)
+		const s32 width = rect.z;
+		const s32 height = rect.w;
+		u8* output = &page->backingMemory[rect.y * s_texturePacker->width + rect.x];
+		for (s32 y = 0; y < height; y++, output += s_texturePacker->width)
 		{
-			for (s32 x = 0; x < texData->width; x++)
+			if (layout == IMAGE_COLUMN_MAJOR)
 			{
-				output[x] = srcImage[(texData->height - y - 1)*texData->width + x];
+				for (s32 x = 0; x < width; x++)
+				{
+					output[x] = srcImage[x*height + y];
+				}
+			}
+			else
+			{
+				memcpy(output, &srcImage[(height - y - 1)*width], width);
 			}
 		}
-		s_usedTexels += texData->width * texData->height;
-
-		// Copy the mapping into the texture table.
-		tableEntry->x = (s32)node->rect.x;
-		tableEntry->y = (s32)node->rect.y;
-		tableEntry->z = (s32)texData->width;
-		tableEntry->w = (s32)texData->height;
-
-		// Page the page index into the x offset.
-		tableEntry->x |= (s_currentPage << 12);
+		markDirty(page, rect);
 	}
 
-	void packNodeCell(const TextureNode* node, const void* basePtr, const WaxCell* cell, Vec4i* tableEntry)
+	// Hashes can collide, so compare the image with the pixels already in the atlas before reusing them.
+	bool atlasImageMatches(s32 pageIndex, const Vec4i& rect, const u8* srcImage, s32 width, s32 height, ImageLayout layout)
 	{
-		// Copy the texture into place.
-		const s32 compressed = cell->compressed;
-		u8* imageData = (u8*)cell + sizeof(WaxCell);
-		u8* image = (compressed == 1) ? imageData + (cell->sizeX * sizeof(u32)) : imageData;
-		u8* output = &s_texturePacker->pages[s_currentPage]->backingMemory[node->rect.y*s_texturePacker->width + node->rect.x];
+		if (rect.z != width || rect.w != height) { return false; }
 
-		u8 columnWorkBuffer[WAX_DECOMPRESS_SIZE];
-		const u32* columnOffset = (u32*)((u8*)basePtr + cell->columnOffset);
-		for (s32 x = 0; x < cell->sizeX; x++)
+		const u8* atlas = &s_texturePacker->pages[pageIndex]->backingMemory[rect.y * s_texturePacker->width + rect.x];
+		for (s32 y = 0; y < height; y++, atlas += s_texturePacker->width)
 		{
-			u8* column = (u8*)image + columnOffset[x];
-			if (compressed)
+			if (layout == IMAGE_COLUMN_MAJOR)
 			{
-				const u8* colPtr = (u8*)cell + columnOffset[x];
-				sprite_decompressColumn(colPtr, columnWorkBuffer, cell->sizeY);
-				column = columnWorkBuffer;
+				for (s32 x = 0; x < width; x++)
+				{
+					if (atlas[x] != srcImage[x*height + y]) { return false; }
+				}
 			}
-
-			for (s32 y = 0; y < cell->sizeY; y++)
+			else if (memcmp(atlas, &srcImage[(height - y - 1)*width], width) != 0)
 			{
-				output[y*s_texturePacker->width + x] = column[y];
+				return false;
 			}
 		}
-		s_usedTexels += cell->sizeX * cell->sizeY;
-
-		// Copy the mapping into the texture table.
-		tableEntry->x = (s32)node->rect.x;
-		tableEntry->y = (s32)node->rect.y;
-		tableEntry->z = (s32)cell->sizeX;
-		tableEntry->w = (s32)cell->sizeY;
-
-		// Page the page index into the x offset.
-		tableEntry->x |= (s_currentPage << 12);
+		return true;
 	}
 
-	bool isTextureInMap(TextureData* tex)
+	// Evict the least recently used texture not used by the current level, returns false if there is nothing to evict.
+	bool evictOldestTexture()
 	{
-		return (s_textureDataMap.find(tex) != s_textureDataMap.end());
-	}
+		TextureAtlasCache* cache = s_texturePacker->cache;
+		const u32 generation = s_texturePacker->generation;
+		if (cache->evictGeneration != generation)
+		{
+			cache->evictList.clear();
+			for (size_t i = 0; i < cache->entries.size(); i++)
+			{
+				if (cache->entries[i].page >= 0 && cache->entries[i].lastUsed < generation)
+				{
+					cache->evictList.push_back(s32(i));
+				}
+			}
+			std::sort(cache->evictList.begin(), cache->evictList.end(), [cache](s32 a, s32 b)
+			{
+				return cache->entries[a].lastUsed < cache->entries[b].lastUsed;
+			});
+			cache->evictGeneration = generation;
+			cache->evictPos = 0;
+		}
 
-	void insertTextureIntoMap(TextureData* tex, s32 id)
-	{
-		s_textureDataMap[tex] = id;
+		while (cache->evictPos < cache->evictList.size())
+		{
+			const s32 index = cache->evictList[cache->evictPos++];
+			AtlasEntry* entry = &cache->entries[index];
+			// The entry may have been used again since the list was built.
+			if (entry->page < 0 || entry->lastUsed >= generation) { continue; }
+
+			maxRects_release(s_texturePacker->pages[entry->page], entry->rect);
+			// Entries packed after a hash collision are not in the map.
+			std::unordered_map<u64, s32>::iterator iEntry = cache->entryMap.find(entry->hash);
+			if (iEntry != cache->entryMap.end() && iEntry->second == index)
+			{
+				cache->entryMap.erase(iEntry);
+			}
+			cache->freeEntries.push_back(index);
+			entry->page = -1;
+			return true;
+		}
+		return false;
 	}
 
-	bool isWaxCellInMap(WaxCell* cell)
+	// Find space for a new texture: first in the free space of existing pages, then by evicting old textures
+	// and finally by adding pages.
+	bool allocateRect(s32 width, s32 height, s32* pageIndex, Vec4i* rect)
 	{
-		return (s_waxDataMap.find(cell) != s_waxDataMap.end());
-	}
+		if (width <= 0 || height <= 0 || width > s_texturePacker->width || height > s_texturePacker->height) { return false; }
 
-	void insertWaxCellIntoMap(WaxCell* cell, s32 id)
-	{
-		s_waxDataMap[cell] = id;
-	}
+		while (1)
+		{
+			for (s32 p = 0; p < s_texturePacker->pageCount; p++)
+			{
+				if (maxRects_find(s_texturePacker->pages[p], width, height, rect))
+				{
+					*pageIndex = p;
+					maxRects_place(s_texturePacker->pages[p], *rect);
+					return true;
+				}
+			}
+			if (!evictOldestTexture()) { break; }
+		}
 
-	bool insertTexture(TextureData* tex)
-	{
-		if (!tex || isTextureInMap(tex)) { return true; }
-		TextureNode* node = insertNode(s_root, tex, tex->width, tex->height);
-		if (!node)
+		if (s_texturePacker->pageCount >= MAX_TEXTURE_PAGES)
 		{
 			return false;
 		}
+		const s32 p = s_texturePacker->pageCount;
+		s_texturePacker->pages[p] = allocateTexturePage(s_texturePacker->width, s_texturePacker->height);
+		s_texturePacker->pageCount++;
 
-		s_totalTexels += tex->width * tex->height;
-		insertTextureIntoMap(tex, s_texturePacker->texturesPacked);
-
-		assert(node->tex == tex && s_texturePacker->texturesPacked < MAX_TEXTURE_COUNT);
-		tex->textureId = s_texturePacker->texturesPacked;
-		packNode(node, tex, &s_texturePacker->textureTable[s_texturePacker->texturesPacked]);
-		s_texturePacker->texturesPacked++;
+		*rect = { 0, 0, width, height };
+		*pageIndex = p;
+		maxRects_place(s_texturePacker->pages[p], *rect);
 		return true;
 	}
 
-	bool insertDeltTexture(TextureData* tex)
+	// Find or add the image in the atlas and return its texture ID for the current level, or -1 if it cannot be packed.
+	s32 atlasInsert(const u8* image, s32 width, s32 height, ImageLayout layout)
 	{
-		if (!tex || isTextureInMap(tex)) { return true; }
-		TextureNode* node = insertNode(s_root, tex, tex->width, tex->height);
-		if (!node)
+		TextureAtlasCache* cache = s_texturePacker->cache;
+		const u64 hash = hashImage(image, width, height, layout);
+
+		// The same image has already been packed for this level.
+		std::unordered_map<u64, s32>::iterator iId = cache->textureIds.find(hash);
+		if (iId != cache->textureIds.end())
 		{
-			return false;
+			const Vec4i& packed = s_texturePacker->textureTable[iId->second];
+			const Vec4i rect = { packed.x & 0xfff, packed.y, packed.z, packed.w };
+			if (atlasImageMatches(packed.x >> 12, rect, image, width, height, layout))
+			{
+				return iId->second;
+			}
+		}
+		if (s_texturePacker->texturesPacked >= MAX_TEXTURE_COUNT)
+		{
+			return -1;
 		}
 
-		s_totalTexels += tex->width * tex->height;
-		insertTextureIntoMap(tex, s_texturePacker->texturesPacked);
+		s32 entryIndex;
+		std::unordered_map<u64, s32>::iterator iEntry = cache->entryMap.find(hash);
+		if (iEntry != cache->entryMap.end() && atlasImageMatches(cache->entries[iEntry->second].page, cache->entries[iEntry->second].rect, image, width, height, layout))
+		{
+			// Still in the atlas from a previous level.
+			entryIndex = iEntry->second;
+			s_reusedCount++;
+		}
+		else
+		{
+			s32 page;
+			Vec4i rect;
+			if (!allocateRect(width, height, &page, &rect))
+			{
+				return -1;
+			}
+			copyImage(s_texturePacker->pages[page], rect, image, layout);
+			s_usedTexels += width * height;
+			s_copiedCount++;
+
+			if (!cache->freeEntries.empty())
+			{
+				entryIndex = cache->freeEntries.back();
+				cache->freeEntries.pop_back();
+			}
+			else
+			{
+				entryIndex = s32(cache->entries.size());
+				cache->entries.push_back({});
+			}
+			AtlasEntry* entry = &cache->entries[entryIndex];
+			entry->hash = hash;
+			entry->page = page;
+			entry->rect = rect;
+			entry->lastUsed = 0;
+			// After a hash collision the existing mapping is kept and this entry is not shared.
+			cache->entryMap.insert({ hash, entryIndex });
+		}
 
-		assert(node->tex == tex && s_texturePacker->texturesPacked < MAX_TEXTURE_COUNT);
-		tex->textureId = s_texturePacker->texturesPacked;
-		packNodeDeltaTex(node, tex, &s_texturePacker->textureTable[s_texturePacker->texturesPacked]);
+		AtlasEntry* entry = &cache->entries[entryIndex];
+		if (entry->lastUsed != PINNED_GENERATION)
+		{
+			entry->lastUsed = s_texturePacker->generation;
+		}
+
+		// Copy the mapping into the texture table.
+		const s32 id = s_texturePacker->texturesPacked;
+		Vec4i* tableEntry = &s_texturePacker->textureTable[id];
+		// Pack the page index into the x offset.
+		tableEntry->x = entry->rect.x | (entry->page << 12);
+		tableEntry->y = entry->rect.y;
+		tableEntry->z = width;
+		tableEntry->w = height;
 		s_texturePacker->texturesPacked++;
+		s_totalTexels += width * height;
+
+		cache->textureIds.insert({ hash, id });
+		return id;
+	}
+
+	bool insertTexture(TextureData* tex, ImageLayout layout = IMAGE_COLUMN_MAJOR)
+	{
+		if (!tex || s_textureDataMap.find(tex) != s_textureDataMap.end()) { return true; }
+
+		const s32 id = atlasInsert(tex->image, tex->width, tex->height, layout);
+		if (id < 0) { return false; }
+
+		tex->textureId = id;
+		s_textureDataMap[tex] = id;
 		return true;
 	}
 
@@ -415,35 +622,45 @@ namespace TFE_Jedi
 	{
 		if (!basePtr || !frame) { return true; }
 		WaxCell* cell = WAX_CellPtr(basePtr, frame);
-		if (!cell || isWaxCellInMap(cell)) { return true; }
-		
-		TextureNode* node = insertNode(s_root, cell, cell->sizeX, cell->sizeY);
-		if (!node)
+		if (!cell || s_waxDataMap.find(cell) != s_waxDataMap.end()) { return true; }
+
+		// Decompress the cell, so that it can be hashed and copied like other textures.
+		const s32 compressed = cell->compressed;
+		u8* imageData = (u8*)cell + sizeof(WaxCell);
+		u8* image = (compressed == 1) ? imageData + (cell->sizeX * sizeof(u32)) : imageData;
+		const u32* columnOffset = (u32*)((u8*)basePtr + cell->columnOffset);
+
+		s_cellImage.resize(size_t(cell->sizeX) * size_t(cell->sizeY));
+		u8* output = s_cellImage.data();
+		for (s32 x = 0; x < cell->sizeX; x++, output += cell->sizeY)
 		{
-			return false;
+			if (compressed)
+			{
+				sprite_decompressColumn((u8*)cell + columnOffset[x], output, cell->sizeY);
+			}
+			else
+			{
+				memcpy(output, image + columnOffset[x], cell->sizeY);
+			}
 		}
 
-		s_totalTexels += cell->sizeX * cell->sizeY;
-		insertWaxCellIntoMap(cell, s_texturePacker->texturesPacked);
+		const s32 id = atlasInsert(s_cellImage.data(), cell->sizeX, cell->sizeY, IMAGE_COLUMN_MAJOR);
+		if (id < 0) { return false; }
 
-		assert(node->tex == cell && s_texturePacker->texturesPacked < MAX_TEXTURE_COUNT);
-		cell->textureId = s_texturePacker->texturesPacked;
-		packNodeCell(node, basePtr, cell, &s_texturePacker->textureTable[s_texturePacker->texturesPacked]);
-		s_texturePacker->texturesPacked++;
+		cell->textureId = id;
+		s_waxDataMap[cell] = id;
 		return true;
 	}
 
 	bool insertAnimatedTextureFrames(AnimatedTexture* animTex)
 	{
 		if (!animTex) { return true; }
+		bool result = true;
 		for (s32 f = 0; f < animTex->count; f++)
 		{
-			if (!insertTexture(animTex->frameList[f]))
-			{
-				return false;
-			}
+			result &= insertTexture(animTex->frameList[f]);
 		}
-		return true;
+		return result;
 	}
 		
 	s32 textureSort(const void* a, const void* b)
@@ -455,13 +672,6 @@ namespace TFE_Jedi
 		return 0;
 	}
 
-	TextureNode* allocateNode()
-	{
-		TextureNode* node = (TextureNode*)TFE_Memory::allocFromChunkedArray(s_nodePool);
-		memset(node, 0, sizeof(TextureNode));
-		return node;
-	}
-
 	// Begin the packing process, this clears out the texture packer.
 	bool texturepacker_begin(TexturePacker* texturePacker)
 	{
@@ -473,22 +683,24 @@ namespace TFE_Jedi
 
 		s_texturePacker = texturePacker;
 		s_texturePacker->texturesPacked = 0;
+		s_texturePacker->generation++;
 		// Clear pages.
 		for (s32 p = 0; p < s_texturePacker->pageCount; p++)
 		{
-			s_texturePacker->pages[p]->root = nullptr;
-			s_texturePacker->pages[p]->textureCount = 0;
+			resetTexturePage(s_texturePacker->pages[p], s_texturePacker->width, s_texturePacker->height);
 		}
 
-		TFE_Memory::chunkedArrayClear(s_nodePool);
+		TextureAtlasCache* cache = s_texturePacker->cache;
+		cache->entries.clear();
+		cache->freeEntries.clear();
+		cache->entryMap.clear();
+		cache->textureIds.clear();
+		cache->reservedIds.clear();
+		cache->evictList.clear();
+
 		s_textureDataMap.clear();
 		s_waxDataMap.clear();
 		s_texInfoPool.clear();
-
-		// Insert the parent that covers all of the available space.
-		s_root = nullptr;
-		insertNode(nullptr, nullptr, 0, 0);
-		s_texturePacker->pages[0]->root = s_root;
 		return true;
 	}
 
@@ -507,14 +719,23 @@ namespace TFE_Jedi
 			}
 			// Allocate at least 2 layers.
 			s_texturePacker->texture = TFE_RenderBackend::createTextureArray(s_texturePacker->width, s_texturePacker->height, max(2, s_texturePacker->pageCount), 1);
+			// The new texture needs all of the pages.
+			for (s32 p = 0; p < s_texturePacker->pageCount; p++)
+			{
+				markDirty(s_texturePacker->pages[p], { 0, 0, s_texturePacker->width, s_texturePacker->height });
+			}
 		}
 
-		// Then update each page.
-		const size_t size = s_texturePacker->width * s_texturePacker->height;
+		// Then upload the modified part of each page.
 		for (s32 p = 0; p < s_texturePacker->pageCount; p++)
 		{
 			TexturePage* page = s_texturePacker->pages[p];
-			s_texturePacker->texture->update(page->backingMemory, size, p);
+			const Vec4i dirty = page->dirty;
+			if (dirty.z <= dirty.x) { continue; }
+
+			const u8* src = &page->backingMemory[dirty.y * s_texturePacker->width + dirty.x];
+			s_texturePacker->texture->updateRegion(src, s_texturePacker->width, dirty.x, dirty.y, dirty.z - dirty.x, dirty.w - dirty.y, p);
+			page->dirty = { 0 };
 		}
 
 		// Write out the debug atlas if enabled.
@@ -529,6 +750,8 @@ namespace TFE_Jedi
 
 		// Get textures.
 		s_texInfoPool.clear();
+		s_reusedCount = 0;
+		s_copiedCount = 0;
 		if (getList(s_texInfoPool, pool))
 		{
 			s32 count = (s32)s_texInfoPool.size();
@@ -563,116 +786,45 @@ namespace TFE_Jedi
 				}
 			}
 
-			// 2. Sort textures by perimeter from largest to smallest - simplified to w+h
+			// 2. Sort textures by area from largest to smallest, which gives the best packing for new textures.
 			std::qsort(list, size_t(count), sizeof(TextureInfo), textureSort);
 
-			// 3. Put all textures into the unpacked list.
-			s_unpackedTextures[0].resize(count);
-			TextureInfo** unpackedList = s_unpackedTextures[0].data();
+			// 3. Insert each texture, textures already in the atlas are reused and new textures are added to the free space.
+			s32 failedCount = 0;
 			for (s32 i = 0; i < count; i++)
 			{
-				unpackedList[i] = &list[i];
-			}
-
-			// 4. Insert each texture into the tree, adding pages as needed.
-			s_currentPage = s_texturePacker->reservedPages;
-			if (s_currentPage >= s_texturePacker->pageCount)
-			{
-				s_texturePacker->pages[s_texturePacker->pageCount] = allocateTexturePage(s_texturePacker->width, s_texturePacker->height);
-				s_texturePacker->pageCount++;
-
-				s_root = nullptr;
-				insertNode(nullptr, nullptr, 0, 0);
-				s_texturePacker->pages[s_currentPage]->root = s_root;
-			}
-			else
-			{
-				s_root = s_texturePacker->pages[s_currentPage]->root;
-				if (!s_root)
-				{
-					insertNode(nullptr, nullptr, 0, 0);
-					s_texturePacker->pages[s_currentPage]->root = s_root;
-				}
-			}
-
-			s_unpackedBuffer = 0;
-			while (!s_unpackedTextures[s_unpackedBuffer].empty())
-			{
-				count = (s32)s_unpackedTextures[s_unpackedBuffer].size();
-				TextureInfo** unpackedList = s_unpackedTextures[s_unpackedBuffer].data();
-
-				s_unpackedBuffer = (s_unpackedBuffer + 1)&1;
-				s_unpackedTextures[s_unpackedBuffer].clear();
-
-				for (s32 i = 0; i < count; i++)
+				bool packed = true;
+				switch (list[i].type)
 				{
-					switch (unpackedList[i]->type)
+					case TEXINFO_DF_TEXTURE_DATA:
 					{
-						case TEXINFO_DF_TEXTURE_DATA:
-						{
-							if (unpackedList[i]->texData->uvWidth == BM_ANIMATED_TEXTURE)
-							{
-								AnimatedTexture* animTex = (AnimatedTexture*)unpackedList[i]->texData->image;
-								if (!insertAnimatedTextureFrames(animTex))
-								{
-									s_unpackedTextures[s_unpackedBuffer].push_back(unpackedList[i]);
-								}
-							}
-							else
-							{
-								if (!insertTexture(unpackedList[i]->texData))
-								{
-									s_unpackedTextures[s_unpackedBuffer].push_back(unpackedList[i]);
-								}
-							}
-						} break;
-						case TEXINFO_DF_DELT_TEX:
-						{
-							if (!insertDeltTexture(unpackedList[i]->texData))
-							{
-								s_unpackedTextures[s_unpackedBuffer].push_back(unpackedList[i]);
-							}
-						} break;
-						case TEXINFO_DF_ANIM_TEX:
+						if (list[i].texData->uvWidth == BM_ANIMATED_TEXTURE)
 						{
-							if (!insertAnimatedTextureFrames(unpackedList[i]->animTex))
-							{
-								s_unpackedTextures[s_unpackedBuffer].push_back(unpackedList[i]);
-							}
-						} break;
-						case TEXINFO_DF_WAX_CELL:
+							packed = insertAnimatedTextureFrames((AnimatedTexture*)list[i].texData->image);
+						}
+						else
 						{
-							if (!insertWaxFrame(unpackedList[i]->basePtr, unpackedList[i]->frame))
-							{
-								s_unpackedTextures[s_unpackedBuffer].push_back(unpackedList[i]);
-							}
-						} break;
-					}
-				}
-
-				// Allocate another page...
-				if (!s_unpackedTextures[s_unpackedBuffer].empty())
-				{
-					s_currentPage++;
-					if (s_currentPage >= s_texturePacker->pageCount)
+							packed = insertTexture(list[i].texData);
+						}
+					} break;
+					case TEXINFO_DF_DELT_TEX:
 					{
-						s_texturePacker->pages[s_texturePacker->pageCount] = allocateTexturePage(s_texturePacker->width, s_texturePacker->height);
-						s_texturePacker->pageCount++;
-
-						s_root = nullptr;
-						insertNode(nullptr, nullptr, 0, 0);
-						s_texturePacker->pages[s_currentPage]->root = s_root;
-					}
-					else
+						packed = insertTexture(list[i].texData, IMAGE_ROW_MAJOR_FLIPPED);
+					} break;
+					case TEXINFO_DF_ANIM_TEX:
 					{
-						s_root = s_texturePacker->pages[s_currentPage]->root;
-						if (!s_root)
-						{
-							insertNode(nullptr, nullptr, 0, 0);
-							s_texturePacker->pages[s_currentPage]->root = s_root;
-						}
-					}
+						packed = insertAnimatedTextureFrames(list[i].animTex);
+					} break;
+					case TEXINFO_DF_WAX_CELL:
+					{
+						packed = insertWaxFrame(list[i].basePtr, list[i].frame);
+					} break;
 				}
+				if (!packed) { failedCount++; }
+			}
+			if (failedCount)
+			{
+				TFE_System::logWrite(LOG_WARNING, "TexturePacker", "%d textures do not fit in '%s'.", failedCount, s_texturePacker->name);
 			}
 		}
 		return s_texturePacker->texturesPacked;
@@ -683,24 +835,88 @@ namespace TFE_Jedi
 		TexturePacker* texturePacker = s_globalTexturePacker;
 		if (!texturePacker) { return; }
 
+		for (s32 p = 1; p < texturePacker->pageCount; p++)
+		{
+			freeTexturePage(texturePacker->pages[p]);
+		}
 		texturePacker->pageCount = 1;
 		texturePacker->reservedPages = 0;
 		texturePacker->reservedTexturesPacked = 0;
 
 		s_usedTexels = 0;
 		s_totalTexels = 0;
-		s_nodePoolIndex = 0;
-		s_unpackedBuffer = 0;
-		s_currentPage = 0;
-
-		TFE_Memory::chunkedArrayClear(s_nodePool);
-		s_textureDataMap.clear();
-		s_waxDataMap.clear();
-		s_texInfoPool.clear();
 
 		texturepacker_begin(s_globalTexturePacker);
 	}
 
+	///////////////////////////////////////////////////
+	// Benchmark
+	///////////////////////////////////////////////////
+	f64 texturepacker_benchmark(s32 levelCount, s32 texturesPerLevel, f64* reuseRate, s32* pageCount)
+	{
+		if (levelCount <= 0 || texturesPerLevel <= 0) { return 0.0; }
+
+		// Levels draw from a shared set of textures, so some textures are used by several levels.
+		const s32 textureCount = texturesPerLevel * 3;
+		std::vector<TextureData> textures(textureCount);
+		u32 seed = 0x1234567u;
+		for (s32 i = 0; i < textureCount; i++)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			TextureData* tex = &textures[i];
+			*tex = {};
+			tex->width  = 16 << ((seed >> 8) & 3);
+			tex->height = 16 << ((seed >> 12) & 3);
+			tex->image = (u8*)malloc(tex->width * tex->height);
+			for (s32 p = 0; p < tex->width * tex->height; p++)
+			{
+				seed = seed * 1664525u + 1013904223u;
+				tex->image[p] = u8(seed >> 24);
+			}
+		}
+
+		// Use a separate CPU only packer, leaving the state of the current packer alone.
+		TexturePacker* prevPacker = s_texturePacker;
+		std::map<TextureData*, s32> prevTextureDataMap;
+		std::map<WaxCell*, s32> prevWaxDataMap;
+		prevTextureDataMap.swap(s_textureDataMap);
+		prevWaxDataMap.swap(s_waxDataMap);
+
+		TexturePacker* texturePacker = createTexturePacker("Benchmark", 1024, 1024);
+		texturepacker_begin(texturePacker);
+
+		u64 ticks = 0;
+		s32 reused = 0, total = 0;
+		for (s32 l = 0; l < levelCount; l++)
+		{
+			texturepacker_discardUnreservedPages(texturePacker);
+			s_reusedCount = 0;
+
+			const u64 start = TFE_System::getCurrentTimeInTicks();
+			for (s32 t = 0; t < texturesPerLevel; t++)
+			{
+				seed = seed * 1664525u + 1013904223u;
+				insertTexture(&textures[(seed >> 8) % textureCount]);
+			}
+			ticks += TFE_System::getCurrentTimeInTicks() - start;
+
+			reused += s_reusedCount;
+			total += texturePacker->texturesPacked;
+		}
+		*pageCount = texturePacker->pageCount;
+		*reuseRate = total ? f64(reused) / f64(total) : 0.0;
+
+		freeTexturePacker(texturePacker);
+		s_texturePacker = prevPacker;
+		s_textureDataMap.swap(prevTextureDataMap);
+		s_waxDataMap.swap(prevWaxDataMap);
+		for (s32 i = 0; i < textureCount; i++)
+		{
+			free(textures[i].image);
+		}
+		return TFE_System::convertFromTicksToSeconds(ticks) / f64(levelCount);
+	}
+
 #if DEBUG_TEXTURE_ATLAS
 	u32 s_debugPal[256];
 
@@ -1,6 +1,12 @@
 #pragma once
 //////////////////////////////////////////////////////////////////////
 // Pack level textures into an atlas texture or array of textures.
+//
+// The atlas is persistent: textures are identified by a hash of their
+// contents, so textures shared between levels keep their place in the
+// atlas and are not copied or uploaded again. Space used by textures
+// that have not been used recently is reclaimed when a new texture
+// does not fit (LRU by level).
 //////////////////////////////////////////////////////////////////////
 #include <TFE_System/types.h>
 #include <TFE_System/memoryPool.h>
@@ -9,7 +15,7 @@
 #include <TFE_Jedi/Math/core_math.h>
 #include <TFE_RenderBackend/textureGpu.h>
 #include <TFE_RenderBackend/shaderBuffer.h>
-
+#include <vector>
 
 struct TextureData;
 struct AnimatedTexture;
@@ -17,13 +23,14 @@ struct WaxFrame;
 
 namespace TFE_Jedi
 {
-	struct TextureNode;
+	struct TextureAtlasCache;
 
 	struct TexturePage
 	{
-		s32 textureCount;
+		s32 textureCount = 0;			// Textures currently allocated in the page.
 		u8* backingMemory = nullptr;
-		TextureNode* root = nullptr;
+		std::vector<Vec4i> freeRects;	// Free space (x, y, width, height), rectangles may overlap (MaxRects).
+		Vec4i dirty = { 0 };			// Area modified since the last commit (x0, y0, x1, y1), empty if x1 <= x0.
 	};
 
 	struct TexturePacker
@@ -43,6 +50,8 @@ namespace TFE_Jedi
 		s32 pageCount = 0;				// Number of texture pages.
 		s32 reservedPages = 0;			// Number of reserved pages.
 		s32 reservedTexturesPacked = 0;
+		u32 generation = 0;				// Incremented for each level, used to find the least recently used textures.
+		TextureAtlasCache* cache = nullptr;
 
 		// For debugging.
 		char name[64];
@@ -74,4 +83,8 @@ namespace TFE_Jedi
 	// The client must provide a 'getList' function to get a list of 'TextureInfo' (see above).
 	// Note this may be called multiple times on the same texture packer, new pages are created as needed.
 	s32 texturepacker_pack(TextureListCallback getList, AssetPool pool);
+
+	// Pack random textures for 'levelCount' levels, with a CPU only texture packer.
+	// Returns the average time per level in seconds, 'reuseRate' is the fraction of textures found in the atlas.
+	f64 texturepacker_benchmark(s32 levelCount, s32 texturesPerLevel, f64* reuseRate, s32* pageCount);
 }  // TFE_Jedi
\ No newline at end of file
@@ -358,6 +358,8 @@ namespace TFE_Settings
 		writeKeyValue_Bool(settings, "colorCorrection", s_graphicsSettings.colorCorrection);
 		writeKeyValue_Bool(settings, "perspectiveCorrect3DO", s_graphicsSettings.perspectiveCorrectTexturing);
 		writeKeyValue_Bool(settings, "extendAjoinLimits", s_graphicsSettings.extendAjoinLimits);
+		writeKeyValue_Int(settings, "renderThreadCount", s_graphicsSettings.renderThreadCount);
+		writeKeyValue_Bool(settings, "columnMajorRaster", s_graphicsSettings.columnMajorRaster);
 		writeKeyValue_Bool(settings, "vsync", s_graphicsSettings.vsync);
 		writeKeyValue_Bool(settings, "show_fps", s_graphicsSettings.showFps);
 		writeKeyValue_Int(settings, "frameRateLimit", s_graphicsSettings.frameRateLimit);
@@ -398,6 +400,8 @@ namespace TFE_Settings
 		writeKeyValue_Float(settings, "cutsceneMusicVolume", s_soundSettings.cutsceneMusicVolume);
 		writeKeyValue_Int(settings, "audioDevice", s_soundSettings.audioDevice);
 		writeKeyValue_Int(settings, "midiDevice", s_soundSettings.midiDevice);
+		writeKeyValue_Int(settings, "audioOutputRate", s_soundSettings.audioOutputRate);
+		writeKeyValue_Int(settings, "audioBufferSize", s_soundSettings.audioBufferSize);
 		writeKeyValue_Bool(settings, "use16Channels", s_soundSettings.use16Channels);
 		writeKeyValue_Bool(settings, "disableSoundInMenus", s_soundSettings.disableSoundInMenus);
 	}
@@ -407,6 +411,8 @@ namespace TFE_Settings
 		writeHeader(settings, c_sectionNames[SECTION_SYSTEM]);
 		writeKeyValue_Bool(settings, "gameExitsToMenu",   s_systemSettings.gameQuitExitsToMenu);
 		writeKeyValue_Bool(settings, "returnToModLoader", s_systemSettings.returnToModLoader);
+		writeKeyValue_Bool(settings, "enableSnapshots",   s_systemSettings.enableSnapshots);
+		writeKeyValue_Int(settings,  "snapshotInterval",  s_systemSettings.snapshotInterval);
 	}
 
 	void writeGameSettings(FileStream& settings)
@@ -636,6 +642,14 @@ namespace TFE_Settings
 		{
 			s_graphicsSettings.extendAjoinLimits = parseBool(value);
 		}
+		else if (strcasecmp("renderThreadCount", key) == 0)
+		{
+			s_graphicsSettings.renderThreadCount = parseInt(value);
+		}
+		else if (strcasecmp("columnMajorRaster", key) == 0)
+		{
+			s_graphicsSettings.columnMajorRaster = parseBool(value);
+		}
 		else if (strcasecmp("vsync", key) == 0)
 		{
 			s_graphicsSettings.vsync = parseBool(value);
@@ -770,6 +784,14 @@ namespace TFE_Settings
 		{
 			s_soundSettings.midiDevice = parseInt(value);
 		}
+		else if (strcasecmp("audioOutputRate", key) == 0)
+		{
+			s_soundSettings.audioOutputRate = parseInt(value);
+		}
+		else if (strcasecmp("audioBufferSize", key) == 0)
+		{
+			s_soundSettings.audioBufferSize = parseInt(value);
+		}
 		else if (strcasecmp("use16Channels", key) == 0)
 		{
 			s_soundSettings.use16Channels = parseBool(value);
@@ -790,6 +812,14 @@ namespace TFE_Settings
 		{
 			s_systemSettings.returnToModLoader = parseBool(value);
 		}
+		else if (strcasecmp("enableSnapshots", key) == 0)
+		{
+			s_systemSettings.enableSnapshots = parseBool(value);
+		}
+		else if (strcasecmp("snapshotInterval", key) == 0)
+		{
+			s_systemSettings.snapshotInterval = parseInt(value);
+		}
 	}
 
 	void parseGame(const char* key, const char* value)
@@ -45,6 +45,8 @@ struct TFE_Settings_Graphics
 	bool  colorCorrection = false;
 	bool  perspectiveCorrectTexturing = false;
 	bool  extendAjoinLimits = true;
+	s32   renderThreadCount = 1;
+	bool  columnMajorRaster = false;
 	bool  vsync = true;
 	bool  showFps = false;
 	s32   frameRateLimit = 0;
@@ -129,6 +131,8 @@ struct TFE_Settings_Sound
 	f32 cutsceneMusicVolume = 1.0f;
 	s32 audioDevice = -1;
 	s32 midiDevice = -1;
+	s32 audioOutputRate = 44100;	// Output device sample rate, the game audio is resampled to this rate.
+	s32 audioBufferSize = 256;		// Output device buffer size in frames.
 	bool use16Channels = false;
 	bool disableSoundInMenus = false;
 };
@@ -164,6 +168,8 @@ struct TFE_Settings_System
 {
 	bool gameQuitExitsToMenu = true;	// Quitting from the game returns to the main menu instead.
 	bool returnToModLoader = true;		// Return to the Mod Loader if running a mod.
+	bool enableSnapshots = false;		// Keep in-memory snapshots of the current level for the "rewind" console command.
+	s32  snapshotInterval = 5;			// Seconds of game time between snapshots.
 };
 
 namespace TFE_Settings
@@ -241,7 +241,8 @@ void showCrashReportPopup(const char* message)
 	sprintf_s(s_msgBuffer, TFE_MAX_PATH, "The Force Engine (TFE) Crashed.\n%s\nCrash dump written to '%s'.", message, s_dirBuffer);
 	// Write to the log.
 	TFE_System::logWrite(LOG_ERROR, "Crash", s_msgBuffer);
-	TFE_System::logClose();
+	// Flush rather than close, the writer thread may not be in a state where it can be joined.
+	TFE_System::logFlush();
 	// Output to a popup message box.
 	MessageBoxA(NULL, (LPCSTR)s_msgBuffer, (LPCSTR)"Crash Report", MB_OK | MB_ICONERROR | MB_SYSTEMMODAL);
 }
@@ -0,0 +1,135 @@
+#include "jobSystem.h"
+#include "profiler.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace TFE_Jobs
+{
+	static std::vector<std::thread> s_workers;
+	static std::mutex s_mutex;
+	static std::condition_variable s_wakeWorkers;
+	static std::condition_variable s_batchDone;
+
+	// Current batch.
+	static JobFunc s_func = nullptr;
+	static void* s_userData = nullptr;
+	static s32 s_jobCount = 0;
+	static atomic_s32 s_nextJob(0);
+	static s32 s_busyWorkers = 0;
+	static u32 s_batchId = 0;
+	static bool s_exit = false;
+
+	void runJobs()
+	{
+		TFE_ZONE("Jobs");
+		for (s32 index = s_nextJob++; index < s_jobCount; index = s_nextJob++)
+		{
+			s_func(index, s_userData);
+		}
+	}
+
+	// 'batchId' is the last batch submitted before the worker was created, so it only wakes up for new work.
+	void workerMain(u32 batchId)
+	{
+		TFE_THREAD_NAME("Job Worker");
+		while (1)
+		{
+			{
+				std::unique_lock<std::mutex> lock(s_mutex);
+				s_wakeWorkers.wait(lock, [&batchId] { return s_exit || s_batchId != batchId; });
+				if (s_exit) { return; }
+				batchId = s_batchId;
+			}
+
+			runJobs();
+
+			std::unique_lock<std::mutex> lock(s_mutex);
+			s_busyWorkers--;
+			if (s_busyWorkers == 0)
+			{
+				s_batchDone.notify_one();
+			}
+		}
+	}
+
+	void stopWorkers()
+	{
+		{
+			std::unique_lock<std::mutex> lock(s_mutex);
+			s_exit = true;
+		}
+		s_wakeWorkers.notify_all();
+
+		for (size_t i = 0; i < s_workers.size(); i++)
+		{
+			s_workers[i].join();
+		}
+		s_workers.clear();
+		s_exit = false;
+	}
+
+	void setThreadCount(s32 count)
+	{
+		if (count < 1) { count = 1; }
+		else if (count > MAX_THREAD_COUNT) { count = MAX_THREAD_COUNT; }
+		if (count == getThreadCount()) { return; }
+
+		stopWorkers();
+		// The calling thread counts as one of the threads.
+		for (s32 i = 1; i < count; i++)
+		{
+			s_workers.push_back(std::thread(workerMain, s_batchId));
+		}
+	}
+
+	s32 getThreadCount()
+	{
+		return s32(s_workers.size()) + 1;
+	}
+
+	s32 getHardwareThreadCount()
+	{
+		const s32 count = (s32)std::thread::hardware_concurrency();
+		return count > 0 ? count : 1;
+	}
+
+	void parallelFor(s32 count, JobFunc func, void* userData)
+	{
+		if (count <= 0) { return; }
+		// Avoid waking the workers when there is nothing to share.
+		if (s_workers.empty() || count == 1)
+		{
+			for (s32 i = 0; i < count; i++)
+			{
+				func(i, userData);
+			}
+			return;
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(s_mutex);
+			s_func = func;
+			s_userData = userData;
+			s_jobCount = count;
+			s_nextJob = 0;
+			s_busyWorkers = s32(s_workers.size());
+			s_batchId++;
+		}
+		s_wakeWorkers.notify_all();
+
+		// The calling thread works on the batch as well.
+		runJobs();
+
+		std::unique_lock<std::mutex> lock(s_mutex);
+		s_batchDone.wait(lock, [] { return s_busyWorkers == 0; });
+		s_func = nullptr;
+		s_userData = nullptr;
+	}
+
+	void shutdown()
+	{
+		stopWorkers();
+	}
+}
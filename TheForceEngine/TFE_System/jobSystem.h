@@ -0,0 +1,35 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine Job System
+// A small pool of worker threads used to split frame work, such as
+// software rasterization, into independent jobs.
+//
+// Jobs are submitted in batches from the main thread and the calling
+// thread participates in the work, so parallelFor() returns once every
+// job in the batch has completed.
+//////////////////////////////////////////////////////////////////////
+#include "types.h"
+
+namespace TFE_Jobs
+{
+	enum
+	{
+		MAX_THREAD_COUNT = 32,
+	};
+
+	// Job callback, 'index' is in the range [0, count) given to parallelFor().
+	typedef void(*JobFunc)(s32 index, void* userData);
+
+	// Set the number of threads that execute jobs, including the calling thread.
+	// A count of 1 (or less) disables the worker threads.
+	void setThreadCount(s32 count);
+	s32  getThreadCount();
+	// Returns the number of hardware threads available (always at least 1).
+	s32  getHardwareThreadCount();
+
+	// Run func(i, userData) for i = [0, count) and wait for all of the jobs to finish.
+	// Must be called from the main thread.
+	void parallelFor(s32 count, JobFunc func, void* userData);
+
+	void shutdown();
+}
@@ -9,17 +9,57 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 #ifdef _WIN32
 	#include <Windows.h>
 	#include <io.h>
 #endif
 
+// Messages are formatted on the calling thread and pushed into a lock-free queue,
+// a background thread writes them to disk and flushes once per batch.
 namespace TFE_System
 {
+	enum LogConstants
+	{
+		LOG_MAX_LINE   = 2048,
+		LOG_QUEUE_SIZE = 1024,	// Must be a power of 2.
+		LOG_QUEUE_MASK = LOG_QUEUE_SIZE - 1,
+		// Per-tag rate limiting, each tag may write LOG_TAG_RATE_LIMIT messages per second.
+		LOG_TAG_SLOTS  = 64,
+		LOG_TAG_RATE_LIMIT = 100,
+		// The writer wakes up at least this often, even if it is not signaled.
+		LOG_WRITER_WAIT_MS = 50,
+	};
+
+	struct LogEntry
+	{
+		atomic_u32 sequence;
+		u32  length;
+		char text[LOG_MAX_LINE];
+	};
+
+	struct LogTagLimit
+	{
+		atomic_u32 window;		// Current one second window.
+		atomic_u32 count;		// Messages written in the current window.
+		atomic_u32 suppressed;	// Messages dropped in the current window.
+	};
+
+	// Stops the writer thread on exit, if logClose() was not called.
+	struct LogWriter
+	{
+		std::thread thread;
+		~LogWriter();
+	};
+
 	static FileStream s_logFile;
-	static char s_workStr[32768];
-	static char s_msgStr[32768];
 	static const char* c_typeNames[]=
 	{
 		"",			//LOG_MSG = 0,
@@ -28,93 +68,347 @@ namespace TFE_System
 		"Critical", //LOG_CRITICAL,
 	};
 
+	// Queue, multiple producers and a single consumer (whoever holds s_writeMutex).
+	static LogEntry   s_queue[LOG_QUEUE_SIZE];
+	static atomic_u32 s_enqueuePos(0);
+	static u32        s_dequeuePos = 0;
+	static atomic_u32 s_droppedCount(0);
+	static LogTagLimit s_tagLimit[LOG_TAG_SLOTS];
+
+	static std::mutex s_writeMutex;
+	static std::mutex s_wakeMutex;
+	static std::condition_variable s_wakeWriter;
+	static atomic_bool s_logOpen(false);
+	static atomic_bool s_exitWriter(false);
+
+	// Console output is only safe on the main thread, messages from other threads are queued.
+	static std::thread::id s_mainThread;
+	static std::mutex s_consoleMutex;
+	static std::vector<std::string> s_consoleQueue;
+	static atomic_bool s_consolePending(false);
+
+	static LogWriter s_writer;
+
+	void logWriterMain();
+	void drainQueue();
+
+	LogWriter::~LogWriter()
+	{
+		logClose();
+	}
+
 	bool logOpen(const char* filename)
 	{
 		char logPath[TFE_MAX_PATH];
 		TFE_Paths::appendPath(PATH_USER_DOCUMENTS, filename, logPath);
 
-		return s_logFile.open(logPath, Stream::MODE_WRITE);
+		if (!s_logFile.open(logPath, Stream::MODE_WRITE))
+		{
+			return false;
+		}
+
+		for (u32 i = 0; i < LOG_QUEUE_SIZE; i++)
+		{
+			s_queue[i].sequence.store(i, std::memory_order_relaxed);
+		}
+		s_enqueuePos.store(0, std::memory_order_relaxed);
+		s_dequeuePos = 0;
+		s_mainThread = std::this_thread::get_id();
+
+		s_exitWriter.store(false);
+		s_logOpen.store(true, std::memory_order_release);
+		s_writer.thread = std::thread(logWriterMain);
+		return true;
 	}
 
 	void logClose()
 	{
+		if (!s_logOpen.exchange(false)) { return; }
+
+		{
+			std::unique_lock<std::mutex> lock(s_wakeMutex);
+			s_exitWriter.store(true);
+		}
+		s_wakeWriter.notify_one();
+		if (s_writer.thread.joinable())
+		{
+			s_writer.thread.join();
+		}
+
+		// Write anything that was queued after the writer exited.
+		logFlush();
 		s_logFile.close();
 	}
-	
+
+	void logFlush()
+	{
+		std::unique_lock<std::mutex> lock(s_writeMutex);
+		drainQueue();
+	}
+
+	u32 hashTag(const char* tag)
+	{
+		u32 hash = 2166136261u;
+		for (; *tag; tag++)
+		{
+			hash = (hash ^ u8(*tag)) * 16777619u;
+		}
+		return hash;
+	}
+
+	u32 getLogSeconds()
+	{
+		return u32(std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	bool enqueueLine(const char* line, u32 length)
+	{
+		u32 pos = s_enqueuePos.load(std::memory_order_relaxed);
+		LogEntry* entry;
+		while (1)
+		{
+			entry = &s_queue[pos & LOG_QUEUE_MASK];
+			const u32 sequence = entry->sequence.load(std::memory_order_acquire);
+			const s32 diff = s32(sequence - pos);
+			if (diff == 0)
+			{
+				if (s_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (diff < 0)
+			{
+				// The queue is full, drop the message rather than block the caller.
+				s_droppedCount.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			else
+			{
+				pos = s_enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+
+		length = std::min(length, u32(LOG_MAX_LINE));
+		memcpy(entry->text, line, length);
+		entry->length = length;
+		entry->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Returns false if the message should be dropped, 'suppressed' is set to the number of
+	// messages dropped in the previous window.
+	bool checkTagRateLimit(const char* tag, u32* suppressed)
+	{
+		LogTagLimit* limit = &s_tagLimit[hashTag(tag) & (LOG_TAG_SLOTS - 1)];
+		const u32 window = getLogSeconds();
+		u32 prevWindow = limit->window.load(std::memory_order_relaxed);
+		*suppressed = 0;
+		if (prevWindow != window && limit->window.compare_exchange_strong(prevWindow, window, std::memory_order_relaxed))
+		{
+			limit->count.store(0, std::memory_order_relaxed);
+			*suppressed = limit->suppressed.exchange(0, std::memory_order_relaxed);
+		}
+
+		if (limit->count.fetch_add(1, std::memory_order_relaxed) >= LOG_TAG_RATE_LIMIT)
+		{
+			limit->suppressed.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		return true;
+	}
+
+	void writeOutput(const char* str)
+	{
+		//Write to the debugger or terminal output.
+		#ifdef _WIN32
+			OutputDebugStringA(str);
+		#else
+			fprintf(stderr, "%s", str);
+		#endif
+	}
+
+	// Must be called with s_writeMutex held.
+	void drainQueue()
+	{
+		bool wrote = false;
+		while (1)
+		{
+			LogEntry* entry = &s_queue[s_dequeuePos & LOG_QUEUE_MASK];
+			const u32 sequence = entry->sequence.load(std::memory_order_acquire);
+			if (s32(sequence - (s_dequeuePos + 1)) < 0)
+			{
+				break;
+			}
+
+			// The text always has room for the terminator since it ends with "\r\n".
+			s_logFile.writeBuffer(entry->text, entry->length);
+			entry->text[std::min(entry->length, u32(LOG_MAX_LINE - 1))] = 0;
+			writeOutput(entry->text);
+
+			entry->sequence.store(s_dequeuePos + LOG_QUEUE_SIZE, std::memory_order_release);
+			s_dequeuePos++;
+			wrote = true;
+		}
+
+		const u32 dropped = s_droppedCount.exchange(0, std::memory_order_relaxed);
+		if (dropped)
+		{
+			char msg[256];
+			sprintf(msg, "[Log : Warning] %u messages were dropped, the log queue was full.\r\n", dropped);
+			s_logFile.writeBuffer(msg, (u32)strlen(msg));
+			writeOutput(msg);
+			wrote = true;
+		}
+
+		// Flush once per batch rather than once per message.
+		if (wrote)
+		{
+			s_logFile.flush();
+		}
+	}
+
+	void logWriterMain()
+	{
+		while (1)
+		{
+			{
+				std::unique_lock<std::mutex> lock(s_wakeMutex);
+				s_wakeWriter.wait_for(lock, std::chrono::milliseconds(LOG_WRITER_WAIT_MS), [] {
+					return s_exitWriter.load() || s_enqueuePos.load(std::memory_order_relaxed) != s_dequeuePos;
+				});
+			}
+
+			{
+				std::unique_lock<std::mutex> lock(s_writeMutex);
+				drainQueue();
+			}
+			if (s_exitWriter.load()) { break; }
+		}
+	}
+
+	void queueConsole(const char* msg)
+	{
+		std::unique_lock<std::mutex> lock(s_consoleMutex);
+		s_consoleQueue.push_back(msg);
+		s_consolePending.store(true, std::memory_order_release);
+	}
+
+	void logToConsole(char* msg)
+	{
+		size_t len = strlen(msg);
+		char* msgStart = msg;
+		for (size_t i = 0; i < len; i++)
+		{
+			if (msg[i] == '\n')
+			{
+				msg[i] = 0;
+				TFE_FrontEndUI::logToConsole(msgStart);
+
+				msgStart = msg + i + 1;
+			}
+		}
+		if (msgStart < msg + len)
+		{
+			TFE_FrontEndUI::logToConsole(msgStart);
+		}
+	}
+
+	void logUpdateConsole()
+	{
+		if (!s_consolePending.load(std::memory_order_acquire) || std::this_thread::get_id() != s_mainThread) { return; }
+
+		std::vector<std::string> lines;
+		{
+			std::unique_lock<std::mutex> lock(s_consoleMutex);
+			lines.swap(s_consoleQueue);
+			s_consolePending.store(false, std::memory_order_relaxed);
+		}
+		for (size_t i = 0; i < lines.size(); i++)
+		{
+			logToConsole(&lines[i][0]);
+		}
+	}
+
 	void debugWrite(const char* tag, const char* str, ...)
 	{
 		if (!tag || !str) { return; }
+		char msgStr[LOG_MAX_LINE];
+		char workStr[LOG_MAX_LINE];
 
 		//Handle the variable input, "printf" style messages
 		va_list arg;
 		va_start(arg, str);
-		vsprintf(s_msgStr, str, arg);
+		vsnprintf(msgStr, LOG_MAX_LINE, str, arg);
 		va_end(arg);
 
-		sprintf(s_workStr, "[%s] %s\r\n", tag, s_msgStr);
-
-		//Write to the debugger or terminal output.
-		#ifdef _WIN32
-			OutputDebugStringA(s_workStr);
-		#else
-			fprintf(stderr, "%s", s_workStr);
-		#endif
+		snprintf(workStr, LOG_MAX_LINE, "[%s] %s\r\n", tag, msgStr);
+		writeOutput(workStr);
 	}
 
 	void logWrite(LogWriteType type, const char* tag, const char* str, ...)
 	{
-		if (type >= LOG_COUNT || !s_logFile.isOpen() || !tag || !str) { return; }
+		if (type >= LOG_COUNT || !s_logOpen.load(std::memory_order_acquire) || !tag || !str) { return; }
+
+		// Critical messages are never rate limited.
+		u32 suppressed = 0;
+		if (type != LOG_CRITICAL && !checkTagRateLimit(tag, &suppressed))
+		{
+			return;
+		}
+
+		char msgStr[LOG_MAX_LINE];
+		char workStr[LOG_MAX_LINE];
+		if (suppressed)
+		{
+			const s32 len = snprintf(workStr, LOG_MAX_LINE, "[Log : Warning] %u messages with tag '%s' were suppressed.\r\n", suppressed, tag);
+			enqueueLine(workStr, u32(len));
+		}
 
 		//Handle the variable input, "printf" style messages
 		va_list arg;
 		va_start(arg, str);
-		vsprintf(s_msgStr, str, arg);
+		vsnprintf(msgStr, LOG_MAX_LINE - 64, str, arg);
 		va_end(arg);
 		//Format the message
+		s32 len;
 		if (type != LOG_MSG)
 		{
-			sprintf(s_workStr, "[%s : %s] %s\r\n", c_typeNames[type], tag, s_msgStr);
+			len = snprintf(workStr, LOG_MAX_LINE, "[%s : %s] %s\r\n", c_typeNames[type], tag, msgStr);
 		}
 		else
 		{
-			sprintf(s_workStr, "[%s] %s\r\n", tag, s_msgStr);
+			len = snprintf(workStr, LOG_MAX_LINE, "[%s] %s\r\n", tag, msgStr);
 		}
-		//Write to disk
-		s_logFile.writeBuffer(s_workStr, (u32)strlen(s_workStr));
-		//Make sure to flush the file to disk if a crash is likely.
-		//if (type == LOG_ERROR || type == LOG_CRITICAL)
+		if (len >= LOG_MAX_LINE)
 		{
-			s_logFile.flush();
+			// Keep the line ending if the message was truncated.
+			len = LOG_MAX_LINE - 1;
+			workStr[len - 2] = '\r';
+			workStr[len - 1] = '\n';
 		}
-		//Write to the debugger or terminal output.
-		#ifdef _WIN32
-			OutputDebugStringA(s_workStr);
-		#else
-			fprintf(stderr, "%s", s_workStr);
-		#endif
-		//Critical log messages also act as asserts in the debugger.
+
+		//Write to disk on the writer thread.
+		enqueueLine(workStr, u32(len));
+		//Critical log messages also act as asserts in the debugger, so make sure they reach the disk first.
 		if (type == LOG_CRITICAL)
 		{
+			logFlush();
 			assert(0);
 		}
-
-		sprintf(s_workStr, "[%s] %s", tag, s_msgStr);
-		size_t len = strlen(s_msgStr);
-		char* msg = s_msgStr;
-		char* msgStart = msg;
-		for (size_t i = 0; i < len; i++)
+		else
 		{
-			if (msg[i] == '\n')
-			{
-				msg[i] = 0;
-				TFE_FrontEndUI::logToConsole(msgStart);
+			s_wakeWriter.notify_one();
+		}
 
-				msgStart = msg + i + 1;
-			}
+		if (std::this_thread::get_id() == s_mainThread)
+		{
+			logUpdateConsole();
+			logToConsole(msgStr);
 		}
-		if (msgStart < s_msgStr + len)
+		else
 		{
-			TFE_FrontEndUI::logToConsole(msgStart);
+			queueConsole(msgStr);
 		}
 	}
 }
@@ -3,6 +3,9 @@
 #include "types.h"
 #include <math.h>
 #include <float.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 namespace TFE_Math
 {
@@ -34,6 +37,29 @@ namespace TFE_Math
 		return l2;
 	}
 
+	// Index of the lowest and highest set bit, x must not be 0.
+	inline u32 findLowestBit(u32 x)
+	{
+	#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, x);
+		return u32(index);
+	#else
+		return u32(__builtin_ctz(x));
+	#endif
+	}
+
+	inline u32 findHighestBit(u32 x)
+	{
+	#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanReverse(&index, x);
+		return u32(index);
+	#else
+		return u32(31 - __builtin_clz(x));
+	#endif
+	}
+
 	inline u32 nextPow2(u32 x)
 	{
 		if (x == 0) { return 0; }
@@ -2,6 +2,8 @@
 
 #include "parser.h"
 #include <algorithm>
+#include <cctype>
+#include <cstdlib>
 
 namespace
 {
@@ -232,3 +234,71 @@ void TFE_Parser::tokenizeLine(const char* line, TokenList& tokens)
 		tokens.push_back(curToken);
 	}
 }
+
+const char* TFE_Parser::scanLiteral(const char* str, const char* literal)
+{
+	while (isspace(u8(*str))) { str++; }
+	for (; *literal; literal++, str++)
+	{
+		if (*str != *literal) { return nullptr; }
+	}
+	return str;
+}
+
+const char* TFE_Parser::scanToken(const char* str, TokenSlice& token)
+{
+	while (isspace(u8(*str))) { str++; }
+	const char* start = str;
+	while (*str && !isspace(u8(*str))) { str++; }
+	if (str == start) { return nullptr; }
+
+	token = { start, s32(str - start) };
+	return str;
+}
+
+const char* TFE_Parser::scanInt(const char* str, s32& value)
+{
+	char* endPtr = nullptr;
+	const s32 result = s32(strtol(str, &endPtr, 10));
+	if (endPtr == str) { return nullptr; }
+
+	value = result;
+	return endPtr;
+}
+
+const char* TFE_Parser::scanFloat(const char* str, f32& value)
+{
+	char* endPtr = nullptr;
+	const f32 result = strtof(str, &endPtr);
+	if (endPtr == str) { return nullptr; }
+
+	value = result;
+	return endPtr;
+}
+
+void TFE_Parser::copyToken(const TokenSlice& token, char* dst, size_t dstSize)
+{
+	if (!dstSize) { return; }
+	const size_t len = std::min(size_t(token.len), dstSize - 1);
+	memcpy(dst, token.str, len);
+	dst[len] = 0;
+}
+
+s32 TFE_Parser::scanArgs(const char* line, char** args, s32 argCount, size_t argSize)
+{
+	s32 count = 0;
+	TokenSlice token;
+	for (; count < argCount; count++)
+	{
+		line = scanToken(line, token);
+		if (!line) { break; }
+		copyToken(token, args[count], argSize);
+	}
+
+	if (count == 0 && argCount > 0)
+	{
+		args[0][0] = 0;
+		return -1;
+	}
+	return count;
+}
@@ -10,6 +10,13 @@
 
 typedef std::vector<std::string> TokenList;
 
+// A token that points into the source line, it is not null terminated.
+struct TokenSlice
+{
+	const char* str;
+	s32 len;
+};
+
 class TFE_Parser
 {
 public:
@@ -36,6 +43,19 @@ public:
 	// Note strings with spaces still work, they need to be closed in quotes, which are removed upon tokenizing.
 	void tokenizeLine(const char* line, TokenList& tokens);
 
+	// Zero allocation scanning that matches the sscanf() behavior relied on by the Dark Forces parsers:
+	// whitespace is skipped before each item and literals are matched exactly.
+	// Each function returns the position after the item that was read or nullptr on failure.
+	static const char* scanLiteral(const char* str, const char* literal);
+	static const char* scanToken(const char* str, TokenSlice& token);	// %s
+	static const char* scanInt(const char* str, s32& value);			// %d
+	static const char* scanFloat(const char* str, f32& value);			// %f
+	// Copy a token as a null terminated string, truncating it to fit 'dstSize'.
+	static void copyToken(const TokenSlice& token, char* dst, size_t dstSize);
+	// Equivalent to sscanf(line, " %s %s ...", args[0], args[1], ...) but tokens are truncated to 'argSize'.
+	// Returns the number of tokens read or -1 if the line is empty, in which case args[0] is cleared.
+	static s32 scanArgs(const char* line, char** args, s32 argCount, size_t argSize);
+
 private:
 	const char* m_buffer;
 	size_t m_bufferLen;
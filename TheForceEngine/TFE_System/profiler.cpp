@@ -1,26 +1,44 @@
 #include <cstring>
 
 #include "profiler.h"
+#include <TFE_FileSystem/filestream.h>
 #include <assert.h>
 #include <algorithm>
 #include <vector>
 #include <string>
 #include <map>
+#include <mutex>
 
 // TODO: Support call "paths" - with seperate time per path.
 
 namespace TFE_Profiler
 {
-	#define ZONE_BUFFER_COUNT 2
-	#define MAX_ZONE_STACK 256
-	
+	enum ProfilerConstants
+	{
+		ZONE_BUFFER_COUNT = 2,
+		MAX_ZONES = 1024,
+		MAX_ZONE_STACK = 256,
+		MAX_THREADS = 32,
+		// Per-thread ring buffer size, must be a power of 2.
+		THREAD_EVENT_COUNT = 16384,
+		THREAD_EVENT_MASK = THREAD_EVENT_COUNT - 1,
+	};
+
+	// Binary capture layout (little endian):
+	//   u32 magic ('TFPF'), u32 version, f64 seconds per tick,
+	//   u32 zoneCount,   per zone: u8 nameLen, name, u8 funcLen, func, u32 lineNumber
+	//   u32 threadCount, per thread: u8 nameLen, name
+	//   u32 eventCount,  per event: u32 zoneId (NULL_ZONE = frame), u32 thread, u64 startTick, u64 endTick
+	static const u32 c_captureMagic = 0x46504654;	// "TFPF"
+	static const u32 c_captureVersion = 1;
+
 	struct Zone
 	{
 		u32  id;
 		u32  level = 0;
 		u32  parent = NULL_ZONE;
-		u64  path;
 		u64  frame;
+		u64  rootFrame;
 		char name[64];
 		char func[64];
 		u32  lineNumber;
@@ -42,16 +60,66 @@ namespace TFE_Profiler
 		char name[64];
 	};
 
+	// A completed zone.
+	struct ZoneEvent
+	{
+		u32 id;
+		u32 parent;
+		u32 level;
+		u64 start;
+		u64 end;
+	};
+
+	// Single producer (the owning thread), single consumer (frameEnd() on the main thread).
+	struct ThreadBuffer
+	{
+		atomic_bool inUse;
+		atomic_u32  writeIndex;
+		atomic_u32  readIndex;
+		atomic_u32  dropped;
+		ZoneEvent*  events;
+		char name[64];
+
+		// Only accessed by the owning thread.
+		u32 level;
+		u32 stack[MAX_ZONE_STACK];
+	};
+
+	// Releases the buffer when the thread exits, so it can be reused by a new thread.
+	struct ThreadHandle
+	{
+		ThreadBuffer* buffer = nullptr;
+		~ThreadHandle()
+		{
+			if (buffer) { buffer->inUse.store(false, std::memory_order_release); }
+		}
+	};
+
+	struct CaptureEvent
+	{
+		u32 id;
+		u32 thread;
+		u64 start;
+		u64 end;
+	};
+
 	typedef std::map<std::string, u32> ZoneMap;
-	typedef std::vector<Zone> ZoneList;
 	typedef std::vector<u32> SortedZoneList;
 	typedef std::vector<Counter> CounterList;
+	typedef std::vector<CaptureEvent> CaptureList;
 
+	// Zones are stored in a fixed array so that registering a zone on another thread never moves existing zones.
+	static Zone s_zoneList[MAX_ZONES];
+	static atomic_u32 s_zoneCount(0);
 	static ZoneMap  s_zoneMap;
-	static ZoneList s_zoneList;
 	static SortedZoneList s_sortedZoneList;
 	static SortedZoneList s_roots;
 
+	static ThreadBuffer s_threads[MAX_THREADS];
+	static atomic_u32 s_threadCount(0);
+	static thread_local ThreadHandle t_thread;
+	static std::mutex s_mutex;
+
 	static ZoneMap  s_counterMap;
 	static CounterList s_counterList;
 
@@ -59,11 +127,70 @@ namespace TFE_Profiler
 	static f64 s_frameTime;
 	static u32 s_readBuffer = 0;
 	static u32 s_writeBuffer = 1;
-	static u32 s_level;
-	static u32 s_maxLevel;
-	static u32 s_zoneStack[MAX_ZONE_STACK];
 	static u64 s_currentFrame = 1;
-	static u64 s_currentPath;
+	static u32 s_droppedEvents = 0;
+
+	// Capture
+	static CaptureList s_capture;
+	static std::string s_capturePath;
+	static TFE_CaptureFormat s_captureFormat = CAPTURE_TRACE_JSON;
+	static u32  s_captureRequest = 0;
+	static u32  s_captureFramesLeft = 0;
+	static u64  s_captureStart = 0;
+
+	void writeCapture();
+
+	ThreadBuffer* acquireThreadBuffer()
+	{
+		std::unique_lock<std::mutex> lock(s_mutex);
+		const u32 threadCount = s_threadCount.load(std::memory_order_relaxed);
+		for (u32 i = 0; i < threadCount; i++)
+		{
+			bool expected = false;
+			if (s_threads[i].inUse.compare_exchange_strong(expected, true))
+			{
+				ThreadBuffer* buffer = &s_threads[i];
+				buffer->level = 0;
+				sprintf(buffer->name, "Thread %u", i);
+				return buffer;
+			}
+		}
+		if (threadCount >= MAX_THREADS)
+		{
+			return nullptr;
+		}
+
+		ThreadBuffer* buffer = &s_threads[threadCount];
+		buffer->events = new ZoneEvent[THREAD_EVENT_COUNT];
+		buffer->writeIndex.store(0, std::memory_order_relaxed);
+		buffer->readIndex.store(0, std::memory_order_relaxed);
+		buffer->dropped.store(0, std::memory_order_relaxed);
+		buffer->inUse.store(true, std::memory_order_relaxed);
+		buffer->level = 0;
+		sprintf(buffer->name, "Thread %u", threadCount);
+		s_threadCount.store(threadCount + 1, std::memory_order_release);
+		return buffer;
+	}
+
+	ThreadBuffer* getThreadBuffer()
+	{
+		if (!t_thread.buffer)
+		{
+			t_thread.buffer = acquireThreadBuffer();
+		}
+		return t_thread.buffer;
+	}
+
+	void setThreadName(const char* name)
+	{
+		ThreadBuffer* buffer = getThreadBuffer();
+		// Only the owning thread changes the name, so it can be compared without locking.
+		if (!buffer || strncmp(buffer->name, name, 63) == 0) { return; }
+
+		std::unique_lock<std::mutex> lock(s_mutex);
+		strncpy(buffer->name, name, 63);
+		buffer->name[63] = 0;
+	}
 
 	void addZoneChild(u32 parentId, u32 zoneId)
 	{
@@ -102,62 +229,87 @@ namespace TFE_Profiler
 		}
 	}
 
-	u32 beginZone(const char* name, const char* func, u32 lineNumber)
+	u32 registerZone(const char* name, const char* func, u32 lineNumber)
 	{
+		std::unique_lock<std::mutex> lock(s_mutex);
 		ZoneMap::iterator iZone = s_zoneMap.find(name);
-		u32 id = 0;
-
-		if (iZone == s_zoneMap.end())
+		if (iZone != s_zoneMap.end())
 		{
-			id = (u32)s_zoneList.size();
-
-			Zone zone;
-			zone.id = id;
-			zone.path = s_currentPath;
-			zone.timeInZone[s_readBuffer]  = 0;
-			zone.timeInZone[s_writeBuffer] = 0;
-			zone.timeInZoneAve = 0.0;
-			zone.fractOfParentAve = 0.0;
-			zone.frame = 0;
-			
-			s_zoneList.push_back(zone);
-			s_zoneMap[name] = id;
+			return iZone->second;
 		}
-		else
+
+		const u32 id = s_zoneCount.load(std::memory_order_relaxed);
+		if (id >= MAX_ZONES)
 		{
-			id = iZone->second;
+			return NULL_ZONE;
 		}
 
 		Zone& zone = s_zoneList[id];
-		strcpy(zone.name, name);
-		strcpy(zone.func, func);
+		zone.id = id;
+		zone.level = 0;
+		zone.parent = NULL_ZONE;
+		zone.timeInZone[s_readBuffer]  = 0;
+		zone.timeInZone[s_writeBuffer] = 0;
+		zone.timeInZoneAve = 0.0;
+		zone.fractOfParentAve = 0.0;
+		zone.frame = 0;
+		zone.rootFrame = 0;
+		zone.child = NULL_ZONE;
+		zone.sibling = NULL_ZONE;
+		strncpy(zone.name, name, 63);
+		strncpy(zone.func, func, 63);
+		zone.name[63] = 0;
+		zone.func[63] = 0;
 		zone.lineNumber = lineNumber;
-		zone.level = s_level;
 
-		zone.parent = s_level > 0 ? s_zoneStack[s_level - 1] : NULL_ZONE;
-		if (zone.parent == NULL_ZONE)
-		{
-			s_roots.push_back(id);
-		}
-		else
+		s_zoneMap[name] = id;
+		s_zoneCount.store(id + 1, std::memory_order_release);
+		return id;
+	}
+
+	u64 beginZone(u32 id)
+	{
+		ThreadBuffer* buffer = getThreadBuffer();
+		if (buffer)
 		{
-			addZoneChild(zone.parent, zone.id);
+			if (buffer->level < MAX_ZONE_STACK)
+			{
+				buffer->stack[buffer->level] = id;
+			}
+			buffer->level++;
 		}
-
-		s_zoneStack[s_level] = id;
-		s_level++;
-
-		return id;
+		return TFE_System::getCurrentTimeInTicks();
 	}
 
-	void endZone(u32 id, u64 dt)
+	void endZone(u32 id, u64 startTime)
 	{
-		s_zoneList[id].timeInZone[s_writeBuffer] += TFE_System::convertFromTicksToSeconds(dt);
-		s_level--;
+		const u64 endTime = TFE_System::getCurrentTimeInTicks();
+		ThreadBuffer* buffer = t_thread.buffer;
+		if (!buffer || !buffer->level) { return; }
+
+		buffer->level--;
+		if (id == NULL_ZONE) { return; }
+
+		const u32 level = buffer->level;
+		const u32 writeIndex = buffer->writeIndex.load(std::memory_order_relaxed);
+		if (writeIndex - buffer->readIndex.load(std::memory_order_acquire) >= THREAD_EVENT_COUNT)
+		{
+			buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		ZoneEvent* zoneEvent = &buffer->events[writeIndex & THREAD_EVENT_MASK];
+		zoneEvent->id = id;
+		zoneEvent->parent = (level > 0 && level <= MAX_ZONE_STACK) ? buffer->stack[level - 1] : NULL_ZONE;
+		zoneEvent->level = level;
+		zoneEvent->start = startTime;
+		zoneEvent->end = endTime;
+		buffer->writeIndex.store(writeIndex + 1, std::memory_order_release);
 	}
 
 	void addCounter(const char* name, s32* counter)
 	{
+		std::unique_lock<std::mutex> lock(s_mutex);
 		ZoneMap::iterator iCounter = s_counterMap.find(name);
 		if (iCounter == s_counterMap.end())
 		{
@@ -174,29 +326,98 @@ namespace TFE_Profiler
 		}
 	}
 
+	bool captureFrames(u32 frameCount, const char* path, TFE_CaptureFormat format)
+	{
+		if (!frameCount || !path || s_captureFramesLeft || s_captureRequest)
+		{
+			return false;
+		}
+		s_capturePath = path;
+		s_captureFormat = format;
+		s_captureRequest = frameCount;
+		return true;
+	}
+
+	bool isCapturing()
+	{
+		return s_captureRequest || s_captureFramesLeft;
+	}
+
 	void frameBegin()
 	{
 		std::swap(s_readBuffer, s_writeBuffer);
-		s_level = 0;
-		s_maxLevel = 0;
 		s_roots.clear();
 
 		// Swap buffers, s_readBuffer is safe to read in the middle of the next frame.
-		const size_t zoneCount = s_zoneList.size();
-		for (size_t i = 0; i < zoneCount; i++)
+		const u32 zoneCount = s_zoneCount.load(std::memory_order_acquire);
+		for (u32 i = 0; i < zoneCount; i++)
 		{
 			s_zoneList[i].timeInZone[s_writeBuffer] = 0;
 		}
 
 		// Copy counter values from the frame, so that the results can be used
 	    // in the middle of the next frame.
-		const size_t counterCount = s_counterList.size();
-		for (size_t i = 0; i < counterCount; i++)
 		{
-			s_counterList[i].prevValue = *s_counterList[i].ptr;
+			std::unique_lock<std::mutex> lock(s_mutex);
+			const size_t counterCount = s_counterList.size();
+			for (size_t i = 0; i < counterCount; i++)
+			{
+				s_counterList[i].prevValue = *s_counterList[i].ptr;
+			}
+		}
+
+		if (!t_thread.buffer)
+		{
+			setThreadName("Main Thread");
 		}
 
 		s_frameBegin = TFE_System::getCurrentTimeInTicks();
+		if (s_captureRequest)
+		{
+			s_capture.clear();
+			s_captureFramesLeft = s_captureRequest;
+			s_captureRequest = 0;
+			s_captureStart = s_frameBegin;
+		}
+	}
+
+	// Read the completed zones from every thread.
+	void readThreadEvents()
+	{
+		const u32 threadCount = s_threadCount.load(std::memory_order_acquire);
+		for (u32 t = 0; t < threadCount; t++)
+		{
+			ThreadBuffer* buffer = &s_threads[t];
+			const u32 writeIndex = buffer->writeIndex.load(std::memory_order_acquire);
+			u32 readIndex = buffer->readIndex.load(std::memory_order_relaxed);
+			for (; readIndex != writeIndex; readIndex++)
+			{
+				const ZoneEvent* zoneEvent = &buffer->events[readIndex & THREAD_EVENT_MASK];
+				Zone& zone = s_zoneList[zoneEvent->id];
+				zone.timeInZone[s_writeBuffer] += TFE_System::convertFromTicksToSeconds(zoneEvent->end - zoneEvent->start);
+				zone.level = zoneEvent->level;
+				zone.parent = zoneEvent->parent;
+				if (zone.parent == NULL_ZONE)
+				{
+					if (zone.rootFrame != s_currentFrame)
+					{
+						zone.rootFrame = s_currentFrame;
+						s_roots.push_back(zone.id);
+					}
+				}
+				else if (zone.parent != zone.id)
+				{
+					addZoneChild(zone.parent, zone.id);
+				}
+
+				if (s_captureFramesLeft && zoneEvent->start >= s_captureStart)
+				{
+					s_capture.push_back({ zoneEvent->id, t, zoneEvent->start, zoneEvent->end });
+				}
+			}
+			buffer->readIndex.store(readIndex, std::memory_order_release);
+			s_droppedEvents += buffer->dropped.exchange(0, std::memory_order_relaxed);
+		}
 	}
 
 	void traverseZoneTree(u32 id)
@@ -209,7 +430,7 @@ namespace TFE_Profiler
 			s_sortedZoneList.push_back(id);
 		}
 		zone->frame = s_currentFrame;
-		
+
 		while (zone->child != NULL_ZONE)
 		{
 			traverseZoneTree(zone->child);
@@ -226,8 +447,11 @@ namespace TFE_Profiler
 
 	void frameEnd()
 	{
-		s_frameTime = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - s_frameBegin);
-		const size_t zoneCount = s_zoneList.size();
+		const u64 frameEndTime = TFE_System::getCurrentTimeInTicks();
+		s_frameTime = TFE_System::convertFromTicksToSeconds(frameEndTime - s_frameBegin);
+		readThreadEvents();
+
+		const u32 zoneCount = s_zoneCount.load(std::memory_order_acquire);
 		const f64 expBlend = 0.99;
 
 		// Sort Zones
@@ -239,13 +463,13 @@ namespace TFE_Profiler
 		}
 
 		// First compute delta times for each zone.
-		for (size_t i = 0; i < zoneCount; i++)
+		for (u32 i = 0; i < zoneCount; i++)
 		{
 			s_zoneList[i].timeInZoneAve = expBlend * s_zoneList[i].timeInZoneAve + (1.0 - expBlend)*s_zoneList[i].timeInZone[s_writeBuffer];
 		}
 
 		// Then handle percentage of parent and clear
-		for (size_t i = 0; i < zoneCount; i++)
+		for (u32 i = 0; i < zoneCount; i++)
 		{
 			f64 parentTime = (s_zoneList[i].parent != NULL_ZONE) ? s_zoneList[s_zoneList[i].parent].timeInZone[s_writeBuffer] : s_frameTime;
 			s_zoneList[i].fractOfParentAve = expBlend * s_zoneList[i].fractOfParentAve + (1.0 - expBlend)*s_zoneList[i].timeInZone[s_writeBuffer] / parentTime;
@@ -260,6 +484,17 @@ namespace TFE_Profiler
 			s_zoneList[i].sibling = NULL_ZONE;
 		}
 
+		if (s_captureFramesLeft)
+		{
+			const u32 mainThread = t_thread.buffer ? u32(t_thread.buffer - s_threads) : 0;
+			s_capture.push_back({ NULL_ZONE, mainThread, s_frameBegin, frameEndTime });
+			s_captureFramesLeft--;
+			if (!s_captureFramesLeft)
+			{
+				writeCapture();
+			}
+		}
+
 		s_currentFrame++;
 	}
 
@@ -301,4 +536,111 @@ namespace TFE_Profiler
 		info->name = counter.name;
 		info->value = counter.prevValue;
 	}
+
+	u32 getDroppedEventCount()
+	{
+		return s_droppedEvents;
+	}
+
+	////////////////////////////////////////////////
+	// Capture output
+	////////////////////////////////////////////////
+	void writeShortString(FileStream* file, const char* str)
+	{
+		const u8 len = u8(std::min(strlen(str), size_t(255)));
+		file->write(&len);
+		file->writeBuffer(str, len);
+	}
+
+	void writeCaptureBinary(FileStream* file, u32 zoneCount, u32 threadCount)
+	{
+		const f64 secondsPerTick = TFE_System::convertFromTicksToSeconds(1);
+		file->write(&c_captureMagic);
+		file->write(&c_captureVersion);
+		file->write(&secondsPerTick);
+
+		file->write(&zoneCount);
+		for (u32 i = 0; i < zoneCount; i++)
+		{
+			writeShortString(file, s_zoneList[i].name);
+			writeShortString(file, s_zoneList[i].func);
+			file->write(&s_zoneList[i].lineNumber);
+		}
+
+		file->write(&threadCount);
+		for (u32 i = 0; i < threadCount; i++)
+		{
+			writeShortString(file, s_threads[i].name);
+		}
+
+		const u32 eventCount = (u32)s_capture.size();
+		file->write(&eventCount);
+		for (u32 i = 0; i < eventCount; i++)
+		{
+			file->write(&s_capture[i].id);
+			file->write(&s_capture[i].thread);
+			file->write(&s_capture[i].start);
+			file->write(&s_capture[i].end);
+		}
+	}
+
+	void writeCaptureJson(FileStream* file, u32 threadCount)
+	{
+		file->writeString("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		for (u32 i = 0; i < threadCount; i++)
+		{
+			file->writeString("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}},\n", i, s_threads[i].name);
+		}
+
+		const size_t eventCount = s_capture.size();
+		for (size_t i = 0; i < eventCount; i++)
+		{
+			const CaptureEvent& captureEvent = s_capture[i];
+			const f64 start = 1000000.0 * TFE_System::convertFromTicksToSeconds(captureEvent.start - s_captureStart);
+			const f64 duration = 1000000.0 * TFE_System::convertFromTicksToSeconds(captureEvent.end - captureEvent.start);
+			const char* separator = (i + 1 < eventCount) ? "," : "";
+			if (captureEvent.id == NULL_ZONE)
+			{
+				file->writeString("{\"name\":\"Frame\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+					captureEvent.thread, start, duration, separator);
+			}
+			else
+			{
+				const Zone& zone = s_zoneList[captureEvent.id];
+				file->writeString("{\"name\":\"%s\",\"cat\":\"zone\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"func\":\"%s\",\"line\":%u}}%s\n",
+					zone.name, captureEvent.thread, start, duration, zone.func, zone.lineNumber, separator);
+			}
+		}
+		file->writeString("]}\n");
+	}
+
+	void writeCapture()
+	{
+		FileStream file;
+		if (!file.open(s_capturePath.c_str(), Stream::MODE_WRITE))
+		{
+			TFE_System::logWrite(LOG_ERROR, "Profiler", "Cannot write capture '%s'.", s_capturePath.c_str());
+			s_capture.clear();
+			return;
+		}
+
+		const u32 zoneCount = s_zoneCount.load(std::memory_order_acquire);
+		const u32 threadCount = s_threadCount.load(std::memory_order_acquire);
+		{
+			// Thread names can be changed on other threads.
+			std::unique_lock<std::mutex> lock(s_mutex);
+			if (s_captureFormat == CAPTURE_BINARY)
+			{
+				writeCaptureBinary(&file, zoneCount, threadCount);
+			}
+			else
+			{
+				writeCaptureJson(&file, threadCount);
+			}
+		}
+		file.close();
+
+		TFE_System::logWrite(LOG_MSG, "Profiler", "Wrote %u profiler events to '%s'.", (u32)s_capture.size(), s_capturePath.c_str());
+		s_capture.clear();
+	}
 }
@@ -3,7 +3,9 @@
 // The Force Engine Profiler
 // Simple "zone" based profiler.
 // Add TFE_PROFILE_ENABLED to preprocessor defines in the build to enable.
-// Currently does not respect the call path, that is TODO.
+// Zones can be used from any thread, each thread writes completed zones
+// into its own lock-free ring buffer which is read on the main thread
+// in frameEnd(). Zones with the same name are combined.
 //////////////////////////////////////////////////////////////////////
 
 #include "types.h"
@@ -14,12 +16,16 @@
 #define TOKENPASTE(x, y) x ## y
 #define TOKENPASTE2(x, y) TOKENPASTE(x, y)
 #ifdef  TFE_PROFILE_ENABLED
-#define TFE_ZONE(name)  TFE_Profiler_Zone TOKENPASTE2(__localZone, __LINE__)(name, __FUNCTION__, __LINE__)
-#define TFE_ZONE_BEGIN(varName, name)  TFE_Profiler_ZoneManual varName(name, __FUNCTION__, __LINE__)
+// Each zone is registered once per call site, entering and leaving a zone only reads the clock and writes to a per-thread buffer.
+#define TFE_ZONE(name)  static const u32 TOKENPASTE2(__localZoneId, __LINE__) = TFE_Profiler::registerZone(name, __FUNCTION__, __LINE__); \
+	TFE_Profiler_Zone TOKENPASTE2(__localZone, __LINE__)(TOKENPASTE2(__localZoneId, __LINE__))
+#define TFE_ZONE_BEGIN(varName, name)  static const u32 TOKENPASTE2(varName, ZoneId) = TFE_Profiler::registerZone(name, __FUNCTION__, __LINE__); \
+	TFE_Profiler_ZoneManual varName(TOKENPASTE2(varName, ZoneId))
 #define TFE_ZONE_END(varName)  varName.end()
 #define TFE_FRAME_BEGIN() TFE_Profiler::frameBegin()
 #define TFE_FRAME_END() TFE_Profiler::frameEnd()
 #define TFE_COUNTER(varName, name) TFE_Profiler::addCounter(name, &varName)
+#define TFE_THREAD_NAME(name) TFE_Profiler::setThreadName(name)
 #else
 #define TFE_ZONE(name)
 #define TFE_ZONE_BEGIN(varName, name)
@@ -27,6 +33,7 @@
 #define TFE_FRAME_BEGIN()
 #define TFE_FRAME_END()
 #define TFE_COUNTER(varName, name)
+#define TFE_THREAD_NAME(name)
 #endif
 
 #define NULL_ZONE 0xffffffff
@@ -50,17 +57,32 @@ struct TFE_CounterInfo
 	s32   value;
 };
 
+enum TFE_CaptureFormat
+{
+	CAPTURE_TRACE_JSON = 0,	// Chrome trace event JSON, can be opened in chrome://tracing or Perfetto.
+	CAPTURE_BINARY,			// Compact binary capture, see profiler.cpp for the layout.
+};
+
 namespace TFE_Profiler
 {
 	// The main profiling API is used through Macros which can be disabled based on build flags.
-	u32  beginZone(const char* name, const char* func, u32 lineNumber);
-	void endZone(u32 id, u64 dt);
+	// Zones with the same name share an ID, registerZone() is thread safe.
+	u32  registerZone(const char* name, const char* func, u32 lineNumber);
+	// Returns the start time, which is passed back to endZone().
+	u64  beginZone(u32 id);
+	void endZone(u32 id, u64 startTime);
+	// Name the calling thread in captures.
+	void setThreadName(const char* name);
 		
 	void frameBegin();
 	void frameEnd();
 
 	void addCounter(const char* name, s32* counter);
 
+	// Capture every zone, from all threads, for the next 'frameCount' frames and write them to 'path' when done.
+	bool captureFrames(u32 frameCount, const char* path, TFE_CaptureFormat format);
+	bool isCapturing();
+
 	// Profile data API, this is used directly.
 	f64  getTimeInFrame();
 
@@ -69,43 +91,43 @@ namespace TFE_Profiler
 	
 	u32  getCounterCount();
 	void getCounterInfo(u32 index, TFE_CounterInfo* info);
+	// Zone events lost because a thread buffer was full.
+	u32  getDroppedEventCount();
 }
 
 class TFE_Profiler_Zone
 {
 public:
-	TFE_Profiler_Zone(const char* name, const char* func, u32 lineNumber)
+	TFE_Profiler_Zone(u32 id)
 	{
-		m_time = TFE_System::getCurrentTimeInTicks();
-		m_id = TFE_Profiler::beginZone(name, func, lineNumber);
+		m_id = id;
+		m_time = TFE_Profiler::beginZone(id);
 	}
 
 	~TFE_Profiler_Zone()
 	{
-		const u64 deltaTime = TFE_System::getCurrentTimeInTicks() - m_time;
-		TFE_Profiler::endZone(m_id, deltaTime);
+		TFE_Profiler::endZone(m_id, m_time);
 	}
 private:
 	u64 m_time;
-	s32 m_id;
+	u32 m_id;
 };
 
 class TFE_Profiler_ZoneManual
 {
 public:
-	TFE_Profiler_ZoneManual(const char* name, const char* func, u32 lineNumber)
+	TFE_Profiler_ZoneManual(u32 id)
 	{
-		m_time = TFE_System::getCurrentTimeInTicks();
-		m_id = TFE_Profiler::beginZone(name, func, lineNumber);
+		m_id = id;
+		m_time = TFE_Profiler::beginZone(id);
 	}
 
 	void end()
 	{
-		const u64 deltaTime = TFE_System::getCurrentTimeInTicks() - m_time;
-		TFE_Profiler::endZone(m_id, deltaTime);
+		TFE_Profiler::endZone(m_id, m_time);
 	}
 private:
 	u64 m_time;
-	s32 m_id;
+	u32 m_id;
 };
 #endif
@@ -43,6 +43,9 @@ namespace TFE_System
 	static bool s_systemUiRequestPosted = false;
 
 	static s32 s_missedFrameCount = 0;
+	static f64 s_fixedTimeStep = 0.0;
+	static f64 s_fixedTime = 0.0;
+	static bool s_frameTimeOverride = false;
 
 	static char s_versionString[64];
 
@@ -104,6 +107,15 @@ namespace TFE_System
 
 	void update()
 	{
+		logUpdateConsole();
+		if (s_fixedTimeStep > 0.0)
+		{
+			s_fixedTime += s_fixedTimeStep;
+			s_dt = s_fixedTimeStep;
+			s_dtRaw = s_fixedTimeStep;
+			return;
+		}
+
 		// This assumes that SDL_GetPerformanceCounter() is monotonic.
 		// However if errors do occur, the dt clamp later should limit the side effects.
 		const u64 curTime = SDL_GetPerformanceCounter();
@@ -170,10 +182,30 @@ namespace TFE_System
 	// Get time since "start time"
 	f64 getTime()
 	{
+		if (s_fixedTimeStep > 0.0 || s_frameTimeOverride) { return s_fixedTime; }
 		const u64 uDt = s_time - s_startTime;
 		return f64(uDt) * s_freq;
 	}
 	
+	void setFixedTimeStep(f64 step)
+	{
+		s_fixedTimeStep = step;
+		s_fixedTime = 0.0;
+	}
+
+	void overrideFrameTime(f64 time, f64 dt)
+	{
+		s_frameTimeOverride = true;
+		s_fixedTime = time;
+		s_dt = dt;
+		s_dtRaw = dt;
+	}
+
+	void clearFrameTimeOverride()
+	{
+		s_frameTimeOverride = false;
+	}
+
 	u64 getCurrentTimeInTicks()
 	{
 		return SDL_GetPerformanceCounter() - s_startTime;
@@ -245,6 +277,19 @@ namespace TFE_System
 	}
 #endif
 
+	u32 getCpuFeatures()
+	{
+		static u32 s_cpuFeatures = 0xffffffff;
+		if (s_cpuFeatures == 0xffffffff)
+		{
+			s_cpuFeatures = 0;
+			if (SDL_HasSSE2()) { s_cpuFeatures |= CPU_FEATURE_SSE2; }
+			if (SDL_HasAVX2()) { s_cpuFeatures |= CPU_FEATURE_AVX2; }
+			if (SDL_HasNEON()) { s_cpuFeatures |= CPU_FEATURE_NEON; }
+		}
+		return s_cpuFeatures;
+	}
+
 	void postQuitMessage()
 	{
 		s_quitMessagePosted = true;
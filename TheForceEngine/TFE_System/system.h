@@ -11,6 +11,14 @@
 #define TFE_MINOR_VERSION 2
 #define TFE_BUILD_VERSION 1
 
+// CPU features that may be used by SIMD code paths, see getCpuFeatures().
+enum CpuFeature
+{
+	CPU_FEATURE_SSE2 = (1 << 0),
+	CPU_FEATURE_AVX2 = (1 << 1),
+	CPU_FEATURE_NEON = (1 << 2),
+};
+
 enum LogWriteType
 {
 	LOG_MSG = 0,
@@ -39,6 +47,13 @@ namespace TFE_System
 	f64 getDeltaTimeRaw();
 	// Get the absolute time since the last start time.
 	f64 getTime();
+	// Advance time by a fixed step in update() rather than reading the system clock, so runs are repeatable.
+	// A step of 0 switches back to the system clock.
+	void setFixedTimeStep(f64 step);
+	// Override the time and delta time reported for the current frame, used to play back recorded frames.
+	// The override stays in effect until clearFrameTimeOverride() is called.
+	void overrideFrameTime(f64 time, f64 dt);
+	void clearFrameTimeOverride();
 
 	u64 getCurrentTimeInTicks();
 	f64 convertFromTicksToSeconds(u64 ticks);
@@ -49,7 +64,11 @@ namespace TFE_System
 	// Log
 	bool logOpen(const char* filename);
 	void logClose();
+	// Messages are written to disk on a background thread, logFlush() writes all pending messages immediately.
 	void logWrite(LogWriteType type, const char* tag, const char* str, ...);
+	void logFlush();
+	// Forwards messages logged from other threads to the console, called from the main thread.
+	void logUpdateConsole();
 
 	// Lighter weight debug output (only useful when running in a terminal or debugger).
 	void debugWrite(const char* tag, const char* str, ...);
@@ -57,6 +76,8 @@ namespace TFE_System
 	// System
 	bool osShellExecute(const char* pathToExe, const char* exeDir, const char* param, bool waitForCompletion);
 	void sleep(u32 sleepDeltaMS);
+	// Returns the CpuFeature flags supported by the current CPU.
+	u32  getCpuFeatures();
 
 	void postQuitMessage();
 	bool quitMessagePosted();
@@ -7,6 +7,7 @@
 #include <TFE_Archive/gobArchive.h>
 #include <TFE_Game/igame.h>
 #include <TFE_Game/saveSystem.h>
+#include <TFE_Game/replaySystem.h>
 #include <TFE_Game/reticle.h>
 #include <TFE_Jedi/InfSystem/infSystem.h>
 //#include <TFE_Editor/editor.h>
@@ -20,8 +21,13 @@
 #include <TFE_System/system.h>
 #include <TFE_System/CrashHandler/crashHandler.h>
 #include <TFE_System/frameLimiter.h>
+#include <TFE_System/jobSystem.h>
 #include <TFE_System/tfeMessage.h>
 #include <TFE_Jedi/Task/task.h>
+#include <TFE_Jedi/Renderer/jediRenderer.h>
+#include <TFE_Jedi/Renderer/virtualFramebuffer.h>
+#include <TFE_DarkForces/time.h>
+#include <TFE_FileSystem/filestream.h>
 #include <TFE_RenderShared/texturePacker.h>
 #include <TFE_Asset/paletteAsset.h>
 #include <TFE_Asset/imageAsset.h>
@@ -73,8 +79,23 @@ static s32  s_startupGame = -1;
 static IGame* s_curGame = nullptr;
 static const char* s_loadRequestFilename = nullptr;
 
+// Headless mode, see runHeadless().
+static bool s_headless = false;
+static bool s_headlessRender = false;
+static const char* s_headlessLevel = nullptr;
+static u32  s_headlessTicks = TICKS_PER_SECOND * 60;
+static u32  s_headlessCaptureInterval = 0;
+static char s_headlessOutputDir[TFE_MAX_PATH] = "";
+static std::vector<u32> s_headlessImage;
+static char s_headlessReplayLevel[TFE_ReplaySystem::REPLAY_MAX_LEVEL_NAME];
+
+// Input recording and replay.
+static const char* s_replayRecordPath = nullptr;
+static const char* s_replayPlayPath = nullptr;
+
 void parseOption(const char* name, const std::vector<const char*>& values, bool longName);
 bool validatePath();
+s32  runHeadless();
 
 void handleEvent(SDL_Event& Event)
 {
@@ -299,6 +320,28 @@ bool sdlInit()
 static AppState s_curState = APP_STATE_UNINIT;
 static bool s_soundPaused = false;
 
+// Start recording or playing back input once the game is running, if requested on the command line.
+void startReplay(int argc, char* argv[])
+{
+	if (s_replayPlayPath)
+	{
+		TFE_ReplaySystem::startPlayback(s_replayPlayPath, s_curGame);
+	}
+	else if (s_replayRecordPath)
+	{
+		// The level is passed to the game as -l<name>, store it so the replay can be started in the same level.
+		const char* levelName = nullptr;
+		for (s32 i = 1; i < argc; i++)
+		{
+			if (argv[i][0] == '-' && (argv[i][1] == 'l' || argv[i][1] == 'L') && argv[i][2])
+			{
+				levelName = &argv[i][2];
+			}
+		}
+		TFE_ReplaySystem::startRecording(s_replayRecordPath, s_curGame, levelName);
+	}
+}
+
 void setAppState(AppState newState, int argc, char* argv[])
 {
 	const TFE_Settings_Graphics* config = TFE_Settings::getGraphicsSettings();
@@ -392,6 +435,7 @@ void setAppState(AppState newState, int argc, char* argv[])
 				else
 				{
 					TFE_Input::enableRelativeMode(true);
+					startReplay(argc, argv);
 				}
 			}
 		}
@@ -507,6 +551,225 @@ bool validatePath()
 	return TFE_Paths::hasPath(PATH_SOURCE_DATA);
 }
 
+void headless_writeFrame(u32 tick)
+{
+	u32 width, height;
+	TFE_Jedi::vfb_getResolution(&width, &height);
+	const u8* framebuffer = TFE_Jedi::vfb_getCpuBuffer();
+	if (!framebuffer || !width || !height) { return; }
+
+	const u32* palette = TFE_Jedi::vfb_getPalette();
+	s_headlessImage.resize(width * height);
+	for (u32 i = 0; i < width * height; i++)
+	{
+		s_headlessImage[i] = palette[framebuffer[i]];
+	}
+
+	char imagePath[TFE_MAX_PATH];
+	sprintf(imagePath, "%sframe_%06u.png", s_headlessOutputDir, tick);
+	TFE_Image::writeImage(imagePath, width, height, s_headlessImage.data());
+}
+
+void headless_writeSummary(u32 tickCount, f64 elapsedTime, u32 replayMismatches)
+{
+	char summaryPath[TFE_MAX_PATH];
+	sprintf(summaryPath, "%sheadless_summary.txt", s_headlessOutputDir);
+
+	FileStream file;
+	if (!file.open(summaryPath, Stream::MODE_WRITE))
+	{
+		TFE_System::logWrite(LOG_ERROR, "Headless", "Cannot write summary '%s'.", summaryPath);
+		return;
+	}
+	file.writeString("version=%s\n", c_gitVersion);
+	file.writeString("level=%s\n", s_headlessLevel);
+	file.writeString("render=%d\n", s_headlessRender ? 1 : 0);
+	file.writeString("ticks=%u\n", tickCount);
+	file.writeString("seconds=%f\n", elapsedTime);
+	file.writeString("msPerTick=%f\n", tickCount ? 1000.0 * elapsedTime / f64(tickCount) : 0.0);
+	if (s_replayPlayPath)
+	{
+		file.writeString("replay=%s\n", s_replayPlayPath);
+		file.writeString("replayMismatches=%u\n", replayMismatches);
+	}
+	file.close();
+}
+
+// Run a level without a window, GPU or audio device.
+// The tasks are advanced by exactly one tick per step, independent of the wall clock, so runs are repeatable.
+s32 runHeadless()
+{
+	if (!validatePath())
+	{
+		TFE_System::logWrite(LOG_ERROR, "Headless", "Invalid game source path.");
+		return PROGRAM_ERROR;
+	}
+	TFE_ReplaySystem::ReplayHeader replayHeader;
+	if (!s_headlessLevel && s_replayPlayPath && TFE_ReplaySystem::readHeader(s_replayPlayPath, &replayHeader) && replayHeader.levelName[0])
+	{
+		strcpy(s_headlessReplayLevel, replayHeader.levelName);
+		s_headlessLevel = s_headlessReplayLevel;
+	}
+	if (!s_headlessLevel)
+	{
+		TFE_System::logWrite(LOG_ERROR, "Headless", "A level is required, use --level <name>.");
+		return PROGRAM_ERROR;
+	}
+
+	if (!s_headlessOutputDir[0])
+	{
+		TFE_Paths::appendPath(PATH_USER_DOCUMENTS, "Headless/", s_headlessOutputDir);
+	}
+	TFE_Paths::fixupPathAsDirectory(s_headlessOutputDir);
+	if (!FileUtil::directoryExits(s_headlessOutputDir))
+	{
+		FileUtil::makeDirectory(s_headlessOutputDir);
+	}
+	TFE_System::logWrite(LOG_MSG, "Headless", "Level: %s, Ticks: %u, Render: %s, Output: \"%s\"",
+		s_headlessLevel, s_headlessTicks, s_headlessRender ? "yes" : "no", s_headlessOutputDir);
+
+	// Only the timer is required, there are no windows or input devices.
+	if (SDL_Init(SDL_INIT_TIMER) != 0)
+	{
+		TFE_System::logWrite(LOG_CRITICAL, "SDL", "Cannot initialize SDL.");
+		return PROGRAM_ERROR;
+	}
+
+	// Headless runs always use the software renderer, these changes are not written back to the settings file.
+	TFE_Settings_Graphics* graphics = TFE_Settings::getGraphicsSettings();
+	graphics->rendererIndex = RENDERER_SOFTWARE;
+	graphics->vsync = false;
+
+	TFE_System::init(0.0f, false, c_gitVersion);
+	// Slightly more than one tick per step, so rounding never drops a tick.
+	TFE_System::setFixedTimeStep((1.0 + 1e-9) / TIMER_FREQ);
+
+	TFE_Settings_Window* windowSettings = TFE_Settings::getWindowSettings();
+	WindowState windowState =
+	{
+		"",
+		windowSettings->width,
+		windowSettings->height,
+		windowSettings->baseWidth,
+		windowSettings->baseHeight,
+		windowSettings->width,
+		windowSettings->height,
+		0,
+		0.0f
+	};
+	TFE_RenderBackend::initHeadless(windowState);
+	TFE_Jedi::renderer_enableDraw(s_headlessRender ? JTRUE : JFALSE);
+	TFE_Audio::init(true);
+	TFE_MidiPlayer::init(TFE_Settings::getSoundSettings()->midiDevice, true);
+	TFE_Polygon::init();
+	TFE_Image::init();
+	TFE_Palette::createDefault256();
+	game_init();
+	inputMapping_startup();
+	TFE_SaveSystem::init();
+
+	// Start directly in the requested level, skipping the cutscenes and the agent menu.
+	char levelArg[TFE_MAX_PATH];
+	sprintf(levelArg, "-l%s", s_headlessLevel);
+	const char* gameArgs[] = { "TheForceEngine", "-c0", levelArg };
+
+	s32 result = PROGRAM_SUCCESS;
+	TFE_Game* gameInfo = TFE_Settings::getGame();
+	s_curGame = createGame(gameInfo->id);
+	TFE_SaveSystem::setCurrentGame(s_curGame);
+	if (!s_curGame || !s_curGame->runGame(TFE_ARRAYSIZE(gameArgs), gameArgs, nullptr))
+	{
+		TFE_System::logWrite(LOG_ERROR, "Headless", "Cannot run game '%s'.", gameInfo->game);
+		result = PROGRAM_ERROR;
+	}
+	else
+	{
+		if (s_replayPlayPath)
+		{
+			// Playback uses the recorded frame times, which also decide when the tasks run.
+			if (!TFE_ReplaySystem::startPlayback(s_replayPlayPath, s_curGame))
+			{
+				result = PROGRAM_ERROR;
+			}
+		}
+		else
+		{
+			TFE_Jedi::task_setFixedStep(JTRUE);
+			if (s_replayRecordPath)
+			{
+				TFE_ReplaySystem::startRecording(s_replayRecordPath, s_curGame, s_headlessLevel);
+			}
+		}
+
+		// With a replay, --ticks limits the number of frames played back.
+		const u64 startTime = TFE_System::getCurrentTimeInTicks();
+		u32 tick = 0;
+		for (u32 frame = 0; result == PROGRAM_SUCCESS && frame < s_headlessTicks && !TFE_System::quitMessagePosted(); frame++)
+		{
+			TFE_FRAME_BEGIN();
+			TFE_System::update();
+			TFE_Audio::update();
+
+			TFE_ReplaySystem::beginFrame();
+			if (TFE_ReplaySystem::playbackFinished())
+			{
+				break;
+			}
+			s_curGame->loopGame();
+			const bool tickRan = TFE_Jedi::task_run() != 0;
+			TFE_ReplaySystem::endFrame(s_curGame, tickRan);
+
+			if (tickRan)
+			{
+				if (s_headlessRender && s_headlessCaptureInterval && (tick % s_headlessCaptureInterval) == 0)
+				{
+					headless_writeFrame(tick);
+				}
+				tick++;
+
+				TFE_Input::endFrame();
+				inputMapping_endFrame();
+			}
+			game_endFrame();
+			TFE_FRAME_END();
+		}
+		const f64 elapsedTime = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - startTime);
+		TFE_System::logWrite(LOG_MSG, "Headless", "Ran %u ticks in %f seconds (%f ms per tick).", tick, elapsedTime, tick ? 1000.0 * elapsedTime / f64(tick) : 0.0);
+
+		const u32 replayMismatches = TFE_ReplaySystem::stop();
+		headless_writeSummary(tick, elapsedTime, replayMismatches);
+		if (replayMismatches)
+		{
+			result = PROGRAM_ERROR;
+		}
+		TFE_Jedi::task_setFixedStep(JFALSE);
+	}
+
+	if (s_curGame)
+	{
+		freeGame(s_curGame);
+		s_curGame = nullptr;
+	}
+	game_destroy();
+	inputMapping_shutdown();
+
+	// Cleanup, the settings are not written since they were modified for the headless run.
+	TFE_Audio::shutdown();
+	TFE_MidiPlayer::destroy();
+	TFE_Polygon::shutdown();
+	TFE_Image::shutdown();
+	TFE_Jobs::shutdown();
+	TFE_Palette::freeAll();
+	TFE_Jedi::texturepacker_freeGlobal();
+	TFE_RenderBackend::destroy();
+	TFE_SaveSystem::destroy();
+	TFE_System::setFixedTimeStep(0.0);
+	SDL_Quit();
+
+	TFE_System::logWrite(LOG_MSG, "Headless", "Headless run finished.");
+	return result;
+}
+
 int main(int argc, char* argv[])
 {
 	#if INSTALL_CRASH_HANDLER
@@ -566,6 +829,14 @@ int main(int argc, char* argv[])
 	TFE_System::logWrite(LOG_MSG, "Paths", "User Documents: \"%s\"", TFE_Paths::getPath(PATH_USER_DOCUMENTS));
 	TFE_System::logWrite(LOG_MSG, "Paths", "Source Data: \"%s\"",    TFE_Paths::getPath(PATH_SOURCE_DATA));
 
+	if (s_headless)
+	{
+		const s32 result = runHeadless();
+		TFE_System::logClose();
+		TFE_System::freeMessages();
+		return result;
+	}
+
 	// Create a screenshot directory
 	char screenshotDir[TFE_MAX_PATH];
 	TFE_Paths::appendPath(TFE_PathType::PATH_USER_DOCUMENTS, "Screenshots/", screenshotDir);
@@ -687,10 +958,17 @@ int main(int argc, char* argv[])
 		s32 mouseAbsX, mouseAbsY;
 		u32 state = SDL_GetRelativeMouseState(&mouseX, &mouseY);
 		SDL_GetMouseState(&mouseAbsX, &mouseAbsY);
-		TFE_Input::setRelativeMousePos(mouseX, mouseY);
+		// During replay playback, the mouse movement comes from the replay instead.
+		if (!TFE_ReplaySystem::isPlaying())
+		{
+			TFE_Input::setRelativeMousePos(mouseX, mouseY);
+		}
 		TFE_Input::setMousePos(mouseAbsX, mouseAbsY);
 		inputMapping_updateInput();
 
+		// Handle sound sources that have finished playing on the audio thread.
+		TFE_Audio::update();
+
 		// Can we save?
 		TFE_FrontEndUI::setCanSave(s_curGame ? s_curGame->canSave() : false);
 
@@ -710,6 +988,7 @@ int main(int argc, char* argv[])
 		{
 			if (appState == APP_STATE_EXIT_TO_MENU)	// Return to the menu from the game.
 			{
+				TFE_ReplaySystem::stop();
 				if (s_curGame)
 				{
 					freeGame(s_curGame);
@@ -828,8 +1107,10 @@ int main(int argc, char* argv[])
 			else
 			{
 				TFE_SaveSystem::update();
+				TFE_ReplaySystem::beginFrame();
 				s_curGame->loopGame();
 				endInputFrame = TFE_Jedi::task_run() != 0;
+				TFE_ReplaySystem::endFrame(s_curGame, endInputFrame);
 			}
 		}
 		else
@@ -865,10 +1146,12 @@ int main(int argc, char* argv[])
 
 		if (endInputFrame)
 		{
+			game_endFrame();
 			TFE_FRAME_END();
 		}
 	}
 
+	TFE_ReplaySystem::stop();
 	if (s_curGame)
 	{
 		freeGame(s_curGame);
@@ -885,6 +1168,7 @@ int main(int argc, char* argv[])
 	TFE_MidiPlayer::destroy();
 	TFE_Polygon::shutdown();
 	TFE_Image::shutdown();
+	TFE_Jobs::shutdown();
 	TFE_Palette::freeAll();
 	TFE_RenderBackend::updateSettings();
 	TFE_Settings::shutdown();
@@ -936,5 +1220,44 @@ void parseOption(const char* name, const std::vector<const char*>& values, bool
 			// --noaudio
 			s_nullAudioDevice = true;
 		}
+		else if (strcasecmp(name, "headless") == 0)
+		{
+			// --headless
+			s_headless = true;
+			s_nullAudioDevice = true;
+		}
+		else if (strcasecmp(name, "level") == 0 && values.size() >= 1)
+		{
+			// --level SECBASE
+			s_headlessLevel = values[0];
+		}
+		else if (strcasecmp(name, "ticks") == 0 && values.size() >= 1)
+		{
+			// --ticks 8700
+			s_headlessTicks = u32(strtoul(values[0], nullptr, 10));
+		}
+		else if (strcasecmp(name, "output") == 0 && values.size() >= 1)
+		{
+			// --output path/to/dir
+			strncpy(s_headlessOutputDir, values[0], TFE_MAX_PATH - 2);
+			s_headlessOutputDir[TFE_MAX_PATH - 2] = 0;
+		}
+		else if (strcasecmp(name, "record") == 0 && values.size() >= 1)
+		{
+			// --record replay.tfr
+			s_replayRecordPath = values[0];
+		}
+		else if (strcasecmp(name, "replay") == 0 && values.size() >= 1)
+		{
+			// --replay replay.tfr
+			s_replayPlayPath = values[0];
+		}
+		else if (strcasecmp(name, "render") == 0)
+		{
+			// --render [captureInterval]
+			// Render using the software renderer, optionally writing every Nth frame to the output directory.
+			s_headlessRender = true;
+			s_headlessCaptureInterval = values.size() >= 1 ? u32(strtoul(values[0], nullptr, 10)) : 0;
+		}
 	}
 }
\ No newline at end of file